@@ -0,0 +1,662 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2016 Srđan Panić <i@srdja.me>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * collectc_bench - a cross-container microbenchmark suite.
+ *
+ * Every suite is run over a number of sizes and key distributions and the
+ * best time out of all repetitions is reported for each operation, along
+ * with the peak number of bytes the container had allocated while the
+ * operation was running.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hashtable.h"
+#include "bench.h"
+
+#define DEFAULT_SIZES   "1000,100000,1000000"
+#define DEFAULT_REPEAT  3
+#define DEFAULT_SEED    0x5eed
+#define ZIPF_EXPONENT   0.99
+#define MAX_SIZES       16
+
+volatile uintptr_t bench_sink;
+size_t             bench_calls;
+unsigned           bench_threads;
+
+static const BenchSuite suites[] = {
+    {"hashtable",    bench_hashtable,    false},
+    {"hashtable_oa", bench_hashtable_oa, false},
+    {"hashset",      bench_hashset,      false},
+    {"hashmap",      bench_hashmap,      false},
+    {"concurrent",   bench_concurrent,   false},
+    {"treetable",    bench_treetable,    false},
+    {"tsttable",     bench_tsttable,     true},
+    {"array",        bench_array,        false},
+    {"array_sized",  bench_array_sized,  false},
+    {"deque",        bench_deque,        false},
+    {"list",         bench_list,         false},
+    {"pqueue",       bench_pqueue,       false},
+    {"hash",         bench_hash,         false},
+    {"keycmp",       bench_keycmp,       true},
+};
+
+#define SUITE_COUNT (sizeof(suites) / sizeof(suites[0]))
+
+static const char *dist_names[BENCH_DIST_COUNT] = {
+    "sequential",
+    "uniform",
+    "zipf",
+    "string",
+};
+
+/**
+ * A single result row. Repeated runs of the same operation are folded
+ * into one row that keeps the best time and the highest peak.
+ */
+typedef struct bench_result_s {
+    const char      *container;
+    const char      *op;
+    enum bench_dist  dist;
+    size_t           n;
+    size_t           ops;
+    uint64_t         ns;
+    size_t           peak_bytes;
+    bool             counted;
+    size_t           calls;
+} BenchResult;
+
+static BenchResult *results;
+static size_t       results_size;
+static size_t       results_capacity;
+
+static uint64_t     rng_state;
+
+
+/*******************************************************************************
+ *
+ *
+ *  Allocation accounting
+ *
+ *
+ ******************************************************************************/
+
+/* Every block is prefixed by a header that remembers its size, padded so
+ * that the returned block keeps the alignment malloc guarantees. */
+typedef union alloc_header_u {
+    size_t      size;
+    max_align_t align;
+} AllocHeader;
+
+static size_t mem_live;
+static size_t mem_peak;
+
+static INLINE void mem_account(size_t size)
+{
+    mem_live += size;
+    if (mem_live > mem_peak)
+        mem_peak = mem_live;
+}
+
+void *bench_malloc(size_t size)
+{
+    AllocHeader *h = malloc(sizeof(AllocHeader) + size);
+
+    if (!h)
+        return NULL;
+
+    h->size = size;
+    mem_account(size);
+    return h + 1;
+}
+
+void *bench_calloc(size_t blocks, size_t size)
+{
+    size_t       total = blocks * size;
+    AllocHeader *h     = calloc(1, sizeof(AllocHeader) + total);
+
+    if (!h)
+        return NULL;
+
+    h->size = total;
+    mem_account(total);
+    return h + 1;
+}
+
+void *bench_realloc(void *block, size_t size)
+{
+    if (!block)
+        return bench_malloc(size);
+
+    AllocHeader *h   = ((AllocHeader*) block) - 1;
+    size_t       old = h->size;
+    AllocHeader *n   = realloc(h, sizeof(AllocHeader) + size);
+
+    if (!n)
+        return NULL;
+
+    n->size   = size;
+    mem_live -= old;
+    mem_account(size);
+    return n + 1;
+}
+
+void bench_free(void *block)
+{
+    if (!block)
+        return;
+
+    AllocHeader *h = ((AllocHeader*) block) - 1;
+    mem_live -= h->size;
+    free(h);
+}
+
+size_t bench_mem_live(void)
+{
+    return mem_live;
+}
+
+
+/*******************************************************************************
+ *
+ *
+ *  Timing and reporting
+ *
+ *
+ ******************************************************************************/
+
+uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * Starts the timer and resets the peak allocation counter to the number
+ * of bytes that are currently live.
+ */
+void bench_start(BenchTimer *t)
+{
+    mem_peak       = mem_live;
+    bench_calls    = 0;
+    t->count_calls = false;
+    t->start_ns    = bench_now_ns();
+}
+
+/**
+ * Starts the timer like bench_start(), but the result also reports the
+ * number of bench_calls per op.
+ */
+void bench_start_counted(BenchTimer *t)
+{
+    bench_start(t);
+    t->count_calls = true;
+}
+
+/**
+ * Stops the timer and records the result of <code>ops</code> operations
+ * of type <code>op</code> performed on <code>container</code>.
+ */
+void bench_stop(BenchTimer *t, const BenchWorkload *w,
+                const char *container, const char *op, size_t ops)
+{
+    uint64_t ns = bench_now_ns() - t->start_ns;
+
+    if (ns == 0)
+        ns = 1;
+
+    size_t i;
+    for (i = 0; i < results_size; i++) {
+        BenchResult *r = &results[i];
+
+        if (r->dist == w->dist && r->n == w->n &&
+            !strcmp(r->container, container) && !strcmp(r->op, op)) {
+            if (ns < r->ns)
+                r->ns = ns;
+            if (mem_peak > r->peak_bytes)
+                r->peak_bytes = mem_peak;
+            return;
+        }
+    }
+
+    if (results_size == results_capacity) {
+        results_capacity = results_capacity ? results_capacity * 2 : 64;
+        results = realloc(results, results_capacity * sizeof(BenchResult));
+        if (!results) {
+            fprintf(stderr, "collectc_bench: out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    BenchResult *r = &results[results_size++];
+    r->container  = container;
+    r->op         = op;
+    r->dist       = w->dist;
+    r->n          = w->n;
+    r->ops        = ops;
+    r->ns         = ns;
+    r->peak_bytes = mem_peak;
+    r->counted    = t->count_calls;
+    r->calls      = bench_calls;
+}
+
+const char *bench_dist_name(enum bench_dist dist)
+{
+    return dist_names[dist];
+}
+
+static void print_text(FILE *f)
+{
+    fprintf(f, "%-12s %-18s %-11s %10s %12s %12s %14s %10s\n",
+            "container", "op", "dist", "n", "ns/op", "Mops/s", "peak bytes", "calls/op");
+
+    size_t i;
+    for (i = 0; i < results_size; i++) {
+        BenchResult *r = &results[i];
+        double ns_op = (double) r->ns / r->ops;
+
+        fprintf(f, "%-12s %-18s %-11s %10zu %12.2f %12.3f %14zu",
+                r->container, r->op, dist_names[r->dist], r->n,
+                ns_op, 1e3 / ns_op, r->peak_bytes);
+
+        if (r->counted)
+            fprintf(f, " %10.3f\n", (double) r->calls / r->ops);
+        else
+            fprintf(f, " %10s\n", "-");
+    }
+}
+
+static void print_json(FILE *f, unsigned repeat, uint64_t seed)
+{
+    fprintf(f, "{\n");
+    fprintf(f, "  \"benchmark\": \"collectc_bench\",\n");
+    fprintf(f, "  \"format_version\": 1,\n");
+    fprintf(f, "  \"repeat\": %u,\n", repeat);
+    fprintf(f, "  \"seed\": %llu,\n", (unsigned long long) seed);
+    fprintf(f, "  \"results\": [\n");
+
+    size_t i;
+    for (i = 0; i < results_size; i++) {
+        BenchResult *r = &results[i];
+        double ns_op = (double) r->ns / r->ops;
+
+        fprintf(f, "    {\"container\": \"%s\", \"op\": \"%s\", \"dist\": \"%s\", "
+                "\"n\": %zu, \"ops\": %zu, \"total_ns\": %llu, \"ns_per_op\": %.3f, "
+                "\"ops_per_sec\": %.1f, \"peak_bytes\": %zu",
+                r->container, r->op, dist_names[r->dist], r->n, r->ops,
+                (unsigned long long) r->ns, ns_op, 1e9 / ns_op, r->peak_bytes);
+
+        if (r->counted)
+            fprintf(f, ", \"calls_per_op\": %.3f", (double) r->calls / r->ops);
+
+        fprintf(f, "}%s\n", i + 1 < results_size ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+
+/*******************************************************************************
+ *
+ *
+ *  Workload generation
+ *
+ *
+ ******************************************************************************/
+
+/**
+ * SplitMix64 finalizer. It is a bijection, so mixing distinct integers
+ * always produces distinct keys.
+ */
+static INLINE uint64_t mix64(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+uint64_t bench_rand(void)
+{
+    rng_state += 0x9e3779b97f4a7c15ULL;
+    return mix64(rng_state);
+}
+
+static size_t rand_below(size_t n)
+{
+    return (size_t) (bench_rand() % n);
+}
+
+static void shuffle(size_t *a, size_t n)
+{
+    size_t i;
+    for (i = n - 1; i > 0 && n > 1; i--) {
+        size_t j   = rand_below(i + 1);
+        size_t tmp = a[i];
+        a[i] = a[j];
+        a[j] = tmp;
+    }
+}
+
+static int cmp_u64(const void *k1, const void *k2)
+{
+    uint64_t a = *((const uint64_t*) k1);
+    uint64_t b = *((const uint64_t*) k2);
+
+    if (a < b)
+        return -1;
+    if (a > b)
+        return 1;
+    return 0;
+}
+
+static int cmp_u64_indirect(const void *k1, const void *k2)
+{
+    return cmp_u64(*((void* const*) k1), *((void* const*) k2));
+}
+
+static int cmp_str_indirect(const void *k1, const void *k2)
+{
+    return strcmp(*((char* const*) k1), *((char* const*) k2));
+}
+
+/**
+ * Fills probe with Zipf distributed indices in [0, n). Rank r is mapped
+ * to a random key so that the hot keys are spread over the insertion order.
+ */
+static void gen_zipf(size_t *probe, size_t n)
+{
+    double *cdf  = malloc(n * sizeof(double));
+    size_t *rank = malloc(n * sizeof(size_t));
+    double  sum  = 0;
+
+    size_t i;
+    for (i = 0; i < n; i++) {
+        sum   += 1.0 / pow((double) (i + 1), ZIPF_EXPONENT);
+        cdf[i] = sum;
+        rank[i] = i;
+    }
+    shuffle(rank, n);
+
+    for (i = 0; i < n; i++) {
+        double u  = (double) (bench_rand() >> 11) / (double) (1ULL << 53) * sum;
+        size_t lo = 0;
+        size_t hi = n - 1;
+
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (cdf[mid] < u)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        probe[i] = rank[lo];
+    }
+    free(cdf);
+    free(rank);
+}
+
+/* Storage that backs the keys of a workload */
+static uint64_t *int_pool;
+static char     *str_pool;
+
+#define STR_KEY_FORMAT "https://example.com/catalog/item/%016llx/view"
+#define STR_KEY_LENGTH 56
+
+static BenchWorkload *workload_new(enum bench_dist dist, size_t n)
+{
+    BenchWorkload *w = calloc(1, sizeof(BenchWorkload));
+
+    w->dist   = dist;
+    w->n      = n;
+    w->keys   = malloc(n * sizeof(void*));
+    w->stream = malloc(n * sizeof(void*));
+    w->probe  = malloc(n * sizeof(size_t));
+    w->order  = malloc(n * sizeof(size_t));
+
+    uint64_t salt = bench_rand();
+
+    size_t i;
+    if (dist == BENCH_DIST_STRING) {
+        str_pool = malloc(n * STR_KEY_LENGTH);
+        for (i = 0; i < n; i++) {
+            char *k = str_pool + i * STR_KEY_LENGTH;
+            snprintf(k, STR_KEY_LENGTH, STR_KEY_FORMAT,
+                     (unsigned long long) mix64(i ^ salt));
+            w->keys[i] = k;
+        }
+        w->cmp          = cc_common_cmp_str;
+        w->cmp_indirect = cmp_str_indirect;
+        w->hash         = STRING_HASH;
+        w->key_length   = KEY_LENGTH_VARIABLE;
+    } else {
+        int_pool = malloc(n * sizeof(uint64_t));
+        for (i = 0; i < n; i++) {
+            int_pool[i] = dist == BENCH_DIST_SEQUENTIAL ? i : mix64(i ^ salt);
+            w->keys[i]  = &int_pool[i];
+        }
+        w->cmp          = cmp_u64;
+        w->cmp_indirect = cmp_u64_indirect;
+        w->hash         = GENERAL_HASH;
+        w->key_length   = sizeof(uint64_t);
+    }
+
+    for (i = 0; i < n; i++)
+        w->order[i] = i;
+
+    switch (dist) {
+    case BENCH_DIST_SEQUENTIAL:
+        for (i = 0; i < n; i++)
+            w->probe[i] = i;
+        break;
+    case BENCH_DIST_ZIPF:
+        gen_zipf(w->probe, n);
+        shuffle(w->order, n);
+        break;
+    default:
+        for (i = 0; i < n; i++)
+            w->probe[i] = rand_below(n);
+        shuffle(w->order, n);
+        break;
+    }
+
+    for (i = 0; i < n; i++)
+        w->stream[i] = w->keys[w->probe[i]];
+
+    return w;
+}
+
+static void workload_destroy(BenchWorkload *w)
+{
+    free(int_pool);
+    free(str_pool);
+    int_pool = NULL;
+    str_pool = NULL;
+
+    free(w->keys);
+    free(w->stream);
+    free(w->probe);
+    free(w->order);
+    free(w);
+}
+
+
+/*******************************************************************************
+ *
+ *
+ *  Command line
+ *
+ *
+ ******************************************************************************/
+
+static void usage(FILE *f)
+{
+    fprintf(f,
+            "usage: collectc_bench [options]\n"
+            "  -n SIZES   comma separated element counts (default " DEFAULT_SIZES ")\n"
+            "  -c NAMES   comma separated containers to run (default all)\n"
+            "  -d DISTS   comma separated distributions: sequential,uniform,zipf,string\n"
+            "  -r N       repetitions per measurement, the best one is kept (default %d)\n"
+            "  -s SEED    random seed (default %d)\n"
+            "  -t N       maximum number of threads (default: online CPUs)\n"
+            "  -j FILE    write the results as JSON to FILE ('-' for stdout)\n"
+            "  -h         show this help\n",
+            DEFAULT_REPEAT, DEFAULT_SEED);
+}
+
+/**
+ * Returns true if name is an element of a comma separated list, or if the
+ * list is NULL.
+ */
+static bool in_list(const char *list, const char *name)
+{
+    if (!list)
+        return true;
+
+    size_t len = strlen(name);
+    const char *p = list;
+
+    while (*p) {
+        const char *end = strchr(p, ',');
+        size_t      l   = end ? (size_t) (end - p) : strlen(p);
+
+        if (l == len && !strncmp(p, name, len))
+            return true;
+        if (!end)
+            break;
+        p = end + 1;
+    }
+    return false;
+}
+
+static size_t parse_sizes(const char *s, size_t *sizes)
+{
+    size_t count = 0;
+
+    while (*s && count < MAX_SIZES) {
+        char *end;
+        unsigned long long v = strtoull(s, &end, 10);
+
+        if (end == s)
+            break;
+        if (v > 0)
+            sizes[count++] = (size_t) v;
+        if (*end != ',')
+            break;
+        s = end + 1;
+    }
+    return count;
+}
+
+int main(int argc, char **argv)
+{
+    const char *size_arg  = DEFAULT_SIZES;
+    const char *cont_arg  = NULL;
+    const char *dist_arg  = NULL;
+    const char *json_path = NULL;
+    unsigned    repeat    = DEFAULT_REPEAT;
+    uint64_t    seed      = DEFAULT_SEED;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:c:d:r:s:t:j:h")) != -1) {
+        switch (opt) {
+        case 'n': size_arg  = optarg; break;
+        case 'c': cont_arg  = optarg; break;
+        case 'd': dist_arg  = optarg; break;
+        case 'r': repeat    = (unsigned) strtoul(optarg, NULL, 10); break;
+        case 's': seed      = strtoull(optarg, NULL, 0); break;
+        case 't': bench_threads = (unsigned) strtoul(optarg, NULL, 10); break;
+        case 'j': json_path = optarg; break;
+        case 'h':
+            usage(stdout);
+            return EXIT_SUCCESS;
+        default:
+            usage(stderr);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (bench_threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        bench_threads = cpus > 0 ? (unsigned) cpus : 1;
+    }
+
+    size_t sizes[MAX_SIZES];
+    size_t n_sizes = parse_sizes(size_arg, sizes);
+
+    if (n_sizes == 0 || repeat == 0) {
+        usage(stderr);
+        return EXIT_FAILURE;
+    }
+
+    rng_state = seed;
+
+    size_t s;
+    for (s = 0; s < n_sizes; s++) {
+        int d;
+        for (d = 0; d < BENCH_DIST_COUNT; d++) {
+            if (!in_list(dist_arg, dist_names[d]))
+                continue;
+
+            BenchWorkload *w = workload_new((enum bench_dist) d, sizes[s]);
+
+            unsigned r;
+            for (r = 0; r < repeat; r++) {
+                size_t i;
+                for (i = 0; i < SUITE_COUNT; i++) {
+                    if (!in_list(cont_arg, suites[i].name))
+                        continue;
+                    if (suites[i].strings_only && d != BENCH_DIST_STRING)
+                        continue;
+                    suites[i].run(w);
+                }
+            }
+            workload_destroy(w);
+        }
+    }
+
+    if (!json_path || strcmp(json_path, "-"))
+        print_text(stdout);
+
+    if (json_path) {
+        FILE *f = strcmp(json_path, "-") ? fopen(json_path, "w") : stdout;
+
+        if (!f) {
+            perror(json_path);
+            return EXIT_FAILURE;
+        }
+        print_json(f, repeat, seed);
+        if (f != stdout)
+            fclose(f);
+    }
+    free(results);
+    return EXIT_SUCCESS;
+}
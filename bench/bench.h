@@ -0,0 +1,165 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2016 Srđan Panić <i@srdja.me>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COLLECTIONS_C_BENCH_H
+#define COLLECTIONS_C_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Key distributions a workload can be generated from.
+ */
+enum bench_dist {
+    BENCH_DIST_SEQUENTIAL = 0,
+    BENCH_DIST_UNIFORM    = 1,
+    BENCH_DIST_ZIPF       = 2,
+    BENCH_DIST_STRING     = 3,
+
+    BENCH_DIST_COUNT      = 4,
+};
+
+/**
+ * A generated workload that is shared by all container benchmarks of a
+ * single (size, distribution) run.
+ *
+ * Keys are either pointers to uint64_t values or NUL-terminated strings
+ * (for BENCH_DIST_STRING). In both cases <code>cmp</code>, <code>hash</code>
+ * and <code>key_length</code> describe how the keys should be compared and
+ * hashed.
+ */
+typedef struct bench_workload_s {
+    enum bench_dist dist;
+
+    /**
+     * Number of distinct keys */
+    size_t   n;
+
+    /**
+     * n distinct keys in insertion order. Sequential keys are ascending,
+     * all other distributions are shuffled. */
+    void   **keys;
+
+    /**
+     * n keys drawn from the distribution (with repetitions for zipf). Used
+     * for lookups and as the element stream of the sequence containers. */
+    void   **stream;
+
+    /**
+     * n indices into keys drawn from the distribution. */
+    size_t  *probe;
+
+    /**
+     * A permutation of [0, n) used as the removal order. */
+    size_t  *order;
+
+    /**
+     * Key comparator, hash function and key length suitable for a
+     * HashTableConf. */
+    int    (*cmp)  (const void *k1, const void *k2);
+    size_t (*hash) (const void *key, int l, uint32_t seed);
+    int      key_length;
+
+    /**
+     * Comparator over pointers to keys (void**), as used by array_sort
+     * and list_sort. */
+    int    (*cmp_indirect) (const void *k1, const void *k2);
+} BenchWorkload;
+
+/**
+ * A running timer.
+ */
+typedef struct bench_timer_s {
+    uint64_t start_ns;
+    bool     count_calls;
+} BenchTimer;
+
+/**
+ * Benchmark suite entry point. Each suite runs every operation that its
+ * container supports on the workload and reports it with bench_stop().
+ */
+typedef void (*bench_suite_fn) (const BenchWorkload *w);
+
+/**
+ * A named benchmark suite.
+ */
+typedef struct bench_suite_s {
+    const char     *name;
+    bench_suite_fn  run;
+
+    /**
+     * Set if the suite only works with string keys. */
+    bool            strings_only;
+} BenchSuite;
+
+/* Allocators that keep track of the live and peak allocated byte counts.
+ * Every container under test should be configured to use these. */
+void     *bench_malloc    (size_t size);
+void     *bench_calloc    (size_t blocks, size_t size);
+void      bench_free      (void *block);
+void     *bench_realloc   (void *block, size_t size);
+
+size_t    bench_mem_live  (void);
+
+void      bench_start     (BenchTimer *t);
+void      bench_start_counted (BenchTimer *t);
+void      bench_stop      (BenchTimer *t, const BenchWorkload *w,
+                           const char *container, const char *op, size_t ops);
+
+uint64_t  bench_now_ns    (void);
+uint64_t  bench_rand      (void);
+
+const char *bench_dist_name (enum bench_dist dist);
+
+/**
+ * A value sink that prevents the compiler from optimizing away results
+ * of the benchmarked operations.
+ */
+extern volatile uintptr_t bench_sink;
+
+/**
+ * Counter of calls to instrumented callbacks, such as a counting key
+ * comparator. It is reset by bench_start() and reported per op for
+ * timers started with bench_start_counted().
+ */
+extern size_t bench_calls;
+
+/**
+ * The highest number of threads that multi-threaded suites run with.
+ */
+extern unsigned bench_threads;
+
+void bench_hashtable    (const BenchWorkload *w);
+void bench_hashtable_oa (const BenchWorkload *w);
+void bench_hashset      (const BenchWorkload *w);
+void bench_hashmap      (const BenchWorkload *w);
+void bench_concurrent   (const BenchWorkload *w);
+void bench_treetable    (const BenchWorkload *w);
+void bench_tsttable     (const BenchWorkload *w);
+void bench_array        (const BenchWorkload *w);
+void bench_array_sized  (const BenchWorkload *w);
+void bench_deque        (const BenchWorkload *w);
+void bench_list         (const BenchWorkload *w);
+void bench_pqueue       (const BenchWorkload *w);
+void bench_hash         (const BenchWorkload *w);
+void bench_keycmp       (const BenchWorkload *w);
+
+#endif /* COLLECTIONS_C_BENCH_H */
@@ -0,0 +1,134 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2016 Srđan Panić <i@srdja.me>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "array.h"
+#include "bench.h"
+
+static uint64_t u64_key(const void *e)
+{
+    return *(const uint64_t*) e;
+}
+
+void bench_array(const BenchWorkload *w)
+{
+    ArrayConf conf;
+    array_conf_init(&conf);
+
+    conf.mem_alloc  = bench_malloc;
+    conf.mem_calloc = bench_calloc;
+    conf.mem_free   = bench_free;
+
+    BenchTimer t;
+    Array     *ar;
+    size_t     i;
+
+    array_new_conf(&conf, &ar);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        array_add(ar, w->stream[i]);
+    bench_stop(&t, w, "array", "insert", w->n);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++) {
+        void *e;
+        if (array_get_at(ar, w->probe[i], &e) == CC_OK)
+            bench_sink += (uintptr_t) e;
+    }
+    bench_stop(&t, w, "array", "lookup", w->n);
+
+    bench_start(&t);
+    ArrayIter iter;
+    void     *e;
+    array_iter_init(&iter, ar);
+    while (array_iter_next(&iter, &e) != CC_ITER_END)
+        bench_sink += (uintptr_t) e;
+    bench_stop(&t, w, "array", "iterate", w->n);
+
+    Array *copy;
+
+    bench_start(&t);
+    array_copy_shallow(ar, &copy);
+    bench_stop(&t, w, "array", "bulk-copy", w->n);
+
+    bench_start(&t);
+    array_sort(copy, w->cmp_indirect);
+    bench_stop(&t, w, "array", "sort", w->n);
+
+    array_destroy(copy);
+    array_copy_shallow(ar, &copy);
+
+    bench_start(&t);
+    array_sort_stable(copy, w->cmp_indirect);
+    bench_stop(&t, w, "array", "sort-stable", w->n);
+
+    ArrayParConf pc;
+    array_par_conf_init(&pc);
+    pc.threads = bench_threads;
+
+    array_destroy(copy);
+    array_copy_shallow(ar, &copy);
+
+    bench_start(&t);
+    array_par_sort(copy, w->cmp_indirect, &pc);
+    bench_stop(&t, w, "array", "par-sort", w->n);
+
+    if (w->dist != BENCH_DIST_STRING) {
+        array_destroy(copy);
+        array_copy_shallow(ar, &copy);
+
+        bench_start(&t);
+        array_sort_by_key(copy, u64_key);
+        bench_stop(&t, w, "array", "sort-by-key", w->n);
+    }
+
+    array_destroy(copy);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        array_remove_last(ar, NULL);
+    bench_stop(&t, w, "array", "remove", w->n);
+
+    array_destroy(ar);
+
+    /* Growth through realloc, and through huge page aligned mappings for
+     * buffers of 1MB and more. Mapped buffers are not counted by the
+     * bench allocators. */
+    conf.capacity    = 1;
+    conf.mem_realloc = bench_realloc;
+    array_new_conf(&conf, &ar);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        array_add(ar, w->stream[i]);
+    bench_stop(&t, w, "array", "insert-realloc", w->n);
+
+    array_destroy(ar);
+
+    conf.mmap_threshold = 1 << 20;
+    array_new_conf(&conf, &ar);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        array_add(ar, w->stream[i]);
+    bench_stop(&t, w, "array", "insert-mmap", w->n);
+
+    array_destroy(ar);
+}
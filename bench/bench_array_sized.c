@@ -0,0 +1,91 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2016 Srđan Panić <i@srdja.me>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "array_sized.h"
+#include "bench.h"
+
+#define KEY(p) (*(uint64_t*) (p))
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t*) a;
+    uint64_t y = *(const uint64_t*) b;
+
+    return (x > y) - (x < y);
+}
+
+/*
+ * The same operations as the array suite, on an array that stores the
+ * integer keys by value. Not run on string keys.
+ */
+void bench_array_sized(const BenchWorkload *w)
+{
+    if (w->dist == BENCH_DIST_STRING)
+        return;
+
+    ArraySizedConf conf;
+    array_sized_conf_init(&conf);
+
+    conf.elem_size  = sizeof(uint64_t);
+    conf.mem_alloc  = bench_malloc;
+    conf.mem_calloc = bench_calloc;
+    conf.mem_free   = bench_free;
+
+    BenchTimer  t;
+    ArraySized *ar;
+    size_t      i;
+
+    if (array_sized_new_conf(&conf, &ar) != CC_OK)
+        return;
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        array_sized_add(ar, w->stream[i]);
+    bench_stop(&t, w, "array_sized", "insert", w->n);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++) {
+        uint64_t e;
+        if (array_sized_get_at(ar, w->probe[i], &e) == CC_OK)
+            bench_sink += e;
+    }
+    bench_stop(&t, w, "array_sized", "lookup", w->n);
+
+    bench_start(&t);
+    ArraySizedIter iter;
+    uint64_t       e;
+    array_sized_iter_init(&iter, ar);
+    while (array_sized_iter_next(&iter, &e) != CC_ITER_END)
+        bench_sink += e;
+    bench_stop(&t, w, "array_sized", "iterate", w->n);
+
+    bench_start(&t);
+    array_sized_sort(ar, cmp_u64);
+    bench_stop(&t, w, "array_sized", "sort", w->n);
+
+    bench_sink += KEY(array_sized_get_buffer(ar));
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        array_sized_remove_last(ar, NULL);
+    bench_stop(&t, w, "array_sized", "remove", w->n);
+
+    array_sized_destroy(ar);
+}
@@ -0,0 +1,249 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2016 Srđan Panić <i@srdja.me>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "concurrent_hashtable.h"
+#include "sharded_hashtable.h"
+#include "hashtable.h"
+#include "bench.h"
+
+/*
+ * Thread scaling of ConcurrentHashTable, with and without lock-free reads,
+ * and of ShardedHashTable against a HashTable behind a single mutex. Every operation is run with 1, 2, 4 ... bench_threads threads that
+ * each work on an equal slice of the workload. The bench allocators aren't
+ * thread safe, so the tables use malloc and no memory is reported.
+ */
+
+#define MAX_THREADS 64
+
+enum phase {
+    PHASE_INSERT,
+    PHASE_LOOKUP,
+    PHASE_MIXED,
+
+    PHASE_COUNT
+};
+
+static const char *phase_names[PHASE_COUNT] = {"insert", "lookup", "mixed"};
+
+/* bench_stop() keeps the op name, so the names live here */
+static char op_names[PHASE_COUNT][MAX_THREADS + 1][24];
+
+typedef struct ops_s {
+    enum cc_stat (*add) (void *table, void *key, void *val);
+    enum cc_stat (*get) (void *table, void *key, void **out);
+} Ops;
+
+typedef struct job_s {
+    const BenchWorkload *w;
+    const Ops           *ops;
+    void                *table;
+    enum phase           phase;
+    size_t               lo;
+    size_t               hi;
+} Job;
+
+static atomic_bool go;
+
+static pthread_mutex_t table_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static enum cc_stat locked_add(void *table, void *key, void *val)
+{
+    pthread_mutex_lock(&table_lock);
+    enum cc_stat stat = hashtable_add(table, key, val);
+    pthread_mutex_unlock(&table_lock);
+    return stat;
+}
+
+static enum cc_stat locked_get(void *table, void *key, void **out)
+{
+    pthread_mutex_lock(&table_lock);
+    enum cc_stat stat = hashtable_get(table, key, out);
+    pthread_mutex_unlock(&table_lock);
+    return stat;
+}
+
+static enum cc_stat striped_add(void *table, void *key, void *val)
+{
+    return concurrent_hashtable_add(table, key, val);
+}
+
+static enum cc_stat striped_get(void *table, void *key, void **out)
+{
+    return concurrent_hashtable_get(table, key, out);
+}
+
+static enum cc_stat sharded_add(void *table, void *key, void *val)
+{
+    return sharded_hashtable_add(table, key, val);
+}
+
+static enum cc_stat sharded_get(void *table, void *key, void **out)
+{
+    return sharded_hashtable_get(table, key, out);
+}
+
+static const Ops locked_ops  = {locked_add,  locked_get};
+static const Ops striped_ops = {striped_add, striped_get};
+static const Ops sharded_ops = {sharded_add, sharded_get};
+
+static void *worker(void *arg)
+{
+    Job                 *job = arg;
+    const BenchWorkload *w   = job->w;
+    uintptr_t            sum = 0;
+    size_t               i;
+
+    while (!atomic_load_explicit(&go, memory_order_acquire))
+        ;
+
+    for (i = job->lo; i < job->hi; i++) {
+        void *v = NULL;
+
+        switch (job->phase) {
+        case PHASE_INSERT:
+            job->ops->add(job->table, w->keys[i], w->keys[i]);
+            break;
+        case PHASE_LOOKUP:
+            job->ops->get(job->table, w->stream[i], &v);
+            break;
+        case PHASE_MIXED:
+            /* one write for every nine reads */
+            if (i % 10 == 0)
+                job->ops->add(job->table, w->keys[w->probe[i]], w->stream[i]);
+            else
+                job->ops->get(job->table, w->stream[i], &v);
+            break;
+        default:
+            break;
+        }
+        sum += (uintptr_t) v;
+    }
+    bench_sink += sum;
+    return NULL;
+}
+
+/**
+ * Runs one phase on nthreads threads and reports it.
+ */
+static void run_phase(const BenchWorkload *w, const char *container, const Ops *ops,
+                      void *table, enum phase phase, unsigned nthreads)
+{
+    pthread_t  threads[MAX_THREADS];
+    Job        jobs[MAX_THREADS];
+    BenchTimer t;
+    unsigned   i;
+
+    atomic_store(&go, false);
+
+    for (i = 0; i < nthreads; i++) {
+        jobs[i].w     = w;
+        jobs[i].ops   = ops;
+        jobs[i].table = table;
+        jobs[i].phase = phase;
+        jobs[i].lo    = w->n * i / nthreads;
+        jobs[i].hi    = w->n * (i + 1) / nthreads;
+        pthread_create(&threads[i], NULL, worker, &jobs[i]);
+    }
+
+    bench_start(&t);
+    atomic_store_explicit(&go, true, memory_order_release);
+
+    for (i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+
+    char *name = op_names[phase][nthreads];
+    if (!name[0])
+        snprintf(name, sizeof(op_names[phase][nthreads]), "%s/%ut",
+                 phase_names[phase], nthreads);
+
+    bench_stop(&t, w, container, name, w->n);
+}
+
+void bench_concurrent(const BenchWorkload *w)
+{
+    unsigned max = bench_threads < MAX_THREADS ? bench_threads : MAX_THREADS;
+    unsigned n;
+
+    HashTableConf conf;
+    hashtable_conf_init(&conf);
+    conf.hash        = w->hash;
+    conf.key_compare = w->cmp;
+    conf.key_length  = w->key_length;
+
+    ConcurrentHashTableConf cconf;
+    concurrent_hashtable_conf_init(&cconf);
+    cconf.hash        = w->hash;
+    cconf.key_compare = w->cmp;
+    cconf.key_length  = w->key_length;
+
+    ConcurrentHashTableConf lfconf = cconf;
+    lfconf.lock_free_reads = true;
+
+    ShardedHashTableConf sconf;
+    sharded_hashtable_conf_init(&sconf);
+    sconf.table_conf = conf;
+
+    for (n = 1; n <= max; n = n < max && n * 2 > max ? max : n * 2) {
+        HashTable           *locked;
+        ConcurrentHashTable *striped;
+        ConcurrentHashTable *lock_free;
+        ShardedHashTable    *sharded;
+        int                  p;
+
+        if (hashtable_new_conf(&conf, &locked) != CC_OK)
+            return;
+
+        if (concurrent_hashtable_new_conf(&cconf, &striped) != CC_OK) {
+            hashtable_destroy(locked);
+            return;
+        }
+
+        if (concurrent_hashtable_new_conf(&lfconf, &lock_free) != CC_OK) {
+            hashtable_destroy(locked);
+            concurrent_hashtable_destroy(striped);
+            return;
+        }
+
+        if (sharded_hashtable_new_conf(&sconf, &sharded) != CC_OK) {
+            hashtable_destroy(locked);
+            concurrent_hashtable_destroy(striped);
+            concurrent_hashtable_destroy(lock_free);
+        sharded_hashtable_destroy(sharded);
+            return;
+        }
+
+        for (p = 0; p < PHASE_COUNT; p++) {
+            run_phase(w, "mutex_table", &locked_ops, locked, p, n);
+            run_phase(w, "concurrent", &striped_ops, striped, p, n);
+            run_phase(w, "lock_free", &striped_ops, lock_free, p, n);
+            run_phase(w, "sharded", &sharded_ops, sharded, p, n);
+        }
+        hashtable_destroy(locked);
+        concurrent_hashtable_destroy(striped);
+        concurrent_hashtable_destroy(lock_free);
+
+        if (n == max)
+            break;
+    }
+}
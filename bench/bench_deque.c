@@ -0,0 +1,74 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2016 Srđan Panić <i@srdja.me>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "deque.h"
+#include "bench.h"
+
+void bench_deque(const BenchWorkload *w)
+{
+    DequeConf conf;
+    deque_conf_init(&conf);
+
+    conf.mem_alloc  = bench_malloc;
+    conf.mem_calloc = bench_calloc;
+    conf.mem_free   = bench_free;
+
+    BenchTimer t;
+    Deque     *deque;
+    size_t     i;
+
+    deque_new_conf(&conf, &deque);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        deque_add_last(deque, w->stream[i]);
+    bench_stop(&t, w, "deque", "insert", w->n);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++) {
+        void *e;
+        if (deque_get_at(deque, w->probe[i], &e) == CC_OK)
+            bench_sink += (uintptr_t) e;
+    }
+    bench_stop(&t, w, "deque", "lookup", w->n);
+
+    bench_start(&t);
+    DequeIter iter;
+    void     *e;
+    deque_iter_init(&iter, deque);
+    while (deque_iter_next(&iter, &e) != CC_ITER_END)
+        bench_sink += (uintptr_t) e;
+    bench_stop(&t, w, "deque", "iterate", w->n);
+
+    Deque *copy;
+
+    bench_start(&t);
+    deque_copy_shallow(deque, &copy);
+    bench_stop(&t, w, "deque", "bulk-copy", w->n);
+
+    deque_destroy(copy);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        deque_remove_first(deque, NULL);
+    bench_stop(&t, w, "deque", "remove", w->n);
+
+    deque_destroy(deque);
+}
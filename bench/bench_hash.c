@@ -0,0 +1,72 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2016 Srđan Panić <i@srdja.me>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "hashtable.h"
+#include "bench.h"
+
+typedef size_t (*hash_fn) (const void *key, int l, uint32_t seed);
+
+/* Every key is hashed ROUNDS times so that small workloads still run long
+ * enough to be timed reliably. */
+#define ROUNDS 8
+
+static void run(const BenchWorkload *w, const char *op, hash_fn hash, int len)
+{
+    BenchTimer t;
+    size_t     i;
+    int        r;
+    size_t     acc = 0;
+
+    bench_start(&t);
+    for (r = 0; r < ROUNDS; r++) {
+        for (i = 0; i < w->n; i++)
+            acc += hash(w->keys[i], len, r);
+    }
+    bench_stop(&t, w, "hash", op, w->n * ROUNDS);
+
+    bench_sink += acc;
+}
+
+/*
+ * Compares the throughput of the built-in hash functions on the workload's
+ * keys. String keys are hashed both as NUL terminated strings and as fixed
+ * length keys, integer keys are hashed both by value and by address.
+ */
+void bench_hash(const BenchWorkload *w)
+{
+    if (w->dist == BENCH_DIST_STRING) {
+        int len = strlen(w->keys[0]);
+
+        run(w, "djb2-string", STRING_HASH,     KEY_LENGTH_VARIABLE);
+        run(w, "wy-string",   WY_STRING_HASH,  KEY_LENGTH_VARIABLE);
+        run(w, "sip-string",  SIP_STRING_HASH, KEY_LENGTH_VARIABLE);
+        run(w, "murmur3",     GENERAL_HASH,    len);
+        run(w, "wy",          WY_HASH,         len);
+        run(w, "sip",         SIP_HASH,        len);
+        return;
+    }
+    run(w, "murmur3",     GENERAL_HASH,    sizeof(uint64_t));
+    run(w, "wy",          WY_HASH,         sizeof(uint64_t));
+    run(w, "sip",         SIP_HASH,        sizeof(uint64_t));
+    run(w, "murmur3-ptr", POINTER_HASH,    KEY_LENGTH_POINTER);
+    run(w, "wy-ptr",      WY_POINTER_HASH, KEY_LENGTH_POINTER);
+}
@@ -0,0 +1,90 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2016 Srđan Panić <i@srdja.me>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hashmap.h"
+#include "bench.h"
+
+#define U64_EQ(a, b) ((a) == (b))
+
+CC_HASHMAP_DEFINE(U64Map, uint64_t, uint64_t, cc_hashmap_hash_u64, U64_EQ)
+
+#define KEY(p) (*(uint64_t*) (p))
+
+/*
+ * The same operations as the hashtable_oa suite, on a map that stores the
+ * integer keys by value. Not run on string keys.
+ */
+void bench_hashmap(const BenchWorkload *w)
+{
+    BenchTimer   t;
+    U64Map      *map;
+    size_t       i;
+
+    if (w->dist == BENCH_DIST_STRING)
+        return;
+
+    HashMapConf conf;
+    hashmap_conf_init(&conf);
+
+    conf.mem_alloc  = bench_malloc;
+    conf.mem_calloc = bench_calloc;
+    conf.mem_free   = bench_free;
+
+    if (U64Map_new_conf(&conf, &map) != CC_OK)
+        return;
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        U64Map_add(map, KEY(w->keys[i]), i);
+    bench_stop(&t, w, "hashmap", "insert", w->n);
+
+    U64Map *reserved;
+    if (U64Map_new_conf(&conf, &reserved) == CC_OK) {
+        bench_start(&t);
+        U64Map_reserve(reserved, w->n);
+        for (i = 0; i < w->n; i++)
+            U64Map_add(reserved, KEY(w->keys[i]), i);
+        bench_stop(&t, w, "hashmap", "insert-reserved", w->n);
+        U64Map_destroy(reserved);
+    }
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++) {
+        uint64_t v;
+        if (U64Map_get(map, KEY(w->stream[i]), &v) == CC_OK)
+            bench_sink += v;
+    }
+    bench_stop(&t, w, "hashmap", "lookup", w->n);
+
+    bench_start(&t);
+    U64MapIter   iter;
+    U64MapEntry *e;
+    U64Map_iter_init(&iter, map);
+    while (U64Map_iter_next(&iter, &e) != CC_ITER_END)
+        bench_sink += e->value;
+    bench_stop(&t, w, "hashmap", "iterate", w->n);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        U64Map_remove(map, KEY(w->keys[w->order[i]]), NULL);
+    bench_stop(&t, w, "hashmap", "remove", w->n);
+
+    U64Map_destroy(map);
+}
@@ -0,0 +1,141 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2016 Srđan Panić <i@srdja.me>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hashset.h"
+#include "bench.h"
+
+/* Number of elements per hashset_contains_batch call */
+#define BATCH 256
+
+void bench_hashset(const BenchWorkload *w)
+{
+    BenchTimer t;
+    HashSet   *set;
+    size_t     i;
+
+    HashSetConf conf;
+    hashset_conf_init(&conf);
+
+    conf.hash        = w->hash;
+    conf.key_compare = w->cmp;
+    conf.key_length  = w->key_length;
+    conf.mem_alloc   = bench_malloc;
+    conf.mem_calloc  = bench_calloc;
+    conf.mem_free    = bench_free;
+
+    if (hashset_new_conf(&conf, &set) != CC_OK)
+        return;
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        hashset_add(set, w->keys[i]);
+    bench_stop(&t, w, "hashset", "insert", w->n);
+
+    HashSet *loaded;
+    if (hashset_new_conf(&conf, &loaded) == CC_OK) {
+        bench_start(&t);
+        hashset_add_all_from_array(loaded, w->keys, w->n);
+        bench_stop(&t, w, "hashset", "bulk-add", w->n);
+        hashset_destroy(loaded);
+    }
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        bench_sink += hashset_contains(set, w->stream[i]);
+    bench_stop(&t, w, "hashset", "lookup", w->n);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i += BATCH) {
+        size_t len = w->n - i < BATCH ? w->n - i : BATCH;
+        bench_sink += hashset_contains_batch(set, w->stream + i, len, NULL);
+    }
+    bench_stop(&t, w, "hashset", "lookup-batch", w->n);
+
+    bench_start(&t);
+    HashSetIter iter;
+    void       *e;
+    hashset_iter_init(&iter, set);
+    while (hashset_iter_next(&iter, &e) != CC_ITER_END)
+        bench_sink += (uintptr_t) e;
+    bench_stop(&t, w, "hashset", "iterate", w->n);
+
+    /* set algebra against a set that holds a tenth of the keys */
+    HashSet *other;
+    HashSet *r;
+    hashset_new_conf(&conf, &other);
+    for (i = 0; i < w->n / 10; i++)
+        hashset_add(other, w->keys[w->order[i]]);
+
+    bench_start(&t);
+    if (hashset_union(set, other, &r) == CC_OK)
+        hashset_destroy(r);
+    bench_stop(&t, w, "hashset", "union", w->n);
+
+    bench_start(&t);
+    if (hashset_intersection(set, other, &r) == CC_OK)
+        hashset_destroy(r);
+    bench_stop(&t, w, "hashset", "intersection", w->n);
+
+    /* the same intersection written with the iterator */
+    bench_start(&t);
+    if (hashset_new_conf(&conf, &r) == CC_OK) {
+        hashset_iter_init(&iter, set);
+        while (hashset_iter_next(&iter, &e) != CC_ITER_END) {
+            if (hashset_contains(other, e))
+                hashset_add(r, e);
+        }
+        hashset_destroy(r);
+    }
+    bench_stop(&t, w, "hashset", "intersection-loop", w->n);
+
+    bench_start(&t);
+    if (hashset_difference(set, other, &r) == CC_OK)
+        hashset_destroy(r);
+    bench_stop(&t, w, "hashset", "difference", w->n);
+
+    if (hashset_union(other, other, &r) == CC_OK) {
+        bench_start(&t);
+        hashset_union_mut(r, set);
+        bench_stop(&t, w, "hashset", "union-mut", w->n);
+        hashset_destroy(r);
+    }
+
+    if (hashset_union(set, set, &r) == CC_OK) {
+        bench_start(&t);
+        hashset_intersection_mut(r, other);
+        bench_stop(&t, w, "hashset", "intersection-mut", w->n);
+        hashset_destroy(r);
+    }
+
+    if (hashset_union(set, set, &r) == CC_OK) {
+        bench_start(&t);
+        hashset_difference_mut(r, other);
+        bench_stop(&t, w, "hashset", "difference-mut", w->n);
+        hashset_destroy(r);
+    }
+    hashset_destroy(other);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        hashset_remove(set, w->keys[w->order[i]], NULL);
+    bench_stop(&t, w, "hashset", "remove", w->n);
+
+    hashset_destroy(set);
+}
@@ -0,0 +1,176 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2016 Srđan Panić <i@srdja.me>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hashtable.h"
+#include "bench.h"
+
+/* Number of keys per hashtable_get_batch call */
+#define BATCH 256
+
+static void new_table(const BenchWorkload *w, enum cc_hashtable_backend backend,
+                      float min_load_factor, HashTable **out)
+{
+    HashTableConf conf;
+    hashtable_conf_init(&conf);
+
+    conf.backend         = backend;
+    conf.min_load_factor = min_load_factor;
+    conf.hash        = w->hash;
+    conf.key_compare = w->cmp;
+    conf.key_length  = w->key_length;
+    conf.mem_alloc   = bench_malloc;
+    conf.mem_calloc  = bench_calloc;
+    conf.mem_free    = bench_free;
+
+    hashtable_new_conf(&conf, out);
+}
+
+static bool every_other(const void *key, void *value, void *ctx)
+{
+    return (*(size_t*) ctx)++ & 1;
+}
+
+static void run(const BenchWorkload *w, enum cc_hashtable_backend backend,
+                const char *name)
+{
+    BenchTimer t;
+    HashTable *table;
+    size_t     i;
+
+    new_table(w, backend, 0, &table);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        hashtable_add(table, w->keys[i], w->keys[i]);
+    bench_stop(&t, w, name, "insert", w->n);
+
+    HashTable *loaded;
+
+    new_table(w, backend, 0, &loaded);
+    bench_start(&t);
+    hashtable_reserve(loaded, w->n);
+    for (i = 0; i < w->n; i++)
+        hashtable_add(loaded, w->keys[i], w->keys[i]);
+    bench_stop(&t, w, name, "insert-reserved", w->n);
+    hashtable_destroy(loaded);
+
+    new_table(w, backend, 0, &loaded);
+    bench_start(&t);
+    hashtable_add_all_from_arrays(loaded, w->keys, w->keys, w->n);
+    bench_stop(&t, w, name, "bulk-add", w->n);
+    hashtable_destroy(loaded);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++) {
+        void *v;
+        if (hashtable_get(table, w->stream[i], &v) == CC_OK)
+            bench_sink += (uintptr_t) v;
+    }
+    bench_stop(&t, w, name, "lookup", w->n);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i += BATCH) {
+        void  *v[BATCH];
+        size_t len = w->n - i < BATCH ? w->n - i : BATCH;
+
+        v[0] = NULL;
+        hashtable_get_batch(table, w->stream + i, len, v, NULL);
+        bench_sink += (uintptr_t) v[0];
+    }
+    bench_stop(&t, w, name, "lookup-batch", w->n);
+
+    bench_start(&t);
+    HashTableIter iter;
+    TableEntry   *entry;
+    hashtable_iter_init(&iter, table);
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END)
+        bench_sink += (uintptr_t) entry->value;
+    bench_stop(&t, w, name, "iterate", w->n);
+
+    bench_start(&t);
+    Array *keys;
+    if (hashtable_get_keys(table, &keys) == CC_OK) {
+        bench_sink += array_size(keys);
+        array_destroy(keys);
+    }
+    bench_stop(&t, w, name, "bulk-copy", w->n);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        hashtable_remove(table, w->keys[w->order[i]], NULL);
+    bench_stop(&t, w, name, "remove", w->n);
+
+    /* the same removals with the shrink policy enabled */
+    new_table(w, backend, 0.1f, &loaded);
+    for (i = 0; i < w->n; i++)
+        hashtable_add(loaded, w->keys[i], w->keys[i]);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        hashtable_remove(loaded, w->keys[w->order[i]], NULL);
+    bench_stop(&t, w, name, "remove-shrink", w->n);
+    hashtable_destroy(loaded);
+
+    /* iterate over the 1% of the keys that are left after a bulk delete */
+    for (i = 0; i < w->n; i++)
+        hashtable_add(table, w->keys[i], w->keys[i]);
+    for (i = 0; i < w->n; i++) {
+        if (i % 100)
+            hashtable_remove(table, w->keys[w->order[i]], NULL);
+    }
+
+    bench_start(&t);
+    hashtable_iter_init(&iter, table);
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END)
+        bench_sink += (uintptr_t) entry->value;
+    bench_stop(&t, w, name, "iterate-sparse", hashtable_size(table));
+
+    /* expiry sweeps that remove every other entry */
+    for (i = 0; i < w->n; i++)
+        hashtable_add(table, w->keys[i], w->keys[i]);
+
+    bench_start(&t);
+    hashtable_iter_init(&iter, table);
+    for (i = 0; hashtable_iter_next(&iter, &entry) != CC_ITER_END; i++) {
+        if (i & 1)
+            hashtable_iter_remove(&iter, NULL);
+    }
+    bench_stop(&t, w, name, "iter-remove", w->n);
+
+    for (i = 0; i < w->n; i++)
+        hashtable_add(table, w->keys[i], w->keys[i]);
+
+    size_t visited = 0;
+    bench_start(&t);
+    hashtable_retain(table, every_other, &visited);
+    bench_stop(&t, w, name, "retain", w->n);
+
+    hashtable_destroy(table);
+}
+
+void bench_hashtable(const BenchWorkload *w)
+{
+    run(w, HASHTABLE_CHAINED, "hashtable");
+}
+
+void bench_hashtable_oa(const BenchWorkload *w)
+{
+    run(w, HASHTABLE_OPEN_ADDRESSING, "hashtable_oa");
+}
@@ -0,0 +1,113 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2016 Srđan Panić <i@srdja.me>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "hashtable.h"
+#include "bench.h"
+
+/* Length of the prefix that all keys of this suite share */
+#define PREFIX_LENGTH 240
+
+static int counting_strcmp(const void *k1, const void *k2)
+{
+    bench_calls++;
+    return strcmp(k1, k2);
+}
+
+/*
+ * Builds n keys that share a long common prefix and differ only in a hex
+ * suffix of varying length, so that every comparison of two distinct keys
+ * runs over the whole prefix.
+ */
+static char **new_keys(size_t n)
+{
+    char  **keys = malloc(n * sizeof(char*));
+    size_t  i;
+
+    for (i = 0; i < n; i++) {
+        keys[i] = malloc(PREFIX_LENGTH + 17);
+        memset(keys[i], 'p', PREFIX_LENGTH);
+        sprintf(keys[i] + PREFIX_LENGTH, "%llx",
+                (unsigned long long) (bench_rand() >> (bench_rand() & 31)));
+    }
+    return keys;
+}
+
+static void free_keys(char **keys, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++)
+        free(keys[i]);
+    free(keys);
+}
+
+static void run(const BenchWorkload *w, char **keys, char **misses,
+                bool cache_key_length, const char *hit_op, const char *miss_op)
+{
+    HashTableConf conf;
+    HashTable    *table;
+    BenchTimer    t;
+    size_t        i;
+
+    hashtable_conf_init(&conf);
+    conf.key_compare      = counting_strcmp;
+    conf.cache_key_length = cache_key_length;
+    conf.mem_alloc        = bench_malloc;
+    conf.mem_calloc       = bench_calloc;
+    conf.mem_free         = bench_free;
+
+    hashtable_new_conf(&conf, &table);
+
+    for (i = 0; i < w->n; i++)
+        hashtable_add(table, keys[i], keys[i]);
+
+    bench_start_counted(&t);
+    for (i = 0; i < w->n; i++) {
+        void *v;
+        if (hashtable_get(table, keys[w->probe[i]], &v) == CC_OK)
+            bench_sink += (uintptr_t) v;
+    }
+    bench_stop(&t, w, "hashtable", hit_op, w->n);
+
+    bench_start_counted(&t);
+    for (i = 0; i < w->n; i++)
+        bench_sink += hashtable_contains_key(table, misses[i]);
+    bench_stop(&t, w, "hashtable", miss_op, w->n);
+
+    hashtable_destroy(table);
+}
+
+/*
+ * Counts the key comparator calls of hits and misses on long keys with a
+ * shared prefix, where every call is expensive.
+ */
+void bench_keycmp(const BenchWorkload *w)
+{
+    char **keys   = new_keys(w->n);
+    char **misses = new_keys(w->n);
+
+    run(w, keys, misses, false, "hit",           "miss");
+    run(w, keys, misses, true,  "hit-cachedlen", "miss-cachedlen");
+
+    free_keys(keys, w->n);
+    free_keys(misses, w->n);
+}
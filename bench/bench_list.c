@@ -0,0 +1,84 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2016 Srđan Panić <i@srdja.me>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "list.h"
+#include "bench.h"
+
+/* list_get_at is a linear walk, so the number of lookups is capped to keep
+ * the large sizes from taking quadratic time. */
+#define MAX_LOOKUPS 1000
+
+void bench_list(const BenchWorkload *w)
+{
+    ListConf conf;
+    list_conf_init(&conf);
+
+    conf.mem_alloc  = bench_malloc;
+    conf.mem_calloc = bench_calloc;
+    conf.mem_free   = bench_free;
+
+    BenchTimer t;
+    List      *list;
+    size_t     i;
+
+    list_new_conf(&conf, &list);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        list_add(list, w->stream[i]);
+    bench_stop(&t, w, "list", "insert", w->n);
+
+    size_t lookups = w->n < MAX_LOOKUPS ? w->n : MAX_LOOKUPS;
+
+    bench_start(&t);
+    for (i = 0; i < lookups; i++) {
+        void *e;
+        if (list_get_at(list, w->probe[i], &e) == CC_OK)
+            bench_sink += (uintptr_t) e;
+    }
+    bench_stop(&t, w, "list", "lookup", lookups);
+
+    bench_start(&t);
+    ListIter iter;
+    void    *e;
+    list_iter_init(&iter, list);
+    while (list_iter_next(&iter, &e) != CC_ITER_END)
+        bench_sink += (uintptr_t) e;
+    bench_stop(&t, w, "list", "iterate", w->n);
+
+    List *copy;
+
+    bench_start(&t);
+    list_copy_shallow(list, &copy);
+    bench_stop(&t, w, "list", "bulk-copy", w->n);
+
+    bench_start(&t);
+    list_sort_in_place(copy, w->cmp_indirect);
+    bench_stop(&t, w, "list", "sort", w->n);
+
+    list_destroy(copy);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        list_remove_first(list, NULL);
+    bench_stop(&t, w, "list", "remove", w->n);
+
+    list_destroy(list);
+}
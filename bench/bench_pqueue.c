@@ -0,0 +1,53 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2016 Srđan Panić <i@srdja.me>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pqueue.h"
+#include "bench.h"
+
+void bench_pqueue(const BenchWorkload *w)
+{
+    PQueueConf conf;
+    pqueue_conf_init(&conf, w->cmp);
+
+    conf.mem_alloc  = bench_malloc;
+    conf.mem_calloc = bench_calloc;
+    conf.mem_free   = bench_free;
+
+    BenchTimer t;
+    PQueue    *pq;
+    size_t     i;
+
+    pqueue_new_conf(&conf, &pq);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        pqueue_push(pq, w->stream[i]);
+    bench_stop(&t, w, "pqueue", "insert", w->n);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++) {
+        void *e;
+        if (pqueue_pop(pq, &e) == CC_OK)
+            bench_sink += (uintptr_t) e;
+    }
+    bench_stop(&t, w, "pqueue", "remove", w->n);
+
+    pqueue_destroy(pq);
+}
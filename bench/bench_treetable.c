@@ -0,0 +1,68 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2016 Srđan Panić <i@srdja.me>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "treetable.h"
+#include "bench.h"
+
+static void sink_value(void *v)
+{
+    bench_sink += (uintptr_t) v;
+}
+
+void bench_treetable(const BenchWorkload *w)
+{
+    TreeTableConf conf;
+    treetable_conf_init(&conf);
+
+    conf.cmp        = w->cmp;
+    conf.mem_alloc  = bench_malloc;
+    conf.mem_calloc = bench_calloc;
+    conf.mem_free   = bench_free;
+
+    BenchTimer t;
+    TreeTable *table;
+    size_t     i;
+
+    treetable_new_conf(&conf, &table);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        treetable_add(table, w->keys[i], w->keys[i]);
+    bench_stop(&t, w, "treetable", "insert", w->n);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++) {
+        void *v;
+        if (treetable_get(table, w->stream[i], &v) == CC_OK)
+            bench_sink += (uintptr_t) v;
+    }
+    bench_stop(&t, w, "treetable", "lookup", w->n);
+
+    bench_start(&t);
+    treetable_foreach_value(table, sink_value);
+    bench_stop(&t, w, "treetable", "iterate", w->n);
+
+    bench_start(&t);
+    for (i = 0; i < w->n; i++)
+        treetable_remove(table, w->keys[w->order[i]], NULL);
+    bench_stop(&t, w, "treetable", "remove", w->n);
+
+    treetable_destroy(table);
+}
@@ -18,10 +18,22 @@
  * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* mremap */
+#endif
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
 #include "array.h"
+#include "sort_internal.h"
+#include "thread_pool_internal.h"
 
 #define DEFAULT_CAPACITY 8
 #define DEFAULT_EXPANSION_FACTOR 2
+#define DEFAULT_GRAIN 16384
+#define HUGE_PAGE_SIZE ((size_t) 2 * 1024 * 1024)
 
 struct array_s {
     size_t   size;
@@ -32,9 +44,18 @@ struct array_s {
     void *(*mem_alloc)  (size_t size);
     void *(*mem_calloc) (size_t blocks, size_t size);
     void  (*mem_free)   (void *block);
+    void *(*mem_realloc) (void *block, size_t size);
+
+    size_t   mmap_threshold;
+
+    /* Size of the mapping if the buffer was mapped with mmap(), 0 if it
+     * was allocated with mem_alloc. */
+    size_t   mapped_size;
 };
 
 static enum cc_stat expand_capacity(Array *ar);
+static enum cc_stat resize_buffer  (Array *ar, size_t capacity);
+static void         free_buffer    (Array *ar);
 
 
 /**
@@ -89,20 +110,18 @@ enum cc_stat array_new_conf(ArrayConf const * const conf, Array **out)
     if (!ar)
         return CC_ERR_ALLOC;
 
-    void **buff = conf->mem_alloc(conf->capacity * sizeof(void*));
+    ar->exp_factor     = ex;
+    ar->mem_alloc      = conf->mem_alloc;
+    ar->mem_calloc     = conf->mem_calloc;
+    ar->mem_free       = conf->mem_free;
+    ar->mem_realloc    = conf->mem_realloc;
+    ar->mmap_threshold = conf->mmap_threshold;
 
-    if (!buff) {
+    if (resize_buffer(ar, conf->capacity) != CC_OK) {
         conf->mem_free(ar);
         return CC_ERR_ALLOC;
     }
 
-    ar->buffer     = buff;
-    ar->exp_factor = ex;
-    ar->capacity   = conf->capacity;
-    ar->mem_alloc  = conf->mem_alloc;
-    ar->mem_calloc = conf->mem_calloc;
-    ar->mem_free   = conf->mem_free;
-
     *out = ar;
     return CC_OK;
 }
@@ -119,6 +138,8 @@ void array_conf_init(ArrayConf *conf)
     conf->mem_alloc  = malloc;
     conf->mem_calloc = calloc;
     conf->mem_free   = free;
+    conf->mem_realloc    = NULL;
+    conf->mmap_threshold = 0;
 }
 
 /**
@@ -128,7 +149,7 @@ void array_conf_init(ArrayConf *conf)
  */
 void array_destroy(Array *ar)
 {
-    ar->mem_free(ar->buffer);
+    free_buffer(ar);
     ar->mem_free(ar);
 }
 
@@ -481,6 +502,8 @@ enum cc_stat array_subarray(Array *ar, size_t b, size_t e, Array **out)
     sub_ar->mem_alloc  = ar->mem_alloc;
     sub_ar->mem_calloc = ar->mem_calloc;
     sub_ar->mem_free   = ar->mem_free;
+    sub_ar->mem_realloc    = ar->mem_realloc;
+    sub_ar->mmap_threshold = ar->mmap_threshold;
     sub_ar->size       = e - b + 1;
     sub_ar->capacity   = sub_ar->size;
 
@@ -522,6 +545,9 @@ enum cc_stat array_copy_shallow(Array *ar, Array **out)
     copy->mem_alloc  = ar->mem_alloc;
     copy->mem_calloc = ar->mem_calloc;
     copy->mem_free   = ar->mem_free;
+    copy->mem_realloc    = ar->mem_realloc;
+    copy->mmap_threshold = ar->mmap_threshold;
+    copy->mapped_size    = 0;
 
     memcpy(copy->buffer,
            ar->buffer,
@@ -564,6 +590,9 @@ enum cc_stat array_copy_deep(Array *ar, void *(*cp) (void *), Array **out)
     copy->mem_alloc  = ar->mem_alloc;
     copy->mem_calloc = ar->mem_calloc;
     copy->mem_free   = ar->mem_free;
+    copy->mem_realloc    = ar->mem_realloc;
+    copy->mmap_threshold = ar->mmap_threshold;
+    copy->mapped_size    = 0;
 
     size_t i;
     for (i = 0; i < copy->size; i++)
@@ -659,6 +688,9 @@ enum cc_stat array_filter(Array *ar, bool (*pred) (const void*), Array **out)
     filtered->mem_alloc  = ar->mem_alloc;
     filtered->mem_calloc = ar->mem_calloc;
     filtered->mem_free   = ar->mem_free;
+    filtered->mem_realloc    = ar->mem_realloc;
+    filtered->mmap_threshold = ar->mmap_threshold;
+    filtered->mapped_size    = 0;
 
     size_t f = 0;
     for (size_t i = 0; i < ar->size; i++) {
@@ -703,23 +735,12 @@ void array_reverse(Array *ar)
  */
 enum cc_stat array_trim_capacity(Array *ar)
 {
-    if (ar->size == ar->capacity)
-        return CC_OK;
-
-    void **new_buff = ar->mem_calloc(ar->size, sizeof(void*));
+    size_t capacity = ar->size < 1 ? 1 : ar->size;
 
-    if (!new_buff)
-        return CC_ERR_ALLOC;
-
-    size_t size = ar->size < 1 ? 1 : ar->size;
-
-    memcpy(new_buff, ar->buffer, size * sizeof(void*));
-    ar->mem_free(ar->buffer);
-
-    ar->buffer   = new_buff;
-    ar->capacity = ar->size;
+    if (capacity == ar->capacity)
+        return CC_OK;
 
-    return CC_OK;
+    return resize_buffer(ar, capacity);
 }
 
 /**
@@ -821,7 +842,48 @@ size_t array_capacity(Array *ar)
  */
 void array_sort(Array *ar, int (*cmp) (const void*, const void*))
 {
-    qsort(ar->buffer, ar->size, sizeof(void*), cmp);
+    sort_pdq(ar->buffer, ar->size, cmp);
+}
+
+/**
+ * Sorts the array like array_sort(), except that elements that compare
+ * equal keep their order. Sorts in linear time when the array is made of
+ * a few sorted runs, such as a sorted array with some elements appended.
+ *
+ * The sort needs a scratch buffer of up to half the size of the array,
+ * which is allocated with the array's allocator.
+ *
+ * @param[in] ar  array to be sorted
+ * @param[in] cmp the comparator function, as with array_sort()
+ *
+ * @return CC_OK if the array was sorted, or CC_ERR_ALLOC if the memory
+ * allocation for the scratch buffer failed, in which case the array holds
+ * the same elements in an unspecified order.
+ */
+enum cc_stat array_sort_stable(Array *ar, int (*cmp) (const void*, const void*))
+{
+    return sort_tim(ar->buffer, ar->size, cmp, ar->mem_alloc, ar->mem_free);
+}
+
+/**
+ * Sorts the array in ascending order of the keys returned by key, which is
+ * called once for every element. The elements are sorted with a radix sort
+ * that makes a pass over the array for every byte in which the keys differ,
+ * without any comparisons. Elements with equal keys keep their order.
+ *
+ * Signed keys can be sorted by flipping their sign bit, eg.
+ * <code>(uint64_t) k ^ (1ULL << 63)</code>.
+ *
+ * @param[in] ar  array to be sorted
+ * @param[in] key function that returns the key of an element
+ *
+ * @return CC_OK if the array was sorted, or CC_ERR_ALLOC if the memory
+ * allocation for the scratch buffer failed, in which case the array is left
+ * unchanged.
+ */
+enum cc_stat array_sort_by_key(Array *ar, uint64_t (*key) (const void*))
+{
+    return sort_radix_u64(ar->buffer, ar->size, key, ar->mem_alloc, ar->mem_free);
 }
 
 /**
@@ -846,23 +908,187 @@ static enum cc_stat expand_capacity(Array *ar)
     /* As long as the capacity is greater that the expansion factor
      * at the point of overflow, this is check is valid. */
     if (new_capacity <= ar->capacity)
-        ar->capacity = CC_MAX_ELEMENTS;
-    else
-        ar->capacity = new_capacity;
+        new_capacity = CC_MAX_ELEMENTS;
+
+    return resize_buffer(ar, new_capacity);
+}
+
+#if !defined(_WIN32)
+/**
+ * Maps length bytes of anonymous memory at an address aligned to
+ * HUGE_PAGE_SIZE, so that the kernel can back the whole mapping with
+ * huge pages.
+ *
+ * @param[in] length size of the mapping, a multiple of HUGE_PAGE_SIZE
+ *
+ * @return the start of the mapping, or NULL if it could not be mapped.
+ */
+static void *map_huge(size_t length)
+{
+    if (length > SIZE_MAX - HUGE_PAGE_SIZE)
+        return NULL;
+
+    /* Over-map by one huge page and unmap whatever lies outside of the
+     * aligned range. */
+    size_t span = length + HUGE_PAGE_SIZE;
+    char  *p    = mmap(NULL, span, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (p == MAP_FAILED)
+        return NULL;
+
+    char  *start = (char*) (((uintptr_t) p + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+    size_t head  = start - p;
+    size_t tail  = span - head - length;
+
+    if (head)
+        munmap(p, head);
+    if (tail)
+        munmap(start + length, tail);
+
+#ifdef MADV_HUGEPAGE
+    madvise(start, length, MADV_HUGEPAGE);
+#endif
+    return start;
+}
+
+/**
+ * Moves the buffer into a mapping of at least bytes bytes, aligned to
+ * HUGE_PAGE_SIZE. Where mremap() is available, a mapped buffer is shrunk in
+ * place or has its pages moved into the new aligned range instead of
+ * copied. Otherwise the elements are copied into a new mapping and the old
+ * buffer is released.
+ *
+ * @param[in] ar the array whose buffer is being mapped
+ * @param[in] bytes the minimum size of the new buffer
+ * @param[out] length the size of the new mapping
+ *
+ * @return the new buffer, or NULL if it could not be mapped.
+ */
+static void **map_buffer(Array *ar, size_t bytes, size_t *length)
+{
+    if (bytes > SIZE_MAX - HUGE_PAGE_SIZE)
+        return NULL;
+
+    size_t len = (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+
+    *length = len;
+
+    if (len == ar->mapped_size)
+        return ar->buffer;
+
+#if defined(MREMAP_MAYMOVE) && defined(MREMAP_FIXED)
+    /* Shrinking in place keeps the start of the mapping aligned. */
+    if (len < ar->mapped_size) {
+        if (mremap(ar->buffer, ar->mapped_size, len, 0) == MAP_FAILED)
+            return NULL;
+        return ar->buffer;
+    }
+#endif
+    void **p = map_huge(len);
+
+    if (!p)
+        return NULL;
+
+#if defined(MREMAP_MAYMOVE) && defined(MREMAP_FIXED)
+    /* Move the pages into the aligned range, replacing the fresh mapping,
+     * instead of copying them. */
+    if (ar->mapped_size) {
+        void *moved = mremap(ar->buffer, ar->mapped_size, len,
+                             MREMAP_MAYMOVE | MREMAP_FIXED, p);
+
+        if (moved == MAP_FAILED) {
+            munmap(p, len);
+            return NULL;
+        }
+#ifdef MADV_HUGEPAGE
+        madvise(moved, len, MADV_HUGEPAGE);
+#endif
+        return moved;
+    }
+#endif
 
-    void **new_buff = ar->mem_alloc(new_capacity * sizeof(void*));
+    if (ar->size)
+        memcpy(p, ar->buffer, ar->size * sizeof(void*));
 
-    if (!new_buff)
+    free_buffer(ar);
+    return p;
+}
+#endif
+
+/**
+ * Resizes the Array buffer to the given capacity, keeping the elements
+ * that are currently stored. Buffers above the mmap threshold are mapped
+ * directly, the rest are resized with mem_realloc if the array has one,
+ * or are copied into a new block from mem_alloc otherwise.
+ *
+ * @param[in] ar the array whose buffer is being resized
+ * @param[in] capacity the new capacity, at least the size of the array
+ *
+ * @return CC_OK if the buffer was resized, or CC_ERR_ALLOC if the new
+ * buffer could not be allocated, in which case the array is left
+ * unchanged.
+ */
+static enum cc_stat resize_buffer(Array *ar, size_t capacity)
+{
+    if (capacity > SIZE_MAX / sizeof(void*))
         return CC_ERR_ALLOC;
 
-    memcpy(new_buff, ar->buffer, ar->size * sizeof(void*));
+    size_t bytes = capacity * sizeof(void*);
+    void **buff;
 
-    ar->mem_free(ar->buffer);
-    ar->buffer = new_buff;
+#if !defined(_WIN32)
+    /* Once mapped, the buffer stays mapped even if it is trimmed below
+     * the threshold. */
+    if (ar->mapped_size || (ar->mmap_threshold && bytes >= ar->mmap_threshold)) {
+        size_t length;
+
+        if (!(buff = map_buffer(ar, bytes, &length)))
+            return CC_ERR_ALLOC;
+
+        ar->buffer      = buff;
+        ar->capacity    = capacity;
+        ar->mapped_size = length;
+
+        return CC_OK;
+    }
+#endif
+
+    if (ar->mem_realloc && ar->buffer) {
+        if (!(buff = ar->mem_realloc(ar->buffer, bytes)))
+            return CC_ERR_ALLOC;
+    } else {
+        if (!(buff = ar->mem_alloc(bytes)))
+            return CC_ERR_ALLOC;
+
+        if (ar->size)
+            memcpy(buff, ar->buffer, ar->size * sizeof(void*));
+        if (ar->buffer)
+            ar->mem_free(ar->buffer);
+    }
+    ar->buffer   = buff;
+    ar->capacity = capacity;
 
     return CC_OK;
 }
 
+/**
+ * Releases the Array buffer.
+ *
+ * @param[in] ar the array whose buffer is being released
+ */
+static void free_buffer(Array *ar)
+{
+#if !defined(_WIN32)
+    if (ar->mapped_size) {
+        munmap(ar->buffer, ar->mapped_size);
+        ar->mapped_size = 0;
+        return;
+    }
+#endif
+    ar->mem_free(ar->buffer);
+}
+
 /**
  * Applies the function fn to each element of the Array.
  *
@@ -900,6 +1126,470 @@ void array_reduce(Array *ar, void (*fn) (void*, void*, void*), void *result)
         fn(result, ar->buffer[i], result);
 }
 
+/*
+ * Parallel operations. Every operation splits the array into tasks of
+ * grain elements, or into one task per thread in the case of sorting, and
+ * runs them on a thread pool that lives for the duration of the call.
+ */
+
+typedef struct par_job_s {
+    Array   *ar;
+    size_t   grain;
+    size_t   tasks;
+
+    /* map and filter */
+    void   (*map)       (void *e);
+    bool   (*pred)      (const void *e);
+    uint8_t *keep;
+    size_t  *counts;
+    void   **out;
+
+    /* reduce */
+    void   (*fold)      (void *acc, void *e);
+    uint8_t *accs;
+    size_t   acc_size;
+
+    /* sort */
+    int    (*cmp)       (const void*, const void*);
+    void   **src;
+    void   **dst;
+    size_t   width;
+    size_t   piece;
+    size_t   pieces;
+} ParJob;
+
+/**
+ * Initializes the fields of the ArrayParConf struct to default values.
+ *
+ * @param[in, out] conf ArrayParConf structure that is being initialized
+ */
+void array_par_conf_init(ArrayParConf *conf)
+{
+    conf->threads = thread_pool_cpus();
+    conf->grain   = DEFAULT_GRAIN;
+}
+
+/**
+ * Returns the number of grain sized tasks the first n elements are split
+ * into, and stores the grain in job.
+ */
+static size_t par_tasks(ParJob *job, ArrayParConf const *conf, size_t n)
+{
+    job->grain = conf->grain ? conf->grain : 1;
+    job->tasks = n / job->grain + (n % job->grain != 0);
+
+    return job->tasks;
+}
+
+/**
+ * Returns a pool for running the given number of tasks, or NULL if they
+ * should run on the calling thread.
+ */
+static ThreadPool *par_pool(Array *ar, ArrayParConf const *conf, size_t tasks)
+{
+    ThreadPool *pool    = NULL;
+    size_t      threads = conf->threads < tasks ? conf->threads : tasks;
+
+    if (threads > 1)
+        thread_pool_new(threads - 1, ar->mem_alloc, ar->mem_free, &pool);
+
+    return pool;
+}
+
+/**
+ * Runs the tasks of the job on a pool that is created for them.
+ */
+static void par_run(ParJob *job, ArrayParConf const *conf, void (*fn) (size_t, void*))
+{
+    ThreadPool *pool = par_pool(job->ar, conf, job->tasks);
+
+    thread_pool_run(pool, job->tasks, fn, job);
+
+    if (pool)
+        thread_pool_destroy(pool);
+}
+
+static INLINE size_t task_start(ParJob *job, size_t task)
+{
+    return task * job->grain;
+}
+
+static INLINE size_t task_end(ParJob *job, size_t task)
+{
+    size_t end = (task + 1) * job->grain;
+    return end < job->ar->size ? end : job->ar->size;
+}
+
+static void map_task(size_t task, void *arg)
+{
+    ParJob *job = arg;
+    size_t  i;
+
+    for (i = task_start(job, task); i < task_end(job, task); i++)
+        job->map(job->ar->buffer[i]);
+}
+
+/**
+ * Applies the function fn to each element of the Array, like array_map(),
+ * on multiple threads. fn may be called on different elements
+ * concurrently, and in no particular order.
+ *
+ * @param[in] ar   array on which this operation is performed
+ * @param[in] fn   operation function that is to be invoked on each Array
+ *                 element
+ * @param[in] conf the number of threads and the grain size
+ */
+void array_par_map(Array *ar, void (*fn) (void *e), ArrayParConf const *conf)
+{
+    ParJob job;
+
+    job.ar  = ar;
+    job.map = fn;
+
+    if (par_tasks(&job, conf, ar->size) > 0)
+        par_run(&job, conf, map_task);
+}
+
+static void reduce_task(size_t task, void *arg)
+{
+    ParJob *job = arg;
+    void   *acc = job->accs + task * job->acc_size;
+    size_t  i;
+
+    for (i = task_start(job, task); i < task_end(job, task); i++)
+        job->fold(acc, job->ar->buffer[i]);
+}
+
+/**
+ * Folds the elements of the Array into result on multiple threads. Every
+ * task starts from a copy of the value that result holds on entry, which
+ * must be an identity of combine, folds its elements into it with fn, and
+ * the partial results are then folded into result with combine, in the
+ * order of the tasks. combine must be associative, but needn't be
+ * commutative.
+ *
+ * For example, a sum of integer elements is computed with:
+ *
+ * @code
+ * void add(void *acc, void *e) { *(long*) acc += *(int*) e; }
+ * void combine(void *acc, const void *part) { *(long*) acc += *(const long*) part; }
+ *
+ * long sum = 0;
+ * array_par_reduce(ar, add, combine, &sum, sizeof(sum), &conf);
+ * @endcode
+ *
+ * @param[in] ar          the array on which this operation is performed
+ * @param[in] fn          function that folds an element into a partial
+ *                        result
+ * @param[in] combine     function that folds a partial result into another
+ * @param[in, out] result the identity on entry, and the result on return
+ * @param[in] result_size size of the result in bytes
+ * @param[in] conf        the number of threads and the grain size
+ *
+ * @return CC_OK if the array was reduced, or CC_ERR_ALLOC if the memory
+ * allocation for the partial results failed.
+ */
+enum cc_stat array_par_reduce(Array *ar, void (*fn) (void *acc, void *e),
+                              void (*combine) (void *acc, const void *part),
+                              void *result, size_t result_size,
+                              ArrayParConf const *conf)
+{
+    ParJob job;
+    size_t i;
+
+    job.ar       = ar;
+    job.fold     = fn;
+    job.acc_size = result_size;
+
+    if (par_tasks(&job, conf, ar->size) < 2) {
+        for (i = 0; i < ar->size; i++)
+            fn(result, ar->buffer[i]);
+        return CC_OK;
+    }
+
+    if (job.tasks > SIZE_MAX / (result_size ? result_size : 1))
+        return CC_ERR_ALLOC;
+
+    job.accs = ar->mem_alloc(job.tasks * result_size);
+
+    if (!job.accs)
+        return CC_ERR_ALLOC;
+
+    for (i = 0; i < job.tasks; i++)
+        memcpy(job.accs + i * result_size, result, result_size);
+
+    par_run(&job, conf, reduce_task);
+
+    for (i = 0; i < job.tasks; i++)
+        combine(result, job.accs + i * result_size);
+
+    ar->mem_free(job.accs);
+
+    return CC_OK;
+}
+
+static void filter_count_task(size_t task, void *arg)
+{
+    ParJob *job   = arg;
+    size_t  count = 0;
+    size_t  i;
+
+    for (i = task_start(job, task); i < task_end(job, task); i++) {
+        job->keep[i] = job->pred(job->ar->buffer[i]);
+        count += job->keep[i];
+    }
+    job->counts[task] = count;
+}
+
+static void filter_copy_task(size_t task, void *arg)
+{
+    ParJob *job = arg;
+    void  **out = job->out + job->counts[task];
+    size_t  i;
+
+    for (i = task_start(job, task); i < task_end(job, task); i++) {
+        if (job->keep[i])
+            *out++ = job->ar->buffer[i];
+    }
+}
+
+/**
+ * Filters the Array like array_filter(), on multiple threads. The
+ * predicate is evaluated concurrently on different elements, after which
+ * the kept elements are copied to their positions in the new Array, which
+ * are found with a prefix sum of the per task counts. The new Array keeps
+ * the order of the elements.
+ *
+ * @param[in] ar   array that is to be filtered
+ * @param[in] pred predicate function which returns true if the element
+ *                 should be kept in the filtered array
+ * @param[in] conf the number of threads and the grain size
+ * @param[out] out pointer to where the new filtered Array is to be stored
+ *
+ * @return CC_OK if the Array was filtered successfully, CC_ERR_OUT_OF_RANGE
+ * if the Array is empty, or CC_ERR_ALLOC if a memory allocation failed.
+ */
+enum cc_stat array_par_filter(Array *ar, bool (*pred) (const void*),
+                              ArrayParConf const *conf, Array **out)
+{
+    if (ar->size == 0)
+        return CC_ERR_OUT_OF_RANGE;
+
+    ParJob job;
+
+    job.ar   = ar;
+    job.pred = pred;
+
+    par_tasks(&job, conf, ar->size);
+
+    job.keep   = ar->mem_alloc(ar->size);
+    job.counts = ar->mem_alloc(job.tasks * sizeof(size_t));
+
+    if (!job.keep || !job.counts) {
+        if (job.keep)
+            ar->mem_free(job.keep);
+        if (job.counts)
+            ar->mem_free(job.counts);
+        return CC_ERR_ALLOC;
+    }
+
+    ThreadPool *pool = par_pool(ar, conf, job.tasks);
+
+    thread_pool_run(pool, job.tasks, filter_count_task, &job);
+
+    /* Turn the counts into offsets */
+    size_t kept = 0;
+    size_t i;
+    for (i = 0; i < job.tasks; i++) {
+        size_t count = job.counts[i];
+        job.counts[i] = kept;
+        kept += count;
+    }
+
+    ArrayConf c;
+    Array    *filtered;
+
+    c.capacity   = kept ? kept : 1;
+    c.exp_factor = ar->exp_factor;
+    c.mem_alloc  = ar->mem_alloc;
+    c.mem_calloc = ar->mem_calloc;
+    c.mem_free   = ar->mem_free;
+    c.mem_realloc    = ar->mem_realloc;
+    c.mmap_threshold = ar->mmap_threshold;
+
+    enum cc_stat status = array_new_conf(&c, &filtered);
+
+    if (status == CC_OK) {
+        job.out = filtered->buffer;
+        thread_pool_run(pool, job.tasks, filter_copy_task, &job);
+        filtered->size = kept;
+        *out = filtered;
+    }
+
+    if (pool)
+        thread_pool_destroy(pool);
+
+    ar->mem_free(job.keep);
+    ar->mem_free(job.counts);
+
+    return status;
+}
+
+static void sort_chunk_task(size_t task, void *arg)
+{
+    ParJob *job   = arg;
+    size_t  start = task * job->width;
+    size_t  end   = start + job->width;
+
+    if (end > job->ar->size)
+        end = job->ar->size;
+
+    if (start < end)
+        sort_pdq(job->src + start, end - start, job->cmp);
+}
+
+/**
+ * Returns how many of the first k elements of the merge of the sorted runs
+ * a and b come from a, with ties going to a.
+ */
+static size_t merge_split(void **a, size_t na, void **b, size_t nb, size_t k,
+                          int (*cmp) (const void*, const void*))
+{
+    size_t lo = k > nb ? k - nb : 0;
+    size_t hi = k < na ? k : na;
+
+    while (lo < hi) {
+        size_t i = lo + (hi - lo) / 2;
+
+        if (cmp(&b[k - i - 1], &a[i]) < 0)
+            hi = i;
+        else
+            lo = i + 1;
+    }
+    return lo;
+}
+
+static void merge_task(size_t task, void *arg)
+{
+    ParJob *job  = arg;
+    size_t  n    = job->ar->size;
+    size_t  pair = task / job->pieces;
+    size_t  base = pair * 2 * job->width;
+
+    if (base >= n)
+        return;
+
+    void  **a  = job->src + base;
+    size_t  na = n - base < job->width ? n - base : job->width;
+    void  **b  = a + na;
+    size_t  nb = n - base - na < job->width ? n - base - na : job->width;
+
+    size_t k0 = (task % job->pieces) * job->piece;
+    size_t k1 = k0 + job->piece;
+
+    if (k0 >= na + nb)
+        return;
+    if (k1 > na + nb)
+        k1 = na + nb;
+
+    size_t i  = merge_split(a, na, b, nb, k0, job->cmp);
+    size_t i1 = merge_split(a, na, b, nb, k1, job->cmp);
+    size_t j  = k0 - i;
+    size_t j1 = k1 - i1;
+
+    void **out = job->dst + base + k0;
+
+    while (i < i1 && j < j1) {
+        if (job->cmp(&b[j], &a[i]) < 0)
+            *out++ = b[j++];
+        else
+            *out++ = a[i++];
+    }
+    while (i < i1)
+        *out++ = a[i++];
+    while (j < j1)
+        *out++ = b[j++];
+}
+
+/**
+ * Sorts the Array like array_sort(), on multiple threads. The array is
+ * split into one chunk per thread, the chunks are sorted concurrently, and
+ * then merged pairwise. Every merge is split into pieces of at least grain
+ * elements that are merged concurrently, so all threads stay busy up to
+ * the last merge. The sort is not stable.
+ *
+ * The merges need a scratch buffer of the size of the array, which is
+ * allocated with the array's allocator.
+ *
+ * @param[in] ar   array to be sorted
+ * @param[in] cmp  the comparator function, as with array_sort()
+ * @param[in] conf the number of threads and the grain size
+ *
+ * @return CC_OK if the array was sorted, or CC_ERR_ALLOC if the memory
+ * allocation for the scratch buffer failed, in which case the array is left
+ * unchanged.
+ */
+enum cc_stat array_par_sort(Array *ar, int (*cmp) (const void*, const void*),
+                            ArrayParConf const *conf)
+{
+    ParJob job;
+    size_t n = ar->size;
+
+    job.ar  = ar;
+    job.cmp = cmp;
+
+    size_t chunks = par_tasks(&job, conf, n);
+
+    if (chunks > conf->threads)
+        chunks = conf->threads;
+
+    if (chunks < 2) {
+        sort_pdq(ar->buffer, n, cmp);
+        return CC_OK;
+    }
+
+    void **scratch = ar->mem_alloc(n * sizeof(void*));
+
+    if (!scratch)
+        return CC_ERR_ALLOC;
+
+    ThreadPool *pool = par_pool(ar, conf, chunks);
+
+    job.src   = ar->buffer;
+    job.dst   = scratch;
+    job.width = n / chunks + (n % chunks != 0);
+
+    thread_pool_run(pool, chunks, sort_chunk_task, &job);
+
+    /* Aim for a few pieces per thread, but no smaller than a grain */
+    job.piece = n / (conf->threads * 4);
+    if (job.piece < job.grain)
+        job.piece = job.grain;
+
+    while (job.width < n) {
+        size_t pairs = n / (2 * job.width) + (n % (2 * job.width) != 0);
+
+        job.pieces = (2 * job.width) / job.piece + ((2 * job.width) % job.piece != 0);
+
+        thread_pool_run(pool, pairs * job.pieces, merge_task, &job);
+
+        void **tmp = job.src;
+        job.src    = job.dst;
+        job.dst    = tmp;
+        job.width *= 2;
+    }
+
+    if (pool)
+        thread_pool_destroy(pool);
+
+    if (job.src != ar->buffer)
+        memcpy(ar->buffer, job.src, n * sizeof(void*));
+
+    ar->mem_free(scratch);
+
+    return CC_OK;
+}
+
 /**
  * Initializes the iterator.
  *
@@ -0,0 +1,766 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2014 Srđan Panić <srdja.panic@gmail.com>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "array_sized.h"
+
+#define DEFAULT_CAPACITY 8
+#define DEFAULT_EXPANSION_FACTOR 2
+
+struct array_sized_s {
+    size_t   size;
+    size_t   capacity;
+    size_t   max_capacity;
+    size_t   elem_size;
+    float    exp_factor;
+    uint8_t *buffer;
+
+    void *(*mem_alloc)  (size_t size);
+    void *(*mem_calloc) (size_t blocks, size_t size);
+    void  (*mem_free)   (void *block);
+};
+
+static enum cc_stat expand_capacity (ArraySized *ar);
+static enum cc_stat resize_buffer   (ArraySized *ar, size_t capacity);
+static void         swap_elements   (uint8_t *a, uint8_t *b, size_t size);
+
+#define ELEM(ar, i) ((ar)->buffer + (i) * (ar)->elem_size)
+
+
+/**
+ * Creates a new empty array of elements of the specified size and returns
+ * a status code.
+ *
+ * @param[in] elem_size the size of an element in bytes
+ * @param[out] out pointer to where the newly created ArraySized is to be
+ *                 stored
+ *
+ * @return CC_OK if the creation was successful, CC_ERR_INVALID_CAPACITY if
+ * elem_size is 0, or CC_ERR_ALLOC if the memory allocation for the new
+ * ArraySized structure failed.
+ */
+enum cc_stat array_sized_new(size_t elem_size, ArraySized **out)
+{
+    ArraySizedConf c;
+    array_sized_conf_init(&c);
+    c.elem_size = elem_size;
+    return array_sized_new_conf(&c, out);
+}
+
+/**
+ * Creates a new empty ArraySized based on the specified ArraySizedConf
+ * struct and returns a status code.
+ *
+ * The ArraySized is allocated using the allocators specified in the
+ * ArraySizedConf struct. The allocation may fail if underlying allocator
+ * fails. It may also fail if elem_size is 0, or if the initial buffer
+ * would not fit into the address space.
+ *
+ * @param[in] conf array configuration structure
+ * @param[out] out pointer to where the newly created ArraySized is to be
+ *                 stored
+ *
+ * @return CC_OK if the creation was successful, CC_ERR_INVALID_CAPACITY if
+ * the above mentioned conditions are not met, or CC_ERR_ALLOC if the memory
+ * allocation for the new ArraySized structure failed.
+ */
+enum cc_stat array_sized_new_conf(ArraySizedConf const * const conf, ArraySized **out)
+{
+    float ex;
+
+    /* The expansion factor must be greater than one for the
+     * array to grow */
+    if (conf->exp_factor <= 1)
+        ex = DEFAULT_EXPANSION_FACTOR;
+    else
+        ex = conf->exp_factor;
+
+    if (!conf->elem_size)
+        return CC_ERR_INVALID_CAPACITY;
+
+    size_t max_capacity = CC_MAX_ELEMENTS / conf->elem_size;
+
+    if (!conf->capacity || conf->capacity > max_capacity ||
+        ex >= max_capacity / conf->capacity)
+        return CC_ERR_INVALID_CAPACITY;
+
+    ArraySized *ar = conf->mem_calloc(1, sizeof(ArraySized));
+
+    if (!ar)
+        return CC_ERR_ALLOC;
+
+    uint8_t *buff = conf->mem_alloc(conf->capacity * conf->elem_size);
+
+    if (!buff) {
+        conf->mem_free(ar);
+        return CC_ERR_ALLOC;
+    }
+
+    ar->buffer       = buff;
+    ar->exp_factor   = ex;
+    ar->capacity     = conf->capacity;
+    ar->max_capacity = max_capacity;
+    ar->elem_size    = conf->elem_size;
+    ar->mem_alloc    = conf->mem_alloc;
+    ar->mem_calloc   = conf->mem_calloc;
+    ar->mem_free     = conf->mem_free;
+
+    *out = ar;
+    return CC_OK;
+}
+
+/**
+ * Initializes the fields of the ArraySizedConf struct to default values.
+ * The element size is set to 0 and must be set before the conf is used.
+ *
+ * @param[in, out] conf ArraySizedConf structure that is being initialized
+ */
+void array_sized_conf_init(ArraySizedConf *conf)
+{
+    conf->exp_factor = DEFAULT_EXPANSION_FACTOR;
+    conf->capacity   = DEFAULT_CAPACITY;
+    conf->elem_size  = 0;
+    conf->mem_alloc  = malloc;
+    conf->mem_calloc = calloc;
+    conf->mem_free   = free;
+}
+
+/**
+ * Destroys the ArraySized structure along with the elements it holds.
+ *
+ * @param[in] ar the array that is to be destroyed
+ */
+void array_sized_destroy(ArraySized *ar)
+{
+    ar->mem_free(ar->buffer);
+    ar->mem_free(ar);
+}
+
+/**
+ * Appends a copy of the element to the array, making it the last element
+ * of the array.
+ *
+ * @param[in] ar the array to which the element is being added
+ * @param[in] element pointer to the element that is being copied into the
+ *                    array
+ *
+ * @return CC_OK if the element was successfully added, CC_ERR_ALLOC if the
+ * memory allocation for the new element failed, or CC_ERR_MAX_CAPACITY if the
+ * array is already at maximum capacity.
+ */
+enum cc_stat array_sized_add(ArraySized *ar, const void *element)
+{
+    if (ar->size >= ar->capacity) {
+        enum cc_stat status = expand_capacity(ar);
+        if (status != CC_OK)
+            return status;
+    }
+
+    memcpy(ELEM(ar, ar->size), element, ar->elem_size);
+    ar->size++;
+
+    return CC_OK;
+}
+
+/**
+ * Inserts a copy of the element at the specified position by shifting all
+ * subsequent elements by one. The specified index must be within the bounds
+ * of the array, or equal to its size.
+ *
+ * @param[in] ar the array to which the element is being added
+ * @param[in] element pointer to the element that is being copied into the
+ *                    array
+ * @param[in] index the position in the array at which the element is being
+ *            added
+ *
+ * @return CC_OK if the element was successfully added, CC_ERR_OUT_OF_RANGE if
+ * the specified index was not in range, CC_ERR_ALLOC if the memory
+ * allocation for the new element failed, or CC_ERR_MAX_CAPACITY if the
+ * array is already at maximum capacity.
+ */
+enum cc_stat array_sized_add_at(ArraySized *ar, const void *element, size_t index)
+{
+    if (index == ar->size)
+        return array_sized_add(ar, element);
+
+    if (index > ar->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    if (ar->size >= ar->capacity) {
+        enum cc_stat status = expand_capacity(ar);
+        if (status != CC_OK)
+            return status;
+    }
+
+    memmove(ELEM(ar, index + 1),
+            ELEM(ar, index),
+            (ar->size - index) * ar->elem_size);
+
+    memcpy(ELEM(ar, index), element, ar->elem_size);
+    ar->size++;
+
+    return CC_OK;
+}
+
+/**
+ * Replaces an array element at the specified index and optionally copies
+ * the replaced element to out. The specified index must be within the
+ * bounds of the array.
+ *
+ * @param[in]  ar      array whose element is being replaced
+ * @param[in]  element pointer to the replacement element
+ * @param[in]  index   index of the element that is being replaced
+ * @param[out] out     pointer to where the replaced element is copied, or
+ *                     NULL if it is to be ignored
+ *
+ * @return CC_OK if the element was successfully replaced, or
+ * CC_ERR_OUT_OF_RANGE if the index was out of range.
+ */
+enum cc_stat array_sized_replace_at(ArraySized *ar, const void *element, size_t index, void *out)
+{
+    if (index >= ar->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    if (out)
+        memcpy(out, ELEM(ar, index), ar->elem_size);
+
+    memcpy(ELEM(ar, index), element, ar->elem_size);
+
+    return CC_OK;
+}
+
+/**
+ * Swaps the elements at the specified indices.
+ *
+ * @param[in] ar     array whose elements are being swapped
+ * @param[in] index1 index of the first element
+ * @param[in] index2 index of the second element
+ *
+ * @return CC_OK if the elements were swapped, or CC_ERR_OUT_OF_RANGE if
+ * either index was out of range.
+ */
+enum cc_stat array_sized_swap_at(ArraySized *ar, size_t index1, size_t index2)
+{
+    if (index1 >= ar->size || index2 >= ar->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    if (index1 != index2)
+        swap_elements(ELEM(ar, index1), ELEM(ar, index2), ar->elem_size);
+
+    return CC_OK;
+}
+
+/**
+ * Removes the element at the specified index and optionally copies it to
+ * out. The index must be within the bounds of the array.
+ *
+ * @param[in] ar the array from which the element is being removed
+ * @param[in] index the index of the element being removed.
+ * @param[out] out  pointer to where the removed element is copied, or NULL
+ *                  if it is to be ignored
+ *
+ * @return CC_OK if the element was successfully removed, or
+ * CC_ERR_OUT_OF_RANGE if the index was out of range.
+ */
+enum cc_stat array_sized_remove_at(ArraySized *ar, size_t index, void *out)
+{
+    if (index >= ar->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    if (out)
+        memcpy(out, ELEM(ar, index), ar->elem_size);
+
+    if (index != ar->size - 1) {
+        memmove(ELEM(ar, index),
+                ELEM(ar, index + 1),
+                (ar->size - 1 - index) * ar->elem_size);
+    }
+    ar->size--;
+
+    return CC_OK;
+}
+
+/**
+ * Removes the last element of the array and optionally copies it to out.
+ *
+ * @param[in] ar the array whose last element is being removed
+ * @param[out] out pointer to where the removed element is copied, or NULL
+ *                 if it is to be ignored
+ *
+ * @return CC_OK if the element was successfully removed, or
+ * CC_ERR_OUT_OF_RANGE if the array is already empty.
+ */
+enum cc_stat array_sized_remove_last(ArraySized *ar, void *out)
+{
+    return array_sized_remove_at(ar, ar->size - 1, out);
+}
+
+/**
+ * Removes all elements from the specified array. This function does not
+ * shrink the array capacity.
+ *
+ * @param[in] ar array from which all elements are to be removed
+ */
+void array_sized_remove_all(ArraySized *ar)
+{
+    ar->size = 0;
+}
+
+/**
+ * Copies the element at the specified index to out. The specified index
+ * must be within the bounds of the array.
+ *
+ * @param[in] ar the array from which the element is being retrieved
+ * @param[in] index the index of the array element
+ * @param[out] out pointer to where the element is copied
+ *
+ * @return CC_OK if the element was found, or CC_ERR_OUT_OF_RANGE if the
+ * index was out of range.
+ */
+enum cc_stat array_sized_get_at(ArraySized *ar, size_t index, void *out)
+{
+    if (index >= ar->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    memcpy(out, ELEM(ar, index), ar->elem_size);
+    return CC_OK;
+}
+
+/**
+ * Sets out to the address of the element at the specified index, so that
+ * the element can be read or modified in place. The address stays valid
+ * until the array's buffer is reallocated by an add, a reserve or a trim.
+ *
+ * @param[in] ar the array from which the element is being retrieved
+ * @param[in] index the index of the array element
+ * @param[out] out pointer to where the address of the element is stored
+ *
+ * @return CC_OK if the element was found, or CC_ERR_OUT_OF_RANGE if the
+ * index was out of range.
+ */
+enum cc_stat array_sized_get_ptr_at(ArraySized *ar, size_t index, void **out)
+{
+    if (index >= ar->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    *out = ELEM(ar, index);
+    return CC_OK;
+}
+
+/**
+ * Copies the last element of the array to out.
+ *
+ * @param[in] ar the array whose last element is being returned
+ * @param[out] out pointer to where the element is copied
+ *
+ * @return CC_OK if the element was found, or CC_ERR_VALUE_NOT_FOUND if the
+ * array is empty.
+ */
+enum cc_stat array_sized_get_last(ArraySized *ar, void *out)
+{
+    if (ar->size == 0)
+        return CC_ERR_VALUE_NOT_FOUND;
+
+    return array_sized_get_at(ar, ar->size - 1, out);
+}
+
+/**
+ * Makes sure that at least n elements fit into the array without
+ * reallocating its buffer.
+ *
+ * @param[in] ar array whose capacity is being reserved
+ * @param[in] n  the number of elements
+ *
+ * @return CC_OK if the capacity was reserved, CC_ERR_ALLOC if the memory
+ * allocation for the new buffer failed, or CC_ERR_MAX_CAPACITY if n
+ * elements don't fit into the address space.
+ */
+enum cc_stat array_sized_reserve(ArraySized *ar, size_t n)
+{
+    if (n <= ar->capacity)
+        return CC_OK;
+
+    if (n > ar->max_capacity)
+        return CC_ERR_MAX_CAPACITY;
+
+    return resize_buffer(ar, n);
+}
+
+/**
+ * Shrinks the capacity of the array to match the number of elements in it,
+ * however the capacity will never shrink below 1.
+ *
+ * @param[in] ar array whose capacity is being trimmed
+ *
+ * @return CC_OK if the capacity was trimmed successfully, or CC_ERR_ALLOC if
+ * the reallocation failed.
+ */
+enum cc_stat array_sized_trim_capacity(ArraySized *ar)
+{
+    size_t capacity = ar->size < 1 ? 1 : ar->size;
+
+    if (capacity == ar->capacity)
+        return CC_OK;
+
+    return resize_buffer(ar, capacity);
+}
+
+/**
+ * Returns the number of elements in the array.
+ *
+ * @param[in] ar array whose size is being returned
+ *
+ * @return the number of elements in the array.
+ */
+size_t array_sized_size(ArraySized *ar)
+{
+    return ar->size;
+}
+
+/**
+ * Returns the capacity of the array in elements.
+ *
+ * @param[in] ar array whose capacity is being returned
+ *
+ * @return the capacity of the array.
+ */
+size_t array_sized_capacity(ArraySized *ar)
+{
+    return ar->capacity;
+}
+
+/**
+ * Returns the size of an element of the array in bytes.
+ *
+ * @param[in] ar array whose element size is being returned
+ *
+ * @return the element size.
+ */
+size_t array_sized_elem_size(ArraySized *ar)
+{
+    return ar->elem_size;
+}
+
+/**
+ * Returns the underlying buffer, which holds array_sized_size() elements
+ * back to back.
+ *
+ * @note Any modification of the buffer beyond the size of the array may
+ *       invalidate the array.
+ *
+ * @param[in] ar array whose underlying buffer is being returned
+ *
+ * @return array's internal buffer.
+ */
+void *array_sized_get_buffer(ArraySized *ar)
+{
+    return ar->buffer;
+}
+
+/**
+ * Gets the index of the first element whose bytes are equal to those of the
+ * specified element.
+ *
+ * @param[in] ar array being searched
+ * @param[in] element pointer to the element whose index is being looked up
+ * @param[out] index  pointer to where the index is stored
+ *
+ * @return CC_OK if the index was found, or CC_ERR_OUT_OF_RANGE if not.
+ */
+enum cc_stat array_sized_index_of(ArraySized *ar, const void *element, size_t *index)
+{
+    size_t i;
+    for (i = 0; i < ar->size; i++) {
+        if (!memcmp(ELEM(ar, i), element, ar->elem_size)) {
+            *index = i;
+            return CC_OK;
+        }
+    }
+    return CC_ERR_OUT_OF_RANGE;
+}
+
+/**
+ * Sorts the elements of the array in place. Unlike array_sort(), the
+ * comparator is passed pointers to the elements themselves.
+ *
+ * @param[in] ar  array to be sorted
+ * @param[in] cmp the comparator function that returns < 0 if the first
+ *                element goes before the second, 0 if the elements are
+ *                equal and > 0 if the second goes before the first
+ */
+void array_sized_sort(ArraySized *ar, int (*cmp) (const void*, const void*))
+{
+    qsort(ar->buffer, ar->size, ar->elem_size, cmp);
+}
+
+/**
+ * Applies the function fn to each element of the array. fn is passed a
+ * pointer to the element, through which it may modify the element in
+ * place.
+ *
+ * @param[in] ar array on which this operation is performed
+ * @param[in] fn operation function that is to be invoked on each element
+ */
+void array_sized_map(ArraySized *ar, void (*fn) (void *e))
+{
+    size_t i;
+    for (i = 0; i < ar->size; i++)
+        fn(ELEM(ar, i));
+}
+
+/**
+ * A fold/reduce function that collects all of the elements in the array
+ * together. For example, if we have an array of [a,b,c...] the end result
+ * will be (...((a+b)+c)+...). fn is passed pointers to the elements.
+ *
+ * @param[in] ar the array on which this operation is performed
+ * @param[in] fn the operation function that is to be invoked on each array
+ *               element
+ * @param[in] result the pointer which will collect the end result
+ */
+void array_sized_reduce(ArraySized *ar, void (*fn) (const void*, const void*, void*),
+                        void *result)
+{
+    if (ar->size == 1) {
+        fn(ELEM(ar, 0), NULL, result);
+        return;
+    }
+    if (ar->size > 1)
+        fn(ELEM(ar, 0), ELEM(ar, 1), result);
+
+    for (size_t i = 2; i < ar->size; i++)
+        fn(result, ELEM(ar, i), result);
+}
+
+/**
+ * Filters the array by modifying it. It removes all elements that don't
+ * return true on pred(element). The order of the kept elements is
+ * preserved.
+ *
+ * @param[in] ar   array that is to be filtered
+ * @param[in] pred predicate function which is passed a pointer to an element
+ *                 and returns true if the element should be kept
+ *
+ * @return CC_OK if the array was filtered successfully, or
+ * CC_ERR_OUT_OF_RANGE if the array is empty.
+ */
+enum cc_stat array_sized_filter_mut(ArraySized *ar, bool (*pred) (const void*))
+{
+    if (ar->size == 0)
+        return CC_ERR_OUT_OF_RANGE;
+
+    size_t keep = 0;
+
+    for (size_t i = 0; i < ar->size; i++) {
+        if (!pred(ELEM(ar, i)))
+            continue;
+        if (keep != i)
+            memcpy(ELEM(ar, keep), ELEM(ar, i), ar->elem_size);
+        keep++;
+    }
+    ar->size = keep;
+
+    return CC_OK;
+}
+
+/**
+ * Expands the capacity of the array by its expansion factor. In case the
+ * expansion would overflow the index range, a maximum capacity buffer is
+ * allocated instead.
+ *
+ * @param[in] ar array whose capacity is being expanded
+ *
+ * @return CC_OK if the buffer was expanded successfully, CC_ERR_ALLOC if
+ * the memory allocation for the new buffer failed, or CC_ERR_MAX_CAPACITY
+ * if the array is already at maximum capacity.
+ */
+static enum cc_stat expand_capacity(ArraySized *ar)
+{
+    if (ar->capacity == ar->max_capacity)
+        return CC_ERR_MAX_CAPACITY;
+
+    size_t new_capacity = ar->capacity * ar->exp_factor;
+
+    if (new_capacity <= ar->capacity || new_capacity > ar->max_capacity)
+        new_capacity = ar->max_capacity;
+
+    return resize_buffer(ar, new_capacity);
+}
+
+/**
+ * Moves the elements of the array into a new buffer of the given capacity,
+ * which must be at least the size of the array.
+ */
+static enum cc_stat resize_buffer(ArraySized *ar, size_t capacity)
+{
+    uint8_t *new_buff = ar->mem_alloc(capacity * ar->elem_size);
+
+    if (!new_buff)
+        return CC_ERR_ALLOC;
+
+    memcpy(new_buff, ar->buffer, ar->size * ar->elem_size);
+
+    ar->mem_free(ar->buffer);
+    ar->buffer   = new_buff;
+    ar->capacity = capacity;
+
+    return CC_OK;
+}
+
+/**
+ * Swaps size bytes between a and b through a small stack buffer.
+ */
+static void swap_elements(uint8_t *a, uint8_t *b, size_t size)
+{
+    uint8_t tmp[64];
+
+    while (size > 0) {
+        size_t n = size < sizeof(tmp) ? size : sizeof(tmp);
+
+        memcpy(tmp, a, n);
+        memcpy(a, b, n);
+        memcpy(b, tmp, n);
+
+        a    += n;
+        b    += n;
+        size -= n;
+    }
+}
+
+/**
+ * Initializes the iterator.
+ *
+ * @param[in] iter the iterator that is being initialized
+ * @param[in] ar the array to iterate over
+ */
+void array_sized_iter_init(ArraySizedIter *iter, ArraySized *ar)
+{
+    iter->ar           = ar;
+    iter->index        = 0;
+    iter->last_removed = false;
+}
+
+/**
+ * Advances the iterator and copies the next element to out.
+ *
+ * @param[in] iter the iterator that is being advanced
+ * @param[out] out pointer to where the next element is copied
+ *
+ * @return CC_OK if the iterator was advanced, or CC_ITER_END if the
+ * end of the array has been reached.
+ */
+enum cc_stat array_sized_iter_next(ArraySizedIter *iter, void *out)
+{
+    if (iter->index >= iter->ar->size)
+        return CC_ITER_END;
+
+    memcpy(out, ELEM(iter->ar, iter->index), iter->ar->elem_size);
+
+    iter->index++;
+    iter->last_removed = false;
+
+    return CC_OK;
+}
+
+/**
+ * Advances the iterator and sets out to the address of the next element,
+ * so that it can be read or modified in place.
+ *
+ * @param[in] iter the iterator that is being advanced
+ * @param[out] out pointer to where the address of the next element is
+ *                 stored
+ *
+ * @return CC_OK if the iterator was advanced, or CC_ITER_END if the
+ * end of the array has been reached.
+ */
+enum cc_stat array_sized_iter_next_ptr(ArraySizedIter *iter, void **out)
+{
+    if (iter->index >= iter->ar->size)
+        return CC_ITER_END;
+
+    *out = ELEM(iter->ar, iter->index);
+
+    iter->index++;
+    iter->last_removed = false;
+
+    return CC_OK;
+}
+
+/**
+ * Removes the last returned element without invalidating the iterator and
+ * optionally copies it to out.
+ *
+ * @note This function should only ever be called after a call to <code>
+ * array_sized_iter_next()</code>.
+ *
+ * @param[in] iter the iterator on which this operation is being performed
+ * @param[out] out pointer to where the removed element is copied, or NULL
+ *                 if it is to be ignored
+ *
+ * @return CC_OK if the element was successfully removed, or
+ * CC_ERR_VALUE_NOT_FOUND.
+ */
+enum cc_stat array_sized_iter_remove(ArraySizedIter *iter, void *out)
+{
+    enum cc_stat status = CC_ERR_VALUE_NOT_FOUND;
+
+    if (!iter->last_removed) {
+        status = array_sized_remove_at(iter->ar, iter->index - 1, out);
+        if (status == CC_OK) {
+            iter->index--;
+            iter->last_removed = true;
+        }
+    }
+    return status;
+}
+
+/**
+ * Replaces the last returned element with a copy of the specified element
+ * and optionally copies the replaced element to out.
+ *
+ * @note This function should only ever be called after a call to <code>
+ * array_sized_iter_next()</code>.
+ *
+ * @param[in] iter the iterator on which this operation is being performed
+ * @param[in] element pointer to the replacement element
+ * @param[out] out pointer to where the replaced element is copied, or NULL
+ *                if it is to be ignored
+ *
+ * @return CC_OK if the element was replaced successfully, or
+ * CC_ERR_OUT_OF_RANGE.
+ */
+enum cc_stat array_sized_iter_replace(ArraySizedIter *iter, const void *element, void *out)
+{
+    return array_sized_replace_at(iter->ar, element, iter->index - 1, out);
+}
+
+/**
+ * Returns the index of the last returned element.
+ *
+ * @note This function should not be called before a call to <code>
+ * array_sized_iter_next()</code>.
+ *
+ * @param[in] iter the iterator on which this operation is being performed
+ *
+ * @return the index.
+ */
+size_t array_sized_iter_index(ArraySizedIter *iter)
+{
+    return iter->index - 1;
+}
@@ -0,0 +1,969 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2015 Srđan Panić <srdja.panic@gmail.com>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#include "concurrent_hashtable.h"
+#include "hashtable_internal.h"
+#include "epoch_internal.h"
+
+#define DEFAULT_CAPACITY    16
+#define DEFAULT_LOAD_FACTOR 0.75f
+#define DEFAULT_STRIPES     64
+
+#define CACHE_LINE          64
+
+/* Number of removed entries that a stripe of a lock-free table collects
+ * before it waits for a grace period and frees them. */
+#define GARBAGE_BATCH       32
+
+/* Links and values may be read by lock-free readers, so writers publish them
+ * with release stores. Under the stripe lock they are read relaxed. */
+#define LOAD(p)       atomic_load_explicit(&(p), memory_order_relaxed)
+#define ACQUIRE(p)    atomic_load_explicit(&(p), memory_order_acquire)
+#define PUBLISH(p, v) atomic_store_explicit(&(p), (v), memory_order_release)
+
+typedef struct entry_s {
+    void                    *key;
+    size_t                   hash;
+    void *_Atomic            value;
+    struct entry_s *_Atomic  next;
+} Entry;
+
+typedef struct bucket_array_s {
+    size_t          capacity;
+    Entry *_Atomic  buckets[];
+} BucketArray;
+
+/* A stripe owns every bucket whose index is congruent to the stripe index
+ * modulo the number of stripes. Since the capacity is always a multiple of
+ * the stripe count, a key stays in the same stripe when the table grows.
+ *
+ * The stripe remembers which bucket array its buckets currently live in.
+ * While the table is resizing, stripes that haven't been moved yet still
+ * point to the old array. */
+typedef struct stripe_s {
+    pthread_mutex_t       lock;
+    BucketArray *_Atomic  view;
+    atomic_size_t         size;
+
+    /* Lock-free tables only. Readers take the stripe lock while it is set,
+     * and removed entries wait in garbage for a grace period. */
+    atomic_bool           locked_reads;
+    size_t                garbage_count;
+    Entry                *garbage[GARBAGE_BATCH];
+} Stripe;
+
+/* Stripes are padded to a cache line so that threads working on adjacent
+ * stripes don't share lines. */
+typedef union padded_stripe_u {
+    Stripe stripe;
+    char   pad[(sizeof(Stripe) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE];
+} PaddedStripe;
+
+struct concurrent_hashtable_s {
+    PaddedStripe   *stripes;
+    void           *stripes_block;
+    size_t          stripe_count;
+    float           load_factor;
+    uint32_t        hash_seed;
+    int             key_len;
+
+    /* Set if the table has lock-free reads */
+    Epoch          *epoch;
+
+    /* A stripe whose size exceeds stripe_threshold makes the table grow. */
+    atomic_size_t   stripe_threshold;
+
+    /* The newest bucket array. Only written by the thread that holds
+     * resize_lock, before it opens the stripes for transfer. */
+    BucketArray *_Atomic buckets;
+
+    /* Stripes below transfer_next have been claimed for a move to the new
+     * bucket array, and transferred of them are done. */
+    pthread_mutex_t resize_lock;
+    atomic_size_t   transfer_next;
+    atomic_size_t   transferred;
+    atomic_bool     resizing;
+
+    size_t  (*hash)       (const void *key, int l, uint32_t seed);
+    int     (*key_cmp)    (const void *k1, const void *k2);
+    void   *(*mem_alloc)  (size_t size);
+    void   *(*mem_calloc) (size_t blocks, size_t size);
+    void    (*mem_free)   (void *block);
+};
+
+static BucketArray    *buckets_new     (ConcurrentHashTable *table, size_t capacity);
+static void            grow            (ConcurrentHashTable *table, size_t capacity);
+static void            help_resize     (ConcurrentHashTable *table);
+static void            transfer_stripe (ConcurrentHashTable *table, size_t i);
+static bool            copy_stripe     (ConcurrentHashTable *table, Stripe *s, size_t i,
+                                        BucketArray *dst);
+static void            move_stripe     (ConcurrentHashTable *table, Stripe *s, size_t i,
+                                        BucketArray *dst);
+static void            free_chains     (ConcurrentHashTable *table, BucketArray *a,
+                                        size_t i);
+static void            retire          (ConcurrentHashTable *table, Stripe *s,
+                                        Entry *e, Entry **batch, size_t *n);
+static void            free_entries    (ConcurrentHashTable *table, Entry **entries,
+                                        size_t n);
+static Entry *_Atomic *find            (ConcurrentHashTable *table, Stripe *s,
+                                        const void *key, size_t hash);
+
+
+/**
+ * Creates a new ConcurrentHashTable and returns a status code.
+ *
+ * @note The newly created ConcurrentHashTable will work with string keys.
+ *
+ * @param[out] out Pointer to where the newly created ConcurrentHashTable is
+ *                 to be stored
+ *
+ * @return CC_OK if the creation was successful, or CC_ERR_ALLOC if the memory
+ * allocation for the new ConcurrentHashTable failed.
+ */
+enum cc_stat concurrent_hashtable_new(ConcurrentHashTable **out)
+{
+    ConcurrentHashTableConf conf;
+    concurrent_hashtable_conf_init(&conf);
+    return concurrent_hashtable_new_conf(&conf, out);
+}
+
+/**
+ * Creates a new ConcurrentHashTable based on the specified
+ * ConcurrentHashTableConf struct and returns a status code.
+ *
+ * @param[in] conf the ConcurrentHashTable conf structure
+ * @param[out] out Pointer to where the newly created ConcurrentHashTable is
+ *                 stored
+ *
+ * @return CC_OK if the creation was successful, or CC_ERR_ALLOC if the memory
+ * allocation for the new ConcurrentHashTable structure failed.
+ */
+enum cc_stat concurrent_hashtable_new_conf(ConcurrentHashTableConf const * const conf,
+                                           ConcurrentHashTable **out)
+{
+    ConcurrentHashTable *table = conf->mem_calloc(1, sizeof(ConcurrentHashTable));
+
+    if (!table)
+        return CC_ERR_ALLOC;
+
+    size_t stripes  = conf->stripes > 1 ? round_pow_two(conf->stripes) : 1;
+    size_t capacity = round_pow_two(conf->initial_capacity);
+
+    if (capacity < stripes)
+        capacity = stripes;
+
+    table->stripe_count = stripes;
+    table->load_factor  = conf->load_factor;
+    table->hash_seed    = conf->random_seed ? hashtable_random_seed() : conf->hash_seed;
+    table->key_len      = conf->key_length;
+    table->hash         = conf->hash;
+    table->key_cmp      = conf->key_compare;
+    table->mem_alloc    = conf->mem_alloc;
+    table->mem_calloc   = conf->mem_calloc;
+    table->mem_free     = conf->mem_free;
+
+    BucketArray *buckets = buckets_new(table, capacity);
+
+    table->stripes_block = conf->mem_alloc((stripes + 1) * sizeof(PaddedStripe));
+
+    if (conf->lock_free_reads && buckets && table->stripes_block) {
+        if (epoch_new(conf->mem_alloc, conf->mem_free, &table->epoch) != CC_OK)
+            table->epoch = NULL;
+    }
+
+    if (!buckets || !table->stripes_block || (conf->lock_free_reads && !table->epoch)) {
+        conf->mem_free(buckets);
+        conf->mem_free(table->stripes_block);
+        conf->mem_free(table);
+        return CC_ERR_ALLOC;
+    }
+    /* align the stripes to a cache line */
+    table->stripes = (PaddedStripe*)
+        (((uintptr_t) table->stripes_block + CACHE_LINE - 1) & ~(uintptr_t) (CACHE_LINE - 1));
+
+    size_t i;
+    for (i = 0; i < stripes; i++) {
+        Stripe *s = &table->stripes[i].stripe;
+
+        pthread_mutex_init(&s->lock, NULL);
+        atomic_init(&s->view, buckets);
+        atomic_init(&s->size, 0);
+        atomic_init(&s->locked_reads, false);
+        s->garbage_count = 0;
+    }
+    pthread_mutex_init(&table->resize_lock, NULL);
+
+    size_t threshold = (size_t) (capacity * table->load_factor) / stripes;
+
+    atomic_init(&table->buckets, buckets);
+    atomic_init(&table->stripe_threshold, threshold ? threshold : 1);
+    atomic_init(&table->transfer_next, stripes);
+    atomic_init(&table->transferred, stripes);
+    atomic_init(&table->resizing, false);
+
+    *out = table;
+    return CC_OK;
+}
+
+/**
+ * Initializes the ConcurrentHashTableConf structs fields to default values.
+ *
+ * @param[in] conf the struct that is being initialized
+ */
+void concurrent_hashtable_conf_init(ConcurrentHashTableConf *conf)
+{
+    conf->hash             = STRING_HASH;
+    conf->key_compare      = cc_common_cmp_str;
+    conf->initial_capacity = DEFAULT_CAPACITY;
+    conf->load_factor      = DEFAULT_LOAD_FACTOR;
+    conf->stripes          = DEFAULT_STRIPES;
+    conf->lock_free_reads  = false;
+    conf->random_seed      = false;
+    conf->key_length       = KEY_LENGTH_VARIABLE;
+    conf->hash_seed        = 0;
+    conf->mem_alloc        = malloc;
+    conf->mem_calloc       = calloc;
+    conf->mem_free         = free;
+}
+
+/**
+ * Destroys the specified ConcurrentHashTable structure without destroying the
+ * data contained within it. No other thread may be using the table.
+ *
+ * @param[in] table ConcurrentHashTable to be destroyed
+ */
+void concurrent_hashtable_destroy(ConcurrentHashTable *table)
+{
+    concurrent_hashtable_remove_all(table);
+
+    size_t i;
+    for (i = 0; i < table->stripe_count; i++) {
+        Stripe *s = &table->stripes[i].stripe;
+
+        free_entries(table, s->garbage, s->garbage_count);
+        pthread_mutex_destroy(&s->lock);
+    }
+    pthread_mutex_destroy(&table->resize_lock);
+
+    if (table->epoch)
+        epoch_destroy(table->epoch);
+
+    table->mem_free(atomic_load(&table->buckets));
+    table->mem_free(table->stripes_block);
+    table->mem_free(table);
+}
+
+/**
+ * Returns the hash of the key. The NULL key always hashes to zero.
+ */
+static INLINE size_t hash_key(ConcurrentHashTable *table, const void *key)
+{
+    return key ? table->hash(key, table->key_len, table->hash_seed) : 0;
+}
+
+/**
+ * Returns the stripe that guards the keys with the specified hash.
+ */
+static INLINE Stripe *stripe_of(ConcurrentHashTable *table, size_t hash)
+{
+    return &table->stripes[hash & (table->stripe_count - 1)].stripe;
+}
+
+/**
+ * Checks whether the entry holds the specified key.
+ */
+static INLINE bool entry_matches(ConcurrentHashTable *table, Entry *e,
+                                 const void *key, size_t hash)
+{
+    if (e->hash != hash)
+        return false;
+
+    return key ? e->key && table->key_cmp(e->key, key) == 0 : !e->key;
+}
+
+/**
+ * Helps with a resize that is in progress before the calling thread locks
+ * a stripe.
+ */
+static INLINE void enter(ConcurrentHashTable *table)
+{
+    if (atomic_load_explicit(&table->resizing, memory_order_relaxed))
+        help_resize(table);
+}
+
+/**
+ * Returns the link that points to the entry with the specified key, or to
+ * the end of the chain if the key isn't in the table. The stripe of the key
+ * must be locked.
+ */
+static Entry *_Atomic *find(ConcurrentHashTable *table, Stripe *s, const void *key,
+                            size_t hash)
+{
+    BucketArray    *view = LOAD(s->view);
+    Entry *_Atomic *link = &view->buckets[hash & (view->capacity - 1)];
+    Entry          *e;
+
+    while ((e = LOAD(*link))) {
+        if (entry_matches(table, e, key, hash))
+            return link;
+
+        link = &e->next;
+    }
+    return link;
+}
+
+/**
+ * Finds the entry of the key in the locked stripe, or adds a new entry that
+ * maps the key to val. Returns the entry, or NULL if the allocation failed.
+ */
+static Entry *get_or_add(ConcurrentHashTable *table, Stripe *s, void *key,
+                         void *val, size_t hash, bool *inserted)
+{
+    Entry *_Atomic *link = find(table, s, key, hash);
+    Entry          *e    = LOAD(*link);
+
+    if (e) {
+        *inserted = false;
+        return e;
+    }
+
+    e = table->mem_alloc(sizeof(Entry));
+
+    if (!e)
+        return NULL;
+
+    e->key  = key;
+    e->hash = hash;
+    atomic_init(&e->value, val);
+    atomic_init(&e->next, NULL);
+
+    PUBLISH(*link, e);
+
+    atomic_store_explicit(&s->size, LOAD(s->size) + 1, memory_order_relaxed);
+    *inserted = true;
+    return e;
+}
+
+/**
+ * Returns true if the locked stripe has outgrown the table.
+ */
+static INLINE bool over_threshold(ConcurrentHashTable *table, Stripe *s)
+{
+    return LOAD(s->size) > LOAD(table->stripe_threshold);
+}
+
+/**
+ * Creates a new key-value mapping in the specified ConcurrentHashTable. If the
+ * key is already mapped to a value in this table, that value is replaced with
+ * the new value.
+ *
+ * @param[in] table the table to which this new key-value mapping is being added
+ * @param[in] key a hash table key used to access the specified value
+ * @param[in] val a value that is being stored in the table
+ *
+ * @return CC_OK if the mapping was successfully added, or CC_ERR_ALLOC if the
+ * memory allocation failed.
+ */
+enum cc_stat concurrent_hashtable_add(ConcurrentHashTable *table, void *key, void *val)
+{
+    const size_t hash = hash_key(table, key);
+    Stripe      *s    = stripe_of(table, hash);
+    bool         inserted = false;
+
+    enter(table);
+    pthread_mutex_lock(&s->lock);
+
+    Entry *e = get_or_add(table, s, key, val, hash, &inserted);
+
+    if (e && !inserted)
+        PUBLISH(e->value, val);
+
+    bool   full     = inserted && over_threshold(table, s);
+    size_t capacity = LOAD(s->view)->capacity;
+
+    pthread_mutex_unlock(&s->lock);
+
+    if (!e)
+        return CC_ERR_ALLOC;
+
+    if (full)
+        grow(table, capacity);
+
+    return CC_OK;
+}
+
+/**
+ * Updates the value of the key in one atomic step. fn is called with the
+ * current value of the key and true, or with NULL and false if the key isn't
+ * in the table, and the value it returns is stored under the key.
+ *
+ * @note fn is called while the stripe of the key is locked, so it must not
+ * access the table.
+ *
+ * @param[in] table the table in which the key is being updated
+ * @param[in] key   the key whose value is being updated
+ * @param[in] fn    function that returns the new value of the key
+ * @param[in] ctx   user data that is passed to fn
+ *
+ * @return CC_OK if the key was updated or added, or CC_ERR_ALLOC if the
+ * memory allocation failed.
+ */
+enum cc_stat concurrent_hashtable_upsert(ConcurrentHashTable *table, void *key,
+                                         void *(*fn) (void *value, bool exists, void *ctx),
+                                         void *ctx)
+{
+    const size_t hash = hash_key(table, key);
+    Stripe      *s    = stripe_of(table, hash);
+    bool         inserted = false;
+
+    enter(table);
+    pthread_mutex_lock(&s->lock);
+
+    Entry *e = get_or_add(table, s, key, NULL, hash, &inserted);
+
+    if (e)
+        PUBLISH(e->value, fn(LOAD(e->value), !inserted, ctx));
+
+    bool   full     = inserted && over_threshold(table, s);
+    size_t capacity = LOAD(s->view)->capacity;
+
+    pthread_mutex_unlock(&s->lock);
+
+    if (!e)
+        return CC_ERR_ALLOC;
+
+    if (full)
+        grow(table, capacity);
+
+    return CC_OK;
+}
+
+/**
+ * Looks the key up under the stripe lock.
+ */
+static enum cc_stat locked_get(ConcurrentHashTable *table, Stripe *s, void *key,
+                               size_t hash, void **out)
+{
+    pthread_mutex_lock(&s->lock);
+
+    Entry *e = LOAD(*find(table, s, key, hash));
+
+    if (e && out)
+        *out = LOAD(e->value);
+
+    pthread_mutex_unlock(&s->lock);
+
+    return e ? CC_OK : CC_ERR_KEY_NOT_FOUND;
+}
+
+/**
+ * Gets a value associated with the specified key and sets the out
+ * parameter to it.
+ *
+ * If the table was created with lock_free_reads, the lookup doesn't take
+ * any locks and doesn't write to memory that other threads use.
+ *
+ * @param[in] table the table from which the mapping is being returned
+ * @param[in] key   the key that is being looked up
+ * @param[out] out  pointer to where the returned value is stored, or NULL
+ *
+ * @return CC_OK if the key was found, or CC_ERR_KEY_NOT_FOUND if not.
+ */
+enum cc_stat concurrent_hashtable_get(ConcurrentHashTable *table, void *key, void **out)
+{
+    const size_t hash = hash_key(table, key);
+    Stripe      *s    = stripe_of(table, hash);
+
+    if (!table->epoch)
+        return locked_get(table, s, key, hash, out);
+
+    size_t token = epoch_enter(table->epoch);
+
+    /* The stripe is being rebuilt in place */
+    if (atomic_load(&s->locked_reads)) {
+        epoch_exit(table->epoch, token);
+        return locked_get(table, s, key, hash, out);
+    }
+
+    BucketArray *view = ACQUIRE(s->view);
+    Entry       *e    = ACQUIRE(view->buckets[hash & (view->capacity - 1)]);
+
+    while (e && !entry_matches(table, e, key, hash))
+        e = ACQUIRE(e->next);
+
+    if (e && out)
+        *out = ACQUIRE(e->value);
+
+    epoch_exit(table->epoch, token);
+
+    return e ? CC_OK : CC_ERR_KEY_NOT_FOUND;
+}
+
+/**
+ * Checks whether or not the ConcurrentHashTable contains the specified key.
+ *
+ * @param[in] table the table on which the search is being performed
+ * @param[in] key the key that is being searched for
+ *
+ * @return true if the table contains the key.
+ */
+bool concurrent_hashtable_contains_key(ConcurrentHashTable *table, void *key)
+{
+    return concurrent_hashtable_get(table, key, NULL) == CC_OK;
+}
+
+/**
+ * Removes a key-value mapping from the specified table and sets the out
+ * parameter to value.
+ *
+ * @param[in] table the table from which the key-value pair is being removed
+ * @param[in] key the key of the value being returned
+ * @param[out] out pointer to where the removed value is stored, or NULL
+ *                 if it is to be ignored
+ *
+ * @return CC_OK if the mapping was successfully removed, or CC_ERR_KEY_NOT_FOUND
+ * if the key was not found.
+ */
+enum cc_stat concurrent_hashtable_remove(ConcurrentHashTable *table, void *key, void **out)
+{
+    const size_t hash = hash_key(table, key);
+    Stripe      *s    = stripe_of(table, hash);
+    Entry       *batch[GARBAGE_BATCH];
+    size_t       n = 0;
+
+    pthread_mutex_lock(&s->lock);
+
+    Entry *_Atomic *link = find(table, s, key, hash);
+    Entry          *e    = LOAD(*link);
+
+    if (e) {
+        PUBLISH(*link, LOAD(e->next));
+        atomic_store_explicit(&s->size, LOAD(s->size) - 1, memory_order_relaxed);
+
+        if (out)
+            *out = LOAD(e->value);
+
+        retire(table, s, e, batch, &n);
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    if (!e)
+        return CC_ERR_KEY_NOT_FOUND;
+
+    free_entries(table, batch, n);
+    return CC_OK;
+}
+
+/**
+ * Takes an entry that was unlinked from the locked stripe. Tables without
+ * lock-free reads hand it back through batch right away. Lock-free tables
+ * collect it in the stripe's garbage, and hand back the whole batch once it
+ * is full. The caller frees the batch after unlocking the stripe.
+ */
+static void retire(ConcurrentHashTable *table, Stripe *s, Entry *e,
+                   Entry **batch, size_t *n)
+{
+    if (!table->epoch) {
+        batch[(*n)++] = e;
+        return;
+    }
+    s->garbage[s->garbage_count++] = e;
+
+    if (s->garbage_count == GARBAGE_BATCH) {
+        memcpy(batch, s->garbage, sizeof(s->garbage));
+        *n = GARBAGE_BATCH;
+        s->garbage_count = 0;
+    }
+}
+
+/**
+ * Frees entries that were retired, after a grace period if the table has
+ * lock-free reads.
+ */
+static void free_entries(ConcurrentHashTable *table, Entry **entries, size_t n)
+{
+    size_t i;
+
+    if (n == 0)
+        return;
+
+    if (table->epoch)
+        epoch_synchronize(table->epoch);
+
+    for (i = 0; i < n; i++)
+        table->mem_free(entries[i]);
+}
+
+/**
+ * Removes all key-value mappings from the specified table. The stripes are
+ * cleared one at a time, so keys that other threads add at the same time may
+ * survive.
+ *
+ * @param[in] table the table from which all mappings are being removed
+ */
+void concurrent_hashtable_remove_all(ConcurrentHashTable *table)
+{
+    Entry *batch[GARBAGE_BATCH];
+    size_t i;
+
+    enter(table);
+
+    for (i = 0; i < table->stripe_count; i++) {
+        Stripe      *s    = &table->stripes[i].stripe;
+        BucketArray *view;
+        size_t       b;
+
+        pthread_mutex_lock(&s->lock);
+        view = LOAD(s->view);
+
+        for (b = i; b < view->capacity; b += table->stripe_count) {
+            Entry *e;
+
+            while ((e = LOAD(view->buckets[b]))) {
+                size_t n = 0;
+
+                PUBLISH(view->buckets[b], LOAD(e->next));
+                retire(table, s, e, batch, &n);
+
+                /* Readers don't take the lock, so the batch can be freed
+                 * while holding it */
+                free_entries(table, batch, n);
+            }
+        }
+        atomic_store_explicit(&s->size, 0, memory_order_relaxed);
+
+        pthread_mutex_unlock(&s->lock);
+    }
+}
+
+/**
+ * Returns the number of key-value mappings in the table. The stripe counters
+ * are read without locking, so while other threads modify the table the
+ * result is only a snapshot.
+ *
+ * @param[in] table the table whose size is being returned
+ *
+ * @return the number of key-value mappings in the table.
+ */
+size_t concurrent_hashtable_size(ConcurrentHashTable *table)
+{
+    size_t size = 0;
+    size_t i;
+
+    for (i = 0; i < table->stripe_count; i++)
+        size += LOAD(table->stripes[i].stripe.size);
+
+    return size;
+}
+
+/**
+ * Returns the current capacity of the table.
+ *
+ * @param[in] table the table whose capacity is being returned
+ *
+ * @return the capacity of the table.
+ */
+size_t concurrent_hashtable_capacity(ConcurrentHashTable *table)
+{
+    return atomic_load(&table->buckets)->capacity;
+}
+
+/**
+ * Returns the number of lock stripes of the table.
+ *
+ * @param[in] table the table whose stripe count is being returned
+ *
+ * @return the number of lock stripes.
+ */
+size_t concurrent_hashtable_stripes(ConcurrentHashTable *table)
+{
+    return table->stripe_count;
+}
+
+/**
+ * Calls fn on the key or the value of every entry of the table, one locked
+ * stripe at a time.
+ */
+static void foreach(ConcurrentHashTable *table, void (*key_fn) (const void *key),
+                    void (*val_fn) (void *val))
+{
+    size_t i;
+
+    enter(table);
+
+    for (i = 0; i < table->stripe_count; i++) {
+        Stripe      *s = &table->stripes[i].stripe;
+        BucketArray *view;
+        size_t       b;
+
+        pthread_mutex_lock(&s->lock);
+        view = LOAD(s->view);
+
+        for (b = i; b < view->capacity; b += table->stripe_count) {
+            Entry *e;
+            for (e = LOAD(view->buckets[b]); e; e = LOAD(e->next)) {
+                if (key_fn)
+                    key_fn(e->key);
+                else
+                    val_fn(LOAD(e->value));
+            }
+        }
+        pthread_mutex_unlock(&s->lock);
+    }
+}
+
+/**
+ * Applies the function fn to each key of the table.
+ *
+ * @note fn is called while the stripe of the key is locked, so it must not
+ * access the table.
+ *
+ * @param[in] table the table on which this operation is being performed
+ * @param[in] fn the operation function that is invoked on each key of the table
+ */
+void concurrent_hashtable_foreach_key(ConcurrentHashTable *table,
+                                      void (*fn) (const void *key))
+{
+    foreach(table, fn, NULL);
+}
+
+/**
+ * Applies the function fn to each value of the table.
+ *
+ * @note fn is called while the stripe of the value is locked, so it must not
+ * access the table.
+ *
+ * @param[in] table the table on which this operation is being performed
+ * @param[in] fn the operation function that is invoked on each value of the
+ *               table
+ */
+void concurrent_hashtable_foreach_value(ConcurrentHashTable *table,
+                                        void (*fn) (void *val))
+{
+    foreach(table, NULL, fn);
+}
+
+
+/*******************************************************************************
+ *
+ *
+ *  Resizing
+ *
+ *
+ ******************************************************************************/
+
+/**
+ * Allocates an empty bucket array.
+ */
+static BucketArray *buckets_new(ConcurrentHashTable *table, size_t capacity)
+{
+    BucketArray *a = table->mem_calloc(1, sizeof(BucketArray) +
+                                          capacity * sizeof(Entry*));
+    if (a)
+        a->capacity = capacity;
+
+    return a;
+}
+
+/**
+ * Doubles the capacity of the table, unless it has already grown past the
+ * capacity that the caller saw. If another thread is already resizing the
+ * table, the caller returns right away. A failed allocation leaves the table
+ * at its current capacity.
+ *
+ * The resizing thread publishes the new bucket array and then moves stripes
+ * to it, together with any thread that enters the table in the meantime.
+ * Each stripe is moved under its own lock, so operations on the other
+ * stripes can continue while the table is resizing.
+ */
+static void grow(ConcurrentHashTable *table, size_t capacity)
+{
+    if (pthread_mutex_trylock(&table->resize_lock) != 0)
+        return;
+
+    BucketArray *old_buckets = atomic_load(&table->buckets);
+
+    if (old_buckets->capacity != capacity || capacity >= MAX_POW_TWO) {
+        pthread_mutex_unlock(&table->resize_lock);
+        return;
+    }
+
+    const size_t new_capacity = capacity << 1;
+    BucketArray *new_buckets  = buckets_new(table, new_capacity);
+
+    if (!new_buckets) {
+        pthread_mutex_unlock(&table->resize_lock);
+        return;
+    }
+
+    /* No stripe can be claimed before the new array is visible, since
+     * every claim reads transfer_next after the reset below. */
+    atomic_store(&table->buckets, new_buckets);
+    atomic_store(&table->transferred, 0);
+    atomic_store(&table->transfer_next, 0);
+    atomic_store(&table->resizing, true);
+
+    help_resize(table);
+
+    while (atomic_load(&table->transferred) < table->stripe_count)
+        sched_yield();
+
+    size_t threshold = (size_t) (new_capacity * table->load_factor) / table->stripe_count;
+
+    atomic_store(&table->stripe_threshold, threshold ? threshold : 1);
+    atomic_store(&table->resizing, false);
+
+    /* Every stripe now points to the new array. Readers of a lock-free
+     * table may still be walking the old one, which keeps the originals of
+     * the entries that were copied to the new array. */
+    if (table->epoch) {
+        size_t i;
+
+        epoch_synchronize(table->epoch);
+
+        for (i = 0; i < table->stripe_count; i++)
+            free_chains(table, old_buckets, i);
+    }
+    table->mem_free(old_buckets);
+
+    pthread_mutex_unlock(&table->resize_lock);
+}
+
+/**
+ * Claims and moves stripes until there are none left to claim.
+ */
+static void help_resize(ConcurrentHashTable *table)
+{
+    size_t i;
+
+    while ((i = atomic_fetch_add(&table->transfer_next, 1)) < table->stripe_count) {
+        transfer_stripe(table, i);
+        atomic_fetch_add(&table->transferred, 1);
+    }
+}
+
+/**
+ * Moves the entries of stripe i to the newest bucket array.
+ */
+static void transfer_stripe(ConcurrentHashTable *table, size_t i)
+{
+    Stripe      *s   = &table->stripes[i].stripe;
+    BucketArray *dst = atomic_load(&table->buckets);
+
+    pthread_mutex_lock(&s->lock);
+
+    if (!table->epoch) {
+        move_stripe(table, s, i, dst);
+    } else if (!copy_stripe(table, s, i, dst)) {
+        /* Out of memory. Make readers take the lock instead, and wait for
+         * the ones that didn't see the flag before relinking the chains. */
+        atomic_store(&s->locked_reads, true);
+        epoch_synchronize(table->epoch);
+        move_stripe(table, s, i, dst);
+        atomic_store(&s->locked_reads, false);
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+/**
+ * Relinks the entries of the locked stripe i into dst, and clears the
+ * stripe's buckets in the old array.
+ */
+static void move_stripe(ConcurrentHashTable *table, Stripe *s, size_t i,
+                        BucketArray *dst)
+{
+    BucketArray *src  = LOAD(s->view);
+    size_t       mask = dst->capacity - 1;
+    size_t       b;
+
+    for (b = i; b < src->capacity; b += table->stripe_count) {
+        Entry *e = LOAD(src->buckets[b]);
+
+        while (e) {
+            Entry          *next   = LOAD(e->next);
+            Entry *_Atomic *bucket = &dst->buckets[e->hash & mask];
+
+            atomic_store_explicit(&e->next, LOAD(*bucket), memory_order_relaxed);
+            atomic_store_explicit(bucket, e, memory_order_relaxed);
+            e = next;
+        }
+        atomic_store_explicit(&src->buckets[b], NULL, memory_order_relaxed);
+    }
+    PUBLISH(s->view, dst);
+}
+
+/**
+ * Copies the entries of the locked stripe i into dst and publishes dst to
+ * the stripe's readers. The old chains are left untouched for readers that
+ * are still walking them. Returns false, without changing the stripe, if an
+ * allocation failed.
+ */
+static bool copy_stripe(ConcurrentHashTable *table, Stripe *s, size_t i,
+                        BucketArray *dst)
+{
+    BucketArray *src  = LOAD(s->view);
+    size_t       mask = dst->capacity - 1;
+    size_t       b;
+
+    for (b = i; b < src->capacity; b += table->stripe_count) {
+        Entry *e;
+
+        for (e = LOAD(src->buckets[b]); e; e = LOAD(e->next)) {
+            Entry          *copy   = table->mem_alloc(sizeof(Entry));
+            Entry *_Atomic *bucket = &dst->buckets[e->hash & mask];
+
+            if (!copy) {
+                free_chains(table, dst, i);
+                return false;
+            }
+
+            copy->key  = e->key;
+            copy->hash = e->hash;
+            atomic_init(&copy->value, LOAD(e->value));
+            atomic_init(&copy->next, LOAD(*bucket));
+            atomic_store_explicit(bucket, copy, memory_order_relaxed);
+        }
+    }
+    PUBLISH(s->view, dst);
+    return true;
+}
+
+/**
+ * Frees the entries of stripe i in the bucket array and clears its buckets.
+ */
+static void free_chains(ConcurrentHashTable *table, BucketArray *a, size_t i)
+{
+    size_t b;
+
+    for (b = i; b < a->capacity; b += table->stripe_count) {
+        Entry *e = LOAD(a->buckets[b]);
+
+        while (e) {
+            Entry *next = LOAD(e->next);
+            table->mem_free(e);
+            e = next;
+        }
+        atomic_store_explicit(&a->buckets[b], NULL, memory_order_relaxed);
+    }
+}
@@ -33,6 +33,7 @@ struct deque_s {
     void *(*mem_alloc)  (size_t size);
     void *(*mem_calloc) (size_t blocks, size_t size);
     void  (*mem_free)   (void *block);
+    void *(*mem_realloc) (void *block, size_t size);
 };
 
 static size_t upper_pow_two (size_t);
@@ -85,6 +86,7 @@ enum cc_stat deque_new_conf(DequeConf const * const conf, Deque **d)
     deque->mem_alloc  = conf->mem_alloc;
     deque->mem_calloc = conf->mem_calloc;
     deque->mem_free   = conf->mem_free;
+    deque->mem_realloc = conf->mem_realloc;
     deque->capacity   = upper_pow_two(conf->capacity);
     deque->first      = 0;
     deque->last       = 0;
@@ -105,6 +107,7 @@ void deque_conf_init(DequeConf *conf)
     conf->mem_alloc  = malloc;
     conf->mem_calloc = calloc;
     conf->mem_free   = free;
+    conf->mem_realloc = NULL;
 }
 
 /**
@@ -588,6 +591,7 @@ enum cc_stat deque_copy_shallow(Deque const * const deque, Deque **out)
     copy->mem_alloc  = deque->mem_alloc;
     copy->mem_calloc = deque->mem_calloc;
     copy->mem_free   = deque->mem_free;
+    copy->mem_realloc = deque->mem_realloc;
 
     copy_buffer(deque, copy->buffer, NULL);
 
@@ -630,6 +634,7 @@ enum cc_stat deque_copy_deep(Deque const * const deque, void *(*cp) (void*), Deq
     copy->mem_alloc  = deque->mem_alloc;
     copy->mem_calloc = deque->mem_calloc;
     copy->mem_free   = deque->mem_free;
+    copy->mem_realloc = deque->mem_realloc;
 
     copy_buffer(deque, copy->buffer, cp);
 
@@ -951,6 +956,32 @@ static enum cc_stat expand_capacity(Deque *deque)
         return CC_ERR_MAX_CAPACITY;
 
     size_t new_capacity = deque->capacity << 1;
+
+    if (deque->mem_realloc) {
+        void **new_buffer = deque->mem_realloc(deque->buffer, new_capacity * sizeof(void*));
+
+        if (!new_buffer)
+            return CC_ERR_ALLOC;
+
+        /* The deque is full, so its elements run from first to the old
+         * end of the buffer and wrap around to first. Move the shorter
+         * part past the old end to make them contiguous again. */
+        size_t c = deque->capacity;
+        size_t f = deque->first;
+
+        if (f < c - f) {
+            memcpy(&new_buffer[c], new_buffer, f * sizeof(void*));
+            deque->last = c + f;
+        } else {
+            memcpy(&new_buffer[c + f], &new_buffer[f], (c - f) * sizeof(void*));
+            deque->first = c + f;
+        }
+        deque->capacity = new_capacity;
+        deque->buffer   = new_buffer;
+
+        return CC_OK;
+    }
+
     void **new_buffer = deque->mem_calloc(new_capacity, sizeof(void*));
 
     if (!new_buffer)
@@ -0,0 +1,229 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2015 Srđan Panić <srdja.panic@gmail.com>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#include "epoch_internal.h"
+
+#define CACHE_LINE 64
+
+/* Every thread counts its active readers in one slot. The counter that a
+ * reader uses is picked by the parity of the epoch it entered in, so that a
+ * writer can wait for the readers of the previous epoch to drain while new
+ * readers use the other counter. */
+typedef union epoch_slot_u {
+    atomic_size_t active[2];
+    char          pad[CACHE_LINE];
+} EpochSlot;
+
+struct epoch_s {
+    EpochSlot       slots[EPOCH_SLOTS];
+
+    atomic_size_t   epoch;
+    pthread_mutex_t lock;
+
+    void           *block;
+    void          (*mem_free) (void *block);
+};
+
+/* Reader slots are handed out to threads from the used_slots bitmap and are
+ * given back when the thread exits, through the destructor of slot_key.
+ * Threads beyond the first EPOCH_SLOTS live ones share slots round robin. */
+static atomic_uint_least64_t      used_slots;
+static atomic_uint                shared_slot;
+static pthread_once_t             slot_once = PTHREAD_ONCE_INIT;
+static pthread_key_t              slot_key;
+static _Thread_local unsigned int thread_slot = UINT_MAX;
+
+_Static_assert(EPOCH_SLOTS <= 64, "used_slots holds one bit per slot");
+
+static void         slot_key_init (void);
+static void         slot_release  (void *slot);
+static unsigned int slot_acquire  (void);
+
+
+/**
+ * Creates a new reclamation domain.
+ *
+ * @param[in] mem_alloc allocator of the domain
+ * @param[in] mem_free  the matching deallocator
+ * @param[out] out      pointer to where the new domain is stored
+ *
+ * @return CC_OK if the domain was created, or CC_ERR_ALLOC if the memory
+ * allocation failed.
+ */
+enum cc_stat epoch_new(void *(*mem_alloc) (size_t size),
+                       void  (*mem_free)  (void *block),
+                       Epoch **out)
+{
+    void *block = mem_alloc(sizeof(Epoch) + CACHE_LINE);
+
+    if (!block)
+        return CC_ERR_ALLOC;
+
+    /* align the reader slots to a cache line */
+    Epoch *epoch = (Epoch*)
+        (((uintptr_t) block + CACHE_LINE - 1) & ~(uintptr_t) (CACHE_LINE - 1));
+
+    size_t i;
+    for (i = 0; i < EPOCH_SLOTS; i++) {
+        atomic_init(&epoch->slots[i].active[0], 0);
+        atomic_init(&epoch->slots[i].active[1], 0);
+    }
+    atomic_init(&epoch->epoch, 0);
+    pthread_mutex_init(&epoch->lock, NULL);
+
+    epoch->block    = block;
+    epoch->mem_free = mem_free;
+
+    *out = epoch;
+    return CC_OK;
+}
+
+/**
+ * Destroys the domain. No thread may be inside of it.
+ *
+ * @param[in] epoch the domain that is being destroyed
+ */
+void epoch_destroy(Epoch *epoch)
+{
+    pthread_mutex_destroy(&epoch->lock);
+    epoch->mem_free(epoch->block);
+}
+
+/**
+ * Enters the domain on the calling thread. Blocks that were reachable when
+ * the call returned stay allocated until the matching epoch_exit().
+ *
+ * @param[in] epoch the domain that is being entered
+ *
+ * @return a token that must be passed to epoch_exit().
+ */
+size_t epoch_enter(Epoch *epoch)
+{
+    if (thread_slot == UINT_MAX)
+        thread_slot = slot_acquire();
+
+    EpochSlot *slot = &epoch->slots[thread_slot];
+
+    for (;;) {
+        size_t e = atomic_load(&epoch->epoch);
+
+        atomic_fetch_add(&slot->active[e & 1], 1);
+
+        /* If the epoch moved on before the reader was counted, the writer
+         * may already be waiting on the other counter. */
+        if (atomic_load(&epoch->epoch) == e)
+            return thread_slot * 2 + (e & 1);
+
+        atomic_fetch_sub(&slot->active[e & 1], 1);
+    }
+}
+
+/**
+ * Leaves the domain.
+ *
+ * @param[in] epoch the domain that is being left
+ * @param[in] token the token returned by epoch_enter()
+ */
+void epoch_exit(Epoch *epoch, size_t token)
+{
+    atomic_fetch_sub_explicit(&epoch->slots[token / 2].active[token & 1], 1,
+                              memory_order_release);
+}
+
+/**
+ * Waits until every reader that entered the domain before the call has left
+ * it. Blocks that were unlinked before the call can be freed afterwards.
+ * Must not be called from inside of the domain.
+ *
+ * @param[in] epoch the domain whose readers are being waited for
+ */
+void epoch_synchronize(Epoch *epoch)
+{
+    pthread_mutex_lock(&epoch->lock);
+
+    size_t parity = atomic_fetch_add(&epoch->epoch, 1) & 1;
+    size_t i;
+
+    for (i = 0; i < EPOCH_SLOTS; i++) {
+        while (atomic_load(&epoch->slots[i].active[parity]) != 0)
+            sched_yield();
+    }
+    pthread_mutex_unlock(&epoch->lock);
+}
+
+/**
+ * Creates the key whose destructor gives a thread's reader slot back.
+ */
+static void slot_key_init(void)
+{
+    pthread_key_create(&slot_key, slot_release);
+}
+
+/**
+ * Marks the reader slot of an exiting thread as free.
+ *
+ * @param[in] slot the slot index plus one
+ */
+static void slot_release(void *slot)
+{
+    uint_least64_t bit = (uint_least64_t) 1 << ((uintptr_t) slot - 1);
+
+    atomic_fetch_and(&used_slots, ~bit);
+}
+
+/**
+ * Picks the reader slot of the calling thread. A free slot is reserved for
+ * the thread until it exits. If every slot is taken, the thread shares one
+ * with other threads, which is still correct, but the readers then write
+ * to the same cache line.
+ *
+ * @return the index of the slot.
+ */
+static unsigned int slot_acquire(void)
+{
+    uint_least64_t used = atomic_load(&used_slots);
+    unsigned int   i;
+
+    pthread_once(&slot_once, slot_key_init);
+
+    for (;;) {
+        for (i = 0; i < EPOCH_SLOTS && (used >> i & 1); i++)
+            ;
+
+        if (i == EPOCH_SLOTS)
+            break;
+
+        /* On failure used is reloaded and the search starts over */
+        if (atomic_compare_exchange_weak(&used_slots, &used,
+                                         used | (uint_least64_t) 1 << i)) {
+            if (pthread_setspecific(slot_key, (void*) (uintptr_t) (i + 1)) == 0)
+                return i;
+
+            slot_release((void*) (uintptr_t) (i + 1));
+            break;
+        }
+    }
+    return atomic_fetch_add(&shared_slot, 1) % EPOCH_SLOTS;
+}
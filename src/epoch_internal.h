@@ -0,0 +1,51 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2015 Srđan Panić <srdja.panic@gmail.com>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Epoch based reclamation of memory that lock-free readers may still be
+ * looking at. This header is internal to the library and isn't installed.
+ *
+ * Readers bracket their accesses with epoch_enter() and epoch_exit(). A
+ * writer that has unlinked a block from a shared structure calls
+ * epoch_synchronize(), which returns once every reader that could have seen
+ * the block has exited, after which the block can be freed.
+ *
+ * Readers only write to a reader slot that is private to their thread, as
+ * long as no more than EPOCH_SLOTS threads that have entered a domain are
+ * alive at the same time. Slots are reused once their threads exit. */
+
+#ifndef COLLECTIONS_C_EPOCH_INTERNAL_H
+#define COLLECTIONS_C_EPOCH_INTERNAL_H
+
+#include "common.h"
+
+#define EPOCH_SLOTS 64
+
+typedef struct epoch_s Epoch;
+
+enum cc_stat  epoch_new         (void *(*mem_alloc) (size_t size),
+                                 void  (*mem_free)  (void *block),
+                                 Epoch **out);
+void          epoch_destroy     (Epoch *epoch);
+
+size_t        epoch_enter       (Epoch *epoch);
+void          epoch_exit        (Epoch *epoch, size_t token);
+void          epoch_synchronize (Epoch *epoch);
+
+#endif /* COLLECTIONS_C_EPOCH_INTERNAL_H */
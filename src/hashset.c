@@ -18,17 +18,68 @@
  * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
+
 #include "hashset.h"
+#include "hashtable_internal.h"
+
+#define MIN_CAPACITY 2
 
+/* The set stores its elements in an open addressing table that is laid out
+ * like the open addressing HashTable backend, but without the values and
+ * stored hashes. Each slot is a single element pointer and has a control
+ * byte (see hashtable_internal.h), so an element costs sizeof(void*) + 1
+ * bytes of table memory. Sets smaller than a group use a single group whose
+ * trailing control bytes are always empty and masked out of the probes. */
 struct hashset_s {
-    HashTable *table;
-    int       *dummy;
+    size_t   capacity;
+    size_t   size;
+    size_t   deleted;
+    size_t   threshold;
+    size_t   min_capacity;
+    size_t   group_index_mask;
+    uint32_t group_mask;
+    uint32_t hash_seed;
+    int      key_len;
+    float    load_factor;
+    float    min_load_factor;
+
+    uint8_t  *ctrl;
+    void    **slots;
 
-    void *(*mem_alloc)  (size_t size);
-    void *(*mem_calloc) (size_t blocks, size_t size);
-    void  (*mem_free)   (void *block);
+    size_t (*hash)       (const void *key, int l, uint32_t seed);
+    int    (*key_cmp)    (const void *k1, const void *k2);
+    void  *(*mem_alloc)  (size_t size);
+    void  *(*mem_calloc) (size_t blocks, size_t size);
+    void   (*mem_free)   (void *block);
 };
 
+/* A batch of up to BATCH_WIDTH elements taken from one set, together with
+ * their slots in that set and their hashes and slots in another set. */
+typedef struct probe_batch_s {
+    size_t  next;
+    size_t  n;
+    void   *elements[BATCH_WIDTH];
+    size_t  src_slots[BATCH_WIDTH];
+    size_t  hashes[BATCH_WIDTH];
+    size_t  slots[BATCH_WIDTH];
+} ProbeBatch;
+
+static enum cc_stat set_alloc        (HashSet *set, size_t capacity);
+static enum cc_stat set_resize       (HashSet *set, size_t new_capacity);
+static enum cc_stat set_reserve      (HashSet *set, size_t n);
+static enum cc_stat set_new_like     (HashSet *proto, size_t n, HashSet **out);
+static void         set_copy         (HashSet *dst, HashSet *src);
+static size_t       set_find         (HashSet *set, const void *element, size_t hash);
+static void         set_find_batch   (HashSet *set, void **elements, size_t n,
+                                      size_t *hashes, size_t *slots);
+static size_t       set_find_free    (HashSet *set, size_t hash);
+static size_t       set_next_full    (HashSet *set, size_t slot);
+static void         set_insert_unique(HashSet *set, void *element, size_t hash);
+static void         set_remove_at    (HashSet *set, size_t slot);
+static void         maybe_shrink     (HashSet *set);
+static size_t       probe_next       (HashSet *src, HashSet *dst, ProbeBatch *batch);
+
 /**
  * Initializes the fields of the HashSetConf struct to default values.
  *
@@ -74,22 +125,30 @@ enum cc_stat hashset_new_conf(HashSetConf const * const conf, HashSet **hs)
     if (!set)
         return CC_ERR_ALLOC;
 
-    HashTable *table;
-    enum cc_stat stat = hashtable_new_conf(conf, &table);
+    set->hash        = conf->hash;
+    set->key_cmp     = conf->key_compare;
+    set->key_len     = conf->key_length;
+    set->hash_seed   = conf->random_seed ? hashtable_random_seed() : conf->hash_seed;
+    set->load_factor = conf->load_factor;
+    set->min_load_factor = conf->min_load_factor;
+    set->min_capacity    = round_pow_two(conf->initial_capacity);
+    set->mem_alloc   = conf->mem_alloc;
+    set->mem_calloc  = conf->mem_calloc;
+    set->mem_free    = conf->mem_free;
 
-    if (stat != CC_OK) {
-        conf->mem_free(set);
-        return stat;
-    }
+    if (set->load_factor > OA_MAX_LOAD_FACTOR)
+        set->load_factor = OA_MAX_LOAD_FACTOR;
 
-    set->table      = table;
-    set->mem_alloc  = conf->mem_alloc;
-    set->mem_calloc = conf->mem_calloc;
-    set->mem_free   = conf->mem_free;
+    if (set->min_load_factor > set->load_factor / 4)
+        set->min_load_factor = set->load_factor / 4;
 
-    /* A dummy pointer that is never actually dereferenced
-    *  that must not be null.*/
-    set->dummy = (int*) 1;
+    if (set->min_capacity < MIN_CAPACITY)
+        set->min_capacity = MIN_CAPACITY;
+
+    if (set_alloc(set, round_pow_two(conf->initial_capacity)) != CC_OK) {
+        conf->mem_free(set);
+        return CC_ERR_ALLOC;
+    }
     *hs = set;
     return CC_OK;
 }
@@ -102,39 +161,126 @@ enum cc_stat hashset_new_conf(HashSetConf const * const conf, HashSet **hs)
  */
 void hashset_destroy(HashSet *set)
 {
-    hashtable_destroy(set->table);
+    set->mem_free(set->ctrl);
+    set->mem_free(set->slots);
     set->mem_free(set);
 }
 
 /**
- * Adds a new element to the HashSet.
+ * Returns the hash of the element. NULL always hashes to zero.
+ */
+static INLINE size_t hash_element(HashSet *set, const void *element)
+{
+    return element ? set->hash(element, set->key_len, set->hash_seed) : 0;
+}
+
+/**
+ * Adds a new element to the HashSet. If an equal element is already in the
+ * set, the set is left unchanged.
  *
  * @param[in] set the set to which the element is being added
  * @param[in] element the element being added
  *
- * @return CC_OK if the element was successfully added, or CC_ERR_ALLOC
- * if the memory allocation failed.
+ * @return CC_OK if the element was successfully added, CC_ERR_ALLOC if the
+ * memory allocation failed, or CC_ERR_MAX_CAPACITY if the set is already at
+ * its maximum capacity.
  */
 enum cc_stat hashset_add(HashSet *set, void *element)
 {
-    return hashtable_add(set->table, element, set->dummy);
+    const size_t hash = hash_element(set, element);
+
+    if (set_find(set, element, hash) != SLOT_NONE)
+        return CC_OK;
+
+    if (set->size + set->deleted >= set->threshold) {
+        /* If at least half of the used slots are tombstones it's enough
+         * to clean them up, otherwise the set grows. */
+        size_t new_capacity = set->capacity;
+
+        if (set->size >= set->deleted) {
+            if (set->capacity == MAX_POW_TWO)
+                return CC_ERR_MAX_CAPACITY;
+            new_capacity <<= 1;
+        }
+        enum cc_stat stat = set_resize(set, new_capacity);
+        if (stat != CC_OK)
+            return stat;
+    }
+    set_insert_unique(set, element, hash);
+
+    return CC_OK;
+}
+
+/**
+ * Adds n elements to the HashSet. The result is the same as calling
+ * hashset_add() for every element.
+ *
+ * The set is first reserved for all n elements, so it's resized at most
+ * once. The elements are then hashed a batch at a time, and their first
+ * probe groups prefetched, before any of them is placed.
+ *
+ * @param[in] set the set to which the elements are being added
+ * @param[in] elements array of n elements
+ * @param[in] n number of elements
+ *
+ * @return CC_OK if all elements were added, CC_ERR_ALLOC if the memory
+ * allocation failed, or CC_ERR_MAX_CAPACITY if the set can't grow large
+ * enough, in which case the set is left unchanged.
+ */
+enum cc_stat hashset_add_all_from_array(HashSet *set, void **elements, size_t n)
+{
+    size_t hashes[BATCH_WIDTH];
+    size_t base;
+
+    enum cc_stat stat = set_reserve(set, set->size + n);
+    if (stat != CC_OK)
+        return stat;
+
+    for (base = 0; base < n; base += BATCH_WIDTH) {
+        const size_t width = n - base < BATCH_WIDTH ? n - base : BATCH_WIDTH;
+        size_t k;
+
+        for (k = 0; k < width; k++) {
+            hashes[k] = hash_element(set, elements[base + k]);
+
+            size_t slot = ((hashes[k] >> 7) & set->group_index_mask) * GROUP_WIDTH;
+
+            PREFETCH(set->ctrl + slot);
+            PREFETCH(set->slots + slot);
+        }
+        for (k = 0; k < width; k++) {
+            if (set_find(set, elements[base + k], hashes[k]) == SLOT_NONE)
+                set_insert_unique(set, elements[base + k], hashes[k]);
+        }
+    }
+    return CC_OK;
 }
 
 /**
  * Removes the specified element from the HashSet and sets the out
- * parameter to its value.
+ * parameter to the element that was stored in the set.
  *
  * @param[in] set the set from which the element is being removed
  * @param[in] element the element being removed
- * @param[out] out Pointer to where the removed value is stored, or NULL
+ * @param[out] out Pointer to where the removed element is stored, or NULL
  *                 if it is to be ignored
  *
- * @return CC_OK if the element was successfully removed, or CC_ERR_VALUE_NOT_FOUND
- * if the value was not found.
+ * @return CC_OK if the element was successfully removed, or CC_ERR_KEY_NOT_FOUND
+ * if the element was not found.
  */
 enum cc_stat hashset_remove(HashSet *set, void *element, void **out)
 {
-    return hashtable_remove(set->table, element, out);
+    size_t slot = set_find(set, element, hash_element(set, element));
+
+    if (slot == SLOT_NONE)
+        return CC_ERR_KEY_NOT_FOUND;
+
+    if (out)
+        *out = set->slots[slot];
+
+    set_remove_at(set, slot);
+    maybe_shrink(set);
+    return CC_OK;
 }
 
 /**
@@ -144,7 +290,11 @@ enum cc_stat hashset_remove(HashSet *set, void *element, void **out)
  */
 void hashset_remove_all(HashSet *set)
 {
-    hashtable_remove_all(set->table);
+    memset(set->ctrl, CTRL_EMPTY, set->capacity < GROUP_WIDTH ? GROUP_WIDTH : set->capacity);
+    set->size    = 0;
+    set->deleted = 0;
+
+    maybe_shrink(set);
 }
 
 /**
@@ -157,7 +307,312 @@ void hashset_remove_all(HashSet *set)
  */
 bool hashset_contains(HashSet *set, void *element)
 {
-    return hashtable_contains_key(set->table, element);
+    return set_find(set, element, hash_element(set, element)) != SLOT_NONE;
+}
+
+/**
+ * Checks which of the n elements are a part of the specified set. This is
+ * equivalent to calling hashset_contains() for every element, but the
+ * memory accesses of multiple lookups are overlapped.
+ *
+ * @param[in] set the set being searched for the specified elements
+ * @param[in] elements array of n elements being searched for
+ * @param[in] n number of elements
+ * @param[out] out array of n flags where true is stored if the i-th element
+ *                 is an element of the set, or NULL if only the result is
+ *                 of interest
+ *
+ * @return true if all specified elements are elements of the set
+ */
+bool hashset_contains_batch(HashSet *set, void **elements, size_t n, bool *out)
+{
+    size_t hashes[BATCH_WIDTH];
+    size_t slots[BATCH_WIDTH];
+    bool   all = true;
+    size_t base;
+
+    for (base = 0; base < n; base += BATCH_WIDTH) {
+        const size_t width = n - base < BATCH_WIDTH ? n - base : BATCH_WIDTH;
+        size_t k;
+
+        set_find_batch(set, elements + base, width, hashes, slots);
+
+        for (k = 0; k < width; k++) {
+            bool found = slots[k] != SLOT_NONE;
+
+            if (out)
+                out[base + k] = found;
+            all = all && found;
+        }
+    }
+    return all;
+}
+
+/**
+ * Creates a new set that holds the elements of both sets. Both sets must
+ * use the same hash function, key comparator and key length. The new set
+ * is configured like set a, and if both sets hold equal elements, the one
+ * from set a is kept.
+ *
+ * The larger set is copied without any lookups and only the elements of the
+ * smaller set are probed. The new set is sized for both sets up front, so
+ * it's never resized while it's being filled.
+ *
+ * @param[in] a the first set
+ * @param[in] b the second set
+ * @param[out] out Pointer to where the new set is stored
+ *
+ * @return CC_OK if the set was successfully created, or CC_ERR_ALLOC if the
+ * memory allocation for the new set failed.
+ */
+enum cc_stat hashset_union(HashSet *a, HashSet *b, HashSet **out)
+{
+    HashSet *large = a->size >= b->size ? a : b;
+    HashSet *small = large == a ? b : a;
+    HashSet *set;
+
+    enum cc_stat stat = set_new_like(a, a->size + b->size, &set);
+    if (stat != CC_OK)
+        return stat;
+
+    set_copy(set, large);
+
+    ProbeBatch batch;
+    batch.next = 0;
+
+    while (probe_next(small, set, &batch)) {
+        size_t k;
+        for (k = 0; k < batch.n; k++) {
+            if (batch.slots[k] == SLOT_NONE)
+                set_insert_unique(set, batch.elements[k], batch.hashes[k]);
+            else if (small == a)
+                set->slots[batch.slots[k]] = batch.elements[k];
+        }
+    }
+    *out = set;
+    return CC_OK;
+}
+
+/**
+ * Creates a new set that holds the elements that are in both sets. Both
+ * sets must use the same hash function, key comparator and key length. The
+ * new set is configured like set a and holds the elements of set a.
+ *
+ * Only the elements of the smaller set are probed, and the new set is sized
+ * for the smaller set up front.
+ *
+ * @param[in] a the first set
+ * @param[in] b the second set
+ * @param[out] out Pointer to where the new set is stored
+ *
+ * @return CC_OK if the set was successfully created, or CC_ERR_ALLOC if the
+ * memory allocation for the new set failed.
+ */
+enum cc_stat hashset_intersection(HashSet *a, HashSet *b, HashSet **out)
+{
+    HashSet *large = a->size >= b->size ? a : b;
+    HashSet *small = large == a ? b : a;
+    HashSet *set;
+
+    enum cc_stat stat = set_new_like(a, small->size, &set);
+    if (stat != CC_OK)
+        return stat;
+
+    const bool rehash = set->hash != large->hash || set->hash_seed != large->hash_seed;
+
+    ProbeBatch batch;
+    batch.next = 0;
+
+    while (probe_next(small, large, &batch)) {
+        size_t k;
+        for (k = 0; k < batch.n; k++) {
+            if (batch.slots[k] == SLOT_NONE)
+                continue;
+
+            void *e = small == a ? batch.elements[k] : large->slots[batch.slots[k]];
+            set_insert_unique(set, e, rehash ? hash_element(set, e) : batch.hashes[k]);
+        }
+    }
+    *out = set;
+    return CC_OK;
+}
+
+/**
+ * Creates a new set that holds the elements of set a that are not in set b.
+ * Both sets must use the same hash function, key comparator and key length.
+ * The new set is configured like set a.
+ *
+ * If set b is the smaller one, set a is copied and the elements of set b
+ * are removed from the copy. Otherwise the elements of set a are probed in
+ * set b. Either way the new set is sized for set a up front.
+ *
+ * @param[in] a the set whose elements are kept
+ * @param[in] b the set whose elements are left out
+ * @param[out] out Pointer to where the new set is stored
+ *
+ * @return CC_OK if the set was successfully created, or CC_ERR_ALLOC if the
+ * memory allocation for the new set failed.
+ */
+enum cc_stat hashset_difference(HashSet *a, HashSet *b, HashSet **out)
+{
+    HashSet *set;
+
+    enum cc_stat stat = set_new_like(a, a->size, &set);
+    if (stat != CC_OK)
+        return stat;
+
+    ProbeBatch batch;
+    batch.next = 0;
+
+    if (b->size < a->size) {
+        set_copy(set, a);
+
+        while (probe_next(b, set, &batch)) {
+            size_t k;
+            for (k = 0; k < batch.n; k++) {
+                if (batch.slots[k] != SLOT_NONE)
+                    set_remove_at(set, batch.slots[k]);
+            }
+        }
+    } else {
+        const bool rehash = set->hash != b->hash || set->hash_seed != b->hash_seed;
+
+        while (probe_next(a, b, &batch)) {
+            size_t k;
+            for (k = 0; k < batch.n; k++) {
+                if (batch.slots[k] != SLOT_NONE)
+                    continue;
+
+                void *e = batch.elements[k];
+                set_insert_unique(set, e, rehash ? hash_element(set, e) : batch.hashes[k]);
+            }
+        }
+    }
+    *out = set;
+    return CC_OK;
+}
+
+/**
+ * Adds the elements of set b to set a. Both sets must use the same hash
+ * function, key comparator and key length. Set a keeps its own element if
+ * both sets hold equal elements.
+ *
+ * Set a is grown once to make room for all elements of set b before any of
+ * them is added.
+ *
+ * @param[in] a the set to which the elements are added
+ * @param[in] b the set whose elements are added
+ *
+ * @return CC_OK if the elements were successfully added, CC_ERR_ALLOC if the
+ * memory allocation failed, or CC_ERR_MAX_CAPACITY if set a can't grow any
+ * further. Set a is left unchanged if an error is returned.
+ */
+enum cc_stat hashset_union_mut(HashSet *a, HashSet *b)
+{
+    if (a == b)
+        return CC_OK;
+
+    enum cc_stat stat = set_reserve(a, a->size + b->size);
+    if (stat != CC_OK)
+        return stat;
+
+    ProbeBatch batch;
+    batch.next = 0;
+
+    while (probe_next(b, a, &batch)) {
+        size_t k;
+        for (k = 0; k < batch.n; k++) {
+            if (batch.slots[k] == SLOT_NONE)
+                set_insert_unique(a, batch.elements[k], batch.hashes[k]);
+        }
+    }
+    return CC_OK;
+}
+
+/**
+ * Removes the elements of set a that are not in set b. Both sets must use
+ * the same hash function, key comparator and key length.
+ *
+ * If set a is the smaller one, its elements are probed in set b and
+ * removed in place. Otherwise the (smaller) intersection is built in new
+ * storage that then replaces the storage of set a.
+ *
+ * @param[in] a the set from which the elements are removed
+ * @param[in] b the set whose elements are kept
+ *
+ * @return CC_OK if the operation was successful, or CC_ERR_ALLOC if the
+ * memory allocation failed, in which case set a is left unchanged.
+ */
+enum cc_stat hashset_intersection_mut(HashSet *a, HashSet *b)
+{
+    ProbeBatch batch;
+    batch.next = 0;
+
+    if (a->size <= b->size) {
+        while (probe_next(a, b, &batch)) {
+            size_t k;
+            for (k = 0; k < batch.n; k++) {
+                if (batch.slots[k] == SLOT_NONE)
+                    set_remove_at(a, batch.src_slots[k]);
+            }
+        }
+        return CC_OK;
+    }
+
+    HashSet *set;
+    enum cc_stat stat = hashset_intersection(a, b, &set);
+    if (stat != CC_OK)
+        return stat;
+
+    a->mem_free(a->ctrl);
+    a->mem_free(a->slots);
+
+    a->capacity         = set->capacity;
+    a->size             = set->size;
+    a->deleted          = set->deleted;
+    a->threshold        = set->threshold;
+    a->group_index_mask = set->group_index_mask;
+    a->group_mask       = set->group_mask;
+    a->ctrl             = set->ctrl;
+    a->slots            = set->slots;
+
+    a->mem_free(set);
+    return CC_OK;
+}
+
+/**
+ * Removes the elements of set b from set a. Both sets must use the same
+ * hash function, key comparator and key length. The elements of the smaller
+ * set are the ones that are probed.
+ *
+ * @param[in] a the set from which the elements are removed
+ * @param[in] b the set whose elements are removed
+ *
+ * @return CC_OK
+ */
+enum cc_stat hashset_difference_mut(HashSet *a, HashSet *b)
+{
+    ProbeBatch batch;
+    batch.next = 0;
+
+    if (b->size < a->size) {
+        while (probe_next(b, a, &batch)) {
+            size_t k;
+            for (k = 0; k < batch.n; k++) {
+                if (batch.slots[k] != SLOT_NONE)
+                    set_remove_at(a, batch.slots[k]);
+            }
+        }
+    } else {
+        while (probe_next(a, b, &batch)) {
+            size_t k;
+            for (k = 0; k < batch.n; k++) {
+                if (batch.slots[k] != SLOT_NONE)
+                    set_remove_at(a, batch.src_slots[k]);
+            }
+        }
+    }
+    return CC_OK;
 }
 
 /**
@@ -169,7 +624,7 @@ bool hashset_contains(HashSet *set, void *element)
  */
 size_t hashset_size(HashSet *set)
 {
-    return hashtable_size(set->table);
+    return set->size;
 }
 
 /**
@@ -181,7 +636,43 @@ size_t hashset_size(HashSet *set)
  */
 size_t hashset_capacity(HashSet *set)
 {
-    return hashtable_capacity(set->table);
+    return set->capacity;
+}
+
+/**
+ * Grows the set so that it can hold n elements without resizing. The set is
+ * never shrunk by this function.
+ *
+ * @param[in] set the set that is being grown
+ * @param[in] n the number of elements the set should be able to hold
+ *
+ * @return CC_OK if the set was successfully grown, CC_ERR_ALLOC if the memory
+ * allocation failed, or CC_ERR_MAX_CAPACITY if n elements exceed the maximum
+ * capacity of the set.
+ */
+enum cc_stat hashset_reserve(HashSet *set, size_t n)
+{
+    return set_reserve(set, n);
+}
+
+/**
+ * Shrinks the set to the smallest capacity that holds its elements.
+ *
+ * @note This invalidates all iterators of the set.
+ *
+ * @param[in] set the set that is being shrunk
+ *
+ * @return CC_OK if the set was successfully shrunk, or CC_ERR_ALLOC if the
+ * memory allocation failed, in which case the set is left unchanged.
+ */
+enum cc_stat hashset_shrink_to_fit(HashSet *set)
+{
+    size_t capacity = capacity_for(set->size, set->load_factor, MIN_CAPACITY);
+
+    if (capacity >= set->capacity && !set->deleted)
+        return CC_OK;
+
+    return set_resize(set, capacity < set->capacity ? capacity : set->capacity);
 }
 
 /**
@@ -193,7 +684,9 @@ size_t hashset_capacity(HashSet *set)
  */
 void hashset_foreach(HashSet *set, void (*fn) (const void *e))
 {
-    hashtable_foreach_key(set->table, fn);
+    size_t i;
+    for (i = set_next_full(set, 0); i != SLOT_NONE; i = set_next_full(set, i + 1))
+        fn(set->slots[i]);
 }
 
 /**
@@ -204,7 +697,9 @@ void hashset_foreach(HashSet *set, void (*fn) (const void *e))
  */
 void hashset_iter_init(HashSetIter *iter, HashSet *set)
 {
-    hashtable_iter_init(&(iter->iter), set->table);
+    iter->set  = set;
+    iter->next = set_next_full(set, 0);
+    iter->last = SLOT_NONE;
 }
 
 /**
@@ -219,14 +714,14 @@ void hashset_iter_init(HashSetIter *iter, HashSet *set)
  */
 enum cc_stat hashset_iter_next(HashSetIter *iter, void **out)
 {
-    TableEntry *entry;
-    enum cc_stat status = hashtable_iter_next(&(iter->iter), &entry);
+    if (iter->next == SLOT_NONE)
+        return CC_ITER_END;
 
-    if (status != CC_OK)
-        return status;
+    iter->last = iter->next;
+    iter->next = set_next_full(iter->set, iter->next + 1);
 
     if (out)
-        *out = entry->key;
+        *out = iter->set->slots[iter->last];
 
     return CC_OK;
 }
@@ -244,9 +739,320 @@ enum cc_stat hashset_iter_next(HashSetIter *iter, void **out)
  *                 if it is to be ignored
  *
  * @return CC_OK if the entry was successfully removed, or
- * CC_ERR_VALUE_NOT_FOUND.
+ * CC_ERR_KEY_NOT_FOUND if the last returned element was already removed.
  */
 enum cc_stat hashset_iter_remove(HashSetIter *iter, void **out)
 {
-    return hashtable_iter_remove(&(iter->iter), out);
+    if (iter->last == SLOT_NONE)
+        return CC_ERR_KEY_NOT_FOUND;
+
+    if (out)
+        *out = iter->set->slots[iter->last];
+
+    set_remove_at(iter->set, iter->last);
+    iter->last = SLOT_NONE;
+
+    return CC_OK;
+}
+
+
+/*******************************************************************************
+ *
+ *
+ *  Slot table
+ *
+ *
+ ******************************************************************************/
+
+/**
+ * Allocates empty slot and control arrays of the given capacity and
+ * attaches them to the set. The control array always covers at least one
+ * full group.
+ */
+static enum cc_stat set_alloc(HashSet *set, size_t capacity)
+{
+    if (capacity < MIN_CAPACITY)
+        capacity = MIN_CAPACITY;
+
+    const size_t ctrl_size = capacity < GROUP_WIDTH ? GROUP_WIDTH : capacity;
+
+    uint8_t *ctrl  = set->mem_alloc(ctrl_size);
+    void   **slots = set->mem_alloc(capacity * sizeof(void*));
+
+    if (!ctrl || !slots) {
+        set->mem_free(ctrl);
+        set->mem_free(slots);
+        return CC_ERR_ALLOC;
+    }
+    memset(ctrl, CTRL_EMPTY, ctrl_size);
+
+    set->ctrl             = ctrl;
+    set->slots            = slots;
+    set->capacity         = capacity;
+    set->deleted          = 0;
+    set->group_index_mask = ctrl_size / GROUP_WIDTH - 1;
+    set->group_mask       = capacity < GROUP_WIDTH ? ((uint32_t) 1 << capacity) - 1
+                                                   : GROUP_MASK_ALL;
+    set->threshold        = capacity * set->load_factor;
+
+    if (set->threshold == 0)
+        set->threshold = 1;
+
+    return CC_OK;
+}
+
+/**
+ * Makes sure that n elements fit into the set without a resize. Tombstones
+ * are dropped if the set has to be resized.
+ */
+static enum cc_stat set_reserve(HashSet *set, size_t n)
+{
+    if (n + set->deleted <= set->threshold)
+        return CC_OK;
+
+    size_t capacity = capacity_for(n, set->load_factor, MIN_CAPACITY);
+
+    if ((size_t) (capacity * set->load_factor) < n)
+        return CC_ERR_MAX_CAPACITY;
+
+    if (capacity < set->capacity)
+        capacity = set->capacity;
+
+    return set_resize(set, capacity);
+}
+
+/**
+ * Shrinks the set once removals have dropped its load below the minimum
+ * load factor, the same way HashTable does. The new capacity puts the load
+ * at about half of the load factor. The set is left as it is if the memory
+ * allocation fails.
+ */
+static void maybe_shrink(HashSet *set)
+{
+    if (set->capacity <= set->min_capacity || set->size >= set->capacity * set->min_load_factor)
+        return;
+
+    size_t capacity = capacity_for(set->size * 2, set->load_factor, set->min_capacity);
+
+    if (capacity < set->capacity)
+        set_resize(set, capacity);
+}
+
+/**
+ * Creates an empty set that is configured like proto and can hold n
+ * elements without a resize.
+ */
+static enum cc_stat set_new_like(HashSet *proto, size_t n, HashSet **out)
+{
+    HashSet *set = proto->mem_alloc(sizeof(HashSet));
+
+    if (!set)
+        return CC_ERR_ALLOC;
+
+    *set      = *proto;
+    set->size = 0;
+
+    if (set_alloc(set, capacity_for(n, proto->load_factor, MIN_CAPACITY)) != CC_OK) {
+        proto->mem_free(set);
+        return CC_ERR_ALLOC;
+    }
+    *out = set;
+    return CC_OK;
+}
+
+/**
+ * Adds all elements of src to dst, which must be empty and have room for
+ * them.
+ */
+static void set_copy(HashSet *dst, HashSet *src)
+{
+    size_t i;
+    for (i = set_next_full(src, 0); i != SLOT_NONE; i = set_next_full(src, i + 1))
+        set_insert_unique(dst, src->slots[i], hash_element(dst, src->slots[i]));
+}
+
+/**
+ * Moves all elements into new slot and control arrays of the given capacity.
+ * Tombstones are dropped in the process. Since the set doesn't store the
+ * hashes of its elements, every element is hashed again.
+ */
+static enum cc_stat set_resize(HashSet *set, size_t new_capacity)
+{
+    uint8_t *old_ctrl  = set->ctrl;
+    void   **old_slots = set->slots;
+    size_t   old_cap   = set->capacity;
+
+    if (set_alloc(set, new_capacity) != CC_OK)
+        return CC_ERR_ALLOC;
+
+    size_t i;
+    for (i = 0; i < old_cap; i++) {
+        if (old_ctrl[i] & CTRL_EMPTY)
+            continue;
+
+        size_t hash = hash_element(set, old_slots[i]);
+        size_t slot = set_find_free(set, hash);
+
+        set->ctrl[slot]  = CTRL_H2(hash);
+        set->slots[slot] = old_slots[i];
+    }
+    set->mem_free(old_ctrl);
+    set->mem_free(old_slots);
+
+    return CC_OK;
+}
+
+/**
+ * Returns the slot that holds the element, or SLOT_NONE if the element is
+ * not in the set. Groups are probed quadratically (by triangular numbers),
+ * which visits every group exactly once.
+ */
+static size_t set_find(HashSet *set, const void *element, size_t hash)
+{
+    const uint8_t h2    = CTRL_H2(hash);
+    size_t        group = (hash >> 7) & set->group_index_mask;
+    size_t        step  = 0;
+
+    for (;;) {
+        const uint8_t *ctrl  = set->ctrl + group * GROUP_WIDTH;
+        uint32_t       match = group_match(ctrl, h2);
+
+        while (match) {
+            size_t slot = group * GROUP_WIDTH + ctz32(match);
+            void  *e    = set->slots[slot];
+
+            if (element ? (e && set->key_cmp(e, element) == 0) : !e)
+                return slot;
+
+            match &= match - 1;
+        }
+        /* An empty slot terminates every probe sequence that reaches it,
+         * so the element can't be in any of the following groups. */
+        if (group_match(ctrl, CTRL_EMPTY))
+            return SLOT_NONE;
+
+        group = (group + ++step) & set->group_index_mask;
+    }
+}
+
+/**
+ * Looks up n elements, where n is at most BATCH_WIDTH, and stores their
+ * hashes and slots. All elements are hashed and the first group of each
+ * probe sequence is prefetched before any element is compared.
+ */
+static void set_find_batch(HashSet *set, void **elements, size_t n,
+                           size_t *hashes, size_t *slots)
+{
+    size_t k;
+    for (k = 0; k < n; k++) {
+        hashes[k] = hash_element(set, elements[k]);
+
+        size_t slot = ((hashes[k] >> 7) & set->group_index_mask) * GROUP_WIDTH;
+
+        PREFETCH(set->ctrl + slot);
+        PREFETCH(set->slots + slot);
+    }
+    for (k = 0; k < n; k++)
+        slots[k] = set_find(set, elements[k], hashes[k]);
+}
+
+/**
+ * Takes the next batch of elements from src, starting at batch->next, and
+ * looks them up in dst. Elements of src that were already taken may be
+ * removed from src between the calls.
+ *
+ * @return the number of elements in the batch, which is 0 once all
+ * elements of src have been taken.
+ */
+static size_t probe_next(HashSet *src, HashSet *dst, ProbeBatch *batch)
+{
+    size_t slot = batch->next;
+    size_t n    = 0;
+
+    while (n < BATCH_WIDTH && (slot = set_next_full(src, slot)) != SLOT_NONE) {
+        batch->elements[n]  = src->slots[slot];
+        batch->src_slots[n] = slot;
+        n++;
+        slot++;
+    }
+    batch->next = slot;
+    batch->n    = n;
+
+    set_find_batch(dst, batch->elements, n, batch->hashes, batch->slots);
+
+    return n;
+}
+
+/**
+ * Returns the first empty or deleted slot on the probe sequence of the hash.
+ * The set must have at least one free slot.
+ */
+static size_t set_find_free(HashSet *set, size_t hash)
+{
+    size_t group = (hash >> 7) & set->group_index_mask;
+    size_t step  = 0;
+
+    for (;;) {
+        uint32_t free = group_match_free(set->ctrl + group * GROUP_WIDTH) & set->group_mask;
+
+        if (free)
+            return group * GROUP_WIDTH + ctz32(free);
+
+        group = (group + ++step) & set->group_index_mask;
+    }
+}
+
+/**
+ * Returns the first occupied slot at or after the specified slot, or
+ * SLOT_NONE if there are none.
+ */
+static size_t set_next_full(HashSet *set, size_t slot)
+{
+    while (slot < set->capacity) {
+        size_t   base = slot & ~((size_t) GROUP_WIDTH - 1);
+        uint32_t full = ~group_match_free(set->ctrl + base) & set->group_mask;
+
+        full &= GROUP_MASK_ALL << (slot - base);
+
+        if (full)
+            return base + ctz32(full);
+
+        slot = base + GROUP_WIDTH;
+    }
+    return SLOT_NONE;
+}
+
+/**
+ * Stores an element that isn't in the set yet without looking for it
+ * first. The set must have room for the element.
+ */
+static void set_insert_unique(HashSet *set, void *element, size_t hash)
+{
+    size_t slot = set_find_free(set, hash);
+
+    if (set->ctrl[slot] == CTRL_DELETED)
+        set->deleted--;
+
+    set->ctrl[slot]  = CTRL_H2(hash);
+    set->slots[slot] = element;
+    set->size++;
+}
+
+/**
+ * Releases an occupied slot.
+ */
+static void set_remove_at(HashSet *set, size_t slot)
+{
+    const uint8_t *group = set->ctrl + (slot & ~((size_t) GROUP_WIDTH - 1));
+
+    /* A probe only moves past a group that has no empty slots. If this
+     * group still has one, no probe sequence continues beyond it and the
+     * slot can be marked as empty instead of leaving a tombstone. */
+    if (group_match(group, CTRL_EMPTY)) {
+        set->ctrl[slot] = CTRL_EMPTY;
+    } else {
+        set->ctrl[slot] = CTRL_DELETED;
+        set->deleted++;
+    }
+    set->size--;
 }
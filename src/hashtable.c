@@ -18,11 +18,51 @@
  * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <pthread.h>
+#include <stddef.h>
+
 #include "hashtable.h"
+#include "hashtable_internal.h"
+
+#if defined(__linux__)
+#include <errno.h>
+#include <sys/random.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+#define HASHTABLE_ARC4RANDOM
+#endif
+
+#if !defined(HASHTABLE_ARC4RANDOM)
+#include <stdio.h>
+#include <time.h>
+#endif
 
 #define DEFAULT_CAPACITY 16
 #define DEFAULT_LOAD_FACTOR 0.75f
 
+/* Chained tables carve their entries out of chunks that start at
+ * ENTRY_CHUNK_MIN entries and double in size up to ENTRY_CHUNK_MAX. */
+#define ENTRY_CHUNK_MIN    16
+#define ENTRY_CHUNK_MAX    4096
+
+/* Entries of chained tables remember their position in the dense entry
+ * array. The key length is only stored if the table caches key lengths. */
+typedef struct chained_entry_s {
+    TableEntry entry;
+    size_t     order;
+    size_t     key_len;
+} ChainedEntry;
+
+#define ORDER(e)   (((ChainedEntry*) (e))->order)
+#define KEY_LEN(e) (((ChainedEntry*) (e))->key_len)
+
+#define DENSE_MIN_CAPACITY 16
+
+typedef struct entry_chunk_s {
+    struct entry_chunk_s *next;
+    size_t                capacity;
+    TableEntry            entries[];
+} EntryChunk;
+
 struct hashtable_s {
     size_t       capacity;
     size_t       size;
@@ -30,8 +70,64 @@ struct hashtable_s {
     uint32_t     hash_seed;
     int          key_len;
     float        load_factor;
+
+    /* Removals that drop the load below min_load_factor shrink the table,
+     * but never below min_capacity. */
+    float        min_load_factor;
+    size_t       min_capacity;
     TableEntry **buckets;
 
+    enum cc_hashtable_backend backend;
+
+    /* While an incremental resize is in progress, buckets below
+     * migrate_index have already been moved to the new bucket array.
+     * Every step moves migrate_step buckets, which is resize_step or more
+     * if that isn't enough to finish before the table reaches the next
+     * threshold. */
+    TableEntry **old_buckets;
+    size_t       old_capacity;
+    size_t       migrate_index;
+    size_t       migrate_step;
+    size_t       resize_step;
+
+    /* Chains longer than max_chain make the table re-seed itself */
+    size_t       max_chain;
+
+    /* Size of the ChainedEntry prefix that the table uses */
+    bool         cache_len;
+    size_t       entry_size;
+
+    /* Chained entries in insertion order. Removed entries leave NULL holes
+     * behind until the array is compacted. */
+    TableEntry **dense;
+    size_t       dense_size;
+    size_t       dense_capacity;
+    size_t       holes;
+
+    /* Tables with a resize_step grow, compact and shrink the dense array
+     * incrementally. While that is in progress the live entries of
+     * dense_old from dense_read on are still to be packed into dense,
+     * from dense_write on, dense_step slots per add or remove. Entries
+     * added in the meantime are appended after the space reserved for
+     * them. */
+    TableEntry **dense_old;
+    size_t       dense_old_size;
+    size_t       dense_read;
+    size_t       dense_write;
+    size_t       dense_step;
+
+    /* Entry slab. Entries of the head chunk past chunk_used have never been
+     * handed out, removed entries are kept on the free_entries list. */
+    EntryChunk  *chunks;
+    size_t       chunk_used;
+    TableEntry  *free_entries;
+    size_t       free_count;
+
+    /* Open addressing storage */
+    TableEntry  *slots;
+    uint8_t     *ctrl;
+    size_t       deleted;
+
     size_t  (*hash)       (const void *key, int l, uint32_t seed);
     int     (*key_cmp)    (const void *k1, const void *k2);
     void   *(*mem_alloc)  (size_t size);
@@ -40,15 +136,57 @@ struct hashtable_s {
 };
 
 static enum cc_stat resize          (HashTable *t, size_t new_capacity);
+static void         rehash_step     (HashTable *t);
+static void         rehash_finish   (HashTable *t);
+static void         reseed          (HashTable *t);
+static enum cc_stat remove_key      (HashTable *table, void *key, void **out);
 static enum cc_stat get_null_key    (HashTable *table, void **out);
-static enum cc_stat add_null_key    (HashTable *table, void *val);
+static enum cc_stat get_or_add      (HashTable *table, void *key, void *val,
+                                     TableEntry **out, bool *inserted);
+static enum cc_stat chained_get_or_add(HashTable *table, void *key, void *val,
+                                       size_t hash, TableEntry **out, bool *inserted);
+static enum cc_stat chained_rebuild (HashTable *table, size_t capacity);
+static void         maybe_shrink    (HashTable *table);
 static enum cc_stat remove_null_key (HashTable *table, void **out);
 
-static size_t get_table_index  (HashTable *table, void *key);
-static size_t round_pow_two    (size_t n);
+static TableEntry  *entry_alloc (HashTable *table);
+static void         entry_free  (HashTable *table, TableEntry *entry);
+static void         entry_chunks_free (HashTable *table);
+static enum cc_stat entry_reserve     (HashTable *table, size_t n);
+
+static enum cc_stat dense_make_room (HashTable *table);
+static enum cc_stat dense_reserve   (HashTable *table, size_t n);
+static void         dense_compact   (HashTable *table);
+static void         dense_shrink    (HashTable *table);
+static enum cc_stat dense_rebuild   (HashTable *table, size_t capacity);
+static void         dense_migrate   (HashTable *table, size_t n);
+static void         dense_remove    (HashTable *table, TableEntry *entry);
+static size_t       dense_next      (HashTable *table, size_t i);
+
+static void         unlink_entry    (HashTable *table, TableEntry *entry);
+static void         remove_entry    (HashTable *table, TableEntry *entry);
+
+static TableEntry **get_bucket (HashTable *table, size_t hash);
+static bool   entry_matches    (HashTable *table, TableEntry *e, const void *key,
+                                size_t hash, size_t len);
+static size_t key_length       (HashTable *table, const void *key);
+static void   random_bytes     (void *buf, size_t size);
+static size_t hash_key         (HashTable *table, const void *key);
 static void   move_entries     (TableEntry **src_bucket, TableEntry **dest_bucket,
                                  size_t src_size, size_t dest_size);
 
+static enum cc_stat oa_new      (HashTable *table, size_t capacity);
+static enum cc_stat oa_resize   (HashTable *table, size_t new_capacity);
+static enum cc_stat oa_get_or_add(HashTable *table, void *key, void *val,
+                                  TableEntry **out, bool *inserted);
+static size_t       oa_find     (HashTable *table, const void *key, size_t hash);
+static size_t       oa_find_free(const uint8_t *ctrl, size_t capacity, size_t hash);
+static TableEntry  *oa_insert_at(HashTable *table, size_t slot, void *key, void *val,
+                                 size_t hash);
+static void         oa_remove_at(HashTable *table, size_t slot);
+static size_t       oa_next_full(HashTable *table, size_t slot);
+static void         oa_prefetch (HashTable *table, size_t hash);
+
 /**
  * Creates a new HashTable and returns a status code.
  *
@@ -86,24 +224,56 @@ enum cc_stat hashtable_new_conf(HashTableConf const * const conf, HashTable **ou
     if (!table)
         return CC_ERR_ALLOC;
 
-    table->capacity = round_pow_two(conf->initial_capacity);
-    table->buckets  = conf->mem_calloc(table->capacity, sizeof(TableEntry*));
-
-    if (!table->buckets) {
-        conf->mem_free(table);
-        return CC_ERR_ALLOC;
-    }
-
     table->hash        = conf->hash;
     table->key_cmp     = conf->key_compare;
     table->load_factor = conf->load_factor;
-    table->hash_seed   = conf->hash_seed;
+    table->hash_seed   = conf->random_seed ? hashtable_random_seed() : conf->hash_seed;
     table->key_len     = conf->key_length;
+    table->backend     = conf->backend;
+    table->resize_step = conf->resize_step;
+    table->max_chain   = conf->max_chain_length;
+    table->cache_len   = conf->cache_key_length && conf->key_length == KEY_LENGTH_VARIABLE;
+    table->entry_size  = table->cache_len ? sizeof(ChainedEntry)
+                                          : offsetof(ChainedEntry, key_len);
     table->size        = 0;
     table->mem_alloc   = conf->mem_alloc;
     table->mem_calloc  = conf->mem_calloc;
     table->mem_free    = conf->mem_free;
-    table->threshold   = table->capacity * table->load_factor;
+
+    if (table->backend == HASHTABLE_OPEN_ADDRESSING) {
+        if (table->load_factor > OA_MAX_LOAD_FACTOR)
+            table->load_factor = OA_MAX_LOAD_FACTOR;
+    }
+
+    /* A table that was just shrunk or grown sits at about half of the
+     * load factor. Keeping the minimum at a quarter of the load factor
+     * makes sure that it can't immediately flip back. */
+    table->min_load_factor = conf->min_load_factor;
+    table->min_capacity    = round_pow_two(conf->initial_capacity);
+
+    if (table->min_load_factor > table->load_factor / 4)
+        table->min_load_factor = table->load_factor / 4;
+
+    if (table->backend == HASHTABLE_OPEN_ADDRESSING) {
+        if (table->min_capacity < GROUP_WIDTH)
+            table->min_capacity = GROUP_WIDTH;
+
+        if (oa_new(table, round_pow_two(conf->initial_capacity)) != CC_OK) {
+            conf->mem_free(table);
+            return CC_ERR_ALLOC;
+        }
+        *out = table;
+        return CC_OK;
+    }
+
+    table->capacity = round_pow_two(conf->initial_capacity);
+    table->buckets  = conf->mem_calloc(table->capacity, sizeof(TableEntry*));
+
+    if (!table->buckets) {
+        conf->mem_free(table);
+        return CC_ERR_ALLOC;
+    }
+    table->threshold = table->capacity * table->load_factor;
 
     *out = table;
     return CC_OK;
@@ -119,9 +289,15 @@ void hashtable_conf_init(HashTableConf *conf)
     conf->hash             = STRING_HASH;
     conf->key_compare      = cc_common_cmp_str;
     conf->initial_capacity = DEFAULT_CAPACITY;
+    conf->min_load_factor  = 0;
     conf->load_factor      = DEFAULT_LOAD_FACTOR;
     conf->key_length       = KEY_LENGTH_VARIABLE;
     conf->hash_seed        = 0;
+    conf->backend          = HASHTABLE_CHAINED;
+    conf->resize_step      = 0;
+    conf->random_seed      = false;
+    conf->max_chain_length = 0;
+    conf->cache_key_length = false;
     conf->mem_alloc        = malloc;
     conf->mem_calloc       = calloc;
     conf->mem_free         = free;
@@ -136,16 +312,22 @@ void hashtable_conf_init(HashTableConf *conf)
  */
 void hashtable_destroy(HashTable *table)
 {
-    size_t i;
-    for (i = 0; i < table->capacity; i++) {
-        TableEntry *next = table->buckets[i];
-
-        while (next) {
-            TableEntry *tmp = next->next;
-            table->mem_free(next);
-            next = tmp;
-        }
+    if (table->backend == HASHTABLE_OPEN_ADDRESSING) {
+        table->mem_free(table->slots);
+        table->mem_free(table->ctrl);
+        table->mem_free(table);
+        return;
     }
+
+    entry_chunks_free(table);
+
+    if (table->old_buckets)
+        table->mem_free(table->old_buckets);
+    if (table->dense)
+        table->mem_free(table->dense);
+    if (table->dense_old)
+        table->mem_free(table->dense_old);
+
     table->mem_free(table->buckets);
     table->mem_free(table);
 }
@@ -165,80 +347,248 @@ void hashtable_destroy(HashTable *table)
  */
 enum cc_stat hashtable_add(HashTable *table, void *key, void *val)
 {
-    enum cc_stat stat;
-    if (table->size >= table->threshold) {
-        if ((stat = resize(table, table->capacity << 1)) != CC_OK)
-            return stat;
-    }
+    TableEntry *entry;
+    bool        inserted;
 
-    if (!key)
-        return add_null_key(table, val);
+    enum cc_stat stat = get_or_add(table, key, val, &entry, &inserted);
 
-    const size_t hash = table->hash(key, table->key_len, table->hash_seed);
-    const size_t i    = hash & (table->capacity - 1);
+    if (stat == CC_OK)
+        entry->value = val;
 
-    TableEntry *replace = table->buckets[i];
+    return stat;
+}
 
-    while (replace) {
-        void *rk = replace->key;
-        if (rk && table->key_cmp(rk, key) == 0) {
-            replace->value = val;
-            return CC_OK;
+/**
+ * Returns the value slot of the specified key, adding the key with a default
+ * value first if it's not already in the table. The key is hashed and looked
+ * up only once, which makes this cheaper than a hashtable_get() followed by a
+ * hashtable_add() on a miss.
+ *
+ * The returned slot can be used to read and update the value in place. It
+ * remains valid until the table is next modified.
+ *
+ * @param[in] table       the table in which the key is looked up
+ * @param[in] key         the key that is being looked up
+ * @param[in] default_val the value that is mapped to the key if it's added
+ * @param[out] out_slot   pointer to where the pointer to the value slot is
+ *                        stored, or NULL if it is to be ignored
+ * @param[out] inserted   pointer to where true is stored if the key was
+ *                        added, or NULL if it is to be ignored
+ *
+ * @return CC_OK if the key was found or added, or CC_ERR_ALLOC if the memory
+ * allocation failed.
+ */
+enum cc_stat hashtable_get_or_add(HashTable *table, void *key, void *default_val,
+                                  void ***out_slot, bool *inserted)
+{
+    TableEntry *entry;
+    bool        added;
+
+    enum cc_stat stat = get_or_add(table, key, default_val, &entry, &added);
+
+    if (stat != CC_OK)
+        return stat;
+
+    if (out_slot)
+        *out_slot = &entry->value;
+    if (inserted)
+        *inserted = added;
+
+    return CC_OK;
+}
+
+/**
+ * Updates the value mapped to the specified key, or adds the key if it's not
+ * already in the table. The new value is the result of calling fn with the
+ * current value, or with NULL if the key is being added. The key is hashed
+ * and looked up only once.
+ *
+ * @param[in] table the table in which the key is being updated
+ * @param[in] key   the key that is being updated
+ * @param[in] fn    function that returns the new value given the current value,
+ *                  whether the key was already in the table, and ctx
+ * @param[in] ctx   user data that is passed to fn
+ *
+ * @return CC_OK if the key was updated or added, or CC_ERR_ALLOC if the
+ * memory allocation failed.
+ */
+enum cc_stat hashtable_upsert(HashTable *table, void *key,
+                              void *(*fn) (void *value, bool exists, void *ctx),
+                              void *ctx)
+{
+    TableEntry *entry;
+    bool        inserted;
+
+    enum cc_stat stat = get_or_add(table, key, NULL, &entry, &inserted);
+
+    if (stat == CC_OK)
+        entry->value = fn(entry->value, !inserted, ctx);
+
+    return stat;
+}
+
+/**
+ * Adds n key-value mappings to the table, mapping keys[i] to vals[i]. The
+ * result is the same as calling hashtable_add() for every pair in order, so
+ * existing keys get their values replaced and the last of several equal keys
+ * wins.
+ *
+ * The table is first reserved for all n keys, so it's resized at most once.
+ * The keys are then hashed a batch at a time, and their buckets prefetched,
+ * before any of them is placed.
+ *
+ * @param[in] table the table to which the mappings are being added
+ * @param[in] keys  array of n keys
+ * @param[in] vals  array of n values
+ * @param[in] n     number of mappings
+ *
+ * @return CC_OK if all mappings were added, CC_ERR_ALLOC if a memory
+ * allocation failed, or CC_ERR_MAX_CAPACITY if the table can't grow large
+ * enough. If an error is returned, some of the mappings may have been added.
+ */
+enum cc_stat hashtable_add_all_from_arrays(HashTable *table, void **keys, void **vals,
+                                           size_t n)
+{
+    size_t hashes[BATCH_WIDTH];
+    size_t base;
+
+    enum cc_stat stat = hashtable_reserve(table, table->size + n);
+    if (stat != CC_OK)
+        return stat;
+
+    for (base = 0; base < n; base += BATCH_WIDTH) {
+        const size_t   width = n - base < BATCH_WIDTH ? n - base : BATCH_WIDTH;
+        const uint32_t seed  = table->hash_seed;
+        size_t k;
+
+        for (k = 0; k < width; k++) {
+            hashes[k] = hash_key(table, keys[base + k]);
+
+            if (table->backend == HASHTABLE_OPEN_ADDRESSING)
+                oa_prefetch(table, hashes[k]);
+            else
+                PREFETCH(get_bucket(table, hashes[k]));
         }
-        replace = replace->next;
-    }
 
-    TableEntry *new_entry = table->mem_alloc(sizeof(TableEntry));
+        for (k = 0; k < width; k++) {
+            void *key = keys[base + k];
+            void *val = vals[base + k];
 
-    if (!new_entry)
-        return CC_ERR_ALLOC;
+            if (table->backend == HASHTABLE_OPEN_ADDRESSING) {
+                size_t slot = oa_find(table, key, hashes[k]);
+
+                if (slot != SLOT_NONE) {
+                    table->slots[slot].value = val;
+                } else {
+                    slot = oa_find_free(table->ctrl, table->capacity, hashes[k]);
+                    oa_insert_at(table, slot, key, val, hashes[k]);
+                }
+                continue;
+            }
 
-    new_entry->key   = key;
-    new_entry->value = val;
-    new_entry->hash  = hash;
-    new_entry->next  = table->buckets[i];
+            /* The chain length guard may have re-seeded the table */
+            size_t hash = table->hash_seed == seed ? hashes[k] : hash_key(table, key);
 
-    table->buckets[i] = new_entry;
-    table->size++;
+            TableEntry *entry;
+            bool        inserted;
 
+            if ((stat = chained_get_or_add(table, key, val, hash, &entry, &inserted)) != CC_OK)
+                return stat;
+
+            entry->value = val;
+        }
+    }
     return CC_OK;
 }
 
 /**
- * Creates a new key-value mapping for the NULL key. This operation may fail if
- * the space allocation for the new entry fails.
+ * Looks up the entry of the specified key, and adds a new entry that maps the
+ * key to val if the key isn't in the table yet.
  *
- * @param[in] table the table into which this key value-mapping is being added
- * @param[in] val the value that is being mapped to the NULL key
+ * @param[in] table     the table in which the key is looked up
+ * @param[in] key       the key that is being looked up
+ * @param[in] val       value of the new entry if the key is added
+ * @param[out] out      pointer to where the entry of the key is stored
+ * @param[out] inserted pointer to where true is stored if the key was added
  *
- * @return CC_OK if the mapping was successfully added, or CC_ERR_ALLOC if the
- * memory allocation failed.
+ * @return CC_OK if the key was found or added, or CC_ERR_ALLOC if the memory
+ * allocation failed.
+ */
+static enum cc_stat get_or_add(HashTable *table, void *key, void *val,
+                               TableEntry **out, bool *inserted)
+{
+    if (table->backend == HASHTABLE_OPEN_ADDRESSING)
+        return oa_get_or_add(table, key, val, out, inserted);
+
+    enum cc_stat stat;
+
+    if (table->old_buckets)
+        rehash_step(table);
+
+    if (table->size >= table->threshold) {
+        if ((stat = resize(table, table->capacity << 1)) != CC_OK)
+            return stat;
+    }
+
+    /* The NULL key always hashes to 0, which is also the bucket that is
+     * migrated first when the table starts resizing. */
+    return chained_get_or_add(table, key, val, hash_key(table, key), out, inserted);
+}
+
+/**
+ * Looks up the key with the given hash in a chained table and adds it if it's
+ * missing. Unlike get_or_add() this neither checks the load factor nor
+ * advances an incremental resize.
  */
-static enum cc_stat add_null_key(HashTable *table, void *val)
+static enum cc_stat chained_get_or_add(HashTable *table, void *key, void *val,
+                                       size_t hash, TableEntry **out, bool *inserted)
 {
-    TableEntry *replace = table->buckets[0];
+    const size_t len    = key_length(table, key);
+    TableEntry **bucket = get_bucket(table, hash);
+    TableEntry  *entry  = *bucket;
+    size_t       chain  = 0;
 
-    while (replace) {
-        if (!replace->key) {
-            replace->value = val;
+    while (entry) {
+        if (key ? entry_matches(table, entry, key, hash, len) : !entry->key) {
+            *out      = entry;
+            *inserted = false;
             return CC_OK;
         }
-        replace = replace->next;
+        entry = entry->next;
+        chain++;
     }
 
-    TableEntry *new_entry = table->mem_alloc(sizeof(TableEntry));
+    if (table->dense_old)
+        dense_migrate(table, table->dense_step);
+
+    if (table->dense_size == table->dense_capacity &&
+        dense_make_room(table) != CC_OK)
+        return CC_ERR_ALLOC;
+
+    entry = entry_alloc(table);
 
-    if (!new_entry)
+    if (!entry)
         return CC_ERR_ALLOC;
 
-    new_entry->key   = NULL;
-    new_entry->value = val;
-    new_entry->hash  = 0;
-    new_entry->next  = table->buckets[0];
+    ORDER(entry) = table->dense_size;
+    table->dense[table->dense_size++] = entry;
+
+    entry->key   = key;
+    entry->value = val;
+    entry->hash  = hash;
+    entry->next  = *bucket;
 
-    table->buckets[0] = new_entry;
+    if (table->cache_len)
+        KEY_LEN(entry) = len;
+
+    *bucket = entry;
     table->size++;
 
+    if (table->max_chain && chain >= table->max_chain)
+        reseed(table);
+
+    *out      = entry;
+    *inserted = true;
     return CC_OK;
 }
 
@@ -254,14 +604,25 @@ static enum cc_stat add_null_key(HashTable *table, void *val)
  */
 enum cc_stat hashtable_get(HashTable *table, void *key, void **out)
 {
+    if (table->backend == HASHTABLE_OPEN_ADDRESSING) {
+        size_t slot = oa_find(table, key, hash_key(table, key));
+
+        if (slot == SLOT_NONE)
+            return CC_ERR_KEY_NOT_FOUND;
+
+        *out = table->slots[slot].value;
+        return CC_OK;
+    }
+
     if (!key)
         return get_null_key(table, out);
 
-    size_t      index  = get_table_index(table, key);
-    TableEntry *bucket = table->buckets[index];
+    const size_t hash   = table->hash(key, table->key_len, table->hash_seed);
+    const size_t len    = key_length(table, key);
+    TableEntry  *bucket = *get_bucket(table, hash);
 
     while (bucket) {
-        if (bucket->key && table->key_cmp(bucket->key, key) == 0) {
+        if (entry_matches(table, bucket, key, hash, len)) {
             *out = bucket->value;
             return CC_OK;
         }
@@ -270,6 +631,97 @@ enum cc_stat hashtable_get(HashTable *table, void *key, void **out)
     return CC_ERR_KEY_NOT_FOUND;
 }
 
+/**
+ * Looks up n keys at once and stores the value mapped to each of them. This
+ * is equivalent to calling hashtable_get() for every key, but the keys are
+ * processed in small groups: all keys of a group are hashed and their
+ * buckets prefetched before any key is compared, so that the cache misses of
+ * the whole group overlap instead of being paid one after another.
+ *
+ * @param[in] table      the table in which the keys are looked up
+ * @param[in] keys       array of n keys that are being looked up
+ * @param[in] n          number of keys
+ * @param[out] out_values array of n values where the value mapped to the
+ *                        i-th key is stored, or NULL if the values are to
+ *                        be ignored. Values of keys that were not found are
+ *                        left untouched.
+ * @param[out] out_status array of n statuses where CC_OK or
+ *                        CC_ERR_KEY_NOT_FOUND is stored for the i-th key, or
+ *                        NULL if the statuses are to be ignored
+ *
+ * @return CC_OK if all keys were found, or CC_ERR_KEY_NOT_FOUND if at least
+ * one of them wasn't.
+ */
+enum cc_stat hashtable_get_batch(HashTable *table, void **keys, size_t n,
+                                 void **out_values, enum cc_stat *out_status)
+{
+    enum cc_stat result = CC_OK;
+    size_t       hashes[BATCH_WIDTH];
+    TableEntry  *heads[BATCH_WIDTH];
+    size_t       base;
+
+    for (base = 0; base < n; base += BATCH_WIDTH) {
+        const size_t width = n - base < BATCH_WIDTH ? n - base : BATCH_WIDTH;
+        size_t k;
+
+        for (k = 0; k < width; k++) {
+            hashes[k] = hash_key(table, keys[base + k]);
+
+            if (table->backend == HASHTABLE_OPEN_ADDRESSING)
+                oa_prefetch(table, hashes[k]);
+            else
+                PREFETCH(get_bucket(table, hashes[k]));
+        }
+
+        if (table->backend == HASHTABLE_CHAINED) {
+            for (k = 0; k < width; k++) {
+                heads[k] = keys[base + k] ? *get_bucket(table, hashes[k]) : NULL;
+                if (heads[k])
+                    PREFETCH(heads[k]);
+            }
+        }
+
+        for (k = 0; k < width; k++) {
+            void        *key   = keys[base + k];
+            void        *value = NULL;
+            enum cc_stat stat  = CC_ERR_KEY_NOT_FOUND;
+
+            if (table->backend == HASHTABLE_OPEN_ADDRESSING) {
+                size_t slot = oa_find(table, key, hashes[k]);
+
+                if (slot != SLOT_NONE) {
+                    value = table->slots[slot].value;
+                    stat  = CC_OK;
+                }
+            } else if (!key) {
+                stat = get_null_key(table, &value);
+            } else {
+                TableEntry  *e   = heads[k];
+                const size_t len = key_length(table, key);
+
+                while (e) {
+                    if (entry_matches(table, e, key, hashes[k], len)) {
+                        value = e->value;
+                        stat  = CC_OK;
+                        break;
+                    }
+                    e = e->next;
+                }
+            }
+
+            if (stat == CC_OK) {
+                if (out_values)
+                    out_values[base + k] = value;
+            } else {
+                result = stat;
+            }
+            if (out_status)
+                out_status[base + k] = stat;
+        }
+    }
+    return result;
+}
+
 /**
  * Returns a value associated with the NULL key and sets the out parameter
  * to it.
@@ -307,28 +759,72 @@ static enum cc_stat get_null_key(HashTable *table, void **out)
  * if the key was not found.
  */
 enum cc_stat hashtable_remove(HashTable *table, void *key, void **out)
+{
+    if (table->backend == HASHTABLE_OPEN_ADDRESSING) {
+        size_t slot = oa_find(table, key, hash_key(table, key));
+
+        if (slot == SLOT_NONE)
+            return CC_ERR_KEY_NOT_FOUND;
+
+        if (out)
+            *out = table->slots[slot].value;
+
+        oa_remove_at(table, slot);
+        maybe_shrink(table);
+        return CC_OK;
+    }
+
+    if (table->old_buckets)
+        rehash_step(table);
+
+    if (table->dense_old)
+        dense_migrate(table, table->dense_step);
+
+    enum cc_stat stat = remove_key(table, key, out);
+
+    if (table->holes > table->dense_size / 2) {
+        if (!table->resize_step)
+            dense_compact(table);
+        else if (!table->dense_old)
+            dense_rebuild(table, table->dense_capacity);
+    }
+
+    if (stat == CC_OK)
+        maybe_shrink(table);
+
+    return stat;
+}
+
+/**
+ * Removes the key from a chained table without advancing an incremental
+ * resize, so that the bucket arrays stay unchanged for iterators.
+ */
+static enum cc_stat remove_key(HashTable *table, void *key, void **out)
 {
     if (!key)
         return remove_null_key(table, out);
 
-    const size_t i = get_table_index(table, key);
+    const size_t hash   = table->hash(key, table->key_len, table->hash_seed);
+    const size_t len    = key_length(table, key);
+    TableEntry **bucket = get_bucket(table, hash);
 
-    TableEntry *e    = table->buckets[i];
+    TableEntry *e    = *bucket;
     TableEntry *prev = NULL;
     TableEntry *next = NULL;
 
     while (e) {
         next = e->next;
 
-        if (e->key && table->key_cmp(key, e->key) == 0) {
+        if (entry_matches(table, e, key, hash, len)) {
             void *value = e->value;
 
             if (!prev)
-                table->buckets[i] = next;
+                *bucket = next;
             else
                 prev->next = next;
 
-            table->mem_free(e);
+            dense_remove(table, e);
+            entry_free(table, e);
             table->size--;
             if (out)
                 *out = value;
@@ -340,6 +836,38 @@ enum cc_stat hashtable_remove(HashTable *table, void *key, void **out)
     return CC_ERR_KEY_NOT_FOUND;
 }
 
+/**
+ * Unlinks the entry from its bucket chain. The bucket is found through the
+ * stored hash, so neither the hash function nor the key comparator is
+ * called.
+ *
+ * @param[in] table the table that holds the entry
+ * @param[in] entry the entry that is being unlinked
+ */
+static void unlink_entry(HashTable *table, TableEntry *entry)
+{
+    TableEntry **link = get_bucket(table, entry->hash);
+
+    while (*link != entry)
+        link = &(*link)->next;
+
+    *link = entry->next;
+}
+
+/**
+ * Removes the entry of a chained table without looking up its key.
+ *
+ * @param[in] table the table that holds the entry
+ * @param[in] entry the entry that is being removed
+ */
+static void remove_entry(HashTable *table, TableEntry *entry)
+{
+    unlink_entry(table, entry);
+    dense_remove(table, entry);
+    entry_free(table, entry);
+    table->size--;
+}
+
 /**
  * Removes a NULL key mapping from the specified hash table and sets the out
  * parameter to value.
@@ -369,7 +897,8 @@ enum cc_stat remove_null_key(HashTable *table, void **out)
             else
                 prev->next = next;
 
-            table->mem_free(e);
+            dense_remove(table, e);
+            entry_free(table, e);
             table->size--;
             if (out)
                 *out = value;
@@ -388,17 +917,30 @@ enum cc_stat remove_null_key(HashTable *table, void **out)
  */
 void hashtable_remove_all(HashTable *table)
 {
-    size_t i;
-    for (i = 0; i < table->capacity; i++) {
-        TableEntry *entry = table->buckets[i];
-        while (entry) {
-            TableEntry *next = entry->next;
-            table->mem_free(entry);
-            table->size--;
-            entry = next;
-        }
-        table->buckets[i] = NULL;
+    if (table->backend == HASHTABLE_OPEN_ADDRESSING) {
+        memset(table->ctrl, CTRL_EMPTY, table->capacity);
+        table->size    = 0;
+        table->deleted = 0;
+        maybe_shrink(table);
+        return;
+    }
+
+    if (table->old_buckets) {
+        table->mem_free(table->old_buckets);
+        table->old_buckets = NULL;
+    }
+    if (table->dense_old) {
+        table->mem_free(table->dense_old);
+        table->dense_old = NULL;
     }
+    entry_chunks_free(table);
+
+    memset(table->buckets, 0, table->capacity * sizeof(TableEntry*));
+    table->size       = 0;
+    table->dense_size = 0;
+    table->holes      = 0;
+
+    maybe_shrink(table);
 }
 
 /**
@@ -417,11 +959,38 @@ static enum cc_stat resize(HashTable *t, size_t new_capacity)
     if (t->capacity == MAX_POW_TWO)
         return CC_ERR_MAX_CAPACITY;
 
-    TableEntry **new_buckets = t->mem_calloc(new_capacity, sizeof(TableEntry));
+    /* The table outgrew the new bucket array before the previous resize
+     * could finish */
+    if (t->old_buckets)
+        rehash_finish(t);
+
+    TableEntry **new_buckets = t->mem_calloc(new_capacity, sizeof(TableEntry*));
 
     if (!new_buckets)
         return CC_ERR_ALLOC;
 
+    if (t->resize_step) {
+        t->old_buckets   = t->buckets;
+        t->old_capacity  = t->capacity;
+        t->migrate_index = 0;
+        t->buckets       = new_buckets;
+        t->capacity      = new_capacity;
+        t->threshold     = t->load_factor * new_capacity;
+
+        /* Each add until the next threshold takes one step, so the step
+         * must be large enough to move every old bucket by then. Otherwise
+         * the next resize would have to finish the migration at once. */
+        size_t adds = t->threshold > t->size ? t->threshold - t->size : 1;
+
+        t->migrate_step = (t->old_capacity + adds - 1) / adds;
+
+        if (t->migrate_step < t->resize_step)
+            t->migrate_step = t->resize_step;
+
+        rehash_step(t);
+        return CC_OK;
+    }
+
     TableEntry **old_buckets = t->buckets;
 
     move_entries(old_buckets, new_buckets, t->capacity, new_capacity);
@@ -436,80 +1005,573 @@ static enum cc_stat resize(HashTable *t, size_t new_capacity)
 }
 
 /**
- * Rounds the integer to the nearest upper power of two.
+ * Moves the next migrate_step buckets of an incremental resize into the new
+ * bucket array and releases the old array once all buckets have been moved.
  *
- * @param[in] the unsigned integer that is being rounded
- *
- * @return the nearest upper power of two.
+ * @param[in] t the table that is being resized
  */
-static INLINE size_t round_pow_two(size_t n)
+static void rehash_step(HashTable *t)
 {
-    if (n >= MAX_POW_TWO)
-        return MAX_POW_TWO;
+    size_t end = t->migrate_index + t->migrate_step;
+
+    if (end > t->old_capacity)
+        end = t->old_capacity;
+
+    move_entries(t->old_buckets + t->migrate_index, t->buckets,
+                 end - t->migrate_index, t->capacity);
+
+    memset(t->old_buckets + t->migrate_index, 0,
+           (end - t->migrate_index) * sizeof(TableEntry*));
 
-    if (n == 0)
-        return 2;
-    /**
-     * taken from:
-     * http://graphics.stanford.edu/~seander/
-     * bithacks.html#RoundUpPowerOf2Float
-     */
-    n--;
-    n |= n >> 1;
-    n |= n >> 2;
-    n |= n >> 4;
-    n |= n >> 8;
-    n |= n >> 16;
-    n++;
+    t->migrate_index = end;
 
-    return n;
+    if (t->migrate_index == t->old_capacity) {
+        t->mem_free(t->old_buckets);
+        t->old_buckets = NULL;
+    }
 }
 
 /**
- * Moves all entries from one bucket array to another.
+ * Completes an incremental resize in one go.
  *
- * @param[in] src_bucket  the source bucket from which the entries are moved
- * @param[in] dest_bucket the destination bucket to which the entries are being
- *                        moved
- * @param[in] src_size    size of the source bucket
- * @param[in] dest_size   size of the destination bucket
+ * @param[in] t the table that is being resized
  */
-static INLINE void
-move_entries(TableEntry **src_bucket, TableEntry **dest_bucket,
-             size_t       src_size,   size_t       dest_size)
+static void rehash_finish(HashTable *t)
+{
+    move_entries(t->old_buckets + t->migrate_index, t->buckets,
+                 t->old_capacity - t->migrate_index, t->capacity);
+
+    t->mem_free(t->old_buckets);
+    t->old_buckets = NULL;
+}
+
+/**
+ * Picks a new random hash seed and rehashes every key of a chained table in
+ * place. This is done once a chain grows past max_chain, which with a keyed
+ * hash function such as SIP_HASH means that the keys were most likely chosen
+ * to collide under the current seed.
+ *
+ * If some chain is still too long afterwards, the collisions don't depend on
+ * the seed (the keys are equal under the hash function), so the limit is
+ * doubled to keep repeated rehashing amortized.
+ *
+ * @param[in] t the table that is being re-seeded
+ */
+static void reseed(HashTable *t)
 {
+    if (t->old_buckets)
+        rehash_finish(t);
+
+    TableEntry *entries = NULL;
     size_t i;
-    for (i = 0; i < src_size; i++) {
-        TableEntry *entry = src_bucket[i];
 
-        while (entry) {
-            TableEntry *next  = entry->next;
-            size_t      index = entry->hash & (dest_size - 1);
+    for (i = 0; i < t->capacity; i++) {
+        TableEntry *e = t->buckets[i];
 
-            entry->next = dest_bucket[index];
-            dest_bucket[index] = entry;
+        while (e) {
+            TableEntry *next = e->next;
+            e->next = entries;
+            entries = e;
+            e = next;
+        }
+        t->buckets[i] = NULL;
+    }
 
-            entry = next;
+    t->hash_seed = hashtable_random_seed();
+
+    while (entries) {
+        TableEntry *next = entries->next;
+
+        if (entries->key)
+            entries->hash = t->hash(entries->key, t->key_len, t->hash_seed);
+
+        size_t index = entries->hash & (t->capacity - 1);
+
+        entries->next = t->buckets[index];
+        t->buckets[index] = entries;
+        entries = next;
+    }
+
+    for (i = 0; i < t->capacity; i++) {
+        size_t      len = 0;
+        TableEntry *e   = t->buckets[i];
+
+        while (e && len <= t->max_chain) {
+            e = e->next;
+            len++;
+        }
+        if (len > t->max_chain) {
+            t->max_chain <<= 1;
+            break;
         }
     }
 }
 
 /**
- * Returns the size of the specified HashTable. Size of a HashTable represents
- * the number of key-value mappings within the table.
- *
- * @param[in] table the table whose size is being returned
- *
- * @return the size of the table.
+ * Allocates a block with the table's mem_alloc.
  */
-size_t hashtable_size(HashTable *table)
+void *hashtable_mem_alloc(HashTable *table, size_t size)
 {
-    return table->size;
+    return table->mem_alloc(size);
 }
 
 /**
- * Returns the current capacity of the table. The capacity is the number of
- * buckets or the number of random access for table entries.
+ * Frees a block that was allocated with hashtable_mem_alloc().
+ */
+void hashtable_mem_free(HashTable *table, void *block)
+{
+    table->mem_free(block);
+}
+
+/**
+ * Fills buf with size bytes from the operating system's random number
+ * generator. If no generator is available, the bytes are derived from the
+ * current time and a stack address instead.
+ */
+static void random_bytes(void *buf, size_t size)
+{
+#if defined(__linux__)
+    ssize_t n;
+
+    /* getrandom() fails with ENOSYS on old kernels and with EPERM under
+     * some seccomp filters, in which case /dev/urandom is read instead.
+     * Requests of up to 256 bytes are never cut short. */
+    do {
+        n = getrandom(buf, size, 0);
+    } while (n < 0 && errno == EINTR);
+
+    if (n == (ssize_t) size)
+        return;
+#endif
+
+#if defined(HASHTABLE_ARC4RANDOM)
+    arc4random_buf(buf, size);
+#else
+    FILE *f = fopen("/dev/urandom", "rb");
+
+    if (!f || fread(buf, size, 1, f) != 1) {
+        uint64_t z = (uint64_t) time(NULL) ^ (uint64_t) (uintptr_t) &z;
+        uint8_t *p = buf;
+        size_t   i;
+
+        for (i = 0; i < size; i++) {
+            z += UINT64_C(0x9e3779b97f4a7c15);
+            p[i] = (uint8_t) ((z ^ (z >> 31)) * UINT64_C(0xbf58476d1ce4e5b9) >> 56);
+        }
+    }
+    if (f)
+        fclose(f);
+#endif
+}
+
+/**
+ * Returns a seed obtained from the operating system's random number
+ * generator.
+ */
+uint32_t hashtable_random_seed(void)
+{
+    uint32_t seed;
+    random_bytes(&seed, sizeof(seed));
+    return seed;
+}
+
+/**
+ * Returns an unused entry from the table's entry slab. Recycled entries are
+ * handed out first, and a new chunk is allocated only once the current one
+ * is used up.
+ *
+ * @param[in] table the table that needs a new entry
+ *
+ * @return the new entry, or NULL if the memory allocation for a new chunk
+ * failed.
+ */
+static TableEntry *entry_alloc(HashTable *table)
+{
+    TableEntry *entry = table->free_entries;
+
+    if (entry) {
+        table->free_entries = entry->next;
+        table->free_count--;
+        return entry;
+    }
+
+    EntryChunk *chunk = table->chunks;
+
+    if (!chunk || table->chunk_used == chunk->capacity) {
+        size_t capacity = ENTRY_CHUNK_MIN;
+
+        if (chunk && chunk->capacity < ENTRY_CHUNK_MAX)
+            capacity = chunk->capacity << 1;
+        else if (chunk)
+            capacity = ENTRY_CHUNK_MAX;
+
+        chunk = table->mem_alloc(sizeof(EntryChunk) + capacity * table->entry_size);
+
+        if (!chunk)
+            return NULL;
+
+        chunk->capacity   = capacity;
+        chunk->next       = table->chunks;
+        table->chunks     = chunk;
+        table->chunk_used = 0;
+    }
+    return (TableEntry*) ((char*) chunk->entries + table->chunk_used++ * table->entry_size);
+}
+
+/**
+ * Returns the entry to the table's entry slab so that it can be reused by
+ * a later add.
+ *
+ * @param[in] table the table that owns the entry
+ * @param[in] entry the entry that is no longer used
+ */
+static INLINE void entry_free(HashTable *table, TableEntry *entry)
+{
+    entry->next = table->free_entries;
+    table->free_entries = entry;
+    table->free_count++;
+}
+
+/**
+ * Releases all entry chunks of the table at once. Every entry allocated from
+ * them becomes invalid.
+ *
+ * @param[in] table the table whose entries are being released
+ */
+static void entry_chunks_free(HashTable *table)
+{
+    EntryChunk *chunk = table->chunks;
+
+    while (chunk) {
+        EntryChunk *next = chunk->next;
+        table->mem_free(chunk);
+        chunk = next;
+    }
+    table->chunks       = NULL;
+    table->chunk_used   = 0;
+    table->free_entries = NULL;
+    table->free_count   = 0;
+}
+
+/**
+ * Makes sure that n more entries can be handed out without allocating
+ * another chunk. If the slab is short of entries, a single chunk of the
+ * missing size is allocated, and the never used tail of the current chunk
+ * is moved to the free list.
+ *
+ * @param[in] table the table whose slab is being grown
+ * @param[in] n     number of entries that are needed
+ *
+ * @return CC_OK if the entries are available, or CC_ERR_ALLOC if the memory
+ * allocation for a new chunk failed.
+ */
+static enum cc_stat entry_reserve(HashTable *table, size_t n)
+{
+    EntryChunk *chunk = table->chunks;
+    size_t      avail = table->free_count;
+
+    if (chunk)
+        avail += chunk->capacity - table->chunk_used;
+
+    if (n <= avail)
+        return CC_OK;
+
+    size_t      capacity  = n - avail;
+    EntryChunk *new_chunk = table->mem_alloc(sizeof(EntryChunk) + capacity * table->entry_size);
+
+    if (!new_chunk)
+        return CC_ERR_ALLOC;
+
+    while (chunk && table->chunk_used < chunk->capacity) {
+        entry_free(table, (TableEntry*) ((char*) chunk->entries +
+                                         table->chunk_used++ * table->entry_size));
+    }
+    new_chunk->capacity = capacity;
+    new_chunk->next     = table->chunks;
+    table->chunks       = new_chunk;
+    table->chunk_used   = 0;
+
+    return CC_OK;
+}
+
+/**
+ * Makes room for one more entry at the end of the dense entry array, either
+ * by squeezing out the holes or by growing the array.
+ *
+ * @param[in] table the table whose dense array is full
+ *
+ * @return CC_OK if there is room for a new entry, or CC_ERR_ALLOC if the
+ * memory allocation for a larger array failed.
+ */
+static enum cc_stat dense_make_room(HashTable *table)
+{
+    bool compact = table->holes && table->holes >= table->dense_size / 4;
+
+    /* The steps of an incremental rebuild always finish it before the
+     * array fills up */
+    if (table->dense_old)
+        dense_migrate(table, SIZE_MAX);
+
+    if (table->resize_step && table->dense_capacity) {
+        return dense_rebuild(table, compact ? table->dense_capacity
+                                            : table->dense_capacity << 1);
+    }
+
+    if (compact) {
+        dense_compact(table);
+        return CC_OK;
+    }
+
+    size_t capacity = table->dense_capacity ? table->dense_capacity << 1
+                                            : DENSE_MIN_CAPACITY;
+    TableEntry **dense = table->mem_alloc(capacity * sizeof(TableEntry*));
+
+    if (!dense)
+        return CC_ERR_ALLOC;
+
+    if (table->dense) {
+        memcpy(dense, table->dense, table->dense_size * sizeof(TableEntry*));
+        table->mem_free(table->dense);
+    }
+    table->dense          = dense;
+    table->dense_capacity = capacity;
+
+    return CC_OK;
+}
+
+/**
+ * Makes sure that n more entries can be appended to the dense entry array
+ * without growing it. Holes are squeezed out first, and if that isn't
+ * enough the array is grown to the exact size that is needed.
+ *
+ * @param[in] table the table whose dense array is being grown
+ * @param[in] n     number of entries that are going to be appended
+ *
+ * @return CC_OK if there is room for the entries, or CC_ERR_ALLOC if the
+ * memory allocation for a larger array failed.
+ */
+static enum cc_stat dense_reserve(HashTable *table, size_t n)
+{
+    if (table->dense_old)
+        dense_migrate(table, SIZE_MAX);
+
+    if (table->dense_capacity - table->dense_size >= n)
+        return CC_OK;
+
+    if (table->holes)
+        dense_compact(table);
+
+    if (table->dense_capacity - table->dense_size >= n)
+        return CC_OK;
+
+    size_t       capacity = table->dense_size + n;
+    TableEntry **dense    = table->mem_alloc(capacity * sizeof(TableEntry*));
+
+    if (!dense)
+        return CC_ERR_ALLOC;
+
+    if (table->dense) {
+        memcpy(dense, table->dense, table->dense_size * sizeof(TableEntry*));
+        table->mem_free(table->dense);
+    }
+    table->dense          = dense;
+    table->dense_capacity = capacity;
+
+    return CC_OK;
+}
+
+/**
+ * Moves the live entries of the dense entry array to its front, keeping their
+ * order.
+ *
+ * @param[in] table the table whose dense array is being compacted
+ */
+static void dense_compact(HashTable *table)
+{
+    size_t i;
+    size_t j = 0;
+
+    if (table->dense_old)
+        dense_migrate(table, SIZE_MAX);
+
+    for (i = 0; i < table->dense_size; i++) {
+        TableEntry *e = table->dense[i];
+
+        if (e) {
+            ORDER(e) = j;
+            table->dense[j++] = e;
+        }
+    }
+    table->dense_size = j;
+    table->holes      = 0;
+}
+
+/**
+ * Halves the dense entry array, or shrinks it further, once at most a quarter
+ * of it holds live entries. Only used by tables with a resize_step, so the
+ * array is shrunk incrementally. The array is left as it is if a rebuild is
+ * already in progress.
+ *
+ * @param[in] table the table whose dense array is being shrunk
+ */
+static void dense_shrink(HashTable *table)
+{
+    if (table->dense_old || table->dense_capacity <= DENSE_MIN_CAPACITY ||
+        table->size >= table->dense_capacity / 4)
+        return;
+
+    dense_rebuild(table, capacity_for(table->size * 2, 1.0f, DENSE_MIN_CAPACITY));
+}
+
+/**
+ * Starts moving the live entries of the dense array into a new array of the
+ * given capacity, which squeezes out the holes. The entries are moved a few
+ * at a time by dense_migrate(). The step is chosen so that the move is done
+ * before entries appended in the meantime can fill the new array.
+ *
+ * @param[in] table    the table whose dense array is being rebuilt
+ * @param[in] capacity capacity of the new array, larger than the number of
+ *                     live entries
+ *
+ * @return CC_OK if the rebuild was started, or CC_ERR_ALLOC if the memory
+ * allocation for the new array failed.
+ */
+static enum cc_stat dense_rebuild(HashTable *table, size_t capacity)
+{
+    /* The positions of entries that are removed before they are moved
+     * stay empty, so the new array must start out zeroed. */
+    TableEntry **dense = table->mem_calloc(capacity, sizeof(TableEntry*));
+
+    if (!dense)
+        return CC_ERR_ALLOC;
+
+    size_t live = table->dense_size - table->holes;
+    size_t room = capacity - live;
+
+    table->dense_old      = table->dense;
+    table->dense_old_size = table->dense_size;
+    table->dense_read     = 0;
+    table->dense_write    = 0;
+    table->dense_step     = (table->dense_size + room - 1) / room;
+
+    if (table->dense_step < table->resize_step)
+        table->dense_step = table->resize_step;
+
+    table->dense          = dense;
+    table->dense_size     = live;
+    table->dense_capacity = capacity;
+    table->holes          = 0;
+
+    dense_migrate(table, table->dense_step);
+
+    return CC_OK;
+}
+
+/**
+ * Moves the live entries of the next n slots of the old dense array into
+ * the new one and releases the old array once every slot has been moved.
+ *
+ * @param[in] table the table whose dense array is being rebuilt
+ * @param[in] n     number of slots to move, or SIZE_MAX to finish
+ */
+static void dense_migrate(HashTable *table, size_t n)
+{
+    size_t end = table->dense_old_size - table->dense_read > n ?
+        table->dense_read + n : table->dense_old_size;
+
+    for (; table->dense_read < end; table->dense_read++) {
+        TableEntry *e = table->dense_old[table->dense_read];
+
+        if (e) {
+            ORDER(e) = table->dense_write;
+            table->dense[table->dense_write++] = e;
+        }
+    }
+
+    if (table->dense_read == table->dense_old_size) {
+        if (table->dense_old)
+            table->mem_free(table->dense_old);
+        table->dense_old = NULL;
+    }
+}
+
+/**
+ * Leaves a hole in place of the entry in the dense entry array.
+ */
+static INLINE void dense_remove(HashTable *table, TableEntry *entry)
+{
+    size_t i = ORDER(entry);
+
+    /* Entries that are yet to be moved by a rebuild are the only ones in
+     * the unmoved part of the old array. */
+    if (table->dense_old && i >= table->dense_read && i < table->dense_old_size &&
+        table->dense_old[i] == entry)
+        table->dense_old[i] = NULL;
+    else
+        table->dense[i] = NULL;
+
+    table->holes++;
+}
+
+/**
+ * Returns the position of the first live entry at or after position i of
+ * the dense entry array, or SLOT_NONE if there is none.
+ */
+static size_t dense_next(HashTable *table, size_t i)
+{
+    for (; i < table->dense_size; i++) {
+        if (table->dense[i])
+            return i;
+    }
+    return SLOT_NONE;
+}
+
+
+/**
+ * Moves all entries from one bucket array to another.
+ *
+ * @param[in] src_bucket  the source bucket from which the entries are moved
+ * @param[in] dest_bucket the destination bucket to which the entries are being
+ *                        moved
+ * @param[in] src_size    size of the source bucket
+ * @param[in] dest_size   size of the destination bucket
+ */
+static INLINE void
+move_entries(TableEntry **src_bucket, TableEntry **dest_bucket,
+             size_t       src_size,   size_t       dest_size)
+{
+    size_t i;
+    for (i = 0; i < src_size; i++) {
+        TableEntry *entry = src_bucket[i];
+
+        while (entry) {
+            TableEntry *next  = entry->next;
+            size_t      index = entry->hash & (dest_size - 1);
+
+            entry->next = dest_bucket[index];
+            dest_bucket[index] = entry;
+
+            entry = next;
+        }
+    }
+}
+
+/**
+ * Returns the size of the specified HashTable. Size of a HashTable represents
+ * the number of key-value mappings within the table.
+ *
+ * @param[in] table the table whose size is being returned
+ *
+ * @return the size of the table.
+ */
+size_t hashtable_size(HashTable *table)
+{
+    return table->size;
+}
+
+/**
+ * Returns the current capacity of the table. The capacity is the number of
+ * buckets or the number of random access for table entries.
  *
  * @param[in] table the table whose current capacity is being returned
  *
@@ -520,6 +1582,179 @@ size_t hashtable_capacity(HashTable *table)
     return table->capacity;
 }
 
+/**
+ * Grows the table so that it can hold n entries without resizing. Chained
+ * tables also preallocate their entries, so adding up to n entries doesn't
+ * allocate any memory. The table is never shrunk by this function.
+ *
+ * @param[in] table the table that is being grown
+ * @param[in] n     the number of entries the table should be able to hold
+ *
+ * @return CC_OK if the table was successfully grown, CC_ERR_ALLOC if a memory
+ * allocation failed, or CC_ERR_MAX_CAPACITY if n entries exceed the maximum
+ * capacity of the table.
+ */
+enum cc_stat hashtable_reserve(HashTable *table, size_t n)
+{
+    const size_t min_capacity = table->backend == HASHTABLE_OPEN_ADDRESSING ? GROUP_WIDTH : 2;
+    size_t       capacity     = capacity_for(n, table->load_factor, min_capacity);
+
+    if ((size_t) (capacity * table->load_factor) < n)
+        return CC_ERR_MAX_CAPACITY;
+
+    if (table->backend == HASHTABLE_OPEN_ADDRESSING) {
+        if (n + table->deleted <= table->threshold)
+            return CC_OK;
+
+        if (capacity < table->capacity)
+            capacity = table->capacity;
+
+        return oa_resize(table, capacity);
+    }
+
+    enum cc_stat stat;
+
+    if (capacity > table->capacity && (stat = resize(table, capacity)) != CC_OK)
+        return stat;
+
+    if (n <= table->size)
+        return CC_OK;
+
+    if ((stat = dense_reserve(table, n - table->size)) != CC_OK)
+        return stat;
+
+    return entry_reserve(table, n - table->size);
+}
+
+/**
+ * Shrinks the table to the smallest capacity that holds its entries. Chained
+ * tables also move their entries into a single block of memory, and release
+ * the memory of removed entries.
+ *
+ * @note This invalidates all iterators and value slots of the table.
+ *
+ * @param[in] table the table that is being shrunk
+ *
+ * @return CC_OK if the table was successfully shrunk, or CC_ERR_ALLOC if a
+ * memory allocation failed, in which case the table is left unchanged.
+ */
+enum cc_stat hashtable_shrink_to_fit(HashTable *table)
+{
+    if (table->backend == HASHTABLE_CHAINED)
+        return chained_rebuild(table, capacity_for(table->size, table->load_factor, 2));
+
+    size_t capacity = capacity_for(table->size, table->load_factor, GROUP_WIDTH);
+
+    if (capacity >= table->capacity && !table->deleted)
+        return CC_OK;
+
+    return oa_resize(table, capacity < table->capacity ? capacity : table->capacity);
+}
+
+/**
+ * Rebuilds a chained table with a bucket array of the given capacity. The
+ * entries are copied, in insertion order, into a new chunk that holds
+ * exactly the live entries, and the dense array is trimmed to match.
+ *
+ * @param[in] t        the table that is being rebuilt
+ * @param[in] capacity the new capacity, a power of two
+ *
+ * @return CC_OK if the table was rebuilt, or CC_ERR_ALLOC if a memory
+ * allocation failed.
+ */
+static enum cc_stat chained_rebuild(HashTable *t, size_t capacity)
+{
+    if (t->dense_old)
+        dense_migrate(t, SIZE_MAX);
+
+    TableEntry **buckets = t->mem_calloc(capacity, sizeof(TableEntry*));
+    TableEntry **dense   = NULL;
+    EntryChunk  *chunk   = NULL;
+
+    if (buckets && t->size) {
+        dense = t->mem_alloc(t->size * sizeof(TableEntry*));
+        chunk = t->mem_alloc(sizeof(EntryChunk) + t->size * t->entry_size);
+    }
+    if (!buckets || (t->size && (!dense || !chunk))) {
+        t->mem_free(buckets);
+        t->mem_free(dense);
+        t->mem_free(chunk);
+        return CC_ERR_ALLOC;
+    }
+
+    size_t i;
+    size_t j = 0;
+    for (i = dense_next(t, 0); i != SLOT_NONE; i = dense_next(t, i + 1)) {
+        TableEntry *e     = (TableEntry*) ((char*) chunk->entries + j * t->entry_size);
+        size_t      index = t->dense[i]->hash & (capacity - 1);
+
+        memcpy(e, t->dense[i], t->entry_size);
+        ORDER(e) = j;
+        dense[j++] = e;
+
+        e->next = buckets[index];
+        buckets[index] = e;
+    }
+
+    entry_chunks_free(t);
+    if (t->old_buckets) {
+        t->mem_free(t->old_buckets);
+        t->old_buckets = NULL;
+    }
+    t->mem_free(t->buckets);
+    t->mem_free(t->dense);
+
+    if (chunk) {
+        chunk->capacity = t->size;
+        chunk->next     = NULL;
+        t->chunks       = chunk;
+        t->chunk_used   = t->size;
+    }
+    t->buckets        = buckets;
+    t->capacity       = capacity;
+    t->threshold      = capacity * t->load_factor;
+    t->dense          = dense;
+    t->dense_size     = t->size;
+    t->dense_capacity = t->size;
+    t->holes          = 0;
+
+    return CC_OK;
+}
+
+/**
+ * Shrinks the table once removals have dropped its load below the minimum
+ * load factor. The new capacity puts the load at about half of the load
+ * factor, so that neither a grow nor another shrink follows right away.
+ *
+ * Open addressing tables, and chained tables that resize in one go, are
+ * rebuilt at the new capacity, which also releases the memory of removed
+ * entries. Chained tables with a resize_step move their buckets to the
+ * smaller array incrementally, like they do when growing, and only trim
+ * their dense array.
+ *
+ * The table is left as it is if a memory allocation fails.
+ *
+ * @param[in] t the table from which entries were removed
+ */
+static void maybe_shrink(HashTable *t)
+{
+    if (t->capacity <= t->min_capacity || t->size >= t->capacity * t->min_load_factor)
+        return;
+
+    size_t capacity = capacity_for(t->size * 2, t->load_factor, t->min_capacity);
+
+    if (capacity >= t->capacity)
+        return;
+
+    if (t->backend == HASHTABLE_OPEN_ADDRESSING) {
+        oa_resize(t, capacity);
+    } else if (!t->resize_step) {
+        chained_rebuild(t, capacity);
+    } else if (resize(t, capacity) == CC_OK) {
+        dense_shrink(t);
+    }
+}
+
 /**
  * Checks whether or not the HashTable contains the specified key.
  *
@@ -530,10 +1765,20 @@ size_t hashtable_capacity(HashTable *table)
  */
 bool hashtable_contains_key(HashTable *table, void *key)
 {
-    TableEntry *entry = table->buckets[get_table_index(table, key)];
+    if (table->backend == HASHTABLE_OPEN_ADDRESSING)
+        return oa_find(table, key, hash_key(table, key)) != SLOT_NONE;
+
+    if (!key) {
+        void *out;
+        return get_null_key(table, &out) == CC_OK;
+    }
+
+    const size_t hash  = table->hash(key, table->key_len, table->hash_seed);
+    const size_t len   = key_length(table, key);
+    TableEntry  *entry = *get_bucket(table, hash);
 
     while (entry) {
-        if (table->key_cmp(key, entry->key) == 0)
+        if (entry_matches(table, entry, key, hash, len))
             return true;
 
         entry = entry->next;
@@ -566,17 +1811,14 @@ enum cc_stat hashtable_get_values(HashTable *table, Array **out)
     if (stat != CC_OK)
         return stat;
 
-    size_t i;
-    for (i = 0; i <table->capacity; i++) {
-        TableEntry *entry = table->buckets[i];
+    HashTableIter iter;
+    TableEntry   *entry;
+    hashtable_iter_init(&iter, table);
 
-        while (entry) {
-            if ((stat = array_add(values, entry->value)) == CC_OK) {
-                entry = entry->next;
-            } else {
-                array_destroy(values);
-                return stat;
-            }
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END) {
+        if ((stat = array_add(values, entry->value)) != CC_OK) {
+            array_destroy(values);
+            return stat;
         }
     }
     *out = values;
@@ -608,17 +1850,14 @@ enum cc_stat hashtable_get_keys(HashTable *table, Array **out)
     if (stat != CC_OK)
         return stat;
 
-    size_t i;
-    for (i = 0; i < table->capacity; i++) {
-        TableEntry *entry = table->buckets[i];
+    HashTableIter iter;
+    TableEntry   *entry;
+    hashtable_iter_init(&iter, table);
 
-        while (entry) {
-            if ((stat = array_add(keys, entry->key)) == CC_OK) {
-                entry = entry->next;
-            } else {
-                array_destroy(keys);
-                return stat;
-            }
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END) {
+        if ((stat = array_add(keys, entry->key)) != CC_OK) {
+            array_destroy(keys);
+            return stat;
         }
     }
     *out = keys;
@@ -626,12 +1865,52 @@ enum cc_stat hashtable_get_keys(HashTable *table, Array **out)
 }
 
 /**
- * Returns the bucket index that maps to the specified key.
+ * Returns the hash of the key. The NULL key always hashes to zero.
+ */
+static INLINE size_t hash_key(HashTable *table, const void *key)
+{
+    return key ? table->hash(key, table->key_len, table->hash_seed) : 0;
+}
+
+/**
+ * Returns the bucket that holds the entries with the specified hash. During
+ * an incremental resize, entries whose bucket hasn't been migrated yet live
+ * (and are added to) the old bucket array.
+ */
+static INLINE TableEntry **get_bucket(HashTable *table, size_t hash)
+{
+    if (table->old_buckets) {
+        size_t i = hash & (table->old_capacity - 1);
+
+        if (i >= table->migrate_index)
+            return &table->old_buckets[i];
+    }
+    return &table->buckets[hash & (table->capacity - 1)];
+}
+
+/**
+ * Checks whether a chained table entry holds the specified non-NULL key.
+ * Entries whose stored hash or cached key length differs are rejected
+ * without calling the key comparator.
+ */
+static INLINE bool entry_matches(HashTable *table, TableEntry *e, const void *key,
+                                 size_t hash, size_t len)
+{
+    if (e->hash != hash || !e->key)
+        return false;
+
+    if (table->cache_len && KEY_LEN(e) != len)
+        return false;
+
+    return table->key_cmp(e->key, key) == 0;
+}
+
+/**
+ * Returns the length of the key if the table caches key lengths, or 0.
  */
-static INLINE size_t get_table_index(HashTable *table, void *key)
+static INLINE size_t key_length(HashTable *table, const void *key)
 {
-    size_t hash = table->hash(key, table->key_len, table->hash_seed);
-    return hash & (table->capacity - 1);
+    return table->cache_len && key ? strlen(key) : 0;
 }
 
 /**
@@ -645,15 +1924,12 @@ static INLINE size_t get_table_index(HashTable *table, void *key)
  */
 void hashtable_foreach_key(HashTable *table, void (*fn) (const void *key))
 {
-    size_t i;
-    for (i = 0; i <table->capacity; i++) {
-        TableEntry *entry = table->buckets[i];
+    HashTableIter iter;
+    TableEntry   *entry;
+    hashtable_iter_init(&iter, table);
 
-        while (entry) {
-            fn(entry->key);
-            entry = entry->next;
-        }
-    }
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END)
+        fn(entry->key);
 }
 
 /**
@@ -665,21 +1941,19 @@ void hashtable_foreach_key(HashTable *table, void (*fn) (const void *key))
  */
 void hashtable_foreach_value(HashTable *table, void (*fn) (void *val))
 {
-    size_t i;
-    for (i = 0; i <table->capacity; i++) {
-        TableEntry *entry = table->buckets[i];
+    HashTableIter iter;
+    TableEntry   *entry;
+    hashtable_iter_init(&iter, table);
 
-        while (entry) {
-            fn(entry->value);
-            entry = entry->next;
-        }
-    }
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END)
+        fn(entry->value);
 }
 
 /**
  * Initializes the HashTableIter structure.
  *
- * @note The order at which the entries are returned is unspecified.
+ * @note Chained tables return their entries in insertion order. The order of
+ * open addressing tables is unspecified.
  *
  * @param[in] iter the iterator that is being initialized
  * @param[in] table the table over whose entries the iterator is going to iterate
@@ -689,15 +1963,26 @@ void hashtable_iter_init(HashTableIter *iter, HashTable *table)
     memset(iter, 0, sizeof(HashTableIter));
     iter->table = table;
 
-    size_t i;
-    for (i = 0; i < table->capacity; i++) {
-        TableEntry *e = table->buckets[i];
-        if (e) {
-            iter->bucket_index = i;
-            iter->next_entry   = e;
-            iter->prev_entry   = NULL;
-            break;
+    if (table->backend == HASHTABLE_OPEN_ADDRESSING) {
+        size_t slot = oa_next_full(table, 0);
+
+        if (slot != SLOT_NONE) {
+            iter->bucket_index = slot;
+            iter->next_entry   = &table->slots[slot];
         }
+        return;
+    }
+
+    /* Iterating is linear in the size of the table anyway, and finishing a
+     * rebuild of the dense array gives the entries stable positions. */
+    if (table->dense_old)
+        dense_migrate(table, SIZE_MAX);
+
+    size_t i = dense_next(table, 0);
+
+    if (i != SLOT_NONE) {
+        iter->bucket_index = i;
+        iter->next_entry   = table->dense[i];
     }
 }
 
@@ -717,26 +2002,23 @@ enum cc_stat hashtable_iter_next(HashTableIter *iter, TableEntry **te)
         return CC_ITER_END;
 
     iter->prev_entry = iter->next_entry;
-    iter->next_entry = iter->next_entry->next;
 
-    /* Iterate through the list */
-    if (iter->next_entry) {
+    if (iter->table->backend == HASHTABLE_OPEN_ADDRESSING) {
+        size_t slot = oa_next_full(iter->table, iter->bucket_index + 1);
+
+        iter->bucket_index = slot;
+        iter->next_entry   = slot == SLOT_NONE ? NULL : &iter->table->slots[slot];
+
         *te = iter->prev_entry;
         return CC_OK;
     }
 
-    /* Find the next list and return the first element*/
-    size_t i;
-    for (i = iter->bucket_index + 1; i < iter->table->capacity; i++) {
-        iter->next_entry = iter->table->buckets[i];
+    size_t i = dense_next(iter->table, iter->bucket_index + 1);
 
-        if (iter->next_entry) {
-            iter->bucket_index = i;
-            break;
-        }
-    }
-    *te = iter->prev_entry;
+    iter->bucket_index = i;
+    iter->next_entry   = i == SLOT_NONE ? NULL : iter->table->dense[i];
 
+    *te = iter->prev_entry;
     return CC_OK;
 }
 
@@ -753,11 +2035,337 @@ enum cc_stat hashtable_iter_next(HashTableIter *iter, TableEntry **te)
  *                 if it is to be ignored
  *
  * @return CC_OK if the entry was successfully removed, or
- * CC_ERR_KEY_NOT_FOUND.
+ * CC_ERR_KEY_NOT_FOUND if the entry has already been removed.
  */
 enum cc_stat hashtable_iter_remove(HashTableIter *iter, void **out)
 {
-    return hashtable_remove(iter->table, iter->prev_entry->key, out);
+    HashTable  *table = iter->table;
+    TableEntry *entry = iter->prev_entry;
+
+    if (!entry)
+        return CC_ERR_KEY_NOT_FOUND;
+
+    if (out)
+        *out = entry->value;
+
+    iter->prev_entry = NULL;
+
+    /* The entry is removed directly instead of being looked up by its key.
+     * Entries never move on removal, so the iterator stays valid. */
+    if (table->backend == HASHTABLE_OPEN_ADDRESSING)
+        oa_remove_at(table, entry - table->slots);
+    else
+        remove_entry(table, entry);
+
+    return CC_OK;
+}
+
+/**
+ * Removes all entries for which the predicate returns false. This is done in
+ * a single pass over the entries, without looking any key up.
+ *
+ * @param[in] table the table from which the entries are being removed
+ * @param[in] pred  predicate that returns true for the entries that are kept
+ * @param[in] ctx   user data that is passed to the predicate
+ *
+ * @return the number of removed entries.
+ */
+size_t hashtable_retain(HashTable *table,
+                        bool (*pred) (const void *key, void *value, void *ctx),
+                        void *ctx)
+{
+    size_t removed = 0;
+    size_t i;
+
+    if (table->backend == HASHTABLE_OPEN_ADDRESSING) {
+        for (i = oa_next_full(table, 0); i != SLOT_NONE; i = oa_next_full(table, i + 1)) {
+            TableEntry *e = &table->slots[i];
+
+            if (!pred(e->key, e->value, ctx)) {
+                oa_remove_at(table, i);
+                removed++;
+            }
+        }
+        maybe_shrink(table);
+        return removed;
+    }
+
+    /* Compacts the dense array while sweeping it */
+    size_t j = 0;
+
+    if (table->dense_old)
+        dense_migrate(table, SIZE_MAX);
+
+    for (i = 0; i < table->dense_size; i++) {
+        TableEntry *e = table->dense[i];
+
+        if (!e)
+            continue;
+
+        if (pred(e->key, e->value, ctx)) {
+            ORDER(e) = j;
+            table->dense[j++] = e;
+        } else {
+            unlink_entry(table, e);
+            entry_free(table, e);
+            table->size--;
+            removed++;
+        }
+    }
+    table->dense_size = j;
+    table->holes      = 0;
+
+    maybe_shrink(table);
+    return removed;
+}
+
+
+/*******************************************************************************
+ *
+ *
+ *  Open addressing
+ *
+ *
+ ******************************************************************************/
+
+/**
+ * Returns the group at which the probe sequence for the hash starts. The
+ * low bits of the hash are used for the control byte fingerprint, so the
+ * group is selected from the remaining bits.
+ */
+static INLINE size_t oa_probe_start(size_t hash, size_t capacity)
+{
+    return (hash >> 7) & (capacity / GROUP_WIDTH - 1);
+}
+
+/**
+ * Prefetches the first control group and the first slot that the lookup
+ * of a key with the given hash will inspect.
+ */
+static void oa_prefetch(HashTable *table, size_t hash)
+{
+    size_t group = oa_probe_start(hash, table->capacity);
+
+    PREFETCH(table->ctrl + group * GROUP_WIDTH);
+    PREFETCH(table->slots + group * GROUP_WIDTH);
+}
+
+/**
+ * Allocates empty slot and control arrays of the given capacity and
+ * attaches them to the table.
+ */
+static enum cc_stat oa_new(HashTable *table, size_t capacity)
+{
+    if (capacity < GROUP_WIDTH)
+        capacity = GROUP_WIDTH;
+
+    uint8_t    *ctrl  = table->mem_alloc(capacity);
+    TableEntry *slots = table->mem_calloc(capacity, sizeof(TableEntry));
+
+    if (!ctrl || !slots) {
+        table->mem_free(ctrl);
+        table->mem_free(slots);
+        return CC_ERR_ALLOC;
+    }
+    memset(ctrl, CTRL_EMPTY, capacity);
+
+    table->ctrl      = ctrl;
+    table->slots     = slots;
+    table->capacity  = capacity;
+    table->deleted   = 0;
+    table->threshold = capacity * table->load_factor;
+
+    if (table->threshold == 0)
+        table->threshold = 1;
+
+    return CC_OK;
+}
+
+/**
+ * Returns the first empty or deleted slot on the probe sequence of the hash.
+ * Groups are probed quadratically (by triangular numbers), which visits every
+ * group exactly once when the number of groups is a power of two.
+ */
+static INLINE size_t oa_find_free(const uint8_t *ctrl, size_t capacity, size_t hash)
+{
+    const size_t mask  = capacity / GROUP_WIDTH - 1;
+    size_t       group = oa_probe_start(hash, capacity);
+    size_t       step  = 0;
+
+    for (;;) {
+        uint32_t free = group_match_free(ctrl + group * GROUP_WIDTH);
+
+        if (free)
+            return group * GROUP_WIDTH + ctz32(free);
+
+        group = (group + ++step) & mask;
+    }
+}
+
+/**
+ * Returns the slot that holds the key, or SLOT_NONE if the key is not in
+ * the table.
+ */
+static size_t oa_find(HashTable *table, const void *key, size_t hash)
+{
+    const size_t  mask  = table->capacity / GROUP_WIDTH - 1;
+    const uint8_t h2    = CTRL_H2(hash);
+
+    size_t group = oa_probe_start(hash, table->capacity);
+    size_t step  = 0;
+
+    for (;;) {
+        const uint8_t *ctrl  = table->ctrl + group * GROUP_WIDTH;
+        uint32_t       match = group_match(ctrl, h2);
+
+        while (match) {
+            size_t      slot = group * GROUP_WIDTH + ctz32(match);
+            TableEntry *e    = &table->slots[slot];
+
+            if (key ? (e->hash == hash && e->key && table->key_cmp(e->key, key) == 0) : !e->key)
+                return slot;
+
+            match &= match - 1;
+        }
+        /* An empty slot terminates every probe sequence that reaches it,
+         * so the key can't be in any of the following groups. */
+        if (group_match(ctrl, CTRL_EMPTY))
+            return SLOT_NONE;
+
+        group = (group + ++step) & mask;
+    }
+}
+
+/**
+ * Moves all entries into new slot and control arrays of the given capacity.
+ * Tombstones are dropped in the process. The stored hashes are reused, so
+ * the hash function isn't called.
+ */
+static enum cc_stat oa_resize(HashTable *table, size_t new_capacity)
+{
+    uint8_t    *old_ctrl  = table->ctrl;
+    TableEntry *old_slots = table->slots;
+    size_t      old_cap   = table->capacity;
+
+    if (oa_new(table, new_capacity) != CC_OK)
+        return CC_ERR_ALLOC;
+
+    size_t i;
+    for (i = 0; i < old_cap; i++) {
+        if (old_ctrl[i] & CTRL_EMPTY)
+            continue;
+
+        size_t hash = old_slots[i].hash;
+        size_t slot = oa_find_free(table->ctrl, table->capacity, hash);
+
+        table->ctrl[slot]  = CTRL_H2(hash);
+        table->slots[slot] = old_slots[i];
+    }
+    table->mem_free(old_ctrl);
+    table->mem_free(old_slots);
+
+    return CC_OK;
+}
+
+/**
+ * Open addressing variant of get_or_add.
+ */
+static enum cc_stat oa_get_or_add(HashTable *table, void *key, void *val,
+                                  TableEntry **out, bool *inserted)
+{
+    const size_t hash = hash_key(table, key);
+    size_t       slot = oa_find(table, key, hash);
+
+    if (slot != SLOT_NONE) {
+        *out      = &table->slots[slot];
+        *inserted = false;
+        return CC_OK;
+    }
+
+    slot = oa_find_free(table->ctrl, table->capacity, hash);
+
+    if (table->ctrl[slot] == CTRL_EMPTY &&
+        table->size + table->deleted >= table->threshold) {
+        /* If at least half of the used slots are tombstones it's enough
+         * to clean them up, otherwise the table grows. */
+        size_t new_capacity = table->capacity;
+
+        if (table->size >= table->deleted) {
+            if (table->capacity == MAX_POW_TWO)
+                return CC_ERR_MAX_CAPACITY;
+            new_capacity <<= 1;
+        }
+        enum cc_stat stat = oa_resize(table, new_capacity);
+        if (stat != CC_OK)
+            return stat;
+
+        slot = oa_find_free(table->ctrl, table->capacity, hash);
+    }
+
+    *out      = oa_insert_at(table, slot, key, val, hash);
+    *inserted = true;
+    return CC_OK;
+}
+
+/**
+ * Stores a new entry in a free slot.
+ */
+static TableEntry *oa_insert_at(HashTable *table, size_t slot, void *key, void *val,
+                                size_t hash)
+{
+    if (table->ctrl[slot] == CTRL_DELETED)
+        table->deleted--;
+
+    TableEntry *e = &table->slots[slot];
+
+    e->key   = key;
+    e->value = val;
+    e->hash  = hash;
+    e->next  = NULL;
+
+    table->ctrl[slot] = CTRL_H2(hash);
+    table->size++;
+
+    return e;
+}
+
+/**
+ * Releases an occupied slot.
+ */
+static void oa_remove_at(HashTable *table, size_t slot)
+{
+    const uint8_t *group = table->ctrl + (slot & ~((size_t) GROUP_WIDTH - 1));
+
+    /* A probe only moves past a group that has no empty slots. If this
+     * group still has one, no probe sequence continues beyond it and the
+     * slot can be marked as empty instead of leaving a tombstone. */
+    if (group_match(group, CTRL_EMPTY)) {
+        table->ctrl[slot] = CTRL_EMPTY;
+    } else {
+        table->ctrl[slot] = CTRL_DELETED;
+        table->deleted++;
+    }
+    table->size--;
+}
+
+/**
+ * Returns the first occupied slot at or after the specified slot, or
+ * SLOT_NONE if there are none.
+ */
+static size_t oa_next_full(HashTable *table, size_t slot)
+{
+    while (slot < table->capacity) {
+        size_t   base = slot & ~((size_t) GROUP_WIDTH - 1);
+        uint32_t full = ~group_match_free(table->ctrl + base) & GROUP_MASK_ALL;
+
+        full &= GROUP_MASK_ALL << (slot - base);
+
+        if (full)
+            return base + ctz32(full);
+
+        slot = base + GROUP_WIDTH;
+    }
+    return SLOT_NONE;
 }
 
 
@@ -1057,3 +2665,252 @@ size_t hashtable_hash_ptr(const void *key, int len, uint32_t seed)
 }
 
 #endif /* ARCH_64 */
+
+
+/*******************************************************************************
+ *
+ *
+ *  wyhash by Wang Yi, adapted for hashtable use.
+ *
+ *  Long keys are consumed 48 bytes per step in three independent 16 byte
+ *  lanes, each of which is mixed with a 64x64->128 bit multiply. Keys of up
+ *  to 16 bytes are read with at most four overlapping loads.
+ *
+ *
+ ******************************************************************************/
+
+static const uint64_t wy_secret[4] = {
+    BIG_CONSTANT(0xa0761d6478bd642f), BIG_CONSTANT(0xe7037ed1a0b428db),
+    BIG_CONSTANT(0x8ebc6af09c88c6e3), BIG_CONSTANT(0x589965cc75374cc3)
+};
+
+static FORCE_INLINE void wy_mum(uint64_t *a, uint64_t *b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t) *a * *b;
+
+    *a = (uint64_t) r;
+    *b = (uint64_t) (r >> 64);
+#else
+    uint64_t ha = *a >> 32, la = (uint32_t) *a;
+    uint64_t hb = *b >> 32, lb = (uint32_t) *b;
+
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t  = rl + (rm0 << 32);
+    uint64_t c  = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static FORCE_INLINE uint64_t wy_mix(uint64_t a, uint64_t b)
+{
+    wy_mum(&a, &b);
+    return a ^ b;
+}
+
+static FORCE_INLINE uint64_t wy_read8(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static FORCE_INLINE uint64_t wy_read4(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static FORCE_INLINE uint64_t wy_read3(const uint8_t *p, size_t k)
+{
+    return (((uint64_t) p[0]) << 16) | (((uint64_t) p[k >> 1]) << 8) | p[k - 1];
+}
+
+static uint64_t wyhash(const void *key, size_t len, uint64_t seed)
+{
+    const uint8_t *p = key;
+    uint64_t a;
+    uint64_t b;
+
+    seed ^= wy_mix(seed ^ wy_secret[0], wy_secret[1]);
+
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (wy_read4(p) << 32) | wy_read4(p + ((len >> 3) << 2));
+            b = (wy_read4(p + len - 4) << 32) | wy_read4(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = wy_read3(p, len);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+
+        if (i > 48) {
+            uint64_t see1 = seed;
+            uint64_t see2 = seed;
+            do {
+                seed = wy_mix(wy_read8(p)      ^ wy_secret[1], wy_read8(p + 8)  ^ seed);
+                see1 = wy_mix(wy_read8(p + 16) ^ wy_secret[2], wy_read8(p + 24) ^ see1);
+                see2 = wy_mix(wy_read8(p + 32) ^ wy_secret[3], wy_read8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = wy_mix(wy_read8(p) ^ wy_secret[1], wy_read8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = wy_read8(p + i - 16);
+        b = wy_read8(p + i - 8);
+    }
+    a ^= wy_secret[1];
+    b ^= seed;
+    wy_mum(&a, &b);
+
+    return wy_mix(a ^ wy_secret[0] ^ len, b ^ wy_secret[1]);
+}
+
+/*
+ * wyhash of a key of len bytes.
+ */
+size_t hashtable_wyhash(const void *key, int len, uint32_t seed)
+{
+    return (size_t) wyhash(key, len, seed);
+}
+
+/*
+ * wyhash of a NUL terminated string. The len parameter is ignored.
+ */
+size_t hashtable_wyhash_string(const void *key, int len, uint32_t seed)
+{
+    return (size_t) wyhash(key, strlen(key), seed);
+}
+
+/*
+ * wyhash variant that hashes the pointer itself.
+ */
+size_t hashtable_wyhash_ptr(const void *key, int len, uint32_t seed)
+{
+    uint64_t a = (uint64_t) (uintptr_t) key ^ wy_secret[0];
+    uint64_t b = seed ^ wy_secret[1];
+
+    wy_mum(&a, &b);
+    return (size_t) wy_mix(a ^ wy_secret[0], b ^ wy_secret[1]);
+}
+
+
+/*******************************************************************************
+ *
+ *
+ *  SipHash-1-3 by Jean-Philippe Aumasson and Daniel J. Bernstein.
+ *
+ *  A keyed hash for tables that store untrusted keys. The 128 bit key is a
+ *  process wide random secret combined with the table's seed, so that
+ *  keys which collide can't be predicted even by someone who knows or
+ *  guesses the 32 bit seed, and tables with different seeds still hash
+ *  differently.
+ *
+ *
+ ******************************************************************************/
+
+#define SIP_ROUND(v0, v1, v2, v3)                                       \
+    do {                                                                \
+        v0 += v1; v1 = ROTL64(v1, 13); v1 ^= v0; v0 = ROTL64(v0, 32);   \
+        v2 += v3; v3 = ROTL64(v3, 16); v3 ^= v2;                        \
+        v0 += v3; v3 = ROTL64(v3, 21); v3 ^= v0;                        \
+        v2 += v1; v1 = ROTL64(v1, 17); v1 ^= v2; v2 = ROTL64(v2, 32);   \
+    } while (0)
+
+static uint64_t siphash13(const void *key, size_t len, uint64_t k0, uint64_t k1)
+{
+    const uint8_t *p   = key;
+    const uint8_t *end = p + (len & ~(size_t) 7);
+
+    uint64_t v0 = k0 ^ BIG_CONSTANT(0x736f6d6570736575);
+    uint64_t v1 = k1 ^ BIG_CONSTANT(0x646f72616e646f6d);
+    uint64_t v2 = k0 ^ BIG_CONSTANT(0x6c7967656e657261);
+    uint64_t v3 = k1 ^ BIG_CONSTANT(0x7465646279746573);
+    uint64_t b  = ((uint64_t) len) << 56;
+
+    for (; p != end; p += 8) {
+        uint64_t m = 0;
+        int i;
+        for (i = 0; i < 8; i++)
+            m |= ((uint64_t) p[i]) << (8 * i);
+
+        v3 ^= m;
+        SIP_ROUND(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+
+    switch (len & 7) {
+    case 7: b |= ((uint64_t) p[6]) << 48; /* fall through */
+    case 6: b |= ((uint64_t) p[5]) << 40; /* fall through */
+    case 5: b |= ((uint64_t) p[4]) << 32; /* fall through */
+    case 4: b |= ((uint64_t) p[3]) << 24; /* fall through */
+    case 3: b |= ((uint64_t) p[2]) << 16; /* fall through */
+    case 2: b |= ((uint64_t) p[1]) << 8;  /* fall through */
+    case 1: b |= ((uint64_t) p[0]);
+    }
+
+    v3 ^= b;
+    SIP_ROUND(v0, v1, v2, v3);
+    v0 ^= b;
+
+    v2 ^= 0xff;
+    SIP_ROUND(v0, v1, v2, v3);
+    SIP_ROUND(v0, v1, v2, v3);
+    SIP_ROUND(v0, v1, v2, v3);
+
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+static pthread_once_t sip_once = PTHREAD_ONCE_INIT;
+static uint64_t       sip_secret[2];
+
+static void sip_secret_init(void)
+{
+    random_bytes(sip_secret, sizeof(sip_secret));
+}
+
+/*
+ * Returns the SipHash key for the table seed. The secret is read from the
+ * random number generator on first use and the seed is XORed into both
+ * halves of it, since a random key needs no further mixing.
+ */
+static FORCE_INLINE void sip_key(uint32_t seed, uint64_t *k0, uint64_t *k1)
+{
+    pthread_once(&sip_once, sip_secret_init);
+
+    *k0 = sip_secret[0] ^ seed;
+    *k1 = sip_secret[1] ^ ((uint64_t) seed << 32);
+}
+
+/*
+ * SipHash-1-3 of a key of len bytes.
+ */
+size_t hashtable_siphash(const void *key, int len, uint32_t seed)
+{
+    uint64_t k0, k1;
+    sip_key(seed, &k0, &k1);
+    return (size_t) siphash13(key, len, k0, k1);
+}
+
+/*
+ * SipHash-1-3 of a NUL terminated string. The len parameter is ignored.
+ */
+size_t hashtable_siphash_string(const void *key, int len, uint32_t seed)
+{
+    uint64_t k0, k1;
+    sip_key(seed, &k0, &k1);
+    return (size_t) siphash13(key, strlen(key), k0, k1);
+}
@@ -0,0 +1,170 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2015 Srđan Panić <srdja.panic@gmail.com>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Helpers shared by the HashTable and HashSet implementations. This header is
+ * internal to the library and isn't installed. */
+
+#ifndef COLLECTIONS_C_HASHTABLE_INTERNAL_H
+#define COLLECTIONS_C_HASHTABLE_INTERNAL_H
+
+#include "common.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HASHTABLE_SSE2
+#endif
+
+/* Open addressing tables probe their control bytes in groups of GROUP_WIDTH
+ * slots. A control byte is either EMPTY, DELETED (a tombstone), or holds the
+ * low 7 bits of the hash of the entry that occupies the slot. Both special
+ * values have the high bit set, which full slots never do. */
+#define GROUP_WIDTH        16
+#define CTRL_EMPTY         ((uint8_t) 0x80)
+#define CTRL_DELETED       ((uint8_t) 0xFE)
+#define CTRL_H2(hash)      ((uint8_t) ((hash) & 0x7F))
+
+/* Open addressing tables cap their load factor so that every probe
+ * sequence reaches a free slot. */
+#define OA_MAX_LOAD_FACTOR 0.875f
+#define SLOT_NONE          ((size_t) -1)
+
+/* Batched lookups hash and prefetch BATCH_WIDTH keys at a time before
+ * comparing any of them. */
+#define BATCH_WIDTH        16
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(addr)     __builtin_prefetch(addr)
+#else
+#define PREFETCH(addr)     ((void) (addr))
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+static INLINE unsigned ctz32(uint32_t x)
+{
+    unsigned long i;
+    _BitScanForward(&i, x);
+    return (unsigned) i;
+}
+
+#else
+
+#define ctz32(x) ((unsigned) __builtin_ctz(x))
+
+#endif /* _MSC_VER */
+
+#ifdef HASHTABLE_SSE2
+
+/**
+ * Returns a bitmask of the control bytes in the group that are equal to c.
+ */
+static INLINE uint32_t group_match(const uint8_t *ctrl, uint8_t c)
+{
+    __m128i group = _mm_loadu_si128((const __m128i*) ctrl);
+    return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8((char) c), group));
+}
+
+/**
+ * Returns a bitmask of the slots in the group that are either empty or
+ * deleted, in other words, of the control bytes that have the high bit set.
+ */
+static INLINE uint32_t group_match_free(const uint8_t *ctrl)
+{
+    return (uint32_t) _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) ctrl));
+}
+
+#else
+
+static INLINE uint32_t group_match(const uint8_t *ctrl, uint8_t c)
+{
+    uint32_t mask = 0;
+    int i;
+    for (i = 0; i < GROUP_WIDTH; i++)
+        mask |= (uint32_t) (ctrl[i] == c) << i;
+    return mask;
+}
+
+static INLINE uint32_t group_match_free(const uint8_t *ctrl)
+{
+    uint32_t mask = 0;
+    int i;
+    for (i = 0; i < GROUP_WIDTH; i++)
+        mask |= (uint32_t) (ctrl[i] >> 7) << i;
+    return mask;
+}
+
+#endif /* HASHTABLE_SSE2 */
+
+#define GROUP_MASK_ALL ((uint32_t) (1 << GROUP_WIDTH) - 1)
+
+/**
+ * Rounds the integer to the nearest upper power of two.
+ *
+ * @param[in] the unsigned integer that is being rounded
+ *
+ * @return the nearest upper power of two.
+ */
+static INLINE size_t round_pow_two(size_t n)
+{
+    if (n >= MAX_POW_TWO)
+        return MAX_POW_TWO;
+
+    if (n == 0)
+        return 2;
+    /**
+     * taken from:
+     * http://graphics.stanford.edu/~seander/
+     * bithacks.html#RoundUpPowerOf2Float
+     */
+    n--;
+    n |= n >> 1;
+    n |= n >> 2;
+    n |= n >> 4;
+    n |= n >> 8;
+    n |= n >> 16;
+    n++;
+
+    return n;
+}
+
+/**
+ * Returns the smallest power of two capacity, but at least min_capacity, at
+ * which a table with the given load factor holds n entries.
+ */
+static INLINE size_t capacity_for(size_t n, float load_factor, size_t min_capacity)
+{
+    size_t capacity = min_capacity;
+
+    while (capacity < MAX_POW_TWO && (size_t) (capacity * load_factor) < n)
+        capacity <<= 1;
+
+    return capacity;
+}
+
+uint32_t hashtable_random_seed(void);
+
+/* Allocate and free through the allocators the table was configured with */
+struct hashtable_s;
+
+void    *hashtable_mem_alloc   (struct hashtable_s *table, size_t size);
+void     hashtable_mem_free    (struct hashtable_s *table, void *block);
+
+#endif /* COLLECTIONS_C_HASHTABLE_INTERNAL_H */
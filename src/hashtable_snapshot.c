@@ -0,0 +1,535 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2015 Srđan Panić <srdja.panic@gmail.com>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * HashTable snapshots.
+ *
+ * A snapshot is a flat, position independent image of a table that can be
+ * memory mapped and queried in place. All integers are 64-bit, in the byte
+ * order of the machine that wrote the file.
+ *
+ *     header    SnapshotHeader, padded to 64 bytes
+ *     index     capacity IndexSlot entries, an open addressing table with
+ *               linear probing that is at most half full
+ *     data      count records, each made of the key size, the value size,
+ *               the key bytes and the value bytes, each part padded to
+ *               8 bytes
+ *
+ * Index slots hold the hash of the key and the offset of its record from
+ * the start of the data, or SLOT_EMPTY. Keys are hashed with wyhash over
+ * their serialized bytes, so the snapshot doesn't depend on the hash
+ * function of the table it was saved from.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#include <stdio.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "hashtable.h"
+#include "hashtable_internal.h"
+
+#define SNAPSHOT_MAGIC    "CCHTSNAP"
+#define SNAPSHOT_VERSION  1
+#define SNAPSHOT_ENDIAN   0x01020304
+#define HEADER_SIZE       64
+#define SLOT_EMPTY        UINT64_MAX
+#define WRITE_BUFFER_SIZE 65536
+
+#define PAD8(n) (((n) + 7) & ~(uint64_t) 7)
+
+typedef struct snapshot_header_s {
+    char     magic[8];
+    uint32_t version;
+    uint32_t endian;
+    uint64_t count;
+    uint64_t capacity;
+    uint64_t seed;
+    uint64_t index_offset;
+    uint64_t data_offset;
+    uint64_t data_size;
+} SnapshotHeader;
+
+typedef struct index_slot_s {
+    uint64_t hash;
+    uint64_t offset;
+} IndexSlot;
+
+typedef struct record_s {
+    uint64_t key_size;
+    uint64_t val_size;
+} Record;
+
+struct hashtable_snapshot_s {
+    const uint8_t   *base;
+    size_t           length;
+    const IndexSlot *index;
+    const uint8_t   *data;
+    uint64_t         data_size;
+    uint64_t         mask;
+    uint64_t         count;
+    uint32_t         seed;
+};
+
+typedef struct writer_s {
+    int     fd;
+    size_t  used;
+    bool    failed;
+    uint8_t buf[WRITE_BUFFER_SIZE];
+} Writer;
+
+static void   writer_put   (Writer *w, const void *bytes, size_t n);
+static void   writer_flush (Writer *w);
+static size_t slot_of      (const IndexSlot *index, uint64_t mask, uint64_t hash);
+
+
+/**
+ * Returns the hash of a serialized key.
+ */
+static INLINE uint64_t snapshot_hash(const void *key, size_t size, uint32_t seed)
+{
+    return hashtable_wyhash(key, (int) size, seed);
+}
+
+/**
+ * Writes a snapshot of the table to the file descriptor, starting at its
+ * current position. The keys and values are turned into bytes by key_ser and
+ * val_ser, which return a pointer to the serialized bytes of their argument
+ * and store their number in size. The bytes only need to stay valid until
+ * either serializer is called again, so both may share a buffer. Every key
+ * and value is serialized twice, and must serialize to the same number of
+ * bytes both times.
+ *
+ * The snapshot can be opened with hashtable_open_mmap() and queried with
+ * the serialized bytes of a key. If several keys serialize to the same bytes,
+ * lookups find one of them.
+ *
+ * @param[in] table   the table that is being saved
+ * @param[in] fd      file descriptor open for writing
+ * @param[in] key_ser serializer of the keys
+ * @param[in] val_ser serializer of the values
+ *
+ * @return CC_OK if the snapshot was written, CC_ERR_ALLOC if a memory
+ * allocation failed, CC_ERR_INVALID_FORMAT if a serializer returned a
+ * different size the second time, in which case the written snapshot is
+ * incomplete, or CC_ERR_IO if writing to fd failed, in which case errno
+ * describes the error.
+ */
+enum cc_stat hashtable_save(HashTable *table, int fd,
+                            const void *(*key_ser) (const void *key, size_t *size),
+                            const void *(*val_ser) (const void *val, size_t *size))
+{
+    uint64_t       count    = hashtable_size(table);
+    uint64_t       capacity = round_pow_two(count * 2);
+    uint64_t       offset   = 0;
+    HashTableIter  iter;
+    TableEntry    *entry;
+
+    if (capacity < 2 * count)
+        return CC_ERR_MAX_CAPACITY;
+
+    if (count > SIZE_MAX / sizeof(Record) || capacity > SIZE_MAX / sizeof(IndexSlot))
+        return CC_ERR_ALLOC;
+
+    /* The record headers are kept from the first pass, so that the second
+     * one only has to serialize each key and value right before it is
+     * written. */
+    IndexSlot *index   = hashtable_mem_alloc(table, capacity * sizeof(IndexSlot));
+    Record    *records = hashtable_mem_alloc(table, (count ? count : 1) * sizeof(Record));
+    Writer    *writer  = hashtable_mem_alloc(table, sizeof(Writer));
+
+    if (!index || !records || !writer) {
+        if (index)
+            hashtable_mem_free(table, index);
+        if (records)
+            hashtable_mem_free(table, records);
+        if (writer)
+            hashtable_mem_free(table, writer);
+        return CC_ERR_ALLOC;
+    }
+    memset(index, 0xFF, capacity * sizeof(IndexSlot));
+
+    /* Lay out the records and index them */
+    size_t n = 0;
+
+    hashtable_iter_init(&iter, table);
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END) {
+        size_t      key_size;
+        size_t      val_size;
+        const void *key  = key_ser(entry->key, &key_size);
+        uint64_t    hash = snapshot_hash(key, key_size, 0);
+
+        val_ser(entry->value, &val_size);
+
+        size_t slot = slot_of(index, capacity - 1, hash);
+        index[slot].hash   = hash;
+        index[slot].offset = offset;
+
+        records[n].key_size = key_size;
+        records[n].val_size = val_size;
+        n++;
+
+        offset += sizeof(Record) + PAD8(key_size) + PAD8(val_size);
+    }
+
+    SnapshotHeader header;
+    uint8_t        head[HEADER_SIZE];
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version      = SNAPSHOT_VERSION;
+    header.endian       = SNAPSHOT_ENDIAN;
+    header.count        = count;
+    header.capacity     = capacity;
+    header.seed         = 0;
+    header.index_offset = HEADER_SIZE;
+    header.data_offset  = HEADER_SIZE + capacity * sizeof(IndexSlot);
+    header.data_size    = offset;
+
+    memset(head, 0, sizeof(head));
+    memcpy(head, &header, sizeof(header));
+
+    writer->fd     = fd;
+    writer->used   = 0;
+    writer->failed = false;
+
+    writer_put(writer, head, sizeof(head));
+    writer_put(writer, index, capacity * sizeof(IndexSlot));
+
+    /* Write the records in the same order */
+    static const uint8_t zeros[8];
+    enum cc_stat         status = CC_OK;
+
+    n = 0;
+    hashtable_iter_init(&iter, table);
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END && !writer->failed) {
+        const Record *rec = &records[n++];
+        size_t        key_size;
+        size_t        val_size;
+
+        writer_put(writer, rec, sizeof(*rec));
+
+        const void *key = key_ser(entry->key, &key_size);
+
+        if (key_size != rec->key_size) {
+            status = CC_ERR_INVALID_FORMAT;
+            break;
+        }
+        writer_put(writer, key, key_size);
+        writer_put(writer, zeros, PAD8(key_size) - key_size);
+
+        const void *val = val_ser(entry->value, &val_size);
+
+        if (val_size != rec->val_size) {
+            status = CC_ERR_INVALID_FORMAT;
+            break;
+        }
+        writer_put(writer, val, val_size);
+        writer_put(writer, zeros, PAD8(val_size) - val_size);
+    }
+    writer_flush(writer);
+
+    if (writer->failed)
+        status = CC_ERR_IO;
+
+    hashtable_mem_free(table, index);
+    hashtable_mem_free(table, records);
+    hashtable_mem_free(table, writer);
+
+    return status;
+}
+
+/**
+ * Returns the slot of the hash in the index that is being built.
+ */
+static size_t slot_of(const IndexSlot *index, uint64_t mask, uint64_t hash)
+{
+    size_t slot = hash & mask;
+
+    while (index[slot].offset != SLOT_EMPTY)
+        slot = (slot + 1) & mask;
+
+    return slot;
+}
+
+/**
+ * Appends n bytes to the writer's buffer, flushing it when it fills up.
+ */
+static void writer_put(Writer *w, const void *bytes, size_t n)
+{
+    const uint8_t *p = bytes;
+
+    while (n > 0 && !w->failed) {
+        size_t chunk = WRITE_BUFFER_SIZE - w->used;
+
+        if (chunk > n)
+            chunk = n;
+
+        memcpy(w->buf + w->used, p, chunk);
+        w->used += chunk;
+        p       += chunk;
+        n       -= chunk;
+
+        if (w->used == WRITE_BUFFER_SIZE)
+            writer_flush(w);
+    }
+}
+
+/**
+ * Writes the buffered bytes to the file descriptor.
+ */
+static void writer_flush(Writer *w)
+{
+    size_t done = 0;
+
+    while (done < w->used && !w->failed) {
+        ssize_t n = write(w->fd, w->buf + done, w->used - done);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            w->failed = true;
+        else
+            done += (size_t) n;
+    }
+    w->used = 0;
+}
+
+/**
+ * Checks that the header describes a snapshot that fits into length bytes.
+ */
+static bool header_valid(const SnapshotHeader *h, size_t length)
+{
+    if (length < HEADER_SIZE)
+        return false;
+
+    if (memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(h->magic)) ||
+        h->version != SNAPSHOT_VERSION || h->endian != SNAPSHOT_ENDIAN)
+        return false;
+
+    if (h->capacity == 0 || (h->capacity & (h->capacity - 1)) ||
+        h->count > h->capacity / 2)
+        return false;
+
+    if (h->index_offset != HEADER_SIZE ||
+        h->capacity > (length - HEADER_SIZE) / sizeof(IndexSlot))
+        return false;
+
+    if (h->data_offset != HEADER_SIZE + h->capacity * sizeof(IndexSlot) ||
+        h->data_size > length - h->data_offset)
+        return false;
+
+    if (h->count > 0 && h->data_size < sizeof(Record))
+        return false;
+
+    return true;
+}
+
+/**
+ * Opens a snapshot that was written by hashtable_save(). The file is mapped
+ * into memory read-only, and lookups read it in place, so opening is
+ * constant time no matter how large the snapshot is. The file may be
+ * closed or deleted afterwards, but it must not be modified while the
+ * snapshot is open.
+ *
+ * @param[in] path  path of the snapshot file
+ * @param[out] out  pointer to where the opened snapshot is stored
+ *
+ * @return CC_OK if the snapshot was opened, CC_ERR_IO if the file couldn't
+ * be opened or mapped, in which case errno describes the error,
+ * CC_ERR_INVALID_FORMAT if the file isn't a snapshot written on a machine
+ * with the same byte order, or CC_ERR_ALLOC if a memory allocation failed.
+ */
+enum cc_stat hashtable_open_mmap(const char *path, HashTableSnapshot **out)
+{
+    struct stat st;
+    int         fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+        return CC_ERR_IO;
+
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return CC_ERR_IO;
+    }
+
+    size_t length = (size_t) st.st_size;
+
+    if (length < HEADER_SIZE) {
+        close(fd);
+        return CC_ERR_INVALID_FORMAT;
+    }
+
+#if defined(_WIN32)
+    /* No mmap, read the whole file instead */
+    uint8_t *base = malloc(length);
+    size_t   done = 0;
+
+    while (base && done < length) {
+        int n = read(fd, base + done, (unsigned) (length - done));
+        if (n <= 0) {
+            free(base);
+            close(fd);
+            return CC_ERR_IO;
+        }
+        done += (size_t) n;
+    }
+    close(fd);
+
+    if (!base)
+        return CC_ERR_ALLOC;
+#else
+    void *map = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (map == MAP_FAILED)
+        return CC_ERR_IO;
+
+    const uint8_t *base = map;
+#endif
+
+    SnapshotHeader header;
+    memcpy(&header, base, sizeof(header));
+
+    HashTableSnapshot *snap = NULL;
+    enum cc_stat       stat = CC_ERR_INVALID_FORMAT;
+
+    if (header_valid(&header, length)) {
+        snap = malloc(sizeof(HashTableSnapshot));
+        stat = snap ? CC_OK : CC_ERR_ALLOC;
+    }
+
+    if (stat != CC_OK) {
+#if defined(_WIN32)
+        free(base);
+#else
+        munmap(map, length);
+#endif
+        return stat;
+    }
+
+    snap->base      = base;
+    snap->length    = length;
+    snap->index     = (const IndexSlot*) (base + header.index_offset);
+    snap->data      = base + header.data_offset;
+    snap->data_size = header.data_size;
+    snap->mask      = header.capacity - 1;
+    snap->count     = header.count;
+    snap->seed      = (uint32_t) header.seed;
+
+    *out = snap;
+    return CC_OK;
+}
+
+/**
+ * Unmaps the snapshot. Pointers returned by hashtable_snapshot_get() become
+ * invalid.
+ *
+ * @param[in] snap the snapshot that is being closed
+ */
+void hashtable_snapshot_close(HashTableSnapshot *snap)
+{
+#if defined(_WIN32)
+    free((void*) snap->base);
+#else
+    munmap((void*) snap->base, snap->length);
+#endif
+    free(snap);
+}
+
+/**
+ * Looks up the value of a serialized key. The value is returned as a pointer
+ * into the snapshot, aligned to 8 bytes, that stays valid until the snapshot
+ * is closed.
+ *
+ * @param[in] snap      the snapshot in which the key is looked up
+ * @param[in] key       the serialized key
+ * @param[in] key_size  size of the key in bytes
+ * @param[out] out      pointer to where the address of the value is stored,
+ *                      or NULL
+ * @param[out] out_size pointer to where the size of the value is stored,
+ *                      or NULL
+ *
+ * @return CC_OK if the key was found, CC_ERR_KEY_NOT_FOUND if not, or
+ * CC_ERR_INVALID_FORMAT if the record of the key is damaged.
+ */
+enum cc_stat hashtable_snapshot_get(HashTableSnapshot *snap, const void *key, size_t key_size,
+                                    const void **out, size_t *out_size)
+{
+    uint64_t hash = snapshot_hash(key, key_size, snap->seed);
+    uint64_t slot = hash & snap->mask;
+    uint64_t i;
+
+    /* A damaged index may have no empty slot, so give up after one
+     * pass over it. */
+    for (i = 0; i <= snap->mask; i++) {
+        const IndexSlot *s = &snap->index[slot];
+
+        if (s->offset == SLOT_EMPTY)
+            return CC_ERR_KEY_NOT_FOUND;
+
+        if (s->hash == hash) {
+            if (snap->data_size < sizeof(Record) ||
+                s->offset > snap->data_size - sizeof(Record))
+                return CC_ERR_INVALID_FORMAT;
+
+            Record rec;
+            memcpy(&rec, snap->data + s->offset, sizeof(rec));
+
+            uint64_t room = snap->data_size - s->offset - sizeof(Record);
+
+            if (rec.key_size > room || PAD8(rec.key_size) > room ||
+                rec.val_size > room - PAD8(rec.key_size))
+                return CC_ERR_INVALID_FORMAT;
+
+            const uint8_t *k = snap->data + s->offset + sizeof(Record);
+
+            if (rec.key_size == key_size && !memcmp(k, key, key_size)) {
+                if (out)
+                    *out = k + PAD8(rec.key_size);
+                if (out_size)
+                    *out_size = rec.val_size;
+                return CC_OK;
+            }
+        }
+        slot = (slot + 1) & snap->mask;
+    }
+    return CC_ERR_KEY_NOT_FOUND;
+}
+
+/**
+ * Returns the number of keys in the snapshot.
+ *
+ * @param[in] snap the snapshot whose size is being returned
+ *
+ * @return the number of keys in the snapshot.
+ */
+size_t hashtable_snapshot_size(HashTableSnapshot *snap)
+{
+    return snap->count;
+}
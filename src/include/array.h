@@ -50,8 +50,38 @@ typedef struct array_conf_s {
     void *(*mem_alloc)  (size_t size);
     void *(*mem_calloc) (size_t blocks, size_t size);
     void  (*mem_free)   (void *block);
+
+    /**
+     * Optional allocator that resizes blocks returned by mem_alloc, with
+     * the semantics of realloc(). If set, the buffer grows in place
+     * whenever the allocator can manage it. NULL by default. */
+    void *(*mem_realloc) (void *block, size_t size);
+
+    /**
+     * Buffers of at least this many bytes are mapped directly from the
+     * operating system, aligned to 2MB so that they can be backed by
+     * huge pages, and are grown with mremap() where it is available.
+     * Mapped buffers bypass the allocators above. 0 disables mapping,
+     * which is the default. Ignored on Windows. */
+    size_t mmap_threshold;
 } ArrayConf;
 
+/**
+ * Configuration of the parallel Array operations.
+ */
+typedef struct array_par_conf_s {
+    /**
+     * The number of threads an operation runs on, including the calling
+     * thread. Defaults to the number of online processors. */
+    size_t threads;
+
+    /**
+     * The smallest number of elements that is handed to a thread at a
+     * time. Arrays of fewer than two grains are processed on the calling
+     * thread. */
+    size_t grain;
+} ArrayParConf;
+
 /**
  * Array iterator structure. Used to iterate over the elements of
  * the array in an ascending order. The iterator also supports
@@ -121,6 +151,8 @@ size_t        array_capacity        (Array *ar);
 
 enum cc_stat  array_index_of        (Array *ar, void *element, size_t *index);
 void          array_sort            (Array *ar, int (*cmp) (const void*, const void*));
+enum cc_stat  array_sort_stable     (Array *ar, int (*cmp) (const void*, const void*));
+enum cc_stat  array_sort_by_key     (Array *ar, uint64_t (*key) (const void*));
 
 void          array_map             (Array *ar, void (*fn) (void*));
 void          array_reduce          (Array *ar, void (*fn) (void*, void*, void*), void *result);
@@ -128,6 +160,17 @@ void          array_reduce          (Array *ar, void (*fn) (void*, void*, void*)
 enum cc_stat  array_filter_mut      (Array *ar, bool (*predicate) (const void*));
 enum cc_stat  array_filter          (Array *ar, bool (*predicate) (const void*), Array **out);
 
+void          array_par_conf_init   (ArrayParConf *conf);
+void          array_par_map         (Array *ar, void (*fn) (void*), ArrayParConf const *conf);
+enum cc_stat  array_par_reduce      (Array *ar, void (*fn) (void *acc, void *e),
+                                     void (*combine) (void *acc, const void *part),
+                                     void *result, size_t result_size,
+                                     ArrayParConf const *conf);
+enum cc_stat  array_par_filter      (Array *ar, bool (*predicate) (const void*),
+                                     ArrayParConf const *conf, Array **out);
+enum cc_stat  array_par_sort        (Array *ar, int (*cmp) (const void*, const void*),
+                                     ArrayParConf const *conf);
+
 void          array_iter_init       (ArrayIter *iter, Array *ar);
 enum cc_stat  array_iter_next       (ArrayIter *iter, void **out);
 enum cc_stat  array_iter_remove     (ArrayIter *iter, void **out);
@@ -0,0 +1,125 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2015 Srđan Panić <srdja.panic@gmail.com>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COLLECTIONS_C_ARRAY_SIZED_H
+#define COLLECTIONS_C_ARRAY_SIZED_H
+
+#include "common.h"
+
+/**
+ * A dynamic array that stores its elements by value in a single
+ * contiguous buffer. All elements have the same size, which is set when
+ * the array is created. Elements are copied into and out of the array,
+ * so an array of small structs needs a single allocation instead of one
+ * per element, and walking it doesn't chase pointers.
+ */
+typedef struct array_sized_s ArraySized;
+
+/**
+ * ArraySized configuration structure. Used to initialize a new
+ * ArraySized with specific values.
+ */
+typedef struct array_sized_conf_s {
+    /**
+     * The initial capacity of the array in elements */
+    size_t capacity;
+
+    /**
+     * The rate at which the buffer expands (capacity * exp_factor). */
+    float  exp_factor;
+
+    /**
+     * The size of an element in bytes. Must be set, there is no
+     * default. */
+    size_t elem_size;
+
+    /**
+     * Memory allocators used to allocate the ArraySized structure and
+     * the underlying data buffers. */
+    void *(*mem_alloc)  (size_t size);
+    void *(*mem_calloc) (size_t blocks, size_t size);
+    void  (*mem_free)   (void *block);
+} ArraySizedConf;
+
+/**
+ * ArraySized iterator structure. Used to iterate over the elements of
+ * the array in an ascending order. The iterator also supports
+ * operations for safely removing and replacing elements during
+ * iteration.
+ */
+typedef struct array_sized_iter_s {
+    /**
+     * The array associated with this iterator */
+    ArraySized *ar;
+
+    /**
+     * The current position of the iterator.*/
+    size_t      index;
+
+    /**
+     * Set to true if the last returned element was removed. */
+    bool        last_removed;
+} ArraySizedIter;
+
+
+enum cc_stat  array_sized_new           (size_t elem_size, ArraySized **out);
+enum cc_stat  array_sized_new_conf      (ArraySizedConf const * const conf, ArraySized **out);
+void          array_sized_conf_init     (ArraySizedConf *conf);
+
+void          array_sized_destroy       (ArraySized *ar);
+
+enum cc_stat  array_sized_add           (ArraySized *ar, const void *element);
+enum cc_stat  array_sized_add_at        (ArraySized *ar, const void *element, size_t index);
+enum cc_stat  array_sized_replace_at    (ArraySized *ar, const void *element, size_t index, void *out);
+enum cc_stat  array_sized_swap_at       (ArraySized *ar, size_t index1, size_t index2);
+
+enum cc_stat  array_sized_remove_at     (ArraySized *ar, size_t index, void *out);
+enum cc_stat  array_sized_remove_last   (ArraySized *ar, void *out);
+void          array_sized_remove_all    (ArraySized *ar);
+
+enum cc_stat  array_sized_get_at        (ArraySized *ar, size_t index, void *out);
+enum cc_stat  array_sized_get_ptr_at    (ArraySized *ar, size_t index, void **out);
+enum cc_stat  array_sized_get_last      (ArraySized *ar, void *out);
+
+enum cc_stat  array_sized_reserve       (ArraySized *ar, size_t n);
+enum cc_stat  array_sized_trim_capacity (ArraySized *ar);
+
+size_t        array_sized_size          (ArraySized *ar);
+size_t        array_sized_capacity      (ArraySized *ar);
+size_t        array_sized_elem_size     (ArraySized *ar);
+
+enum cc_stat  array_sized_index_of      (ArraySized *ar, const void *element, size_t *index);
+void          array_sized_sort          (ArraySized *ar, int (*cmp) (const void*, const void*));
+
+void          array_sized_map           (ArraySized *ar, void (*fn) (void*));
+void          array_sized_reduce        (ArraySized *ar, void (*fn) (const void*, const void*, void*),
+                                         void *result);
+enum cc_stat  array_sized_filter_mut    (ArraySized *ar, bool (*predicate) (const void*));
+
+void          array_sized_iter_init     (ArraySizedIter *iter, ArraySized *ar);
+enum cc_stat  array_sized_iter_next     (ArraySizedIter *iter, void *out);
+enum cc_stat  array_sized_iter_next_ptr (ArraySizedIter *iter, void **out);
+enum cc_stat  array_sized_iter_remove   (ArraySizedIter *iter, void *out);
+enum cc_stat  array_sized_iter_replace  (ArraySizedIter *iter, const void *element, void *out);
+size_t        array_sized_iter_index    (ArraySizedIter *iter);
+
+void*         array_sized_get_buffer    (ArraySized *ar);
+
+#endif /* COLLECTIONS_C_ARRAY_SIZED_H */
@@ -45,6 +45,9 @@ enum cc_stat {
     CC_ERR_OUT_OF_RANGE     = 8,
 
     CC_ITER_END             = 9,
+
+    CC_ERR_IO               = 10,
+    CC_ERR_INVALID_FORMAT   = 11,
 };
 
 #define CC_MAX_ELEMENTS ((size_t) - 2)
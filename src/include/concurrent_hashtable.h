@@ -0,0 +1,130 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2015 Srđan Panić <srdja.panic@gmail.com>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COLLECTIONS_C_CONCURRENT_HASHTABLE_H
+#define COLLECTIONS_C_CONCURRENT_HASHTABLE_H
+
+#include "common.h"
+#include "hashtable.h"
+
+/**
+ * A thread safe, unordered key-value map. ConcurrentHashTable uses the same
+ * separate chaining design as chained HashTables, but its buckets are split
+ * into lock stripes. Every operation only locks the stripe of its key, so
+ * threads that work on different stripes don't contend with each other.
+ *
+ * When the table grows, threads that access the table while the resize is
+ * in progress help move the stripes to the new bucket array.
+ *
+ * Tables created with lock_free_reads look keys up without taking locks.
+ * Entries and bucket arrays that lookups may still be reading are freed
+ * once every lookup that started before their removal has finished.
+ *
+ * @note The memory allocators that the table is configured with must be
+ * thread safe.
+ */
+typedef struct concurrent_hashtable_s ConcurrentHashTable;
+
+/**
+ * ConcurrentHashTable configuration object.
+ */
+typedef struct concurrent_hashtable_conf_s {
+    /**
+     * The load factor at which the table grows. */
+    float    load_factor;
+
+    /**
+     * The initial capacity of the bucket array. Never lower than the
+     * number of stripes. */
+    size_t   initial_capacity;
+
+    /**
+     * The number of lock stripes, rounded up to a power of two. Stripe i
+     * guards the buckets whose index is i modulo the number of stripes.
+     * More stripes reduce contention at the cost of some memory. */
+    size_t   stripes;
+
+    /**
+     * If set, concurrent_hashtable_get() and contains_key() don't lock the
+     * stripe and don't write to memory shared with other threads, so reads
+     * scale with the number of threads. In exchange, removals free their
+     * entries in batches after a grace period, and a resize copies the
+     * entries instead of relinking them. Suited to tables that are mostly
+     * read. Readers only keep to memory of their own while at most 64
+     * reading threads are alive at once; any beyond that share counters
+     * with the others, which is correct but slower. */
+    bool     lock_free_reads;
+
+    /**
+     * If set, hash_seed is ignored and the table is seeded from the
+     * operating system's random number generator instead. */
+    bool     random_seed;
+
+    /**
+     * Length of the key or -1 if the key length is
+     * variable */
+    int      key_length;
+
+    /**
+     * The hash seed passed to the hash function */
+    uint32_t hash_seed;
+
+    /**
+     * Hash function used for hashing table keys */
+    size_t (*hash)        (const void *key, int l, uint32_t seed);
+
+    /**
+     * The key comparator function */
+    int    (*key_compare) (const void *key1, const void *key2);
+
+    /**
+     * Memory allocators used to allocate the ConcurrentHashTable structure
+     * and for all internal memory allocations. */
+    void  *(*mem_alloc)   (size_t size);
+    void  *(*mem_calloc)  (size_t blocks, size_t size);
+    void   (*mem_free)    (void *block);
+} ConcurrentHashTableConf;
+
+
+void          concurrent_hashtable_conf_init    (ConcurrentHashTableConf *conf);
+enum cc_stat  concurrent_hashtable_new          (ConcurrentHashTable **out);
+enum cc_stat  concurrent_hashtable_new_conf     (ConcurrentHashTableConf const * const conf,
+                                                 ConcurrentHashTable **out);
+
+void          concurrent_hashtable_destroy      (ConcurrentHashTable *table);
+enum cc_stat  concurrent_hashtable_add          (ConcurrentHashTable *table, void *key, void *val);
+enum cc_stat  concurrent_hashtable_get          (ConcurrentHashTable *table, void *key, void **out);
+enum cc_stat  concurrent_hashtable_upsert       (ConcurrentHashTable *table, void *key,
+                                                 void *(*fn) (void *value, bool exists, void *ctx),
+                                                 void *ctx);
+enum cc_stat  concurrent_hashtable_remove       (ConcurrentHashTable *table, void *key, void **out);
+void          concurrent_hashtable_remove_all   (ConcurrentHashTable *table);
+bool          concurrent_hashtable_contains_key (ConcurrentHashTable *table, void *key);
+
+size_t        concurrent_hashtable_size         (ConcurrentHashTable *table);
+size_t        concurrent_hashtable_capacity     (ConcurrentHashTable *table);
+size_t        concurrent_hashtable_stripes      (ConcurrentHashTable *table);
+
+void          concurrent_hashtable_foreach_key  (ConcurrentHashTable *table,
+                                                 void (*fn) (const void *key));
+void          concurrent_hashtable_foreach_value(ConcurrentHashTable *table,
+                                                 void (*fn) (void *val));
+
+#endif /* COLLECTIONS_C_CONCURRENT_HASHTABLE_H */
@@ -46,6 +46,12 @@ typedef struct deque_conf_s {
     void *(*mem_alloc)  (size_t size);
     void *(*mem_calloc) (size_t blocks, size_t size);
     void  (*mem_free)   (void *block);
+
+    /**
+     * Optional allocator that resizes blocks returned by mem_alloc, with
+     * the semantics of realloc(). If set, the buffer grows in place
+     * whenever the allocator can manage it. NULL by default. */
+    void *(*mem_realloc) (void *block, size_t size);
 } DequeConf;
 
 /**
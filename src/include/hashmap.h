@@ -0,0 +1,554 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2015 Srđan Panić <srdja.panic@gmail.com>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COLLECTIONS_C_HASHMAP_H
+#define COLLECTIONS_C_HASHMAP_H
+
+#include "common.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CC_HASHMAP_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/*
+ * Statically typed hash maps with inlined hashing and key comparison.
+ *
+ *     static INLINE bool u64_eq(uint64_t a, uint64_t b) { return a == b; }
+ *
+ *     CC_HASHMAP_DEFINE(U64Map, uint64_t, double, cc_hashmap_hash_u64, u64_eq)
+ *
+ * defines the types U64Map, U64MapEntry and U64MapIter, and the functions
+ * U64Map_new(), U64Map_add(), U64Map_get() and so on. Their semantics match
+ * the corresponding hashtable_* functions, except that keys and values are
+ * stored by value. hash_fn and eq_fn may be functions or macros:
+ *
+ *     size_t hash_fn (KeyT key);
+ *     bool   eq_fn   (KeyT a, KeyT b);
+ *
+ * The maps use the same storage as HASHTABLE_OPEN_ADDRESSING tables: a flat
+ * array of entries with a 1-byte control word per entry, probed 16 entries
+ * at a time. The low 7 bits of the hash are stored in the control word and
+ * the remaining bits select the group where probing starts, so the hash
+ * function must mix its input into all bits. Unlike HashTable, the map
+ * doesn't store hashes, so entries are hashed again when the map grows.
+ *
+ * All functions are static and inline, so a map type can be defined in any
+ * number of translation units.
+ */
+
+#define CC_HASHMAP_GROUP_WIDTH      16
+#define CC_HASHMAP_EMPTY            ((uint8_t) 0x80)
+#define CC_HASHMAP_DELETED          ((uint8_t) 0xFE)
+#define CC_HASHMAP_H2(hash)         ((uint8_t) ((hash) & 0x7F))
+#define CC_HASHMAP_NONE             ((size_t) -1)
+#define CC_HASHMAP_MAX_LOAD_FACTOR  0.875f
+
+/**
+ * Configuration object of the maps defined with CC_HASHMAP_DEFINE.
+ */
+typedef struct hashmap_conf_s {
+    /**
+     * The load factor at which the map grows. Capped at 0.875. */
+    float    load_factor;
+
+    /**
+     * The initial capacity of the map. Rounded up to a power of two, and
+     * to at least 16. */
+    size_t   initial_capacity;
+
+    /**
+     * Memory allocators used to allocate the map structure and all of its
+     * internal memory. */
+    void  *(*mem_alloc)   (size_t size);
+    void  *(*mem_calloc)  (size_t blocks, size_t size);
+    void   (*mem_free)    (void *block);
+} HashMapConf;
+
+/**
+ * Initializes the fields of the HashMapConf struct to default values.
+ *
+ * @param[in, out] conf the configuration struct that is being initialized
+ */
+static INLINE void hashmap_conf_init(HashMapConf *conf)
+{
+    conf->load_factor      = 0.75f;
+    conf->initial_capacity = 16;
+    conf->mem_alloc        = malloc;
+    conf->mem_calloc       = calloc;
+    conf->mem_free         = free;
+}
+
+/**
+ * A hash function for 64-bit integer keys (the finalizer of MurmurHash3).
+ */
+static INLINE size_t cc_hashmap_hash_u64(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return (size_t) key;
+}
+
+/**
+ * A hash function for 32-bit integer keys.
+ */
+static INLINE size_t cc_hashmap_hash_u32(uint32_t key)
+{
+    return cc_hashmap_hash_u64(key);
+}
+
+#if defined(_MSC_VER)
+
+static INLINE unsigned cc_hashmap_ctz(uint32_t x)
+{
+    unsigned long i;
+    _BitScanForward(&i, x);
+    return (unsigned) i;
+}
+
+#else
+
+#define cc_hashmap_ctz(x) ((unsigned) __builtin_ctz(x))
+
+#endif /* _MSC_VER */
+
+/**
+ * Returns a bitmask of the control bytes in the group that are equal to c.
+ */
+static INLINE uint32_t cc_hashmap_match(const uint8_t *ctrl, uint8_t c)
+{
+#ifdef CC_HASHMAP_SSE2
+    __m128i group = _mm_loadu_si128((const __m128i*) ctrl);
+    __m128i match = _mm_cmpeq_epi8(_mm_set1_epi8((char) c), group);
+    return (uint32_t) _mm_movemask_epi8(match);
+#else
+    uint32_t mask = 0;
+    int i;
+    for (i = 0; i < CC_HASHMAP_GROUP_WIDTH; i++)
+        mask |= (uint32_t) (ctrl[i] == c) << i;
+    return mask;
+#endif
+}
+
+/**
+ * Returns a bitmask of the empty and deleted slots in the group.
+ */
+static INLINE uint32_t cc_hashmap_match_free(const uint8_t *ctrl)
+{
+#ifdef CC_HASHMAP_SSE2
+    return (uint32_t) _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) ctrl));
+#else
+    uint32_t mask = 0;
+    int i;
+    for (i = 0; i < CC_HASHMAP_GROUP_WIDTH; i++)
+        mask |= (uint32_t) (ctrl[i] >> 7) << i;
+    return mask;
+#endif
+}
+
+/**
+ * Returns the smallest power of two capacity of at least 16 at which a map
+ * with the given load factor holds n entries.
+ */
+static INLINE size_t cc_hashmap_capacity_for(size_t n, float load_factor)
+{
+    size_t capacity = CC_HASHMAP_GROUP_WIDTH;
+
+    while (capacity < MAX_POW_TWO && (size_t) (capacity * load_factor) < n)
+        capacity <<= 1;
+
+    return capacity;
+}
+
+/**
+ * Defines a map type called name, that maps keys of type KeyT to values of
+ * type ValT, together with its entry type name##Entry, its iterator type
+ * name##Iter, and the following functions:
+ *
+ *     enum cc_stat name##_new           (name **out);
+ *     enum cc_stat name##_new_conf      (HashMapConf const * const conf, name **out);
+ *     void         name##_destroy       (name *map);
+ *     enum cc_stat name##_add           (name *map, KeyT key, ValT val);
+ *     enum cc_stat name##_get           (name *map, KeyT key, ValT *out);
+ *     enum cc_stat name##_get_or_add    (name *map, KeyT key, ValT default_val,
+ *                                        ValT **out_slot, bool *inserted);
+ *     enum cc_stat name##_remove        (name *map, KeyT key, ValT *out);
+ *     void         name##_remove_all    (name *map);
+ *     bool         name##_contains_key  (name *map, KeyT key);
+ *     size_t       name##_size          (name *map);
+ *     size_t       name##_capacity      (name *map);
+ *     enum cc_stat name##_reserve       (name *map, size_t n);
+ *     void         name##_iter_init     (name##Iter *iter, name *map);
+ *     enum cc_stat name##_iter_next     (name##Iter *iter, name##Entry **out);
+ *     enum cc_stat name##_iter_remove   (name##Iter *iter, ValT *out);
+ *
+ * The out parameters of get, remove and iter_remove may be NULL.
+ */
+#define CC_HASHMAP_DEFINE(name, KeyT, ValT, hash_fn, eq_fn)                   \
+                                                                              \
+typedef struct name##_entry_s {                                               \
+    KeyT key;                                                                 \
+    ValT value;                                                               \
+} name##Entry;                                                                \
+                                                                              \
+typedef struct name##_s {                                                     \
+    size_t       capacity;                                                    \
+    size_t       size;                                                        \
+    size_t       deleted;                                                     \
+    size_t       threshold;                                                   \
+    float        load_factor;                                                 \
+    uint8_t     *ctrl;                                                        \
+    name##Entry *slots;                                                       \
+    void *(*mem_alloc)  (size_t size);                                        \
+    void *(*mem_calloc) (size_t blocks, size_t size);                         \
+    void  (*mem_free)   (void *block);                                        \
+} name;                                                                       \
+                                                                              \
+typedef struct name##_iter_s {                                                \
+    name  *map;                                                               \
+    size_t next;                                                              \
+    size_t last;                                                              \
+} name##Iter;                                                                 \
+                                                                              \
+static INLINE enum cc_stat name##_hm_alloc(name *map, size_t capacity)        \
+{                                                                             \
+    uint8_t     *ctrl  = map->mem_alloc(capacity);                            \
+    name##Entry *slots = map->mem_alloc(capacity * sizeof(name##Entry));      \
+                                                                              \
+    if (!ctrl || !slots) {                                                    \
+        map->mem_free(ctrl);                                                  \
+        map->mem_free(slots);                                                 \
+        return CC_ERR_ALLOC;                                                  \
+    }                                                                         \
+    memset(ctrl, CC_HASHMAP_EMPTY, capacity);                                 \
+                                                                              \
+    map->ctrl      = ctrl;                                                    \
+    map->slots     = slots;                                                   \
+    map->capacity  = capacity;                                                \
+    map->deleted   = 0;                                                       \
+    map->threshold = capacity * map->load_factor;                             \
+                                                                              \
+    if (map->threshold == 0)                                                  \
+        map->threshold = 1;                                                   \
+                                                                              \
+    return CC_OK;                                                             \
+}                                                                             \
+                                                                              \
+static INLINE enum cc_stat name##_new_conf(HashMapConf const * const conf,    \
+                                           name **out)                        \
+{                                                                             \
+    name *map = conf->mem_calloc(1, sizeof(name));                            \
+                                                                              \
+    if (!map)                                                                 \
+        return CC_ERR_ALLOC;                                                  \
+                                                                              \
+    map->load_factor = conf->load_factor;                                     \
+    map->mem_alloc   = conf->mem_alloc;                                       \
+    map->mem_calloc  = conf->mem_calloc;                                      \
+    map->mem_free    = conf->mem_free;                                        \
+                                                                              \
+    if (map->load_factor > CC_HASHMAP_MAX_LOAD_FACTOR)                        \
+        map->load_factor = CC_HASHMAP_MAX_LOAD_FACTOR;                        \
+                                                                              \
+    if (name##_hm_alloc(map, cc_hashmap_capacity_for(conf->initial_capacity,  \
+                                                     1.0f)) != CC_OK) {       \
+        conf->mem_free(map);                                                  \
+        return CC_ERR_ALLOC;                                                  \
+    }                                                                         \
+    *out = map;                                                               \
+    return CC_OK;                                                             \
+}                                                                             \
+                                                                              \
+static INLINE enum cc_stat name##_new(name **out)                             \
+{                                                                             \
+    HashMapConf conf;                                                         \
+    hashmap_conf_init(&conf);                                                 \
+    return name##_new_conf(&conf, out);                                       \
+}                                                                             \
+                                                                              \
+static INLINE void name##_destroy(name *map)                                  \
+{                                                                             \
+    map->mem_free(map->ctrl);                                                 \
+    map->mem_free(map->slots);                                                \
+    map->mem_free(map);                                                       \
+}                                                                             \
+                                                                              \
+static INLINE size_t name##_hm_find(name *map, KeyT key, size_t hash)         \
+{                                                                             \
+    const size_t  mask  = map->capacity / CC_HASHMAP_GROUP_WIDTH - 1;         \
+    const uint8_t h2    = CC_HASHMAP_H2(hash);                                \
+    size_t        group = (hash >> 7) & mask;                                 \
+    size_t        step  = 0;                                                  \
+                                                                              \
+    for (;;) {                                                                \
+        const uint8_t *ctrl  = map->ctrl + group * CC_HASHMAP_GROUP_WIDTH;    \
+        uint32_t       match = cc_hashmap_match(ctrl, h2);                    \
+                                                                              \
+        while (match) {                                                       \
+            size_t slot = group * CC_HASHMAP_GROUP_WIDTH +                  \
+                          cc_hashmap_ctz(match);                              \
+                                                                              \
+            if (eq_fn(map->slots[slot].key, key))                             \
+                return slot;                                                  \
+                                                                              \
+            match &= match - 1;                                               \
+        }                                                                     \
+        if (cc_hashmap_match(ctrl, CC_HASHMAP_EMPTY))                         \
+            return CC_HASHMAP_NONE;                                           \
+                                                                              \
+        group = (group + ++step) & mask;                                      \
+    }                                                                         \
+}                                                                             \
+                                                                              \
+static INLINE size_t name##_hm_find_free(name *map, size_t hash)              \
+{                                                                             \
+    const size_t mask  = map->capacity / CC_HASHMAP_GROUP_WIDTH - 1;          \
+    size_t       group = (hash >> 7) & mask;                                  \
+    size_t       step  = 0;                                                   \
+                                                                              \
+    for (;;) {                                                                \
+        uint32_t avail = cc_hashmap_match_free(map->ctrl +                    \
+                                              group * CC_HASHMAP_GROUP_WIDTH); \
+        if (avail)                                                            \
+            return group * CC_HASHMAP_GROUP_WIDTH + cc_hashmap_ctz(avail);    \
+                                                                              \
+        group = (group + ++step) & mask;                                      \
+    }                                                                         \
+}                                                                             \
+                                                                              \
+static INLINE enum cc_stat name##_hm_resize(name *map, size_t capacity)       \
+{                                                                             \
+    uint8_t     *old_ctrl  = map->ctrl;                                       \
+    name##Entry *old_slots = map->slots;                                      \
+    size_t       old_cap   = map->capacity;                                   \
+    size_t       i;                                                           \
+                                                                              \
+    if (name##_hm_alloc(map, capacity) != CC_OK)                              \
+        return CC_ERR_ALLOC;                                                  \
+                                                                              \
+    for (i = 0; i < old_cap; i++) {                                           \
+        if (old_ctrl[i] & CC_HASHMAP_EMPTY)                                   \
+            continue;                                                         \
+                                                                              \
+        size_t hash = hash_fn(old_slots[i].key);                              \
+        size_t slot = name##_hm_find_free(map, hash);                         \
+                                                                              \
+        map->ctrl[slot]  = CC_HASHMAP_H2(hash);                               \
+        map->slots[slot] = old_slots[i];                                      \
+    }                                                                         \
+    map->mem_free(old_ctrl);                                                  \
+    map->mem_free(old_slots);                                                 \
+                                                                              \
+    return CC_OK;                                                             \
+}                                                                             \
+                                                                              \
+static INLINE enum cc_stat name##_get_or_add(name *map, KeyT key,             \
+                                             ValT default_val,                \
+                                             ValT **out_slot, bool *inserted) \
+{                                                                             \
+    const size_t hash = hash_fn(key);                                         \
+    size_t       slot = name##_hm_find(map, key, hash);                       \
+                                                                              \
+    if (slot != CC_HASHMAP_NONE) {                                            \
+        if (out_slot)                                                         \
+            *out_slot = &map->slots[slot].value;                              \
+        if (inserted)                                                         \
+            *inserted = false;                                                \
+        return CC_OK;                                                         \
+    }                                                                         \
+                                                                              \
+    slot = name##_hm_find_free(map, hash);                                    \
+                                                                              \
+    if (map->ctrl[slot] == CC_HASHMAP_EMPTY &&                                \
+        map->size + map->deleted >= map->threshold) {                         \
+        size_t capacity = map->capacity;                                      \
+                                                                              \
+        if (map->size >= map->deleted) {                                      \
+            if (capacity == MAX_POW_TWO)                                      \
+                return CC_ERR_MAX_CAPACITY;                                   \
+            capacity <<= 1;                                                   \
+        }                                                                     \
+        if (name##_hm_resize(map, capacity) != CC_OK)                         \
+            return CC_ERR_ALLOC;                                              \
+                                                                              \
+        slot = name##_hm_find_free(map, hash);                                \
+    }                                                                         \
+                                                                              \
+    if (map->ctrl[slot] == CC_HASHMAP_DELETED)                                \
+        map->deleted--;                                                       \
+                                                                              \
+    map->ctrl[slot]        = CC_HASHMAP_H2(hash);                             \
+    map->slots[slot].key   = key;                                             \
+    map->slots[slot].value = default_val;                                     \
+    map->size++;                                                              \
+                                                                              \
+    if (out_slot)                                                             \
+        *out_slot = &map->slots[slot].value;                                  \
+    if (inserted)                                                             \
+        *inserted = true;                                                     \
+    return CC_OK;                                                             \
+}                                                                             \
+                                                                              \
+static INLINE enum cc_stat name##_add(name *map, KeyT key, ValT val)          \
+{                                                                             \
+    ValT *slot;                                                               \
+    enum cc_stat stat = name##_get_or_add(map, key, val, &slot, NULL);        \
+                                                                              \
+    if (stat == CC_OK)                                                        \
+        *slot = val;                                                          \
+                                                                              \
+    return stat;                                                              \
+}                                                                             \
+                                                                              \
+static INLINE enum cc_stat name##_get(name *map, KeyT key, ValT *out)         \
+{                                                                             \
+    size_t slot = name##_hm_find(map, key, hash_fn(key));                     \
+                                                                              \
+    if (slot == CC_HASHMAP_NONE)                                              \
+        return CC_ERR_KEY_NOT_FOUND;                                          \
+                                                                              \
+    if (out)                                                                  \
+        *out = map->slots[slot].value;                                        \
+    return CC_OK;                                                             \
+}                                                                             \
+                                                                              \
+static INLINE bool name##_contains_key(name *map, KeyT key)                   \
+{                                                                             \
+    return name##_hm_find(map, key, hash_fn(key)) != CC_HASHMAP_NONE;         \
+}                                                                             \
+                                                                              \
+static INLINE void name##_hm_remove_at(name *map, size_t slot)                \
+{                                                                             \
+    const uint8_t *group = map->ctrl +                                        \
+        (slot & ~((size_t) CC_HASHMAP_GROUP_WIDTH - 1));                      \
+                                                                              \
+    if (cc_hashmap_match(group, CC_HASHMAP_EMPTY)) {                          \
+        map->ctrl[slot] = CC_HASHMAP_EMPTY;                                   \
+    } else {                                                                  \
+        map->ctrl[slot] = CC_HASHMAP_DELETED;                                 \
+        map->deleted++;                                                       \
+    }                                                                         \
+    map->size--;                                                              \
+}                                                                             \
+                                                                              \
+static INLINE enum cc_stat name##_remove(name *map, KeyT key, ValT *out)      \
+{                                                                             \
+    size_t slot = name##_hm_find(map, key, hash_fn(key));                     \
+                                                                              \
+    if (slot == CC_HASHMAP_NONE)                                              \
+        return CC_ERR_KEY_NOT_FOUND;                                          \
+                                                                              \
+    if (out)                                                                  \
+        *out = map->slots[slot].value;                                        \
+                                                                              \
+    name##_hm_remove_at(map, slot);                                           \
+    return CC_OK;                                                             \
+}                                                                             \
+                                                                              \
+static INLINE void name##_remove_all(name *map)                               \
+{                                                                             \
+    memset(map->ctrl, CC_HASHMAP_EMPTY, map->capacity);                       \
+    map->size    = 0;                                                         \
+    map->deleted = 0;                                                         \
+}                                                                             \
+                                                                              \
+static INLINE size_t name##_size(name *map)                                   \
+{                                                                             \
+    return map->size;                                                         \
+}                                                                             \
+                                                                              \
+static INLINE size_t name##_capacity(name *map)                               \
+{                                                                             \
+    return map->capacity;                                                     \
+}                                                                             \
+                                                                              \
+static INLINE enum cc_stat name##_reserve(name *map, size_t n)                \
+{                                                                             \
+    size_t capacity = cc_hashmap_capacity_for(n, map->load_factor);           \
+                                                                              \
+    if ((size_t) (capacity * map->load_factor) < n)                           \
+        return CC_ERR_MAX_CAPACITY;                                           \
+                                                                              \
+    if (n + map->deleted <= map->threshold)                                   \
+        return CC_OK;                                                         \
+                                                                              \
+    if (capacity < map->capacity)                                             \
+        capacity = map->capacity;                                             \
+                                                                              \
+    return name##_hm_resize(map, capacity);                                   \
+}                                                                             \
+                                                                              \
+static INLINE size_t name##_hm_next_full(name *map, size_t slot)              \
+{                                                                             \
+    while (slot < map->capacity) {                                            \
+        size_t   base = slot & ~((size_t) CC_HASHMAP_GROUP_WIDTH - 1);        \
+        uint32_t full = ~cc_hashmap_match_free(map->ctrl + base) & 0xFFFF;    \
+                                                                              \
+        full &= (uint32_t) 0xFFFF << (slot - base);                           \
+                                                                              \
+        if (full)                                                             \
+            return base + cc_hashmap_ctz(full);                               \
+                                                                              \
+        slot = base + CC_HASHMAP_GROUP_WIDTH;                                 \
+    }                                                                         \
+    return CC_HASHMAP_NONE;                                                   \
+}                                                                             \
+                                                                              \
+static INLINE void name##_iter_init(name##Iter *iter, name *map)              \
+{                                                                             \
+    iter->map  = map;                                                         \
+    iter->next = name##_hm_next_full(map, 0);                                 \
+    iter->last = CC_HASHMAP_NONE;                                             \
+}                                                                             \
+                                                                              \
+static INLINE enum cc_stat name##_iter_next(name##Iter *iter,                 \
+                                            name##Entry **out)                \
+{                                                                             \
+    if (iter->next == CC_HASHMAP_NONE)                                        \
+        return CC_ITER_END;                                                   \
+                                                                              \
+    iter->last = iter->next;                                                  \
+    iter->next = name##_hm_next_full(iter->map, iter->next + 1);              \
+                                                                              \
+    *out = &iter->map->slots[iter->last];                                     \
+    return CC_OK;                                                             \
+}                                                                             \
+                                                                              \
+static INLINE enum cc_stat name##_iter_remove(name##Iter *iter, ValT *out)    \
+{                                                                             \
+    if (iter->last == CC_HASHMAP_NONE)                                        \
+        return CC_ERR_KEY_NOT_FOUND;                                          \
+                                                                              \
+    if (out)                                                                  \
+        *out = iter->map->slots[iter->last].value;                            \
+                                                                              \
+    name##_hm_remove_at(iter->map, iter->last);                               \
+    iter->last = CC_HASHMAP_NONE;                                             \
+    return CC_OK;                                                             \
+}
+
+#endif /* COLLECTIONS_C_HASHMAP_H */
@@ -27,12 +27,17 @@
 /**
  * An unordered set. The lookup, deletion, and insertion are
  * performed in amortized constant time and in the worst case
- * in amortized linear time.
+ * in amortized linear time. The elements are stored in an open
+ * addressing table that holds only the element pointers.
  */
 typedef struct hashset_s HashSet;
 
 /**
- * HashSet configuration object.
+ * HashSet configuration object. The backend, resize_step,
+ * max_chain_length and cache_key_length fields don't apply to sets
+ * and are ignored. The load factor is capped at 0.875. Like a table,
+ * the set shrinks on hashset_remove() and hashset_remove_all() once its
+ * load drops below min_load_factor, but never on hashset_iter_remove().
  */
 typedef HashTableConf HashSetConf;
 
@@ -42,7 +47,13 @@ typedef HashTableConf HashSetConf;
  * removing elements during iteration.
  */
 typedef struct hashset_iter_s {
-    HashTableIter iter;
+    HashSet *set;
+
+    /**
+     * Slot of the next element, and of the element that was returned
+     * last. */
+    size_t   next;
+    size_t   last;
 } HashSetIter;
 
 void          hashset_conf_init     (HashSetConf *conf);
@@ -52,12 +63,24 @@ enum cc_stat  hashset_new_conf      (HashSetConf const * const conf, HashSet **h
 void          hashset_destroy       (HashSet *set);
 
 enum cc_stat  hashset_add           (HashSet *set, void *element);
+enum cc_stat  hashset_add_all_from_array(HashSet *set, void **elements, size_t n);
 enum cc_stat  hashset_remove        (HashSet *set, void *element, void **out);
 void          hashset_remove_all    (HashSet *set);
 
 bool          hashset_contains      (HashSet *set, void *element);
+bool          hashset_contains_batch(HashSet *set, void **elements, size_t n, bool *out);
+
+enum cc_stat  hashset_union         (HashSet *a, HashSet *b, HashSet **out);
+enum cc_stat  hashset_intersection  (HashSet *a, HashSet *b, HashSet **out);
+enum cc_stat  hashset_difference    (HashSet *a, HashSet *b, HashSet **out);
+enum cc_stat  hashset_union_mut     (HashSet *a, HashSet *b);
+enum cc_stat  hashset_intersection_mut(HashSet *a, HashSet *b);
+enum cc_stat  hashset_difference_mut(HashSet *a, HashSet *b);
+
 size_t        hashset_size          (HashSet *set);
 size_t        hashset_capacity      (HashSet *set);
+enum cc_stat  hashset_reserve       (HashSet *set, size_t n);
+enum cc_stat  hashset_shrink_to_fit (HashSet *set);
 
 void          hashset_foreach       (HashSet *set, void (*op) (const void*));
 
@@ -36,6 +36,28 @@
  */
 typedef struct hashtable_s HashTable;
 
+/**
+ * A read-only view of a HashTable snapshot that was written with
+ * hashtable_save(). Keys and values are byte strings.
+ */
+typedef struct hashtable_snapshot_s HashTableSnapshot;
+
+/**
+ * HashTable storage backends.
+ */
+enum cc_hashtable_backend {
+    /**
+     * Every bucket holds a linked list of separately allocated
+     * entries. */
+    HASHTABLE_CHAINED         = 0,
+
+    /**
+     * Entries are stored inline in a flat slot array. Each slot has a
+     * 1-byte control word holding a fingerprint of the entry's hash, and
+     * lookups probe the control words 16 slots at a time. */
+    HASHTABLE_OPEN_ADDRESSING = 1,
+};
+
 /**
  * A HashTable table entry.
  *
@@ -68,6 +90,10 @@ typedef struct table_entry_s {
  */
 typedef struct hashtable_iter {
     HashTable  *table;
+
+    /**
+     * Current bucket, or the current slot if the table uses open
+     * addressing. */
     size_t      bucket_index;
     TableEntry *prev_entry;
     TableEntry *next_entry;
@@ -85,6 +111,46 @@ typedef struct hashtable_conf_s {
      * be triggered once the 50th entry is added. */
     float    load_factor;
 
+    /**
+     * Once removals drop the load of the table below this, the table
+     * shrinks to about half of the load factor. Values above a quarter of
+     * load_factor are lowered to that, so that a shrink can't be directly
+     * followed by a grow. The table never shrinks below its initial
+     * capacity. hashtable_iter_remove() never shrinks the table, so
+     * that the iterator stays valid. 0 disables shrinking. */
+    float    min_load_factor;
+
+    /**
+     * The storage backend. Open addressing tables cap the load factor
+     * at 0.875. */
+    enum cc_hashtable_backend backend;
+
+    /**
+     * The number of buckets that are moved to the new bucket array
+     * per add or remove while the table is resizing. If set to 0
+     * the whole table is rehashed at once. The step is raised when it
+     * is too small for a resize to finish before the table needs to grow
+     * again. Only applies to chained tables. */
+    size_t   resize_step;
+
+    /**
+     * If set, hash_seed is ignored and every table is seeded from the
+     * operating system's random number generator instead. */
+    bool     random_seed;
+
+    /**
+     * Once adding a key makes a chain longer than this, the table
+     * picks a new random seed and rehashes all keys. 0 disables the
+     * check. Only helps with hash functions that depend on the seed,
+     * such as SIP_HASH, and only applies to chained tables. */
+    size_t   max_chain_length;
+
+    /**
+     * If set, tables with variable length keys store the length of
+     * every key and compare it before calling key_compare. The keys
+     * must be NUL terminated strings. Only applies to chained tables. */
+    bool     cache_key_length;
+
     /**
      * The initial capacity of the table array. */
     size_t   initial_capacity;
@@ -123,12 +189,26 @@ enum cc_stat  hashtable_new_conf        (HashTableConf const * const conf, HashT
 void          hashtable_destroy         (HashTable *table);
 enum cc_stat  hashtable_add             (HashTable *table, void *key, void *val);
 enum cc_stat  hashtable_get             (HashTable *table, void *key, void **out);
+enum cc_stat  hashtable_get_or_add      (HashTable *table, void *key, void *default_val,
+                                         void ***out_slot, bool *inserted);
+enum cc_stat  hashtable_upsert          (HashTable *table, void *key,
+                                         void *(*fn) (void *value, bool exists, void *ctx),
+                                         void *ctx);
+enum cc_stat  hashtable_add_all_from_arrays(HashTable *table, void **keys, void **vals,
+                                            size_t n);
+enum cc_stat  hashtable_get_batch       (HashTable *table, void **keys, size_t n,
+                                         void **out_values, enum cc_stat *out_status);
 enum cc_stat  hashtable_remove          (HashTable *table, void *key, void **out);
 void          hashtable_remove_all      (HashTable *table);
+size_t        hashtable_retain          (HashTable *table,
+                                         bool (*pred) (const void *key, void *value, void *ctx),
+                                         void *ctx);
 bool          hashtable_contains_key    (HashTable *table, void *key);
 
 size_t        hashtable_size            (HashTable *table);
 size_t        hashtable_capacity        (HashTable *table);
+enum cc_stat  hashtable_reserve         (HashTable *table, size_t n);
+enum cc_stat  hashtable_shrink_to_fit   (HashTable *table);
 
 enum cc_stat  hashtable_get_keys        (HashTable *table, Array **out);
 enum cc_stat  hashtable_get_values      (HashTable *table, Array **out);
@@ -136,10 +216,24 @@ enum cc_stat  hashtable_get_values      (HashTable *table, Array **out);
 size_t        hashtable_hash_string     (const void *key, int len, uint32_t seed);
 size_t        hashtable_hash            (const void *key, int len, uint32_t seed);
 size_t        hashtable_hash_ptr        (const void *key, int len, uint32_t seed);
+size_t        hashtable_wyhash          (const void *key, int len, uint32_t seed);
+size_t        hashtable_wyhash_string   (const void *key, int len, uint32_t seed);
+size_t        hashtable_wyhash_ptr      (const void *key, int len, uint32_t seed);
+size_t        hashtable_siphash         (const void *key, int len, uint32_t seed);
+size_t        hashtable_siphash_string  (const void *key, int len, uint32_t seed);
 
 void          hashtable_foreach_key     (HashTable *table, void (*op) (const void *));
 void          hashtable_foreach_value   (HashTable *table, void (*op) (void *));
 
+enum cc_stat  hashtable_save            (HashTable *table, int fd,
+                                         const void *(*key_ser) (const void *key, size_t *size),
+                                         const void *(*val_ser) (const void *val, size_t *size));
+enum cc_stat  hashtable_open_mmap       (const char *path, HashTableSnapshot **out);
+void          hashtable_snapshot_close  (HashTableSnapshot *snap);
+enum cc_stat  hashtable_snapshot_get    (HashTableSnapshot *snap, const void *key, size_t key_size,
+                                         const void **out, size_t *out_size);
+size_t        hashtable_snapshot_size   (HashTableSnapshot *snap);
+
 void          hashtable_iter_init       (HashTableIter *iter, HashTable *table);
 enum cc_stat  hashtable_iter_next       (HashTableIter *iter, TableEntry **out);
 enum cc_stat  hashtable_iter_remove     (HashTableIter *iter, void **out);
@@ -163,5 +257,17 @@ enum cc_stat  hashtable_iter_remove     (HashTableIter *iter, void **out);
 #define STRING_HASH  hashtable_hash_string
 #define POINTER_HASH hashtable_hash_ptr
 
+/* wyhash based alternatives to the hash functions above. They are
+ * considerably faster on keys longer than a few bytes. */
+#define WY_HASH         hashtable_wyhash
+#define WY_STRING_HASH  hashtable_wyhash_string
+#define WY_POINTER_HASH hashtable_wyhash_ptr
+
+/* SipHash-1-3 keyed by the table seed and a random per process secret.
+ * Slower than the functions above, but resistant to hash flooding. The
+ * hashes differ between processes, so they must not be persisted. */
+#define SIP_HASH        hashtable_siphash
+#define SIP_STRING_HASH hashtable_siphash_string
+
 
 #endif /* COLLECTIONS_C_HASHTABLE_H */
@@ -58,6 +58,12 @@ typedef struct pqueue_conf_s {
     void *(*mem_alloc)  (size_t size);
     void *(*mem_calloc) (size_t blocks, size_t size);
     void  (*mem_free)   (void *block);
+
+    /**
+     * Optional allocator that resizes blocks returned by mem_alloc, with
+     * the semantics of realloc(). If set, the buffer grows in place
+     * whenever the allocator can manage it. NULL by default. */
+    void *(*mem_realloc) (void *block, size_t size);
 } PQueueConf;
 
 void          pqueue_conf_init       (PQueueConf *conf, int (*)(const void *, const void *));
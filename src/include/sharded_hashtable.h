@@ -0,0 +1,74 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2015 Srđan Panić <srdja.panic@gmail.com>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COLLECTIONS_C_SHARDED_HASHTABLE_H
+#define COLLECTIONS_C_SHARDED_HASHTABLE_H
+
+#include "common.h"
+#include "hashtable.h"
+
+/**
+ * A thread safe key-value map made of independent HashTable shards. The
+ * high bits of a key's hash pick its shard, and every shard has its own
+ * lock and resizes on its own, so a resize of one shard never blocks the
+ * others.
+ *
+ * @note The memory allocators that the table is configured with must be
+ * thread safe.
+ */
+typedef struct sharded_hashtable_s ShardedHashTable;
+
+/**
+ * ShardedHashTable configuration object.
+ */
+typedef struct sharded_hashtable_conf_s {
+    /**
+     * The number of shards, rounded up to a power of two. */
+    size_t        shards;
+
+    /**
+     * The configuration of every shard. The initial capacity and the
+     * other sizes apply to each shard on its own. The hash function and
+     * the seed are also used to pick the shard of a key. The allocators
+     * are also used for the ShardedHashTable structure. */
+    HashTableConf table_conf;
+} ShardedHashTableConf;
+
+
+void          sharded_hashtable_conf_init    (ShardedHashTableConf *conf);
+enum cc_stat  sharded_hashtable_new          (ShardedHashTable **out);
+enum cc_stat  sharded_hashtable_new_conf     (ShardedHashTableConf const * const conf,
+                                              ShardedHashTable **out);
+
+void          sharded_hashtable_destroy      (ShardedHashTable *table);
+enum cc_stat  sharded_hashtable_add          (ShardedHashTable *table, void *key, void *val);
+enum cc_stat  sharded_hashtable_get          (ShardedHashTable *table, void *key, void **out);
+enum cc_stat  sharded_hashtable_remove       (ShardedHashTable *table, void *key, void **out);
+bool          sharded_hashtable_contains_key (ShardedHashTable *table, void *key);
+
+size_t        sharded_hashtable_size         (ShardedHashTable *table);
+size_t        sharded_hashtable_shards       (ShardedHashTable *table);
+
+void          sharded_hashtable_foreach      (ShardedHashTable *table, size_t threads,
+                                              void (*fn) (const void *key, void *value,
+                                                          void *ctx),
+                                              void *ctx);
+
+#endif /* COLLECTIONS_C_SHARDED_HASHTABLE_H */
@@ -40,6 +40,7 @@ struct pqueue_s {
     void *(*mem_alloc)  (size_t size);
     void *(*mem_calloc) (size_t blocks, size_t size);
     void  (*mem_free)   (void *block);
+    void *(*mem_realloc) (void *block, size_t size);
 
     /*  Comparator function pointer, for compairing the elements of PQueue */
     int   (*cmp) (const void *a, const void *b);
@@ -60,6 +61,7 @@ void pqueue_conf_init(PQueueConf *conf, int (*cmp)(const void *, const void *))
     conf->mem_alloc  = malloc;
     conf->mem_calloc = calloc;
     conf->mem_free   = free;
+    conf->mem_realloc = NULL;
     conf->cmp        = cmp;
     conf->exp_factor = DEFAULT_EXPANSION_FACTOR;
     conf->capacity   = DEFAULT_CAPACITY;
@@ -129,6 +131,7 @@ enum cc_stat pqueue_new_conf(PQueueConf const * const conf, PQueue **out)
     pq->mem_alloc  = conf->mem_alloc;
     pq->mem_calloc = conf->mem_calloc;
     pq->mem_free   = conf->mem_free;
+    pq->mem_realloc = conf->mem_realloc;
     pq->cmp        = conf->cmp;
     pq->buffer     = buff;
     pq->exp_factor = ex;
@@ -189,18 +192,28 @@ static enum cc_stat expand_capacity(PQueue *pq)
     /* As long as the capacity is greater that the expansion factor
      * at the point of overflow, this is check is valid. */
     if (new_capacity <= pq->capacity)
-        pq->capacity = CC_MAX_ELEMENTS;
-    else
-        pq->capacity = new_capacity;
-
-    void **new_buff = pq->mem_alloc(new_capacity * sizeof(void*));
+        new_capacity = CC_MAX_ELEMENTS;
 
-    if (!new_buff)
+    if (new_capacity > SIZE_MAX / sizeof(void*))
         return CC_ERR_ALLOC;
 
-    memcpy(new_buff, pq->buffer, pq->size * sizeof(void*));
+    void **new_buff;
 
-    pq->mem_free(pq->buffer);
+    if (pq->mem_realloc) {
+        new_buff = pq->mem_realloc(pq->buffer, new_capacity * sizeof(void*));
+
+        if (!new_buff)
+            return CC_ERR_ALLOC;
+    } else {
+        new_buff = pq->mem_alloc(new_capacity * sizeof(void*));
+
+        if (!new_buff)
+            return CC_ERR_ALLOC;
+
+        memcpy(new_buff, pq->buffer, pq->size * sizeof(void*));
+        pq->mem_free(pq->buffer);
+    }
+    pq->capacity = new_capacity;
     pq->buffer = new_buff;
 
     return CC_OK;
@@ -241,7 +254,8 @@ enum cc_stat pqueue_push(PQueue *pq, void *element)
 
         i      = CC_PARENT(i);
         child  = pq->buffer[i];
-        parent = pq->buffer[CC_PARENT(i)];
+        if (i != 0)
+            parent = pq->buffer[CC_PARENT(i)];
     }
     return CC_OK;
 }
@@ -306,17 +320,15 @@ static void pqueue_heapify(PQueue *pq, size_t index)
     size_t R   = CC_RIGHT(index);
     size_t tmp = index;
 
-    void *left     = pq->buffer[L];
-    void *right    = pq->buffer[R];
     void *indexPtr = pq->buffer[index];
 
-    if (L < pq->size && pq->cmp(indexPtr, left) < 0) {
-        indexPtr = left;
+    if (L < pq->size && pq->cmp(indexPtr, pq->buffer[L]) < 0) {
+        indexPtr = pq->buffer[L];
         index = L;
     }
 
-    if (R < pq->size && pq->cmp(indexPtr, right) < 0) {
-        indexPtr = right;
+    if (R < pq->size && pq->cmp(indexPtr, pq->buffer[R]) < 0) {
+        indexPtr = pq->buffer[R];
         index = R;
     }
 
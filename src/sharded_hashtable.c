@@ -0,0 +1,399 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2015 Srđan Panić <srdja.panic@gmail.com>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "sharded_hashtable.h"
+#include "hashtable_internal.h"
+
+#define DEFAULT_SHARDS 16
+
+#define CACHE_LINE     64
+
+/* Upper bound on the worker threads of sharded_hashtable_foreach() */
+#define MAX_THREADS    256
+
+typedef struct shard_s {
+    pthread_mutex_t lock;
+    HashTable      *table;
+} Shard;
+
+/* Shards are padded to a cache line so that threads working on adjacent
+ * shards don't share lines. */
+typedef union padded_shard_u {
+    Shard shard;
+    char  pad[(sizeof(Shard) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE];
+} PaddedShard;
+
+struct sharded_hashtable_s {
+    PaddedShard *shards;
+    void        *shards_block;
+    size_t       shard_count;
+    unsigned     shard_bits;
+
+    int          key_len;
+    uint32_t     hash_seed;
+
+    size_t (*hash)     (const void *key, int l, uint32_t seed);
+    void   (*mem_free) (void *block);
+};
+
+/* State shared by the workers of a parallel foreach */
+typedef struct foreach_job_s {
+    ShardedHashTable *table;
+    atomic_size_t     next;
+    void            (*fn) (const void *key, void *value, void *ctx);
+    void             *ctx;
+} ForeachJob;
+
+
+/**
+ * Creates a new ShardedHashTable and returns a status code.
+ *
+ * @note The newly created ShardedHashTable will work with string keys.
+ *
+ * @param[out] out Pointer to where the newly created ShardedHashTable is
+ *                 to be stored
+ *
+ * @return CC_OK if the creation was successful, or CC_ERR_ALLOC if the memory
+ * allocation for the new ShardedHashTable failed.
+ */
+enum cc_stat sharded_hashtable_new(ShardedHashTable **out)
+{
+    ShardedHashTableConf conf;
+    sharded_hashtable_conf_init(&conf);
+    return sharded_hashtable_new_conf(&conf, out);
+}
+
+/**
+ * Creates a new ShardedHashTable based on the specified ShardedHashTableConf
+ * struct and returns a status code. Each shard is created with
+ * hashtable_new_conf() from conf->table_conf.
+ *
+ * @param[in] conf the ShardedHashTable conf structure
+ * @param[out] out Pointer to where the newly created ShardedHashTable is
+ *                 stored
+ *
+ * @return CC_OK if the creation was successful, or CC_ERR_ALLOC if the memory
+ * allocation for the new ShardedHashTable structure failed.
+ */
+enum cc_stat sharded_hashtable_new_conf(ShardedHashTableConf const * const conf,
+                                        ShardedHashTable **out)
+{
+    HashTableConf const *tconf = &conf->table_conf;
+
+    ShardedHashTable *table = tconf->mem_calloc(1, sizeof(ShardedHashTable));
+
+    if (!table)
+        return CC_ERR_ALLOC;
+
+    size_t count = conf->shards > 1 ? round_pow_two(conf->shards) : 1;
+
+    /* The shards are allocated without their own alignment, so one extra
+     * shard of padding leaves room to align them to a cache line. */
+    void *block = tconf->mem_calloc(count + 1, sizeof(PaddedShard));
+
+    if (!block) {
+        tconf->mem_free(table);
+        return CC_ERR_ALLOC;
+    }
+    table->shards = (PaddedShard*)
+        (((uintptr_t) block + CACHE_LINE - 1) & ~(uintptr_t) (CACHE_LINE - 1));
+
+    table->shard_count = count;
+    table->key_len     = tconf->key_length;
+    table->hash_seed   = tconf->random_seed ? hashtable_random_seed() : tconf->hash_seed;
+    table->hash        = tconf->hash;
+    table->mem_free    = tconf->mem_free;
+
+    while (((size_t) 1 << table->shard_bits) < count)
+        table->shard_bits++;
+
+    /* The shards share the seed, since it also picks the shard */
+    HashTableConf shard_conf = *tconf;
+    shard_conf.random_seed = false;
+    shard_conf.hash_seed   = table->hash_seed;
+
+    size_t i;
+    for (i = 0; i < count; i++) {
+        Shard *s = &table->shards[i].shard;
+
+        if (hashtable_new_conf(&shard_conf, &s->table) != CC_OK) {
+            while (i--) {
+                hashtable_destroy(table->shards[i].shard.table);
+                pthread_mutex_destroy(&table->shards[i].shard.lock);
+            }
+            tconf->mem_free(block);
+            tconf->mem_free(table);
+            return CC_ERR_ALLOC;
+        }
+        pthread_mutex_init(&s->lock, NULL);
+    }
+    table->shards_block = block;
+
+    *out = table;
+    return CC_OK;
+}
+
+/**
+ * Initializes the ShardedHashTableConf structs fields to default values.
+ * The shards are configured with the defaults of hashtable_conf_init().
+ *
+ * @param[in] conf the struct that is being initialized
+ */
+void sharded_hashtable_conf_init(ShardedHashTableConf *conf)
+{
+    conf->shards = DEFAULT_SHARDS;
+    hashtable_conf_init(&conf->table_conf);
+}
+
+/**
+ * Destroys the specified ShardedHashTable structure and all of its shards
+ * without destroying the data contained within it. No other thread may be
+ * using the table.
+ *
+ * @param[in] table ShardedHashTable to be destroyed
+ */
+void sharded_hashtable_destroy(ShardedHashTable *table)
+{
+    size_t i;
+
+    for (i = 0; i < table->shard_count; i++) {
+        hashtable_destroy(table->shards[i].shard.table);
+        pthread_mutex_destroy(&table->shards[i].shard.lock);
+    }
+    table->mem_free(table->shards_block);
+    table->mem_free(table);
+}
+
+/**
+ * Returns the shard of the key. The hash is mixed before its high bits are
+ * taken, so that hash functions that only fill the low 32 bits spread the
+ * keys over all shards too. The shards index their buckets with the low
+ * bits of the unmixed hash.
+ */
+static INLINE Shard *shard_of(ShardedHashTable *table, const void *key)
+{
+    if (table->shard_bits == 0)
+        return &table->shards[0].shard;
+
+    uint64_t h = key ? table->hash(key, table->key_len, table->hash_seed) : 0;
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+
+    return &table->shards[h >> (64 - table->shard_bits)].shard;
+}
+
+/**
+ * Creates a new key-value mapping in the specified ShardedHashTable. If the
+ * key is already mapped to a value in this table, that value is replaced with
+ * the new value.
+ *
+ * @param[in] table the table to which this new key-value mapping is being added
+ * @param[in] key a hash table key used to access the specified value
+ * @param[in] val a value that is being stored in the table
+ *
+ * @return CC_OK if the mapping was successfully added, CC_ERR_ALLOC if the
+ * memory allocation failed, or CC_ERR_MAX_CAPACITY if the shard can't grow.
+ */
+enum cc_stat sharded_hashtable_add(ShardedHashTable *table, void *key, void *val)
+{
+    Shard *s = shard_of(table, key);
+
+    pthread_mutex_lock(&s->lock);
+    enum cc_stat stat = hashtable_add(s->table, key, val);
+    pthread_mutex_unlock(&s->lock);
+
+    return stat;
+}
+
+/**
+ * Gets a value associated with the specified key and sets the out
+ * parameter to it.
+ *
+ * @param[in] table the table from which the mapping is being returned
+ * @param[in] key   the key that is being looked up
+ * @param[out] out  pointer to where the returned value is stored, or NULL
+ *
+ * @return CC_OK if the key was found, or CC_ERR_KEY_NOT_FOUND if not.
+ */
+enum cc_stat sharded_hashtable_get(ShardedHashTable *table, void *key, void **out)
+{
+    Shard *s = shard_of(table, key);
+    void  *value;
+
+    pthread_mutex_lock(&s->lock);
+    enum cc_stat stat = hashtable_get(s->table, key, &value);
+    pthread_mutex_unlock(&s->lock);
+
+    if (stat == CC_OK && out)
+        *out = value;
+
+    return stat;
+}
+
+/**
+ * Checks whether or not the ShardedHashTable contains the specified key.
+ *
+ * @param[in] table the table on which the search is being performed
+ * @param[in] key the key that is being searched for
+ *
+ * @return true if the table contains the key.
+ */
+bool sharded_hashtable_contains_key(ShardedHashTable *table, void *key)
+{
+    return sharded_hashtable_get(table, key, NULL) == CC_OK;
+}
+
+/**
+ * Removes a key-value mapping from the specified table and sets the out
+ * parameter to value.
+ *
+ * @param[in] table the table from which the key-value pair is being removed
+ * @param[in] key the key of the value being returned
+ * @param[out] out pointer to where the removed value is stored, or NULL
+ *                 if it is to be ignored
+ *
+ * @return CC_OK if the mapping was successfully removed, or CC_ERR_KEY_NOT_FOUND
+ * if the key was not found.
+ */
+enum cc_stat sharded_hashtable_remove(ShardedHashTable *table, void *key, void **out)
+{
+    Shard *s = shard_of(table, key);
+
+    pthread_mutex_lock(&s->lock);
+    enum cc_stat stat = hashtable_remove(s->table, key, out);
+    pthread_mutex_unlock(&s->lock);
+
+    return stat;
+}
+
+/**
+ * Returns the number of key-value mappings in the table. The shards are
+ * counted one at a time, so while other threads modify the table the result
+ * is only an estimate.
+ *
+ * @param[in] table the table whose size is being returned
+ *
+ * @return the number of key-value mappings in the table.
+ */
+size_t sharded_hashtable_size(ShardedHashTable *table)
+{
+    size_t size = 0;
+    size_t i;
+
+    for (i = 0; i < table->shard_count; i++) {
+        Shard *s = &table->shards[i].shard;
+
+        pthread_mutex_lock(&s->lock);
+        size += hashtable_size(s->table);
+        pthread_mutex_unlock(&s->lock);
+    }
+    return size;
+}
+
+/**
+ * Returns the number of shards of the table.
+ *
+ * @param[in] table the table whose shard count is being returned
+ *
+ * @return the number of shards.
+ */
+size_t sharded_hashtable_shards(ShardedHashTable *table)
+{
+    return table->shard_count;
+}
+
+/**
+ * Claims shards and calls the job's function on their entries until no
+ * shard is left.
+ */
+static void *foreach_worker(void *arg)
+{
+    ForeachJob       *job   = arg;
+    ShardedHashTable *table = job->table;
+    size_t            i;
+
+    while ((i = atomic_fetch_add(&job->next, 1)) < table->shard_count) {
+        Shard         *s = &table->shards[i].shard;
+        HashTableIter  iter;
+        TableEntry    *entry;
+
+        pthread_mutex_lock(&s->lock);
+
+        hashtable_iter_init(&iter, s->table);
+        while (hashtable_iter_next(&iter, &entry) != CC_ITER_END)
+            job->fn(entry->key, entry->value, job->ctx);
+
+        pthread_mutex_unlock(&s->lock);
+    }
+    return NULL;
+}
+
+/**
+ * Calls fn on every key-value mapping of the table. The shards are handed
+ * out to the calling thread and threads - 1 worker threads, so fn is called
+ * concurrently for entries of different shards, and must be thread safe.
+ * Every shard is locked while fn is called on its entries, so fn must not
+ * access the table.
+ *
+ * @param[in] table   the table on which this operation is being performed
+ * @param[in] threads the number of threads that run fn, including the
+ *                    calling thread. 0 or 1 runs everything on the calling
+ *                    thread.
+ * @param[in] fn      the function that is invoked on every mapping
+ * @param[in] ctx     user data that is passed to fn
+ *
+ * @note If some of the worker threads can't be started, the threads that
+ * did start take over their shards.
+ */
+void sharded_hashtable_foreach(ShardedHashTable *table, size_t threads,
+                               void (*fn) (const void *key, void *value,
+                                           void *ctx),
+                               void *ctx)
+{
+    pthread_t  workers[MAX_THREADS];
+    ForeachJob job;
+    size_t     started = 0;
+
+    job.table = table;
+    job.fn    = fn;
+    job.ctx   = ctx;
+    atomic_init(&job.next, 0);
+
+    if (threads > table->shard_count)
+        threads = table->shard_count;
+    if (threads > MAX_THREADS)
+        threads = MAX_THREADS;
+
+    while (started + 1 < threads) {
+        if (pthread_create(&workers[started], NULL, foreach_worker, &job) != 0)
+            break;
+        started++;
+    }
+
+    foreach_worker(&job);
+
+    while (started)
+        pthread_join(workers[--started], NULL);
+}
@@ -0,0 +1,962 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2015 Srđan Panić <srdja.panic@gmail.com>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sort_internal.h"
+
+/*
+ * Pattern-defeating quicksort, after Orson Peters' pdqsort.
+ *
+ * An introsort that falls back to insertion sort on small ranges and to
+ * heapsort after too many unbalanced partitions. On top of that it
+ *
+ *  - picks the pivot as a median of 3, or a pseudo median of 9 on large
+ *    ranges,
+ *  - notices when a partition didn't have to move anything and then tries
+ *    to finish both halves with a bounded insertion sort, which makes
+ *    sorted and nearly sorted ranges linear,
+ *  - partitions runs of elements equal to the previous pivot out in one
+ *    go, which makes ranges with few distinct values linear,
+ *  - shuffles a few elements after an unbalanced partition to break up
+ *    patterns that defeat the median selection.
+ *
+ * Before that, sort_pdq() checks whether the whole buffer is a single
+ * ascending or descending run, which costs a couple of comparisons on
+ * unsorted input.
+ */
+
+#define INSERTION_SORT_THRESHOLD 24
+#define NINTHER_THRESHOLD        128
+#define PARTIAL_INSERTION_LIMIT  8
+
+#define MIN_MERGE     64
+#define MIN_GALLOP    7
+#define MAX_RUNS      85
+
+#define RADIX_BITS    8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES  (64 / RADIX_BITS)
+
+#define LESS(a, b) (cmp((a), (b)) < 0)
+
+typedef int (*cmp_fn) (const void*, const void*);
+
+typedef struct run_s {
+    void   **base;
+    size_t   len;
+} Run;
+
+typedef struct timsort_s {
+    int    (*cmp)       (const void*, const void*);
+    void  *(*mem_alloc) (size_t size);
+    void   (*mem_free)  (void *block);
+
+    /* Scratch space for the shorter run of a merge */
+    void   **tmp;
+    size_t   tmp_capacity;
+
+    size_t   min_gallop;
+    size_t   n_runs;
+    Run      runs[MAX_RUNS];
+} TimSort;
+
+typedef struct keyed_s {
+    uint64_t  key;
+    void     *elem;
+} Keyed;
+
+static bool   single_run             (void **base, size_t n, cmp_fn cmp);
+static void   pdq_loop               (void **begin, void **end, cmp_fn cmp,
+                                      int bad_allowed, bool leftmost);
+static void   insertion_sort         (void **begin, void **end, cmp_fn cmp);
+static void   unguarded_insertion_sort(void **begin, void **end, cmp_fn cmp);
+static bool   partial_insertion_sort (void **begin, void **end, cmp_fn cmp);
+static void **partition_right        (void **begin, void **end, cmp_fn cmp,
+                                      bool *already_partitioned);
+static void **partition_left         (void **begin, void **end, cmp_fn cmp);
+static void   heap_sort              (void **begin, void **end, cmp_fn cmp);
+
+static size_t       min_run_length   (size_t n);
+static size_t       count_run        (void **base, size_t n, cmp_fn cmp);
+static void         binary_insertion_sort(void **base, size_t n, size_t sorted, cmp_fn cmp);
+static size_t       gallop           (void **key, void **base, size_t n, bool right,
+                                      bool from_end, cmp_fn cmp);
+static enum cc_stat merge_collapse   (TimSort *ts);
+static enum cc_stat merge_force_collapse(TimSort *ts);
+static enum cc_stat merge_at         (TimSort *ts, size_t i);
+static void         merge_lo         (TimSort *ts, void **a, size_t na, void **b, size_t nb);
+static void         merge_hi         (TimSort *ts, void **a, size_t na, void **b, size_t nb);
+
+
+static INLINE void swap(void **a, void **b)
+{
+    void *tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+static INLINE void sort2(void **a, void **b, cmp_fn cmp)
+{
+    if (LESS(b, a))
+        swap(a, b);
+}
+
+static INLINE void sort3(void **a, void **b, void **c, cmp_fn cmp)
+{
+    sort2(a, b, cmp);
+    sort2(b, c, cmp);
+    sort2(a, b, cmp);
+}
+
+/**
+ * Sorts the n pointers at base in ascending order as defined by cmp. The
+ * sort is not stable.
+ *
+ * @param[in] base the buffer that is being sorted
+ * @param[in] n    number of elements in the buffer
+ * @param[in] cmp  comparator of buffer slots
+ */
+void sort_pdq(void **base, size_t n, int (*cmp) (const void*, const void*))
+{
+    if (n < 2 || single_run(base, n, cmp))
+        return;
+
+    int    bad_allowed = 0;
+    size_t m           = n;
+
+    while (m >>= 1)
+        bad_allowed++;
+
+    pdq_loop(base, base + n, cmp, bad_allowed, true);
+}
+
+/**
+ * Returns true if the buffer was a single ascending run, or a single
+ * descending run that has been reversed. Gives up on the first element
+ * that breaks the run of the first two elements.
+ */
+static bool single_run(void **base, size_t n, cmp_fn cmp)
+{
+    size_t i = 1;
+
+    if (!LESS(&base[1], &base[0])) {
+        while (i < n && !LESS(&base[i], &base[i - 1]))
+            i++;
+        return i == n;
+    }
+
+    while (i < n && !LESS(&base[i - 1], &base[i]))
+        i++;
+
+    if (i < n)
+        return false;
+
+    void **lo = base;
+    void **hi = base + n - 1;
+
+    while (lo < hi)
+        swap(lo++, hi--);
+
+    return true;
+}
+
+static void pdq_loop(void **begin, void **end, cmp_fn cmp, int bad_allowed, bool leftmost)
+{
+    for (;;) {
+        size_t size = end - begin;
+
+        if (size < INSERTION_SORT_THRESHOLD) {
+            if (leftmost)
+                insertion_sort(begin, end, cmp);
+            else
+                unguarded_insertion_sort(begin, end, cmp);
+            return;
+        }
+
+        /* Move the pivot to begin, and make sure that end[-1] isn't less
+         * than it, which lets partition_right skip a bounds check */
+        size_t half = size / 2;
+
+        if (size > NINTHER_THRESHOLD) {
+            sort3(begin, begin + half, end - 1, cmp);
+            sort3(begin + 1, begin + (half - 1), end - 2, cmp);
+            sort3(begin + 2, begin + (half + 1), end - 3, cmp);
+            sort3(begin + (half - 1), begin + half, begin + (half + 1), cmp);
+            swap(begin, begin + half);
+        } else {
+            sort3(begin + half, begin, end - 1, cmp);
+        }
+
+        /* If the pivot is equal to the element before the range, which
+         * was the pivot of an earlier partition, no element in the range
+         * is less than it. Put all elements equal to it to the left and
+         * only sort the rest. */
+        if (!leftmost && !LESS(begin - 1, begin)) {
+            begin = partition_left(begin, end, cmp) + 1;
+            continue;
+        }
+
+        bool   already_partitioned;
+        void **pivot  = partition_right(begin, end, cmp, &already_partitioned);
+        size_t l_size = pivot - begin;
+        size_t r_size = end - (pivot + 1);
+
+        if (l_size < size / 8 || r_size < size / 8) {
+            if (--bad_allowed == 0) {
+                heap_sort(begin, end, cmp);
+                return;
+            }
+
+            if (l_size >= INSERTION_SORT_THRESHOLD) {
+                swap(begin, begin + l_size / 4);
+                swap(pivot - 1, pivot - l_size / 4);
+
+                if (l_size > NINTHER_THRESHOLD) {
+                    swap(begin + 1, begin + (l_size / 4 + 1));
+                    swap(begin + 2, begin + (l_size / 4 + 2));
+                    swap(pivot - 2, pivot - (l_size / 4 + 1));
+                    swap(pivot - 3, pivot - (l_size / 4 + 2));
+                }
+            }
+
+            if (r_size >= INSERTION_SORT_THRESHOLD) {
+                swap(pivot + 1, pivot + (1 + r_size / 4));
+                swap(end - 1, end - r_size / 4);
+
+                if (r_size > NINTHER_THRESHOLD) {
+                    swap(pivot + 2, pivot + (2 + r_size / 4));
+                    swap(pivot + 3, pivot + (3 + r_size / 4));
+                    swap(end - 2, end - (1 + r_size / 4));
+                    swap(end - 3, end - (2 + r_size / 4));
+                }
+            }
+        } else if (already_partitioned &&
+                   partial_insertion_sort(begin, pivot, cmp) &&
+                   partial_insertion_sort(pivot + 1, end, cmp)) {
+            return;
+        }
+
+        pdq_loop(begin, pivot, cmp, bad_allowed, leftmost);
+        begin    = pivot + 1;
+        leftmost = false;
+    }
+}
+
+static void insertion_sort(void **begin, void **end, cmp_fn cmp)
+{
+    void **cur;
+
+    for (cur = begin + 1; cur < end; cur++) {
+        void **sift = cur;
+        void  *tmp  = *cur;
+
+        while (sift != begin && LESS(&tmp, sift - 1)) {
+            *sift = *(sift - 1);
+            sift--;
+        }
+        *sift = tmp;
+    }
+}
+
+/**
+ * Insertion sort that relies on begin[-1] not being greater than any
+ * element of the range.
+ */
+static void unguarded_insertion_sort(void **begin, void **end, cmp_fn cmp)
+{
+    void **cur;
+
+    for (cur = begin + 1; cur < end; cur++) {
+        void **sift = cur;
+        void  *tmp  = *cur;
+
+        while (LESS(&tmp, sift - 1)) {
+            *sift = *(sift - 1);
+            sift--;
+        }
+        *sift = tmp;
+    }
+}
+
+/**
+ * Insertion sort that gives up once it has moved more than
+ * PARTIAL_INSERTION_LIMIT elements. Returns true if the range got sorted.
+ */
+static bool partial_insertion_sort(void **begin, void **end, cmp_fn cmp)
+{
+    if (begin == end)
+        return true;
+
+    size_t moved = 0;
+    void **cur;
+
+    for (cur = begin + 1; cur < end; cur++) {
+        void **sift = cur;
+        void  *tmp  = *cur;
+
+        while (sift != begin && LESS(&tmp, sift - 1)) {
+            *sift = *(sift - 1);
+            sift--;
+        }
+        *sift = tmp;
+
+        moved += cur - sift;
+        if (moved > PARTIAL_INSERTION_LIMIT)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Partitions the range around the pivot at begin into the elements less
+ * than the pivot and the elements not less than it, and returns the final
+ * position of the pivot. Sets already_partitioned if no elements had to be
+ * swapped.
+ */
+static void **partition_right(void **begin, void **end, cmp_fn cmp, bool *already_partitioned)
+{
+    void  *pivot = *begin;
+    void **first = begin;
+    void **last  = end;
+
+    while (LESS(++first, &pivot))
+        ;
+
+    /* If the first element after the pivot is out of place, some element
+     * to its left is less than the pivot and stops the scan below */
+    if (first - 1 == begin) {
+        while (first < last && !LESS(--last, &pivot))
+            ;
+    } else {
+        while (!LESS(--last, &pivot))
+            ;
+    }
+
+    *already_partitioned = first >= last;
+
+    while (first < last) {
+        swap(first, last);
+        while (LESS(++first, &pivot))
+            ;
+        while (!LESS(--last, &pivot))
+            ;
+    }
+
+    void **pivot_pos = first - 1;
+    *begin     = *pivot_pos;
+    *pivot_pos = pivot;
+
+    return pivot_pos;
+}
+
+/**
+ * Like partition_right, but puts the elements equal to the pivot to the
+ * left of it.
+ */
+static void **partition_left(void **begin, void **end, cmp_fn cmp)
+{
+    void  *pivot = *begin;
+    void **first = begin;
+    void **last  = end;
+
+    while (LESS(&pivot, --last))
+        ;
+
+    if (last + 1 == end) {
+        while (first < last && !LESS(&pivot, ++first))
+            ;
+    } else {
+        while (!LESS(&pivot, ++first))
+            ;
+    }
+
+    while (first < last) {
+        swap(first, last);
+        while (LESS(&pivot, --last))
+            ;
+        while (!LESS(&pivot, ++first))
+            ;
+    }
+
+    *begin = *last;
+    *last  = pivot;
+
+    return last;
+}
+
+static void sift_down(void **heap, size_t root, size_t n, cmp_fn cmp)
+{
+    for (;;) {
+        size_t child = 2 * root + 1;
+
+        if (child >= n)
+            return;
+
+        if (child + 1 < n && LESS(&heap[child], &heap[child + 1]))
+            child++;
+
+        if (!LESS(&heap[root], &heap[child]))
+            return;
+
+        swap(&heap[root], &heap[child]);
+        root = child;
+    }
+}
+
+static void heap_sort(void **begin, void **end, cmp_fn cmp)
+{
+    size_t n = end - begin;
+    size_t i;
+
+    for (i = n / 2; i > 0; i--)
+        sift_down(begin, i - 1, n, cmp);
+
+    for (i = n - 1; i > 0; i--) {
+        swap(&begin[0], &begin[i]);
+        sift_down(begin, 0, i, cmp);
+    }
+}
+
+/*
+ * Timsort, after the list sort of CPython.
+ *
+ * The buffer is split into natural runs, strictly descending runs being
+ * reversed, and runs shorter than a minimum length are extended with a
+ * binary insertion sort. Runs are pushed on a stack and merged while
+ * keeping the run lengths roughly balanced. Merges first skip the part of
+ * either run that is already in place, and switch to galloping, copying
+ * whole blocks found with an exponential search, when one run keeps
+ * winning. Only the shorter run of a merge is copied into the scratch
+ * buffer, so appending a few elements to a sorted buffer costs a single
+ * pass and a small copy.
+ */
+
+/**
+ * Sorts the n pointers at base in ascending order as defined by cmp. The
+ * sort is stable. The scratch buffer is allocated with mem_alloc and holds
+ * at most n / 2 pointers.
+ *
+ * @param[in] base      the buffer that is being sorted
+ * @param[in] n         number of elements in the buffer
+ * @param[in] cmp       comparator of buffer slots
+ * @param[in] mem_alloc allocator of the scratch buffer
+ * @param[in] mem_free  deallocator of the scratch buffer
+ *
+ * @return CC_OK if the buffer was sorted, or CC_ERR_ALLOC if the scratch
+ * buffer couldn't be allocated, in which case the buffer holds the same
+ * elements in an unspecified order.
+ */
+enum cc_stat sort_tim(void **base, size_t n,
+                      int (*cmp) (const void*, const void*),
+                      void *(*mem_alloc) (size_t size),
+                      void  (*mem_free)  (void *block))
+{
+    if (n < 2)
+        return CC_OK;
+
+    TimSort ts;
+
+    ts.cmp          = cmp;
+    ts.mem_alloc    = mem_alloc;
+    ts.mem_free     = mem_free;
+    ts.tmp          = NULL;
+    ts.tmp_capacity = 0;
+    ts.min_gallop   = MIN_GALLOP;
+    ts.n_runs       = 0;
+
+    size_t       min_run = min_run_length(n);
+    size_t       lo      = 0;
+    enum cc_stat status  = CC_OK;
+
+    while (lo < n && status == CC_OK) {
+        size_t remaining = n - lo;
+        size_t len       = count_run(base + lo, remaining, cmp);
+
+        if (len < min_run) {
+            size_t forced = remaining < min_run ? remaining : min_run;
+            binary_insertion_sort(base + lo, forced, len, cmp);
+            len = forced;
+        }
+
+        ts.runs[ts.n_runs].base = base + lo;
+        ts.runs[ts.n_runs].len  = len;
+        ts.n_runs++;
+
+        status = merge_collapse(&ts);
+        lo    += len;
+    }
+
+    if (status == CC_OK)
+        status = merge_force_collapse(&ts);
+
+    if (ts.tmp)
+        mem_free(ts.tmp);
+
+    return status;
+}
+
+/**
+ * Returns the minimum run length, chosen so that n / min_run is a power of
+ * two or a bit less, which keeps the final merges balanced.
+ */
+static size_t min_run_length(size_t n)
+{
+    size_t r = 0;
+
+    while (n >= MIN_MERGE) {
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
+}
+
+/**
+ * Returns the length of the run at the start of the buffer. A strictly
+ * descending run is reversed in place. Equal elements never form a
+ * descending run, so reversing keeps the sort stable.
+ */
+static size_t count_run(void **base, size_t n, cmp_fn cmp)
+{
+    size_t i = 1;
+
+    if (n < 2)
+        return n;
+
+    if (!LESS(&base[1], &base[0])) {
+        while (i < n && !LESS(&base[i], &base[i - 1]))
+            i++;
+        return i;
+    }
+
+    while (i < n && LESS(&base[i], &base[i - 1]))
+        i++;
+
+    void **lo = base;
+    void **hi = base + i - 1;
+
+    while (lo < hi)
+        swap(lo++, hi--);
+
+    return i;
+}
+
+/**
+ * Sorts the buffer, whose first sorted elements are already in order, by
+ * inserting the rest one by one after the last element that isn't greater
+ * than them.
+ */
+static void binary_insertion_sort(void **base, size_t n, size_t sorted, cmp_fn cmp)
+{
+    size_t i;
+
+    for (i = sorted; i < n; i++) {
+        void   *pivot = base[i];
+        size_t  lo    = 0;
+        size_t  hi    = i;
+
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+
+            if (LESS(&pivot, &base[mid]))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        memmove(&base[lo + 1], &base[lo], (i - lo) * sizeof(void*));
+        base[lo] = pivot;
+    }
+}
+
+/**
+ * Returns the number of elements of the sorted run at base that are less
+ * than the key, or not greater than it if right is set. The position is
+ * found with an exponential search from the start of the run, or from its
+ * end if from_end is set, followed by a binary search.
+ */
+static size_t gallop(void **key, void **base, size_t n, bool right, bool from_end, cmp_fn cmp)
+{
+#define BEFORE(slot) (right ? !LESS(key, (slot)) : LESS((slot), key))
+
+    size_t lo;
+    size_t hi;
+    size_t ofs = 1;
+
+    if (n == 0)
+        return 0;
+
+    if (!from_end) {
+        if (!BEFORE(&base[0]))
+            return 0;
+
+        size_t last = 0;
+        while (ofs < n && BEFORE(&base[ofs])) {
+            last = ofs;
+            ofs  = 2 * ofs + 1;
+        }
+        lo = last + 1;
+        hi = ofs < n ? ofs : n;
+    } else {
+        if (BEFORE(&base[n - 1]))
+            return n;
+
+        size_t last = n - 1;
+        while (ofs < n && !BEFORE(&base[n - 1 - ofs])) {
+            last = n - 1 - ofs;
+            ofs  = 2 * ofs + 1;
+        }
+        lo = ofs < n ? n - ofs : 0;
+        hi = last;
+    }
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (BEFORE(&base[mid]))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+
+#undef BEFORE
+}
+
+/**
+ * Merges runs on top of the stack until the lengths of the top runs
+ * satisfy len[k - 2] > len[k - 1] + len[k] and len[k - 1] > len[k], which
+ * bounds the height of the stack by the logarithm of n.
+ */
+static enum cc_stat merge_collapse(TimSort *ts)
+{
+    Run *r = ts->runs;
+
+    while (ts->n_runs > 1) {
+        size_t k = ts->n_runs - 2;
+
+        if ((k > 0 && r[k - 1].len <= r[k].len + r[k + 1].len) ||
+            (k > 1 && r[k - 2].len <= r[k - 1].len + r[k].len)) {
+            if (r[k - 1].len < r[k + 1].len)
+                k--;
+        } else if (r[k].len > r[k + 1].len) {
+            break;
+        }
+
+        enum cc_stat status = merge_at(ts, k);
+        if (status != CC_OK)
+            return status;
+    }
+    return CC_OK;
+}
+
+/**
+ * Merges all runs on the stack into one.
+ */
+static enum cc_stat merge_force_collapse(TimSort *ts)
+{
+    Run *r = ts->runs;
+
+    while (ts->n_runs > 1) {
+        size_t k = ts->n_runs - 2;
+
+        if (k > 0 && r[k - 1].len < r[k + 1].len)
+            k--;
+
+        enum cc_stat status = merge_at(ts, k);
+        if (status != CC_OK)
+            return status;
+    }
+    return CC_OK;
+}
+
+/**
+ * Merges the runs i and i + 1 of the stack.
+ */
+static enum cc_stat merge_at(TimSort *ts, size_t i)
+{
+    void   **a  = ts->runs[i].base;
+    size_t   na = ts->runs[i].len;
+    void   **b  = ts->runs[i + 1].base;
+    size_t   nb = ts->runs[i + 1].len;
+
+    ts->runs[i].len = na + nb;
+    if (i + 3 == ts->n_runs)
+        ts->runs[i + 1] = ts->runs[i + 2];
+    ts->n_runs--;
+
+    /* Elements of a that are not greater than b[0] are already in place */
+    size_t k = gallop(&b[0], a, na, true, false, ts->cmp);
+    a  += k;
+    na -= k;
+    if (na == 0)
+        return CC_OK;
+
+    /* And so are elements of b that are not less than the last one of a */
+    nb = gallop(&a[na - 1], b, nb, false, true, ts->cmp);
+    if (nb == 0)
+        return CC_OK;
+
+    size_t need = na < nb ? na : nb;
+
+    if (need > ts->tmp_capacity) {
+        size_t capacity = ts->tmp_capacity * 2;
+
+        if (capacity < need)
+            capacity = need;
+
+        if (ts->tmp)
+            ts->mem_free(ts->tmp);
+
+        ts->tmp          = ts->mem_alloc(capacity * sizeof(void*));
+        ts->tmp_capacity = ts->tmp ? capacity : 0;
+
+        if (!ts->tmp)
+            return CC_ERR_ALLOC;
+    }
+
+    if (na <= nb)
+        merge_lo(ts, a, na, b, nb);
+    else
+        merge_hi(ts, a, na, b, nb);
+
+    return CC_OK;
+}
+
+/**
+ * Merges the adjacent runs a and b from the front, with a copied to the
+ * scratch buffer. Ties go to a.
+ */
+static void merge_lo(TimSort *ts, void **a, size_t na, void **b, size_t nb)
+{
+    cmp_fn  cmp        = ts->cmp;
+    size_t  min_gallop = ts->min_gallop;
+    size_t  acount     = 0;
+    size_t  bcount     = 0;
+    bool    galloping  = false;
+    void  **pa         = ts->tmp;
+    void  **dest       = a;
+
+    memcpy(pa, a, na * sizeof(void*));
+
+    while (na > 0 && nb > 0) {
+        if (!galloping) {
+            if (LESS(b, pa)) {
+                *dest++ = *b++;
+                nb--;
+                bcount++;
+                acount = 0;
+            } else {
+                *dest++ = *pa++;
+                na--;
+                acount++;
+                bcount = 0;
+            }
+            galloping = acount >= min_gallop || bcount >= min_gallop;
+            continue;
+        }
+
+        size_t k = gallop(b, pa, na, true, false, cmp);
+        memcpy(dest, pa, k * sizeof(void*));
+        dest  += k;
+        pa    += k;
+        na    -= k;
+        acount = k;
+        if (na == 0)
+            break;
+
+        *dest++ = *b++;
+        if (--nb == 0)
+            break;
+
+        k = gallop(pa, b, nb, false, false, cmp);
+        memmove(dest, b, k * sizeof(void*));
+        dest  += k;
+        b     += k;
+        nb    -= k;
+        bcount = k;
+        if (nb == 0)
+            break;
+
+        *dest++ = *pa++;
+        na--;
+
+        if (acount >= MIN_GALLOP || bcount >= MIN_GALLOP) {
+            if (min_gallop > 1)
+                min_gallop--;
+        } else {
+            min_gallop++;
+            galloping = false;
+            acount    = 0;
+            bcount    = 0;
+        }
+    }
+    ts->min_gallop = min_gallop;
+
+    /* Whatever is left of b is already in place */
+    memcpy(dest, pa, na * sizeof(void*));
+}
+
+/**
+ * Merges the adjacent runs a and b from the back, with b copied to the
+ * scratch buffer. Ties go to a.
+ */
+static void merge_hi(TimSort *ts, void **a, size_t na, void **b, size_t nb)
+{
+    cmp_fn  cmp        = ts->cmp;
+    size_t  min_gallop = ts->min_gallop;
+    size_t  acount     = 0;
+    size_t  bcount     = 0;
+    bool    galloping  = false;
+    void  **tmp        = ts->tmp;
+
+    memcpy(tmp, b, nb * sizeof(void*));
+
+    /* The next free slot from the back is always a[na + nb - 1] */
+    while (na > 0 && nb > 0) {
+        if (!galloping) {
+            if (LESS(&tmp[nb - 1], &a[na - 1])) {
+                a[na + nb - 1] = a[na - 1];
+                na--;
+                acount++;
+                bcount = 0;
+            } else {
+                a[na + nb - 1] = tmp[nb - 1];
+                nb--;
+                bcount++;
+                acount = 0;
+            }
+            galloping = acount >= min_gallop || bcount >= min_gallop;
+            continue;
+        }
+
+        size_t k = na - gallop(&tmp[nb - 1], a, na, true, true, cmp);
+        memmove(&a[na + nb - k], &a[na - k], k * sizeof(void*));
+        na    -= k;
+        acount = k;
+        if (na == 0)
+            break;
+
+        a[na + nb - 1] = tmp[nb - 1];
+        if (--nb == 0)
+            break;
+
+        k = nb - gallop(&a[na - 1], tmp, nb, false, true, cmp);
+        memcpy(&a[na + nb - k], &tmp[nb - k], k * sizeof(void*));
+        nb    -= k;
+        bcount = k;
+        if (nb == 0)
+            break;
+
+        a[na + nb - 1] = a[na - 1];
+        na--;
+
+        if (acount >= MIN_GALLOP || bcount >= MIN_GALLOP) {
+            if (min_gallop > 1)
+                min_gallop--;
+        } else {
+            min_gallop++;
+            galloping = false;
+            acount    = 0;
+            bcount    = 0;
+        }
+    }
+    ts->min_gallop = min_gallop;
+
+    /* Whatever is left of a is already in place */
+    memcpy(a, tmp, nb * sizeof(void*));
+}
+
+/**
+ * Sorts the n pointers at base in ascending order of the uint64_t keys
+ * returned by key, with a least significant digit radix sort. The key of
+ * every element is computed once. Digits that are the same in all keys
+ * are skipped. The sort is stable.
+ *
+ * @param[in] base      the buffer that is being sorted
+ * @param[in] n         number of elements in the buffer
+ * @param[in] key       function that returns the key of an element
+ * @param[in] mem_alloc allocator of the scratch buffer
+ * @param[in] mem_free  deallocator of the scratch buffer
+ *
+ * @return CC_OK if the buffer was sorted, or CC_ERR_ALLOC if the scratch
+ * buffer couldn't be allocated, in which case the buffer is unchanged.
+ */
+enum cc_stat sort_radix_u64(void **base, size_t n,
+                            uint64_t (*key) (const void *element),
+                            void *(*mem_alloc) (size_t size),
+                            void  (*mem_free)  (void *block))
+{
+    if (n < 2)
+        return CC_OK;
+
+    if (n > SIZE_MAX / (2 * sizeof(Keyed)))
+        return CC_ERR_ALLOC;
+
+    Keyed *src = mem_alloc(2 * n * sizeof(Keyed));
+
+    if (!src)
+        return CC_ERR_ALLOC;
+
+    Keyed  *dst = src + n;
+    size_t  counts[RADIX_PASSES][RADIX_BUCKETS];
+    size_t  i;
+    int     pass;
+
+    memset(counts, 0, sizeof(counts));
+
+    /* Extract the keys and count the digits of all passes at once */
+    for (i = 0; i < n; i++) {
+        uint64_t k = key(base[i]);
+
+        src[i].key  = k;
+        src[i].elem = base[i];
+
+        for (pass = 0; pass < RADIX_PASSES; pass++)
+            counts[pass][(k >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+    }
+
+    for (pass = 0; pass < RADIX_PASSES; pass++) {
+        int     shift = pass * RADIX_BITS;
+        size_t *count = counts[pass];
+
+        if (count[(src[0].key >> shift) & (RADIX_BUCKETS - 1)] == n)
+            continue;
+
+        size_t offset = 0;
+        int    b;
+        for (b = 0; b < RADIX_BUCKETS; b++) {
+            size_t c = count[b];
+            count[b] = offset;
+            offset  += c;
+        }
+
+        for (i = 0; i < n; i++)
+            dst[count[(src[i].key >> shift) & (RADIX_BUCKETS - 1)]++] = src[i];
+
+        Keyed *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    for (i = 0; i < n; i++)
+        base[i] = src[i].elem;
+
+    mem_free(src < dst ? src : dst);
+
+    return CC_OK;
+}
@@ -0,0 +1,46 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2015 Srđan Panić <srdja.panic@gmail.com>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Sorting routines for buffers of pointers, shared by the containers that
+ * store their elements in a flat buffer. This header is internal to the
+ * library and isn't installed.
+ *
+ * Comparators are passed pointers to the buffer slots (void**), the same
+ * as with qsort(). */
+
+#ifndef COLLECTIONS_C_SORT_INTERNAL_H
+#define COLLECTIONS_C_SORT_INTERNAL_H
+
+#include "common.h"
+
+void          sort_pdq       (void **base, size_t n,
+                              int (*cmp) (const void*, const void*));
+
+enum cc_stat  sort_tim       (void **base, size_t n,
+                              int (*cmp) (const void*, const void*),
+                              void *(*mem_alloc) (size_t size),
+                              void  (*mem_free)  (void *block));
+
+enum cc_stat  sort_radix_u64 (void **base, size_t n,
+                              uint64_t (*key) (const void *element),
+                              void *(*mem_alloc) (size_t size),
+                              void  (*mem_free)  (void *block));
+
+#endif /* COLLECTIONS_C_SORT_INTERNAL_H */
@@ -0,0 +1,234 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2015 Srđan Panić <srdja.panic@gmail.com>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "thread_pool_internal.h"
+
+struct thread_pool_s {
+    pthread_mutex_t  lock;
+
+    /* Signalled when a job is posted or the pool shuts down */
+    pthread_cond_t   work;
+
+    /* Signalled when the last worker is done with a job */
+    pthread_cond_t   done;
+
+    /* The current job. The caller changes it only while all workers are
+     * idle, and the workers read it under the lock. */
+    uint64_t         generation;
+    bool             shutdown;
+    size_t           tasks;
+    void           (*fn) (size_t task, void *ctx);
+    void            *ctx;
+
+    atomic_size_t    next_task;
+
+    /* Workers that haven't finished the current job yet */
+    size_t           active;
+
+    size_t           n_workers;
+    pthread_t       *workers;
+
+    void           (*mem_free) (void *block);
+};
+
+static void *worker_main (void *arg);
+static void  run_tasks   (ThreadPool *pool);
+
+
+/**
+ * Creates a pool with the given number of worker threads. The calling
+ * thread of thread_pool_run() works on the jobs too, so a pool with n
+ * workers runs jobs on up to n + 1 threads. If some of the threads can't
+ * be created, the pool makes do with the ones that could.
+ *
+ * @param[in] workers   the number of worker threads
+ * @param[in] mem_alloc allocator of the pool
+ * @param[in] mem_free  deallocator of the pool
+ * @param[out] out      pointer to where the new pool is stored
+ *
+ * @return CC_OK if the pool was created, or CC_ERR_ALLOC if the memory
+ * allocation for the pool failed.
+ */
+enum cc_stat thread_pool_new(size_t workers,
+                             void *(*mem_alloc) (size_t size),
+                             void  (*mem_free)  (void *block),
+                             ThreadPool **out)
+{
+    ThreadPool *pool = mem_alloc(sizeof(ThreadPool));
+
+    if (!pool)
+        return CC_ERR_ALLOC;
+
+    pool->workers = workers ? mem_alloc(workers * sizeof(pthread_t)) : NULL;
+
+    if (workers && !pool->workers) {
+        mem_free(pool);
+        return CC_ERR_ALLOC;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    pool->generation = 0;
+    pool->shutdown   = false;
+    pool->tasks      = 0;
+    pool->fn         = NULL;
+    pool->ctx        = NULL;
+    pool->active     = 0;
+    pool->n_workers  = 0;
+    pool->mem_free   = mem_free;
+    atomic_init(&pool->next_task, 0);
+
+    while (pool->n_workers < workers) {
+        if (pthread_create(&pool->workers[pool->n_workers], NULL, worker_main, pool) != 0)
+            break;
+        pool->n_workers++;
+    }
+
+    *out = pool;
+    return CC_OK;
+}
+
+/**
+ * Stops the workers of the pool and frees it.
+ *
+ * @param[in] pool the pool that is being destroyed
+ */
+void thread_pool_destroy(ThreadPool *pool)
+{
+    size_t i;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 0; i < pool->n_workers; i++)
+        pthread_join(pool->workers[i], NULL);
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+
+    if (pool->workers)
+        pool->mem_free(pool->workers);
+    pool->mem_free(pool);
+}
+
+/**
+ * Runs fn(task, ctx) for every task in 0 .. tasks - 1 and returns once all
+ * of them are done. Tasks run in no particular order, and concurrently
+ * unless pool is NULL.
+ *
+ * @param[in] pool  the pool on which the tasks are run, or NULL
+ * @param[in] tasks the number of tasks
+ * @param[in] fn    the task function
+ * @param[in] ctx   argument passed to every call of fn
+ */
+void thread_pool_run(ThreadPool *pool, size_t tasks,
+                     void (*fn) (size_t task, void *ctx), void *ctx)
+{
+    if (!pool || pool->n_workers == 0 || tasks < 2) {
+        size_t i;
+        for (i = 0; i < tasks; i++)
+            fn(i, ctx);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->tasks  = tasks;
+    pool->fn     = fn;
+    pool->ctx    = ctx;
+    pool->active = pool->n_workers;
+    atomic_store_explicit(&pool->next_task, 0, memory_order_relaxed);
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_tasks(pool);
+
+    /* Wait for every worker to check in, not just for the tasks to be
+     * done, so that no worker is still looking at this job when the next
+     * one is posted */
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active > 0)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * Returns the number of online processors, or 1 if it can't be determined.
+ */
+size_t thread_pool_cpus(void)
+{
+#if defined(_SC_NPROCESSORS_ONLN)
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (size_t) cpus : 1;
+#else
+    return 1;
+#endif
+}
+
+/**
+ * Claims and runs tasks of the current job until there are none left.
+ */
+static void run_tasks(ThreadPool *pool)
+{
+    for (;;) {
+        size_t task = atomic_fetch_add_explicit(&pool->next_task, 1, memory_order_relaxed);
+
+        if (task >= pool->tasks)
+            return;
+
+        pool->fn(task, pool->ctx);
+    }
+}
+
+static void *worker_main(void *arg)
+{
+    ThreadPool *pool = arg;
+    uint64_t    seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->generation == seen && !pool->shutdown)
+            pthread_cond_wait(&pool->work, &pool->lock);
+
+        if (pool->shutdown)
+            break;
+
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_tasks(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active == 0)
+            pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
@@ -0,0 +1,48 @@
+/*
+ * Collections-C
+ * Copyright (C) 2013-2015 Srđan Panić <srdja.panic@gmail.com>
+ *
+ * This file is part of Collections-C.
+ *
+ * Collections-C is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Collections-C is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Collections-C. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A small fork-join thread pool for data parallel operations. This header
+ * is internal to the library and isn't installed.
+ *
+ * thread_pool_run() runs tasks 0 .. n - 1 of a job on the workers and the
+ * calling thread, which claim them one at a time, and returns once all of
+ * them are done. Everything written by the tasks is visible to the caller
+ * afterwards. A NULL pool runs the tasks on the calling thread. */
+
+#ifndef COLLECTIONS_C_THREAD_POOL_INTERNAL_H
+#define COLLECTIONS_C_THREAD_POOL_INTERNAL_H
+
+#include "common.h"
+
+typedef struct thread_pool_s ThreadPool;
+
+enum cc_stat  thread_pool_new      (size_t workers,
+                                    void *(*mem_alloc) (size_t size),
+                                    void  (*mem_free)  (void *block),
+                                    ThreadPool **out);
+void          thread_pool_destroy  (ThreadPool *pool);
+
+void          thread_pool_run      (ThreadPool *pool, size_t tasks,
+                                    void (*fn) (size_t task, void *ctx),
+                                    void *ctx);
+
+size_t        thread_pool_cpus     (void);
+
+#endif /* COLLECTIONS_C_THREAD_POOL_INTERNAL_H */
@@ -27,6 +27,9 @@ TEST_C_WRAPPER(ArrayTestsWithDefaults, ArrayZipIterRemove);
 TEST_C_WRAPPER(ArrayTestsWithDefaults, ArrayZipIterAdd);
 TEST_C_WRAPPER(ArrayTestsWithDefaults, ArrayZipIterReplace);
 TEST_C_WRAPPER(ArrayTestsWithDefaults, ArrayReduce);
+TEST_C_WRAPPER(ArrayTestsWithDefaults, ArraySortPatterns);
+TEST_C_WRAPPER(ArrayTestsWithDefaults, ArraySortStable);
+TEST_C_WRAPPER(ArrayTestsWithDefaults, ArraySortByKey);
 
 TEST_GROUP_C_WRAPPER(ArrayTestsArrayConf)
 {
@@ -36,6 +39,8 @@ TEST_GROUP_C_WRAPPER(ArrayTestsArrayConf)
 
 TEST_C_WRAPPER(ArrayTestsArrayConf, ArrayAddAt);
 TEST_C_WRAPPER(ArrayTestsArrayConf, ArrayCapacity);
+TEST_C_WRAPPER(ArrayTestsArrayConf, ArrayExpandRealloc);
+TEST_C_WRAPPER(ArrayTestsArrayConf, ArrayExpandMmap);
 
 TEST_GROUP_C_WRAPPER(ArrayTestsFilter)
 {
@@ -48,6 +53,17 @@ TEST_C_WRAPPER(ArrayTestsFilter, ArrayFilterMut2);
 TEST_C_WRAPPER(ArrayTestsFilter, ArrayFilter1);
 TEST_C_WRAPPER(ArrayTestsFilter, ArrayFilter2);
 
+TEST_GROUP_C_WRAPPER(ArrayTestsParallel)
+{
+  TEST_GROUP_C_SETUP_WRAPPER(ArrayTestsParallel);
+  TEST_GROUP_C_TEARDOWN_WRAPPER(ArrayTestsParallel);
+};
+
+TEST_C_WRAPPER(ArrayTestsParallel, ArrayParMap);
+TEST_C_WRAPPER(ArrayTestsParallel, ArrayParReduce);
+TEST_C_WRAPPER(ArrayTestsParallel, ArrayParFilter);
+TEST_C_WRAPPER(ArrayTestsParallel, ArrayParSort);
+
 int main(int argc, char **argv)
 {
   return RUN_ALL_TESTS(argc, argv);
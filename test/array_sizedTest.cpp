@@ -0,0 +1,20 @@
+#include "CppUTest/TestHarness_c.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+TEST_GROUP_C_WRAPPER(ArraySizedTests)
+{
+  TEST_GROUP_C_SETUP_WRAPPER(ArraySizedTests);
+  TEST_GROUP_C_TEARDOWN_WRAPPER(ArraySizedTests);
+};
+
+TEST_C_WRAPPER(ArraySizedTests, ArraySizedNew);
+TEST_C_WRAPPER(ArraySizedTests, ArraySizedAddGet);
+TEST_C_WRAPPER(ArraySizedTests, ArraySizedAddAtRemoveAt);
+TEST_C_WRAPPER(ArraySizedTests, ArraySizedCapacity);
+TEST_C_WRAPPER(ArraySizedTests, ArraySizedSort);
+TEST_C_WRAPPER(ArraySizedTests, ArraySizedMapReduceFilter);
+TEST_C_WRAPPER(ArraySizedTests, ArraySizedIter);
+
+int main(int argc, char **argv) {
+  return RUN_ALL_TESTS(argc, argv);
+}
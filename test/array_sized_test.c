@@ -0,0 +1,234 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "array_sized.h"
+#include "CppUTest/TestHarness_c.h"
+
+typedef struct {
+    uint64_t ts;
+    uint32_t len;
+    char     tag[4];
+} Record;
+
+static ArraySized *ar;
+static int stat;
+
+static Record record(uint64_t ts)
+{
+    Record r;
+    memset(&r, 0, sizeof(r));
+    r.ts  = ts;
+    r.len = (uint32_t) ts * 2;
+    memcpy(r.tag, "rec", 4);
+    return r;
+}
+
+static int cmp_ts(const void *a, const void *b)
+{
+    const Record *r1 = a;
+    const Record *r2 = b;
+
+    if (r1->ts < r2->ts)
+        return -1;
+    if (r1->ts > r2->ts)
+        return 1;
+    return 0;
+}
+
+static bool even_ts(const void *e)
+{
+    return ((const Record*) e)->ts % 2 == 0;
+}
+
+static void double_len(void *e)
+{
+    ((Record*) e)->len *= 2;
+}
+
+static void sum_ts(const void *a, const void *b, void *result)
+{
+    uint64_t sum = ((const Record*) a)->ts + (b ? ((const Record*) b)->ts : 0);
+    ((Record*) result)->ts = sum;
+}
+
+TEST_GROUP_C_SETUP(ArraySizedTests)
+{
+    stat = array_sized_new(sizeof(Record), &ar);
+};
+
+TEST_GROUP_C_TEARDOWN(ArraySizedTests)
+{
+    array_sized_destroy(ar);
+};
+
+TEST_C(ArraySizedTests, ArraySizedNew)
+{
+    ArraySized *bad;
+
+    CHECK_EQUAL_C_INT(CC_OK, stat);
+    CHECK_EQUAL_C_INT(sizeof(Record), array_sized_elem_size(ar));
+    CHECK_EQUAL_C_INT(CC_ERR_INVALID_CAPACITY, array_sized_new(0, &bad));
+};
+
+TEST_C(ArraySizedTests, ArraySizedAddGet)
+{
+    uint64_t i;
+    for (i = 0; i < 100; i++) {
+        Record r = record(i);
+        CHECK_EQUAL_C_INT(CC_OK, array_sized_add(ar, &r));
+    }
+    CHECK_EQUAL_C_INT(100, array_sized_size(ar));
+
+    for (i = 0; i < 100; i++) {
+        Record r;
+        CHECK_EQUAL_C_INT(CC_OK, array_sized_get_at(ar, i, &r));
+        CHECK_EQUAL_C_INT(i, r.ts);
+        CHECK_EQUAL_C_INT(i * 2, r.len);
+        CHECK_EQUAL_C_STRING("rec", r.tag);
+    }
+    Record r;
+    CHECK_EQUAL_C_INT(CC_ERR_OUT_OF_RANGE, array_sized_get_at(ar, 100, &r));
+
+    const Record *buf = array_sized_get_buffer(ar);
+    CHECK_EQUAL_C_INT(42, buf[42].ts);
+
+    Record *p;
+    array_sized_get_ptr_at(ar, 7, (void**) &p);
+    p->ts = 700;
+    array_sized_get_at(ar, 7, &r);
+    CHECK_EQUAL_C_INT(700, r.ts);
+
+    array_sized_get_last(ar, &r);
+    CHECK_EQUAL_C_INT(99, r.ts);
+};
+
+TEST_C(ArraySizedTests, ArraySizedAddAtRemoveAt)
+{
+    Record a = record(1);
+    Record b = record(2);
+    Record c = record(3);
+    Record r;
+
+    array_sized_add(ar, &a);
+    array_sized_add(ar, &c);
+    CHECK_EQUAL_C_INT(CC_OK, array_sized_add_at(ar, &b, 1));
+    CHECK_EQUAL_C_INT(CC_ERR_OUT_OF_RANGE, array_sized_add_at(ar, &b, 5));
+
+    array_sized_get_at(ar, 1, &r);
+    CHECK_EQUAL_C_INT(2, r.ts);
+    array_sized_get_at(ar, 2, &r);
+    CHECK_EQUAL_C_INT(3, r.ts);
+
+    CHECK_EQUAL_C_INT(CC_OK, array_sized_remove_at(ar, 0, &r));
+    CHECK_EQUAL_C_INT(1, r.ts);
+    CHECK_EQUAL_C_INT(2, array_sized_size(ar));
+
+    CHECK_EQUAL_C_INT(CC_OK, array_sized_replace_at(ar, &a, 1, &r));
+    CHECK_EQUAL_C_INT(3, r.ts);
+
+    CHECK_EQUAL_C_INT(CC_OK, array_sized_swap_at(ar, 0, 1));
+    array_sized_get_at(ar, 0, &r);
+    CHECK_EQUAL_C_INT(1, r.ts);
+
+    size_t index;
+    CHECK_EQUAL_C_INT(CC_OK, array_sized_index_of(ar, &b, &index));
+    CHECK_EQUAL_C_INT(1, index);
+
+    CHECK_EQUAL_C_INT(CC_OK, array_sized_remove_last(ar, &r));
+    CHECK_EQUAL_C_INT(2, r.ts);
+    array_sized_remove_all(ar);
+    CHECK_EQUAL_C_INT(CC_ERR_VALUE_NOT_FOUND, array_sized_get_last(ar, &r));
+};
+
+TEST_C(ArraySizedTests, ArraySizedCapacity)
+{
+    CHECK_EQUAL_C_INT(CC_OK, array_sized_reserve(ar, 1000));
+    CHECK_EQUAL_C_INT(1000, array_sized_capacity(ar));
+
+    Record r = record(5);
+    array_sized_add(ar, &r);
+    CHECK_EQUAL_C_INT(CC_OK, array_sized_trim_capacity(ar));
+    CHECK_EQUAL_C_INT(1, array_sized_capacity(ar));
+
+    array_sized_add(ar, &r);
+    CHECK_EQUAL_C_INT(2, array_sized_capacity(ar));
+    CHECK_EQUAL_C_INT(CC_ERR_MAX_CAPACITY, array_sized_reserve(ar, (size_t) -1));
+};
+
+TEST_C(ArraySizedTests, ArraySizedSort)
+{
+    uint64_t i;
+    for (i = 0; i < 200; i++) {
+        Record r = record((i * 7919) % 200);
+        array_sized_add(ar, &r);
+    }
+    array_sized_sort(ar, cmp_ts);
+
+    for (i = 0; i < 200; i++) {
+        Record r;
+        array_sized_get_at(ar, i, &r);
+        CHECK_EQUAL_C_INT(i, r.ts);
+        CHECK_EQUAL_C_INT(i * 2, r.len);
+    }
+};
+
+TEST_C(ArraySizedTests, ArraySizedMapReduceFilter)
+{
+    uint64_t i;
+    for (i = 1; i <= 10; i++) {
+        Record r = record(i);
+        array_sized_add(ar, &r);
+    }
+    array_sized_map(ar, double_len);
+
+    Record r;
+    array_sized_get_at(ar, 4, &r);
+    CHECK_EQUAL_C_INT(20, r.len);
+
+    Record sum;
+    array_sized_reduce(ar, sum_ts, &sum);
+    CHECK_EQUAL_C_INT(55, sum.ts);
+
+    CHECK_EQUAL_C_INT(CC_OK, array_sized_filter_mut(ar, even_ts));
+    CHECK_EQUAL_C_INT(5, array_sized_size(ar));
+    for (i = 0; i < 5; i++) {
+        array_sized_get_at(ar, i, &r);
+        CHECK_EQUAL_C_INT((i + 1) * 2, r.ts);
+    }
+};
+
+TEST_C(ArraySizedTests, ArraySizedIter)
+{
+    uint64_t i;
+    for (i = 0; i < 10; i++) {
+        Record r = record(i);
+        array_sized_add(ar, &r);
+    }
+
+    ArraySizedIter iter;
+    Record         r;
+    Record         repl = record(100);
+
+    array_sized_iter_init(&iter, ar);
+    i = 0;
+    while (array_sized_iter_next(&iter, &r) != CC_ITER_END) {
+        CHECK_EQUAL_C_INT(i, r.ts);
+        if (r.ts % 3 == 0)
+            CHECK_EQUAL_C_INT(CC_OK, array_sized_iter_remove(&iter, NULL));
+        else if (r.ts == 5)
+            array_sized_iter_replace(&iter, &repl, NULL);
+        i++;
+    }
+    CHECK_EQUAL_C_INT(10, i);
+    CHECK_EQUAL_C_INT(6, array_sized_size(ar));
+
+    Record *p;
+    uint64_t sum = 0;
+    array_sized_iter_init(&iter, ar);
+    while (array_sized_iter_next_ptr(&iter, (void**) &p) != CC_ITER_END)
+        sum += p->ts;
+
+    /* 1 + 2 + 4 + 100 + 7 + 8 */
+    CHECK_EQUAL_C_INT(122, sum);
+};
@@ -360,6 +360,103 @@ TEST_C(ArrayTestsWithDefaults, ArraySort)
     }
 };
 
+#define SORT_SIZE 5000
+
+static int sort_vals[SORT_SIZE];
+
+static void check_sorted(Array *ar, size_t n)
+{
+    size_t i;
+    int *prev;
+    int *e;
+
+    CHECK_EQUAL_C_INT(n, array_size(ar));
+    array_get_at(ar, 0, (void**) &prev);
+    for (i = 1; i < n; i++) {
+        array_get_at(ar, i, (void**) &e);
+        CHECK_C(*prev <= *e);
+        prev = e;
+    }
+}
+
+TEST_C(ArrayTestsWithDefaults, ArraySortPatterns)
+{
+    int pattern;
+    int i;
+
+    for (pattern = 0; pattern < 5; pattern++) {
+        array_remove_all(v1);
+
+        for (i = 0; i < SORT_SIZE; i++) {
+            switch (pattern) {
+            case 0: sort_vals[i] = rand();                   break;
+            case 1: sort_vals[i] = i;                        break;
+            case 2: sort_vals[i] = SORT_SIZE - i;            break;
+            case 3: sort_vals[i] = rand() % 3;               break;
+            case 4: sort_vals[i] = i < SORT_SIZE - 10 ? i : rand() % SORT_SIZE; break;
+            }
+            array_add(v1, &sort_vals[i]);
+        }
+        array_sort(v1, comp);
+        check_sorted(v1, SORT_SIZE);
+    }
+};
+
+static void check_stable(Array *ar)
+{
+    size_t i;
+    int *prev;
+    int *e;
+
+    array_get_at(ar, 0, (void**) &prev);
+    for (i = 1; i < array_size(ar); i++) {
+        array_get_at(ar, i, (void**) &e);
+        if (*prev == *e)
+            CHECK_C(prev < e);
+        prev = e;
+    }
+}
+
+TEST_C(ArrayTestsWithDefaults, ArraySortStable)
+{
+    int pattern;
+    int i;
+
+    for (pattern = 0; pattern < 4; pattern++) {
+        array_remove_all(v1);
+
+        for (i = 0; i < SORT_SIZE; i++) {
+            switch (pattern) {
+            case 0: sort_vals[i] = rand() % 100;                      break;
+            case 1: sort_vals[i] = i / 10;                            break;
+            case 2: sort_vals[i] = (SORT_SIZE - i) / 10;              break;
+            case 3: sort_vals[i] = i < SORT_SIZE - 10 ? i / 3 : rand() % 100; break;
+            }
+            array_add(v1, &sort_vals[i]);
+        }
+        CHECK_EQUAL_C_INT(CC_OK, array_sort_stable(v1, comp));
+        check_sorted(v1, SORT_SIZE);
+        check_stable(v1);
+    }
+};
+
+static uint64_t int_key(const void *e)
+{
+    return (uint64_t) *(const int*) e ^ (1ULL << 63);
+}
+
+TEST_C(ArrayTestsWithDefaults, ArraySortByKey)
+{
+    int i;
+    for (i = 0; i < SORT_SIZE; i++) {
+        sort_vals[i] = rand() % 1000 - 500;
+        array_add(v1, &sort_vals[i]);
+    }
+    CHECK_EQUAL_C_INT(CC_OK, array_sort_by_key(v1, int_key));
+    check_sorted(v1, SORT_SIZE);
+    check_stable(v1);
+};
+
 TEST_C(ArrayTestsWithDefaults, ArrayIterRemove)
 {
     int a = 5;
@@ -700,6 +797,80 @@ TEST_C(ArrayTestsArrayConf, ArrayCapacity)
     CHECK_EQUAL_C_INT(2, array_capacity(v2));
 };
 
+TEST_C(ArrayTestsArrayConf, ArrayExpandRealloc)
+{
+    ArrayConf c;
+    Array    *ar;
+    int       vals[1000];
+    int       i;
+
+    array_conf_init(&c);
+    c.capacity    = 1;
+    c.mem_realloc = realloc;
+    array_new_conf(&c, &ar);
+
+    for (i = 0; i < 1000; i++) {
+        vals[i] = i;
+        CHECK_EQUAL_C_INT(CC_OK, array_add(ar, &vals[i]));
+    }
+    CHECK_EQUAL_C_INT(1024, array_capacity(ar));
+
+    CHECK_EQUAL_C_INT(CC_OK, array_trim_capacity(ar));
+    CHECK_EQUAL_C_INT(1000, array_capacity(ar));
+
+    for (i = 0; i < 1000; i++) {
+        int *e;
+        array_get_at(ar, i, (void**) &e);
+        CHECK_EQUAL_C_POINTER(&vals[i], e);
+    }
+    array_destroy(ar);
+};
+
+TEST_C(ArrayTestsArrayConf, ArrayExpandMmap)
+{
+    ArrayConf c;
+    Array    *ar;
+    Array    *copy;
+    int       vals[100000];
+    int       i;
+
+    array_conf_init(&c);
+    c.mmap_threshold = 4096;
+    array_new_conf(&c, &ar);
+
+    for (i = 0; i < 100000; i++) {
+        vals[i] = i;
+        CHECK_EQUAL_C_INT(CC_OK, array_add(ar, &vals[i]));
+    }
+#if !defined(_WIN32)
+    /* mapped buffers stay aligned to 2MB as they grow */
+    CHECK_EQUAL_C_INT(0, (uintptr_t) array_get_buffer(ar) % (2 * 1024 * 1024));
+#endif
+
+    CHECK_EQUAL_C_INT(CC_OK, array_trim_capacity(ar));
+    CHECK_EQUAL_C_INT(100000, array_capacity(ar));
+
+    CHECK_EQUAL_C_INT(CC_OK, array_copy_shallow(ar, &copy));
+
+    for (i = 0; i < 100000; i++) {
+        int *e;
+        array_get_at(ar, i, (void**) &e);
+        CHECK_EQUAL_C_POINTER(&vals[i], e);
+        array_get_at(copy, i, (void**) &e);
+        CHECK_EQUAL_C_POINTER(&vals[i], e);
+    }
+
+    /* mapped buffers stay mapped when they shrink */
+    array_remove_all(ar);
+    CHECK_EQUAL_C_INT(CC_OK, array_trim_capacity(ar));
+    CHECK_EQUAL_C_INT(1, array_capacity(ar));
+    CHECK_EQUAL_C_INT(CC_OK, array_add(ar, &vals[0]));
+    CHECK_EQUAL_C_INT(CC_OK, array_add(ar, &vals[1]));
+
+    array_destroy(copy);
+    array_destroy(ar);
+};
+
 TEST_GROUP_C_SETUP(ArrayTestsFilter)
 {
     array_new(&v1);
@@ -776,3 +947,94 @@ TEST_C(ArrayTestsFilter, ArrayFilter2)
 
     array_destroy(v2);
 };
+
+#define PAR_SIZE 10000
+
+static ArrayParConf pc;
+static int par_vals[PAR_SIZE];
+
+TEST_GROUP_C_SETUP(ArrayTestsParallel)
+{
+    array_new(&v1);
+
+    int i;
+    for (i = 0; i < PAR_SIZE; i++) {
+        par_vals[i] = (i * 7919) % PAR_SIZE;
+        array_add(v1, &par_vals[i]);
+    }
+
+    array_par_conf_init(&pc);
+    pc.threads = 4;
+    pc.grain   = 100;
+};
+
+TEST_GROUP_C_TEARDOWN(ArrayTestsParallel)
+{
+    array_destroy(v1);
+};
+
+static void par_double(void *e)
+{
+    *(int*) e *= 2;
+}
+
+static void par_add(void *acc, void *e)
+{
+    *(long*) acc += *(int*) e;
+}
+
+static void par_combine(void *acc, const void *part)
+{
+    *(long*) acc += *(const long*) part;
+}
+
+TEST_C(ArrayTestsParallel, ArrayParMap)
+{
+    array_par_map(v1, par_double, &pc);
+
+    int i;
+    for (i = 0; i < PAR_SIZE; i++)
+        CHECK_EQUAL_C_INT(((i * 7919) % PAR_SIZE) * 2, par_vals[i]);
+};
+
+TEST_C(ArrayTestsParallel, ArrayParReduce)
+{
+    long sum = 0;
+
+    CHECK_EQUAL_C_INT(CC_OK, array_par_reduce(v1, par_add, par_combine, &sum, sizeof(sum), &pc));
+    CHECK_EQUAL_C_INT((long) PAR_SIZE * (PAR_SIZE - 1) / 2, sum);
+};
+
+TEST_C(ArrayTestsParallel, ArrayParFilter)
+{
+    CHECK_EQUAL_C_INT(CC_OK, array_par_filter(v1, pred1, &pc, &v2));
+    CHECK_EQUAL_C_INT(1, array_size(v2));
+    array_destroy(v2);
+
+    CHECK_EQUAL_C_INT(CC_OK, array_par_filter(v1, pred2, &pc, &v2));
+    CHECK_EQUAL_C_INT(PAR_SIZE - 1, array_size(v2));
+
+    /* the order of the elements is kept */
+    int *prev;
+    int *e;
+    size_t i;
+    array_get_at(v2, 0, (void**) &prev);
+    for (i = 1; i < array_size(v2); i++) {
+        array_get_at(v2, i, (void**) &e);
+        CHECK_C(prev < e);
+        prev = e;
+    }
+    array_destroy(v2);
+};
+
+TEST_C(ArrayTestsParallel, ArrayParSort)
+{
+    CHECK_EQUAL_C_INT(CC_OK, array_par_sort(v1, comp, &pc));
+
+    int i;
+    for (i = 0; i < PAR_SIZE; i++) {
+        int *e;
+        array_get_at(v1, i, (void**) &e);
+        CHECK_EQUAL_C_INT(i, *e);
+    }
+};
@@ -0,0 +1,29 @@
+#include "CppUTest/TestHarness_c.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+TEST_GROUP_C_WRAPPER(ConcurrentHashTableTests)
+{
+  TEST_GROUP_C_SETUP_WRAPPER(ConcurrentHashTableTests);
+  TEST_GROUP_C_TEARDOWN_WRAPPER(ConcurrentHashTableTests);
+};
+
+TEST_GROUP_C_WRAPPER(ConcurrentHashTableLockFree)
+{
+  TEST_GROUP_C_SETUP_WRAPPER(ConcurrentHashTableLockFree);
+  TEST_GROUP_C_TEARDOWN_WRAPPER(ConcurrentHashTableLockFree);
+};
+
+TEST_C_WRAPPER(ConcurrentHashTableTests, ConcurrentHashTableNew);
+TEST_C_WRAPPER(ConcurrentHashTableTests, ConcurrentHashTableAddGetRemove);
+TEST_C_WRAPPER(ConcurrentHashTableTests, ConcurrentHashTableNullKey);
+TEST_C_WRAPPER(ConcurrentHashTableTests, ConcurrentHashTableGrow);
+TEST_C_WRAPPER(ConcurrentHashTableTests, ConcurrentHashTableForeach);
+TEST_C_WRAPPER(ConcurrentHashTableTests, ConcurrentHashTableParallelAdd);
+TEST_C_WRAPPER(ConcurrentHashTableTests, ConcurrentHashTableParallelUpsert);
+TEST_C_WRAPPER(ConcurrentHashTableTests, ConcurrentHashTableParallelChurn);
+TEST_C_WRAPPER(ConcurrentHashTableLockFree, ConcurrentHashTableLockFreeAddGetRemove);
+TEST_C_WRAPPER(ConcurrentHashTableLockFree, ConcurrentHashTableLockFreeReadersDuringWrites);
+
+int main(int argc, char **argv) {
+  return RUN_ALL_TESTS(argc, argv);
+}
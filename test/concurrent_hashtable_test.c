@@ -0,0 +1,331 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include "concurrent_hashtable.h"
+#include "CppUTest/TestHarness_c.h"
+
+#define THREADS     8
+#define PER_THREAD  5000
+
+static ConcurrentHashTableConf conf;
+static ConcurrentHashTable *table;
+static int stat;
+
+static int cmp_ptr(const void *k1, const void *k2)
+{
+    return k1 == k2 ? 0 : 1;
+}
+
+#define KEY(i) ((void*) (uintptr_t) ((i) + 1))
+
+TEST_GROUP_C_SETUP(ConcurrentHashTableTests)
+{
+    concurrent_hashtable_conf_init(&conf);
+    conf.hash        = WY_POINTER_HASH;
+    conf.key_compare = cmp_ptr;
+    conf.key_length  = KEY_LENGTH_POINTER;
+    conf.stripes     = 4;
+
+    stat = concurrent_hashtable_new_conf(&conf, &table);
+};
+
+TEST_GROUP_C_TEARDOWN(ConcurrentHashTableTests)
+{
+    concurrent_hashtable_destroy(table);
+};
+
+TEST_C(ConcurrentHashTableTests, ConcurrentHashTableNew)
+{
+    ConcurrentHashTable *t;
+
+    CHECK_EQUAL_C_INT(CC_OK, stat);
+    CHECK_EQUAL_C_INT(0, concurrent_hashtable_size(table));
+    CHECK_EQUAL_C_INT(4, concurrent_hashtable_stripes(table));
+
+    /* the capacity is never below the stripe count */
+    conf.stripes = 100;
+    CHECK_EQUAL_C_INT(CC_OK, concurrent_hashtable_new_conf(&conf, &t));
+    CHECK_EQUAL_C_INT(128, concurrent_hashtable_stripes(t));
+    CHECK_EQUAL_C_INT(128, concurrent_hashtable_capacity(t));
+    concurrent_hashtable_destroy(t);
+};
+
+TEST_C(ConcurrentHashTableTests, ConcurrentHashTableAddGetRemove)
+{
+    void *v;
+
+    CHECK_EQUAL_C_INT(CC_OK, concurrent_hashtable_add(table, KEY(1), "a"));
+    CHECK_EQUAL_C_INT(CC_OK, concurrent_hashtable_add(table, KEY(2), "b"));
+    CHECK_EQUAL_C_INT(CC_OK, concurrent_hashtable_add(table, KEY(1), "c"));
+    CHECK_EQUAL_C_INT(2, concurrent_hashtable_size(table));
+
+    CHECK_EQUAL_C_INT(CC_OK, concurrent_hashtable_get(table, KEY(1), &v));
+    CHECK_EQUAL_C_STRING("c", (char*) v);
+    CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND, concurrent_hashtable_get(table, KEY(3), &v));
+
+    CHECK_EQUAL_C_INT(CC_OK, concurrent_hashtable_remove(table, KEY(2), &v));
+    CHECK_EQUAL_C_STRING("b", (char*) v);
+    CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND, concurrent_hashtable_remove(table, KEY(2), &v));
+    CHECK_C(!concurrent_hashtable_contains_key(table, KEY(2)));
+    CHECK_EQUAL_C_INT(1, concurrent_hashtable_size(table));
+};
+
+TEST_C(ConcurrentHashTableTests, ConcurrentHashTableNullKey)
+{
+    void *v;
+
+    CHECK_EQUAL_C_INT(CC_OK, concurrent_hashtable_add(table, NULL, "null"));
+    CHECK_EQUAL_C_INT(CC_OK, concurrent_hashtable_get(table, NULL, &v));
+    CHECK_EQUAL_C_STRING("null", (char*) v);
+    CHECK_EQUAL_C_INT(CC_OK, concurrent_hashtable_remove(table, NULL, NULL));
+    CHECK_EQUAL_C_INT(0, concurrent_hashtable_size(table));
+};
+
+TEST_C(ConcurrentHashTableTests, ConcurrentHashTableGrow)
+{
+    size_t i;
+    void  *v;
+
+    for (i = 0; i < 10000; i++)
+        concurrent_hashtable_add(table, KEY(i), KEY(i * 2));
+
+    CHECK_EQUAL_C_INT(10000, concurrent_hashtable_size(table));
+    CHECK_C(concurrent_hashtable_capacity(table) >= 8192);
+
+    for (i = 0; i < 10000; i++) {
+        CHECK_EQUAL_C_INT(CC_OK, concurrent_hashtable_get(table, KEY(i), &v));
+        CHECK_EQUAL_C_POINTER(KEY(i * 2), v);
+    }
+
+    concurrent_hashtable_remove_all(table);
+    CHECK_EQUAL_C_INT(0, concurrent_hashtable_size(table));
+    CHECK_C(!concurrent_hashtable_contains_key(table, KEY(5)));
+};
+
+static size_t foreach_count;
+
+static void count_key(const void *key)
+{
+    foreach_count += (uintptr_t) key;
+}
+
+TEST_C(ConcurrentHashTableTests, ConcurrentHashTableForeach)
+{
+    size_t i;
+
+    for (i = 0; i < 100; i++)
+        concurrent_hashtable_add(table, KEY(i), NULL);
+
+    foreach_count = 0;
+    concurrent_hashtable_foreach_key(table, count_key);
+    CHECK_EQUAL_C_INT(5050, foreach_count);
+};
+
+static void *insert_range(void *arg)
+{
+    size_t id = (uintptr_t) arg;
+    size_t i;
+
+    for (i = id * PER_THREAD; i < (id + 1) * PER_THREAD; i++)
+        concurrent_hashtable_add(table, KEY(i), KEY(i));
+
+    return NULL;
+}
+
+TEST_C(ConcurrentHashTableTests, ConcurrentHashTableParallelAdd)
+{
+    pthread_t threads[THREADS];
+    size_t    i;
+    void     *v;
+
+    for (i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, insert_range, (void*) (uintptr_t) i);
+    for (i = 0; i < THREADS; i++)
+        pthread_join(threads[i], NULL);
+
+    CHECK_EQUAL_C_INT(THREADS * PER_THREAD, concurrent_hashtable_size(table));
+
+    for (i = 0; i < THREADS * PER_THREAD; i++) {
+        CHECK_EQUAL_C_INT(CC_OK, concurrent_hashtable_get(table, KEY(i), &v));
+        CHECK_EQUAL_C_POINTER(KEY(i), v);
+    }
+};
+
+static void *increment(void *value, bool exists, void *ctx)
+{
+    return (void*) ((uintptr_t) value + 1);
+}
+
+static void *count_up(void *arg)
+{
+    size_t i;
+
+    for (i = 0; i < PER_THREAD; i++)
+        concurrent_hashtable_upsert(table, KEY(i % 100), increment, NULL);
+
+    return NULL;
+}
+
+TEST_C(ConcurrentHashTableTests, ConcurrentHashTableParallelUpsert)
+{
+    pthread_t threads[THREADS];
+    size_t    i;
+    void     *v;
+
+    for (i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, count_up, NULL);
+    for (i = 0; i < THREADS; i++)
+        pthread_join(threads[i], NULL);
+
+    CHECK_EQUAL_C_INT(100, concurrent_hashtable_size(table));
+
+    for (i = 0; i < 100; i++) {
+        concurrent_hashtable_get(table, KEY(i), &v);
+        CHECK_EQUAL_C_INT(THREADS * PER_THREAD / 100, (uintptr_t) v);
+    }
+};
+
+static void *churn(void *arg)
+{
+    size_t id = (uintptr_t) arg;
+    size_t i;
+
+    for (i = id * PER_THREAD; i < (id + 1) * PER_THREAD; i++) {
+        concurrent_hashtable_add(table, KEY(i), KEY(i));
+        if (i % 2)
+            concurrent_hashtable_remove(table, KEY(i - 1), NULL);
+    }
+    return NULL;
+}
+
+TEST_C(ConcurrentHashTableTests, ConcurrentHashTableParallelChurn)
+{
+    pthread_t threads[THREADS];
+    size_t    i;
+
+    for (i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, churn, (void*) (uintptr_t) i);
+    for (i = 0; i < THREADS; i++)
+        pthread_join(threads[i], NULL);
+
+    CHECK_EQUAL_C_INT(THREADS * PER_THREAD / 2, concurrent_hashtable_size(table));
+
+    for (i = 0; i < THREADS * PER_THREAD; i++)
+        CHECK_EQUAL_C_INT(i % 2, concurrent_hashtable_contains_key(table, KEY(i)));
+};
+
+TEST_GROUP_C_SETUP(ConcurrentHashTableLockFree)
+{
+    concurrent_hashtable_conf_init(&conf);
+    conf.hash            = WY_POINTER_HASH;
+    conf.key_compare     = cmp_ptr;
+    conf.key_length      = KEY_LENGTH_POINTER;
+    conf.stripes         = 4;
+    conf.lock_free_reads = true;
+
+    stat = concurrent_hashtable_new_conf(&conf, &table);
+};
+
+TEST_GROUP_C_TEARDOWN(ConcurrentHashTableLockFree)
+{
+    concurrent_hashtable_destroy(table);
+};
+
+TEST_C(ConcurrentHashTableLockFree, ConcurrentHashTableLockFreeAddGetRemove)
+{
+    size_t i;
+    void  *v;
+
+    CHECK_EQUAL_C_INT(CC_OK, stat);
+
+    for (i = 0; i < 10000; i++)
+        concurrent_hashtable_add(table, KEY(i), KEY(i * 2));
+
+    concurrent_hashtable_add(table, KEY(7), "seven");
+
+    for (i = 0; i < 10000; i += 2)
+        CHECK_EQUAL_C_INT(CC_OK, concurrent_hashtable_remove(table, KEY(i), NULL));
+
+    CHECK_EQUAL_C_INT(5000, concurrent_hashtable_size(table));
+
+    for (i = 0; i < 10000; i++) {
+        if (i % 2 == 0) {
+            CHECK_C(!concurrent_hashtable_contains_key(table, KEY(i)));
+        } else if (i != 7) {
+            CHECK_EQUAL_C_INT(CC_OK, concurrent_hashtable_get(table, KEY(i), &v));
+            CHECK_EQUAL_C_POINTER(KEY(i * 2), v);
+        }
+    }
+    concurrent_hashtable_get(table, KEY(7), &v);
+    CHECK_EQUAL_C_STRING("seven", (char*) v);
+
+    concurrent_hashtable_remove_all(table);
+    CHECK_EQUAL_C_INT(0, concurrent_hashtable_size(table));
+    CHECK_C(!concurrent_hashtable_contains_key(table, KEY(1)));
+};
+
+#define STABLE_KEYS 256
+
+static atomic_int writers_done;
+static atomic_int misses;
+
+static void *read_stable(void *arg)
+{
+    size_t i = 0;
+    void  *v;
+
+    while (!atomic_load(&writers_done)) {
+        size_t k = i++ % STABLE_KEYS;
+
+        if (concurrent_hashtable_get(table, KEY(k), &v) != CC_OK || v != KEY(k))
+            atomic_fetch_add(&misses, 1);
+    }
+    return NULL;
+}
+
+static void *write_churn(void *arg)
+{
+    size_t id = (uintptr_t) arg;
+    size_t i;
+
+    for (i = 0; i < PER_THREAD; i++) {
+        size_t k = STABLE_KEYS + id * PER_THREAD + i;
+
+        concurrent_hashtable_add(table, KEY(k), KEY(k));
+        if (i % 4 != 0)
+            concurrent_hashtable_remove(table, KEY(k), NULL);
+    }
+    return NULL;
+}
+
+TEST_C(ConcurrentHashTableLockFree, ConcurrentHashTableLockFreeReadersDuringWrites)
+{
+    pthread_t readers[THREADS / 2];
+    pthread_t writers[THREADS / 2];
+    size_t    i;
+
+    for (i = 0; i < STABLE_KEYS; i++)
+        concurrent_hashtable_add(table, KEY(i), KEY(i));
+
+    atomic_store(&writers_done, 0);
+    atomic_store(&misses, 0);
+
+    for (i = 0; i < THREADS / 2; i++)
+        pthread_create(&readers[i], NULL, read_stable, NULL);
+    for (i = 0; i < THREADS / 2; i++)
+        pthread_create(&writers[i], NULL, write_churn, (void*) (uintptr_t) i);
+
+    for (i = 0; i < THREADS / 2; i++)
+        pthread_join(writers[i], NULL);
+
+    atomic_store(&writers_done, 1);
+
+    for (i = 0; i < THREADS / 2; i++)
+        pthread_join(readers[i], NULL);
+
+    /* the table grew while the readers were running */
+    CHECK_C(concurrent_hashtable_capacity(table) >= 1024);
+    CHECK_EQUAL_C_INT(0, atomic_load(&misses));
+    CHECK_EQUAL_C_INT(STABLE_KEYS + THREADS / 2 * PER_THREAD / 4,
+                      concurrent_hashtable_size(table));
+};
@@ -49,6 +49,7 @@ TEST_GROUP_C_WRAPPER(DequeTestsConf)
 };
 
 TEST_C_WRAPPER(DequeTestsConf, DequeBufferExpansion);
+TEST_C_WRAPPER(DequeTestsConf, DequeBufferExpansionRealloc);
 
 int main(int argc, char **argv) {
   return RUN_ALL_TESTS(argc, argv);
@@ -884,6 +884,56 @@ TEST_C(DequeTestsConf, DequeBufferExpansion)
     CHECK_EQUAL_C_INT(elem5, f);
 };
 
+TEST_C(DequeTestsConf, DequeBufferExpansionRealloc)
+{
+    DequeConf c;
+    Deque    *d;
+    int       vals[200];
+    int       i;
+
+    deque_conf_init(&c);
+    c.capacity    = 4;
+    c.mem_realloc = realloc;
+    deque_new_conf(&c, &d);
+
+    /* Alternate between short and long wrapped around parts so that
+     * both halves get moved on expansion. The deque ends up holding
+     * 199, 197 ... 1, 0, 2 ... 198 */
+    for (i = 0; i < 200; i++) {
+        vals[i] = i;
+        if (i % 2)
+            deque_add_first(d, &vals[i]);
+        else
+            deque_add_last(d, &vals[i]);
+    }
+    CHECK_EQUAL_C_INT(200, deque_size(d));
+    CHECK_EQUAL_C_INT(256, deque_capacity(d));
+
+    for (i = 0; i < 200; i++) {
+        int *e;
+        int  expect = i < 100 ? 199 - 2 * i : 2 * (i - 100);
+        deque_get_at(d, i, (void**) &e);
+        CHECK_EQUAL_C_INT(expect, *e);
+    }
+    deque_destroy(d);
+
+    /* A full deque with the first element near the end of the buffer */
+    deque_new_conf(&c, &d);
+    deque_add_last(d, &vals[0]);
+    deque_add_last(d, &vals[1]);
+    deque_add_last(d, &vals[2]);
+    deque_add_first(d, &vals[3]);
+    deque_add_last(d, &vals[4]);
+
+    int expect[] = {3, 0, 1, 2, 4};
+    for (i = 0; i < 5; i++) {
+        int *e;
+        deque_get_at(d, i, (void**) &e);
+        CHECK_EQUAL_C_INT(expect[i], *e);
+    }
+    deque_destroy(d);
+};
+
 TEST_C(DequeTests, DequeFilter1)
 {
     int a = 1;
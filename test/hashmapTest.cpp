@@ -0,0 +1,32 @@
+#include "CppUTest/TestHarness_c.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+TEST_GROUP_C_WRAPPER(HashMapTests)
+{
+  TEST_GROUP_C_SETUP_WRAPPER(HashMapTests);
+  TEST_GROUP_C_TEARDOWN_WRAPPER(HashMapTests);
+};
+
+TEST_GROUP_C_WRAPPER(HashMapTestsConf)
+{
+  TEST_GROUP_C_SETUP_WRAPPER(HashMapTestsConf);
+  TEST_GROUP_C_TEARDOWN_WRAPPER(HashMapTestsConf);
+};
+
+TEST_C_WRAPPER(HashMapTests, HashMapNew);
+TEST_C_WRAPPER(HashMapTests, HashMapAddGet);
+TEST_C_WRAPPER(HashMapTests, HashMapGetOrAdd);
+TEST_C_WRAPPER(HashMapTests, HashMapAddMany);
+TEST_C_WRAPPER(HashMapTests, HashMapRemove);
+TEST_C_WRAPPER(HashMapTests, HashMapRemoveAll);
+TEST_C_WRAPPER(HashMapTests, HashMapChurn);
+TEST_C_WRAPPER(HashMapTests, HashMapReserve);
+TEST_C_WRAPPER(HashMapTests, HashMapIter);
+TEST_C_WRAPPER(HashMapTests, HashMapIterRemove);
+TEST_C_WRAPPER(HashMapTests, HashMapStringKeys);
+TEST_C_WRAPPER(HashMapTests, HashMapCollisions);
+TEST_C_WRAPPER(HashMapTestsConf, HashMapNewConf);
+
+int main(int argc, char **argv) {
+  return RUN_ALL_TESTS(argc, argv);
+}
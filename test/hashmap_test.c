@@ -0,0 +1,286 @@
+#include <stdio.h>
+#include <string.h>
+#include "hashmap.h"
+#include "CppUTest/TestHarness_c.h"
+
+#define INT_EQ(a, b) ((a) == (b))
+
+static INLINE size_t str_hash(const char *s)
+{
+    size_t h = 5381;
+    while (*s)
+        h = h * 33 + (unsigned char) *s++;
+    return cc_hashmap_hash_u64(h);
+}
+
+static INLINE bool str_eq(const char *a, const char *b)
+{
+    return strcmp(a, b) == 0;
+}
+
+/* Every key lands in the same group and has the same fingerprint. */
+static INLINE size_t const_hash(uint64_t key)
+{
+    return 7;
+}
+
+CC_HASHMAP_DEFINE(IntMap, uint64_t, int, cc_hashmap_hash_u64, INT_EQ)
+CC_HASHMAP_DEFINE(StrMap, const char*, double, str_hash, str_eq)
+CC_HASHMAP_DEFINE(BadMap, uint64_t, uint64_t, const_hash, INT_EQ)
+
+static IntMap *map;
+static int stat;
+
+TEST_GROUP_C_SETUP(HashMapTests)
+{
+    stat = IntMap_new(&map);
+};
+
+TEST_GROUP_C_TEARDOWN(HashMapTests)
+{
+    IntMap_destroy(map);
+};
+
+TEST_C(HashMapTests, HashMapNew)
+{
+    CHECK_EQUAL_C_INT(CC_OK, stat);
+    CHECK_EQUAL_C_INT(0, IntMap_size(map));
+    CHECK_EQUAL_C_INT(16, IntMap_capacity(map));
+};
+
+TEST_C(HashMapTests, HashMapAddGet)
+{
+    int v;
+
+    CHECK_EQUAL_C_INT(CC_OK, IntMap_add(map, 1, 10));
+    CHECK_EQUAL_C_INT(CC_OK, IntMap_add(map, 2, 20));
+    CHECK_EQUAL_C_INT(CC_OK, IntMap_add(map, 1, 11));
+
+    CHECK_EQUAL_C_INT(2, IntMap_size(map));
+    CHECK_EQUAL_C_INT(CC_OK, IntMap_get(map, 1, &v));
+    CHECK_EQUAL_C_INT(11, v);
+    CHECK_EQUAL_C_INT(CC_OK, IntMap_get(map, 2, &v));
+    CHECK_EQUAL_C_INT(20, v);
+    CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND, IntMap_get(map, 3, &v));
+    CHECK_C(IntMap_contains_key(map, 2));
+    CHECK_C(!IntMap_contains_key(map, 3));
+};
+
+TEST_C(HashMapTests, HashMapGetOrAdd)
+{
+    int  *slot;
+    bool  inserted;
+    int   v;
+
+    CHECK_EQUAL_C_INT(CC_OK, IntMap_get_or_add(map, 5, 0, &slot, &inserted));
+    CHECK_C(inserted);
+    CHECK_EQUAL_C_INT(0, *slot);
+    *slot += 3;
+
+    CHECK_EQUAL_C_INT(CC_OK, IntMap_get_or_add(map, 5, 0, &slot, &inserted));
+    CHECK_C(!inserted);
+    *slot += 3;
+
+    IntMap_get(map, 5, &v);
+    CHECK_EQUAL_C_INT(6, v);
+    CHECK_EQUAL_C_INT(1, IntMap_size(map));
+};
+
+TEST_C(HashMapTests, HashMapAddMany)
+{
+    uint64_t i;
+    int      v;
+
+    for (i = 0; i < 10000; i++)
+        CHECK_EQUAL_C_INT(CC_OK, IntMap_add(map, i * 7919, (int) i));
+
+    CHECK_EQUAL_C_INT(10000, IntMap_size(map));
+    CHECK_C(IntMap_size(map) <= IntMap_capacity(map) * 0.75);
+
+    for (i = 0; i < 10000; i++) {
+        CHECK_EQUAL_C_INT(CC_OK, IntMap_get(map, i * 7919, &v));
+        CHECK_EQUAL_C_INT((int) i, v);
+    }
+    CHECK_C(!IntMap_contains_key(map, 1));
+};
+
+TEST_C(HashMapTests, HashMapRemove)
+{
+    uint64_t i;
+    int      v;
+
+    for (i = 0; i < 1000; i++)
+        IntMap_add(map, i, (int) i);
+
+    for (i = 0; i < 1000; i += 2) {
+        CHECK_EQUAL_C_INT(CC_OK, IntMap_remove(map, i, &v));
+        CHECK_EQUAL_C_INT((int) i, v);
+    }
+    CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND, IntMap_remove(map, 0, NULL));
+    CHECK_EQUAL_C_INT(500, IntMap_size(map));
+
+    for (i = 0; i < 1000; i++)
+        CHECK_EQUAL_C_INT(i % 2, IntMap_contains_key(map, i));
+};
+
+TEST_C(HashMapTests, HashMapRemoveAll)
+{
+    IntMap_add(map, 1, 1);
+    IntMap_add(map, 2, 2);
+    IntMap_remove_all(map);
+
+    CHECK_EQUAL_C_INT(0, IntMap_size(map));
+    CHECK_C(!IntMap_contains_key(map, 1));
+    CHECK_EQUAL_C_INT(CC_OK, IntMap_add(map, 1, 1));
+    CHECK_EQUAL_C_INT(1, IntMap_size(map));
+};
+
+TEST_C(HashMapTests, HashMapChurn)
+{
+    uint64_t i;
+
+    /* Tombstones left by removals are reclaimed instead of growing
+     * the map. */
+    for (i = 0; i < 100000; i++) {
+        IntMap_add(map, i, (int) i);
+        if (i >= 8)
+            IntMap_remove(map, i - 8, NULL);
+    }
+    CHECK_EQUAL_C_INT(8, IntMap_size(map));
+    CHECK_EQUAL_C_INT(16, IntMap_capacity(map));
+};
+
+TEST_C(HashMapTests, HashMapReserve)
+{
+    uint64_t i;
+
+    CHECK_EQUAL_C_INT(CC_OK, IntMap_reserve(map, 1000));
+    size_t capacity = IntMap_capacity(map);
+    CHECK_C(capacity * 0.75 >= 1000);
+
+    for (i = 0; i < 1000; i++)
+        IntMap_add(map, i, (int) i);
+
+    CHECK_EQUAL_C_INT(capacity, IntMap_capacity(map));
+};
+
+TEST_C(HashMapTests, HashMapIter)
+{
+    IntMapIter   iter;
+    IntMapEntry *e;
+    uint64_t     i;
+    uint64_t     sum = 0;
+    size_t       n   = 0;
+
+    for (i = 1; i <= 100; i++)
+        IntMap_add(map, i, (int) i * 2);
+
+    IntMap_iter_init(&iter, map);
+    while (IntMap_iter_next(&iter, &e) != CC_ITER_END) {
+        CHECK_EQUAL_C_INT(e->key * 2, e->value);
+        sum += e->key;
+        n++;
+    }
+    CHECK_EQUAL_C_INT(100, n);
+    CHECK_EQUAL_C_INT(5050, sum);
+};
+
+TEST_C(HashMapTests, HashMapIterRemove)
+{
+    IntMapIter   iter;
+    IntMapEntry *e;
+    uint64_t     i;
+    int          v;
+
+    for (i = 0; i < 100; i++)
+        IntMap_add(map, i, (int) i);
+
+    IntMap_iter_init(&iter, map);
+    while (IntMap_iter_next(&iter, &e) != CC_ITER_END) {
+        if (e->key % 3 == 0) {
+            uint64_t key = e->key;
+            CHECK_EQUAL_C_INT(CC_OK, IntMap_iter_remove(&iter, &v));
+            CHECK_EQUAL_C_INT((int) key, v);
+            CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND, IntMap_iter_remove(&iter, NULL));
+        }
+    }
+    CHECK_EQUAL_C_INT(66, IntMap_size(map));
+
+    for (i = 0; i < 100; i++)
+        CHECK_EQUAL_C_INT(i % 3 != 0, IntMap_contains_key(map, i));
+};
+
+TEST_C(HashMapTests, HashMapStringKeys)
+{
+    StrMap *m;
+    double  v;
+    char    key[8];
+
+    CHECK_EQUAL_C_INT(CC_OK, StrMap_new(&m));
+
+    StrMap_add(m, "one", 1.0);
+    StrMap_add(m, "two", 2.0);
+
+    /* keys are compared with eq_fn, not by address */
+    strcpy(key, "two");
+    CHECK_EQUAL_C_INT(CC_OK, StrMap_get(m, key, &v));
+    CHECK_C(v == 2.0);
+    CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND, StrMap_get(m, "three", &v));
+
+    StrMap_destroy(m);
+};
+
+TEST_C(HashMapTests, HashMapCollisions)
+{
+    BadMap  *m;
+    uint64_t i;
+    uint64_t v;
+
+    CHECK_EQUAL_C_INT(CC_OK, BadMap_new(&m));
+
+    for (i = 0; i < 200; i++)
+        BadMap_add(m, i, i + 1);
+
+    for (i = 0; i < 200; i += 2)
+        BadMap_remove(m, i, NULL);
+
+    CHECK_EQUAL_C_INT(100, BadMap_size(m));
+    for (i = 0; i < 200; i++) {
+        if (i % 2) {
+            CHECK_EQUAL_C_INT(CC_OK, BadMap_get(m, i, &v));
+            CHECK_EQUAL_C_INT(i + 1, v);
+        } else {
+            CHECK_C(!BadMap_contains_key(m, i));
+        }
+    }
+    BadMap_destroy(m);
+};
+
+TEST_GROUP_C_SETUP(HashMapTestsConf)
+{
+};
+
+TEST_GROUP_C_TEARDOWN(HashMapTestsConf)
+{
+};
+
+TEST_C(HashMapTestsConf, HashMapNewConf)
+{
+    HashMapConf conf;
+    IntMap     *m;
+
+    hashmap_conf_init(&conf);
+    conf.initial_capacity = 100;
+    conf.load_factor      = 1.0f;
+
+    CHECK_EQUAL_C_INT(CC_OK, IntMap_new_conf(&conf, &m));
+    CHECK_EQUAL_C_INT(128, IntMap_capacity(m));
+
+    /* the load factor is capped at 0.875 */
+    uint64_t i;
+    for (i = 0; i < 113; i++)
+        IntMap_add(m, i, 0);
+    CHECK_EQUAL_C_INT(256, IntMap_capacity(m));
+
+    IntMap_destroy(m);
+};
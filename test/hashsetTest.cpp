@@ -19,6 +19,21 @@ TEST_C_WRAPPER(HashSetTests, HashSetRemove);
 TEST_C_WRAPPER(HashSetTests, HashSetRemoveAll);
 TEST_C_WRAPPER(HashSetTests, HashSetIterNext);
 TEST_C_WRAPPER(HashSetTests, HashSetIterRemove);
+TEST_C_WRAPPER(HashSetTests, HashSetContainsBatch);
+TEST_C_WRAPPER(HashSetTests, HashSetAddMany);
+TEST_C_WRAPPER(HashSetTests, HashSetRemoveOut);
+TEST_C_WRAPPER(HashSetTests, HashSetIterRemoveAll);
+TEST_C_WRAPPER(HashSetTests, HashSetNullElement);
+TEST_C_WRAPPER(HashSetTestsConf, HashSetGrowFromSmall);
+TEST_C_WRAPPER(HashSetTestsConf, HashSetShrinkOnRemove);
+TEST_C_WRAPPER(HashSetTests, HashSetUnion);
+TEST_C_WRAPPER(HashSetTests, HashSetIntersection);
+TEST_C_WRAPPER(HashSetTests, HashSetDifference);
+TEST_C_WRAPPER(HashSetTests, HashSetUnionMut);
+TEST_C_WRAPPER(HashSetTests, HashSetIntersectionMut);
+TEST_C_WRAPPER(HashSetTests, HashSetDifferenceMut);
+TEST_C_WRAPPER(HashSetTests, HashSetAddAllFromArray);
+TEST_C_WRAPPER(HashSetTests, HashSetReserveShrink);
 
 int main(int argc, char **argv) {
   return RUN_ALL_TESTS(argc, argv);
@@ -1,3 +1,4 @@
+#include <stdio.h>
 #include <string.h>
 #include "hashset.h"
 #include "CppUTest/TestHarness_c.h"
@@ -130,6 +131,335 @@ TEST_C(HashSetTests, HashSetIterRemove)
     CHECK_C(!hashset_contains(set, "bar"));
 };
 
+TEST_C(HashSetTests, HashSetContainsBatch)
+{
+    hashset_add(set, "foo");
+    hashset_add(set, "bar");
+    hashset_add(set, "baz");
+
+    char *elements[] = {"bar", "qux", "foo", "baz"};
+    bool  out[4];
+
+    CHECK_C(!hashset_contains_batch(set, (void**) elements, 4, out));
+    CHECK_C(out[0]);
+    CHECK_C(!out[1]);
+    CHECK_C(out[2]);
+    CHECK_C(out[3]);
+
+    elements[1] = "foo";
+    CHECK_C(hashset_contains_batch(set, (void**) elements, 4, NULL));
+};
+
+#define MANY 1000
+
+static char many[MANY][16];
+
+static void make_many(void)
+{
+    int i;
+    for (i = 0; i < MANY; i++)
+        sprintf(many[i], "elem%d", i);
+}
+
+TEST_C(HashSetTests, HashSetAddMany)
+{
+    make_many();
+
+    int i;
+    for (i = 0; i < MANY; i++)
+        CHECK_EQUAL_C_INT(CC_OK, hashset_add(set, many[i]));
+
+    for (i = 0; i < MANY; i++)
+        CHECK_EQUAL_C_INT(CC_OK, hashset_add(set, many[i]));
+
+    CHECK_EQUAL_C_INT(MANY, hashset_size(set));
+    CHECK_C(hashset_capacity(set) >= MANY);
+
+    char key[16];
+    for (i = 0; i < MANY; i++) {
+        sprintf(key, "elem%d", i);
+        CHECK_C(hashset_contains(set, key));
+    }
+    CHECK_C(!hashset_contains(set, "elem1000"));
+};
+
+TEST_C(HashSetTests, HashSetRemoveOut)
+{
+    make_many();
+
+    int i;
+    for (i = 0; i < MANY; i++)
+        hashset_add(set, many[i]);
+
+    char  key[16];
+    void *out;
+    for (i = 0; i < MANY; i += 2) {
+        sprintf(key, "elem%d", i);
+        CHECK_EQUAL_C_INT(CC_OK, hashset_remove(set, key, &out));
+        CHECK_EQUAL_C_POINTER(many[i], out);
+    }
+    CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND, hashset_remove(set, many[0], NULL));
+    CHECK_EQUAL_C_INT(MANY / 2, hashset_size(set));
+
+    for (i = 0; i < MANY; i++)
+        CHECK_EQUAL_C_INT(i % 2 != 0, hashset_contains(set, many[i]));
+
+    /* Churn through the tombstones left behind by the removals. */
+    int round;
+    for (round = 0; round < 4; round++) {
+        for (i = 0; i < MANY; i += 2)
+            CHECK_EQUAL_C_INT(CC_OK, hashset_add(set, many[i]));
+        for (i = 0; i < MANY; i += 2)
+            CHECK_EQUAL_C_INT(CC_OK, hashset_remove(set, many[i], NULL));
+    }
+    CHECK_EQUAL_C_INT(MANY / 2, hashset_size(set));
+    CHECK_C(hashset_capacity(set) <= 2048);
+};
+
+TEST_C(HashSetTests, HashSetIterRemoveAll)
+{
+    make_many();
+
+    int i;
+    for (i = 0; i < MANY; i++)
+        hashset_add(set, many[i]);
+
+    HashSetIter iter;
+    hashset_iter_init(&iter, set);
+
+    size_t seen = 0;
+    void  *e;
+    void  *out;
+    while (hashset_iter_next(&iter, &e) != CC_ITER_END) {
+        CHECK_EQUAL_C_INT(CC_OK, hashset_iter_remove(&iter, &out));
+        CHECK_EQUAL_C_POINTER(e, out);
+        CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND, hashset_iter_remove(&iter, NULL));
+        seen++;
+    }
+    CHECK_EQUAL_C_INT(MANY, seen);
+    CHECK_EQUAL_C_INT(0, hashset_size(set));
+};
+
+TEST_C(HashSetTests, HashSetNullElement)
+{
+    CHECK_C(!hashset_contains(set, NULL));
+    CHECK_EQUAL_C_INT(CC_OK, hashset_add(set, "foo"));
+    CHECK_EQUAL_C_INT(CC_OK, hashset_add(set, NULL));
+    CHECK_EQUAL_C_INT(CC_OK, hashset_add(set, NULL));
+
+    CHECK_EQUAL_C_INT(2, hashset_size(set));
+    CHECK_C(hashset_contains(set, NULL));
+    CHECK_C(hashset_contains(set, "foo"));
+
+    size_t nulls = 0;
+    HASHSET_FOREACH(e, set, {
+            if (!e)
+                nulls++;
+        })
+    CHECK_EQUAL_C_INT(1, nulls);
+
+    CHECK_EQUAL_C_INT(CC_OK, hashset_remove(set, NULL, NULL));
+    CHECK_C(!hashset_contains(set, NULL));
+    CHECK_C(hashset_contains(set, "foo"));
+};
+
+static char copies[MANY][16];
+
+/* Fills set with many[lo, hi) and the returned set with equal copies of
+ * the elements in [lo2, hi2). */
+static HashSet *make_sets(int lo, int hi, int lo2, int hi2)
+{
+    HashSet *other;
+    int      i;
+
+    make_many();
+    hashset_new(&other);
+
+    for (i = lo; i < hi; i++)
+        hashset_add(set, many[i]);
+    for (i = lo2; i < hi2; i++) {
+        strcpy(copies[i], many[i]);
+        hashset_add(other, copies[i]);
+    }
+    return other;
+}
+
+/* Checks that s holds exactly many[lo, hi), as the elements of many if
+ * from_many is set. */
+static void check_range(HashSet *s, int lo, int hi, bool from_many)
+{
+    CHECK_EQUAL_C_INT(hi - lo, hashset_size(s));
+
+    int i;
+    for (i = 0; i < MANY; i++)
+        CHECK_EQUAL_C_INT(i >= lo && i < hi, hashset_contains(s, many[i]));
+
+    void *e;
+    for (i = lo; i < hi && from_many; i++) {
+        hashset_remove(s, many[i], &e);
+        CHECK_EQUAL_C_POINTER(many[i], e);
+        hashset_add(s, e);
+    }
+}
+
+TEST_C(HashSetTests, HashSetUnion)
+{
+    HashSet *other = make_sets(0, 600, 400, 700);
+    HashSet *u;
+
+    CHECK_EQUAL_C_INT(CC_OK, hashset_union(set, other, &u));
+    check_range(u, 0, 700, false);
+    hashset_destroy(u);
+
+    /* set is the smaller operand, its elements still win */
+    hashset_destroy(other);
+    hashset_remove_all(set);
+    other = make_sets(100, 200, 0, 900);
+
+    CHECK_EQUAL_C_INT(CC_OK, hashset_union(set, other, &u));
+    CHECK_EQUAL_C_INT(900, hashset_size(u));
+
+    void *e;
+    hashset_remove(u, many[150], &e);
+    CHECK_EQUAL_C_POINTER(many[150], e);
+    hashset_remove(u, many[250], &e);
+    CHECK_EQUAL_C_POINTER(copies[250], e);
+
+    hashset_destroy(u);
+    hashset_destroy(other);
+};
+
+TEST_C(HashSetTests, HashSetIntersection)
+{
+    HashSet *other = make_sets(0, 600, 400, 700);
+    HashSet *r;
+
+    CHECK_EQUAL_C_INT(CC_OK, hashset_intersection(set, other, &r));
+    check_range(r, 400, 600, true);
+    hashset_destroy(r);
+
+    CHECK_EQUAL_C_INT(CC_OK, hashset_intersection(other, set, &r));
+    CHECK_EQUAL_C_INT(200, hashset_size(r));
+    hashset_destroy(r);
+    hashset_destroy(other);
+};
+
+TEST_C(HashSetTests, HashSetDifference)
+{
+    HashSet *other = make_sets(0, 600, 400, 700);
+    HashSet *r;
+
+    CHECK_EQUAL_C_INT(CC_OK, hashset_difference(set, other, &r));
+    check_range(r, 0, 400, true);
+    hashset_destroy(r);
+    hashset_destroy(other);
+
+    hashset_remove_all(set);
+    other = make_sets(0, 100, 50, 1000);
+
+    CHECK_EQUAL_C_INT(CC_OK, hashset_difference(set, other, &r));
+    check_range(r, 0, 50, true);
+    hashset_destroy(r);
+    hashset_destroy(other);
+};
+
+TEST_C(HashSetTests, HashSetUnionMut)
+{
+    HashSet *other = make_sets(0, 600, 400, 700);
+
+    CHECK_EQUAL_C_INT(CC_OK, hashset_union_mut(set, other));
+    check_range(set, 0, 700, false);
+    CHECK_EQUAL_C_INT(300, hashset_size(other));
+
+    void *e;
+    hashset_remove(set, many[500], &e);
+    CHECK_EQUAL_C_POINTER(many[500], e);
+
+    CHECK_EQUAL_C_INT(CC_OK, hashset_union_mut(set, set));
+    CHECK_EQUAL_C_INT(699, hashset_size(set));
+    hashset_destroy(other);
+};
+
+TEST_C(HashSetTests, HashSetIntersectionMut)
+{
+    HashSet *other = make_sets(0, 600, 400, 700);
+
+    CHECK_EQUAL_C_INT(CC_OK, hashset_intersection_mut(set, other));
+    check_range(set, 400, 600, true);
+    hashset_destroy(other);
+
+    hashset_remove_all(set);
+    other = make_sets(0, 100, 50, 1000);
+
+    CHECK_EQUAL_C_INT(CC_OK, hashset_intersection_mut(set, other));
+    check_range(set, 50, 100, true);
+    hashset_destroy(other);
+};
+
+TEST_C(HashSetTests, HashSetDifferenceMut)
+{
+    HashSet *other = make_sets(0, 600, 400, 700);
+
+    CHECK_EQUAL_C_INT(CC_OK, hashset_difference_mut(set, other));
+    check_range(set, 0, 400, true);
+    hashset_destroy(other);
+
+    hashset_remove_all(set);
+    other = make_sets(0, 100, 50, 1000);
+
+    CHECK_EQUAL_C_INT(CC_OK, hashset_difference_mut(set, other));
+    check_range(set, 0, 50, true);
+
+    CHECK_EQUAL_C_INT(CC_OK, hashset_difference_mut(set, set));
+    CHECK_EQUAL_C_INT(0, hashset_size(set));
+    hashset_destroy(other);
+};
+
+TEST_C(HashSetTests, HashSetAddAllFromArray)
+{
+    make_many();
+
+    void *elements[MANY + 1];
+    int i;
+    for (i = 0; i < MANY; i++)
+        elements[i] = many[i];
+    elements[MANY] = many[7];
+
+    hashset_add(set, "foo");
+    hashset_add(set, many[0]);
+
+    CHECK_EQUAL_C_INT(CC_OK, hashset_add_all_from_array(set, elements, MANY + 1));
+    CHECK_EQUAL_C_INT(MANY + 1, hashset_size(set));
+
+    for (i = 0; i < MANY; i++)
+        CHECK_C(hashset_contains(set, many[i]));
+    CHECK_C(hashset_contains(set, "foo"));
+};
+
+TEST_C(HashSetTests, HashSetReserveShrink)
+{
+    make_many();
+
+    CHECK_EQUAL_C_INT(CC_OK, hashset_reserve(set, MANY));
+    size_t capacity = hashset_capacity(set);
+    CHECK_C(capacity * 0.75 >= MANY);
+
+    int i;
+    for (i = 0; i < MANY; i++)
+        hashset_add(set, many[i]);
+    CHECK_EQUAL_C_INT(capacity, hashset_capacity(set));
+
+    for (i = 0; i < MANY; i++) {
+        if (i % 100)
+            hashset_remove(set, many[i], NULL);
+    }
+    CHECK_EQUAL_C_INT(CC_OK, hashset_shrink_to_fit(set));
+    CHECK_EQUAL_C_INT(16, hashset_capacity(set));
+
+    for (i = 0; i < MANY; i++)
+        CHECK_EQUAL_C_INT(i % 100 == 0, hashset_contains(set, many[i]));
+};
+
 TEST_GROUP_C_SETUP(HashSetTestsConf)
 {
     hashset_conf_init(&conf);
@@ -147,3 +477,62 @@ TEST_C(HashSetTestsConf, HashSetNew)
     CHECK_EQUAL_C_INT(0, hashset_size(set));
     CHECK_EQUAL_C_INT(8, hashset_capacity(set));
 };
+
+TEST_C(HashSetTestsConf, HashSetGrowFromSmall)
+{
+    make_many();
+
+    int i;
+    for (i = 0; i < 7; i++)
+        hashset_add(set, many[i]);
+
+    /* Sets below a single group still honor the load factor. */
+    CHECK_EQUAL_C_INT(16, hashset_capacity(set));
+
+    for (i = 7; i < 100; i++)
+        hashset_add(set, many[i]);
+
+    CHECK_EQUAL_C_INT(100, hashset_size(set));
+    for (i = 0; i < 100; i++)
+        CHECK_C(hashset_contains(set, many[i]));
+    CHECK_C(!hashset_contains(set, many[100]));
+};
+
+TEST_C(HashSetTestsConf, HashSetShrinkOnRemove)
+{
+    hashset_destroy(set);
+    conf.min_load_factor = 0.1f;
+    hashset_new_conf(&conf, &set);
+    make_many();
+
+    int i;
+    for (i = 0; i < MANY; i++)
+        hashset_add(set, many[i]);
+
+    size_t peak = hashset_capacity(set);
+
+    for (i = 0; i < MANY - 50; i++)
+        CHECK_EQUAL_C_INT(CC_OK, hashset_remove(set, many[i], NULL));
+
+    size_t capacity = hashset_capacity(set);
+    CHECK_C(capacity <= peak / 4);
+    CHECK_C(hashset_size(set) >= capacity / 10);
+
+    for (i = 0; i < MANY; i++)
+        CHECK_EQUAL_C_INT(i >= MANY - 50, hashset_contains(set, many[i]));
+
+    /* removing through an iterator never shrinks */
+    HashSetIter iter;
+    void       *e;
+    hashset_iter_init(&iter, set);
+    while (hashset_iter_next(&iter, &e) != CC_ITER_END)
+        hashset_iter_remove(&iter, NULL);
+    CHECK_EQUAL_C_INT(0, hashset_size(set));
+    CHECK_EQUAL_C_INT(capacity, hashset_capacity(set));
+
+    /* but clearing the set does, down to the initial capacity */
+    hashset_add(set, many[0]);
+    hashset_remove_all(set);
+    CHECK_EQUAL_C_INT(8, hashset_capacity(set));
+    CHECK_C(!hashset_contains(set, many[0]));
+};
@@ -59,6 +59,104 @@ TEST_GROUP_C_WRAPPER(HashTableTestsCompare)
 
 TEST_C_WRAPPER(HashTableTestsCompare, HashTableTestsMemoryChunksAsKeys);
 
+TEST_GROUP_C_WRAPPER(HashTableTestsOpenAddressing)
+{
+  TEST_GROUP_C_SETUP_WRAPPER(HashTableTestsOpenAddressing);
+  TEST_GROUP_C_TEARDOWN_WRAPPER(HashTableTestsOpenAddressing);
+};
+
+TEST_C_WRAPPER(HashTableTestsOpenAddressing, HashTableOpenAddressingAddGet);
+TEST_C_WRAPPER(HashTableTestsOpenAddressing, HashTableOpenAddressingRemove);
+TEST_C_WRAPPER(HashTableTestsOpenAddressing, HashTableOpenAddressingCollisions);
+TEST_C_WRAPPER(HashTableTestsOpenAddressing, HashTableOpenAddressingNullKey);
+TEST_C_WRAPPER(HashTableTestsOpenAddressing, HashTableOpenAddressingIterRemove);
+TEST_C_WRAPPER(HashTableTestsOpenAddressing, HashTableOpenAddressingGetBatch);
+TEST_C_WRAPPER(HashTableTestsOpenAddressing, HashTableOpenAddressingGetOrAdd);
+TEST_C_WRAPPER(HashTableTestsOpenAddressing, HashTableOpenAddressingRetain);
+
+TEST_GROUP_C_WRAPPER(HashTableTestsIncremental)
+{
+  TEST_GROUP_C_SETUP_WRAPPER(HashTableTestsIncremental);
+  TEST_GROUP_C_TEARDOWN_WRAPPER(HashTableTestsIncremental);
+};
+
+TEST_C_WRAPPER(HashTableTestsIncremental, HashTableIncrementalAddGetRemove);
+TEST_C_WRAPPER(HashTableTestsIncremental, HashTableIncrementalNullKey);
+TEST_C_WRAPPER(HashTableTestsIncremental, HashTableIncrementalIterRemove);
+TEST_C_WRAPPER(HashTableTestsIncremental, HashTableIncrementalRemoveAll);
+TEST_C_WRAPPER(HashTableTestsIncremental, HashTableIncrementalGetBatch);
+TEST_C_WRAPPER(HashTableTestsIncremental, HashTableIncrementalGetOrAdd);
+TEST_C_WRAPPER(HashTableTestsIncremental, HashTableIncrementalRetain);
+
+TEST_GROUP_C_WRAPPER(HashTableTestsSlab)
+{
+  TEST_GROUP_C_SETUP_WRAPPER(HashTableTestsSlab);
+  TEST_GROUP_C_TEARDOWN_WRAPPER(HashTableTestsSlab);
+};
+
+TEST_C_WRAPPER(HashTableTestsSlab, HashTableSlabRecyclesEntries);
+TEST_C_WRAPPER(HashTableTestsSlab, HashTableSlabRemoveAll);
+TEST_C_WRAPPER(HashTableTestsSlab, HashTableGetBatch);
+TEST_C_WRAPPER(HashTableTestsSlab, HashTableGetOrAdd);
+TEST_C_WRAPPER(HashTableTestsSlab, HashTableIterInsertionOrder);
+TEST_C_WRAPPER(HashTableTestsSlab, HashTableIterAfterBulkRemove);
+TEST_C_WRAPPER(HashTableTestsSlab, HashTableRetain);
+
+TEST_GROUP_C_WRAPPER(HashTableTestsWyHash)
+{
+  TEST_GROUP_C_SETUP_WRAPPER(HashTableTestsWyHash);
+  TEST_GROUP_C_TEARDOWN_WRAPPER(HashTableTestsWyHash);
+};
+
+TEST_C_WRAPPER(HashTableTestsWyHash, HashTableWyHashAddGet);
+TEST_C_WRAPPER(HashTableTestsWyHash, HashTableWyHashLengths);
+TEST_C_WRAPPER(HashTableTestsWyHash, HashTableWyHashPointer);
+
+TEST_GROUP_C_WRAPPER(HashTableTestsFlooding)
+{
+  TEST_GROUP_C_SETUP_WRAPPER(HashTableTestsFlooding);
+  TEST_GROUP_C_TEARDOWN_WRAPPER(HashTableTestsFlooding);
+};
+
+TEST_C_WRAPPER(HashTableTestsFlooding, HashTableFloodingReseeds);
+TEST_C_WRAPPER(HashTableTestsFlooding, HashTableFloodingSeedIndependent);
+TEST_C_WRAPPER(HashTableTestsFlooding, HashTableRandomSeed);
+TEST_C_WRAPPER(HashTableTestsFlooding, HashTableSipHash);
+
+TEST_GROUP_C_WRAPPER(HashTableTestsKeyCompare)
+{
+  TEST_GROUP_C_SETUP_WRAPPER(HashTableTestsKeyCompare);
+  TEST_GROUP_C_TEARDOWN_WRAPPER(HashTableTestsKeyCompare);
+};
+
+TEST_C_WRAPPER(HashTableTestsKeyCompare, HashTableStoredHashSkipsCompare);
+TEST_C_WRAPPER(HashTableTestsKeyCompare, HashTableCachedKeyLength);
+TEST_C_WRAPPER(HashTableTestsKeyCompare, HashTableIterRemoveSkipsCompare);
+TEST_C_WRAPPER(HashTableTestsSlab, HashTableAddAllFromArrays);
+TEST_C_WRAPPER(HashTableTestsIncremental, HashTableIncrementalAddAllFromArrays);
+TEST_C_WRAPPER(HashTableTestsOpenAddressing, HashTableOpenAddressingAddAllFromArrays);
+TEST_C_WRAPPER(HashTableTestsSlab, HashTableReserveShrink);
+TEST_C_WRAPPER(HashTableTestsIncremental, HashTableIncrementalReserveShrink);
+TEST_C_WRAPPER(HashTableTestsOpenAddressing, HashTableOpenAddressingReserveShrink);
+TEST_C_WRAPPER(HashTableTestsSlab, HashTableReserveAllocatesOnce);
+TEST_C_WRAPPER(HashTableTestsSlab, HashTableShrinkOnRemove);
+TEST_C_WRAPPER(HashTableTestsIncremental, HashTableIncrementalShrinkOnRemove);
+TEST_C_WRAPPER(HashTableTestsIncremental, HashTableIncrementalKeepsOrder);
+TEST_C_WRAPPER(HashTableTestsOpenAddressing, HashTableOpenAddressingShrinkOnRemove);
+TEST_C_WRAPPER(HashTableTestsSlab, HashTableShrinkKeepsOrder);
+
+TEST_GROUP_C_WRAPPER(HashTableTestsSnapshot)
+{
+  TEST_GROUP_C_SETUP_WRAPPER(HashTableTestsSnapshot);
+  TEST_GROUP_C_TEARDOWN_WRAPPER(HashTableTestsSnapshot);
+};
+
+TEST_C_WRAPPER(HashTableTestsSnapshot, HashTableSnapshotGet);
+TEST_C_WRAPPER(HashTableTestsSnapshot, HashTableSnapshotEmpty);
+TEST_C_WRAPPER(HashTableTestsSnapshot, HashTableSnapshotInvalid);
+TEST_C_WRAPPER(HashTableTestsSnapshot, HashTableSnapshotCorrupt);
+TEST_C_WRAPPER(HashTableTestsSnapshot, HashTableSnapshotSharedBuffer);
+
 int main(int argc, char **argv) {
   return RUN_ALL_TESTS(argc, argv);
 }
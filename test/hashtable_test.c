@@ -1,5 +1,9 @@
 #include <time.h>
 #include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
 
 #include "hashtable.h"
 #include "CppUTest/TestHarness_c.h"
@@ -381,3 +385,1384 @@ TEST_C(HashTableTests, HashTableIterRemove)
     CHECK_EQUAL_C_INT(2, hashtable_size(table));
     CHECK_C(!hashtable_contains_key(table, "bar"));
 };
+
+#define OA_KEYS 1000
+
+static char oa_keys[OA_KEYS][16];
+
+TEST_GROUP_C_SETUP(HashTableTestsOpenAddressing)
+{
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        sprintf(oa_keys[i], "key%d", i);
+
+    hashtable_conf_init(&conf);
+    conf.backend = HASHTABLE_OPEN_ADDRESSING;
+    stat = hashtable_new_conf(&conf, &table);
+};
+
+TEST_GROUP_C_TEARDOWN(HashTableTestsOpenAddressing)
+{
+    hashtable_destroy(table);
+};
+
+TEST_C(HashTableTestsOpenAddressing, HashTableOpenAddressingAddGet)
+{
+    CHECK_EQUAL_C_INT(CC_OK, stat);
+
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        CHECK_EQUAL_C_INT(CC_OK, hashtable_add(table, oa_keys[i], &oa_keys[i]));
+
+    CHECK_EQUAL_C_INT(OA_KEYS, hashtable_size(table));
+    CHECK_C(hashtable_capacity(table) >= OA_KEYS);
+
+    /* replacing a value doesn't change the size */
+    hashtable_add(table, "key7", "seven");
+    CHECK_EQUAL_C_INT(OA_KEYS, hashtable_size(table));
+
+    void *out;
+    for (i = 0; i < OA_KEYS; i++) {
+        CHECK_EQUAL_C_INT(CC_OK, hashtable_get(table, oa_keys[i], &out));
+        if (i != 7)
+            CHECK_EQUAL_C_POINTER(&oa_keys[i], out);
+    }
+    hashtable_get(table, "key7", &out);
+    CHECK_EQUAL_C_STRING("seven", out);
+    CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND, hashtable_get(table, "nope", &out));
+};
+
+TEST_C(HashTableTestsOpenAddressing, HashTableOpenAddressingRemove)
+{
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    void *out;
+    for (i = 0; i < OA_KEYS; i += 2) {
+        CHECK_EQUAL_C_INT(CC_OK, hashtable_remove(table, oa_keys[i], &out));
+        CHECK_EQUAL_C_POINTER(&oa_keys[i], out);
+    }
+    CHECK_EQUAL_C_INT(OA_KEYS / 2, hashtable_size(table));
+    CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND, hashtable_remove(table, oa_keys[0], NULL));
+
+    for (i = 0; i < OA_KEYS; i++)
+        CHECK_EQUAL_C_INT(i % 2 != 0, hashtable_contains_key(table, oa_keys[i]));
+
+    /* churn through the freed slots */
+    size_t capacity = hashtable_capacity(table);
+    int j;
+    for (j = 0; j < 10; j++) {
+        for (i = 0; i < OA_KEYS; i += 2)
+            hashtable_add(table, oa_keys[i], &oa_keys[i]);
+        for (i = 0; i < OA_KEYS; i += 2)
+            hashtable_remove(table, oa_keys[i], NULL);
+    }
+    CHECK_EQUAL_C_INT(OA_KEYS / 2, hashtable_size(table));
+    CHECK_EQUAL_C_INT(capacity, hashtable_capacity(table));
+
+    for (i = 1; i < OA_KEYS; i += 2)
+        CHECK_C(hashtable_contains_key(table, oa_keys[i]));
+};
+
+TEST_C(HashTableTestsOpenAddressing, HashTableOpenAddressingCollisions)
+{
+    HashTable *t;
+    conf.hash = collision_hash;
+    hashtable_new_conf(&conf, &t);
+
+    int i;
+    for (i = 0; i < 100; i++)
+        hashtable_add(t, oa_keys[i], &oa_keys[i]);
+
+    CHECK_EQUAL_C_INT(100, hashtable_size(t));
+
+    for (i = 0; i < 100; i += 3)
+        hashtable_remove(t, oa_keys[i], NULL);
+
+    void *out;
+    for (i = 0; i < 100; i++) {
+        if (i % 3 == 0) {
+            CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND, hashtable_get(t, oa_keys[i], &out));
+        } else {
+            CHECK_EQUAL_C_INT(CC_OK, hashtable_get(t, oa_keys[i], &out));
+            CHECK_EQUAL_C_POINTER(&oa_keys[i], out);
+        }
+    }
+    hashtable_destroy(t);
+};
+
+TEST_C(HashTableTestsOpenAddressing, HashTableOpenAddressingNullKey)
+{
+    hashtable_add(table, "key", "a");
+    hashtable_add(table, NULL, "b");
+
+    void *out;
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_get(table, NULL, &out));
+    CHECK_EQUAL_C_STRING("b", out);
+    CHECK_EQUAL_C_INT(2, hashtable_size(table));
+
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_remove(table, NULL, NULL));
+    CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND, hashtable_get(table, NULL, &out));
+    CHECK_EQUAL_C_INT(1, hashtable_size(table));
+};
+
+TEST_C(HashTableTestsOpenAddressing, HashTableOpenAddressingIterRemove)
+{
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    int visited = 0;
+    HashTableIter iter;
+    TableEntry *entry;
+    hashtable_iter_init(&iter, table);
+
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END) {
+        char (*k)[16] = entry->value;
+        visited++;
+        if ((k - oa_keys) % 2 == 0)
+            hashtable_iter_remove(&iter, NULL);
+    }
+    CHECK_EQUAL_C_INT(OA_KEYS, visited);
+    CHECK_EQUAL_C_INT(OA_KEYS / 2, hashtable_size(table));
+
+    Array *keys;
+    hashtable_get_keys(table, &keys);
+    CHECK_EQUAL_C_INT(OA_KEYS / 2, array_size(keys));
+    array_destroy(keys);
+
+    hashtable_remove_all(table);
+    CHECK_EQUAL_C_INT(0, hashtable_size(table));
+    CHECK_C(!hashtable_contains_key(table, oa_keys[1]));
+};
+
+TEST_GROUP_C_SETUP(HashTableTestsIncremental)
+{
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        sprintf(oa_keys[i], "key%d", i);
+
+    hashtable_conf_init(&conf);
+    conf.initial_capacity = 4;
+    conf.resize_step      = 1;
+    stat = hashtable_new_conf(&conf, &table);
+};
+
+TEST_GROUP_C_TEARDOWN(HashTableTestsIncremental)
+{
+    hashtable_destroy(table);
+};
+
+TEST_C(HashTableTestsIncremental, HashTableIncrementalAddGetRemove)
+{
+    CHECK_EQUAL_C_INT(CC_OK, stat);
+
+    void *out;
+    int i;
+    for (i = 0; i < OA_KEYS; i++) {
+        CHECK_EQUAL_C_INT(CC_OK, hashtable_add(table, oa_keys[i], &oa_keys[i]));
+
+        /* every key added so far is reachable mid-resize */
+        if (i % 97 == 0) {
+            int j;
+            for (j = 0; j <= i; j++) {
+                CHECK_EQUAL_C_INT(CC_OK, hashtable_get(table, oa_keys[j], &out));
+                CHECK_EQUAL_C_POINTER(&oa_keys[j], out);
+            }
+        }
+    }
+    CHECK_EQUAL_C_INT(OA_KEYS, hashtable_size(table));
+    CHECK_C(hashtable_contains_key(table, "key999"));
+    CHECK_C(!hashtable_contains_key(table, "nope"));
+
+    for (i = 0; i < OA_KEYS; i += 2) {
+        CHECK_EQUAL_C_INT(CC_OK, hashtable_remove(table, oa_keys[i], &out));
+        CHECK_EQUAL_C_POINTER(&oa_keys[i], out);
+    }
+    CHECK_EQUAL_C_INT(OA_KEYS / 2, hashtable_size(table));
+
+    for (i = 0; i < OA_KEYS; i++) {
+        enum cc_stat s = hashtable_get(table, oa_keys[i], &out);
+        CHECK_EQUAL_C_INT(i % 2 ? CC_OK : CC_ERR_KEY_NOT_FOUND, s);
+    }
+};
+
+TEST_C(HashTableTestsIncremental, HashTableIncrementalNullKey)
+{
+    int i;
+    for (i = 0; i < 3; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    hashtable_add(table, NULL, "null");
+
+    /* triggers a resize that leaves most buckets unmigrated */
+    for (i = 3; i < 40; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    void *out;
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_get(table, NULL, &out));
+    CHECK_EQUAL_C_STRING("null", out);
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_remove(table, NULL, &out));
+    CHECK_EQUAL_C_INT(40, hashtable_size(table));
+};
+
+TEST_C(HashTableTestsIncremental, HashTableIncrementalIterRemove)
+{
+    int i;
+    for (i = 0; i < 200; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    HashTableIter iter;
+    hashtable_iter_init(&iter, table);
+
+    int seen = 0;
+    TableEntry *entry;
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END) {
+        seen++;
+        if (seen % 3 == 0)
+            CHECK_EQUAL_C_INT(CC_OK, hashtable_iter_remove(&iter, NULL));
+    }
+    CHECK_EQUAL_C_INT(200, seen);
+    CHECK_EQUAL_C_INT(200 - 200 / 3, hashtable_size(table));
+
+    seen = 0;
+    hashtable_iter_init(&iter, table);
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END)
+        seen++;
+    CHECK_EQUAL_C_INT(hashtable_size(table), seen);
+};
+
+TEST_C(HashTableTestsIncremental, HashTableIncrementalRemoveAll)
+{
+    int i;
+    for (i = 0; i < 100; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    hashtable_remove_all(table);
+    CHECK_EQUAL_C_INT(0, hashtable_size(table));
+    CHECK_C(!hashtable_contains_key(table, "key5"));
+
+    for (i = 0; i < 100; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+    CHECK_EQUAL_C_INT(100, hashtable_size(table));
+};
+
+static int slab_allocs;
+
+static void *counting_malloc(size_t size)
+{
+    slab_allocs++;
+    return malloc(size);
+}
+
+TEST_GROUP_C_SETUP(HashTableTestsSlab)
+{
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        sprintf(oa_keys[i], "key%d", i);
+
+    slab_allocs = 0;
+    hashtable_conf_init(&conf);
+    conf.mem_alloc = counting_malloc;
+    stat = hashtable_new_conf(&conf, &table);
+};
+
+TEST_GROUP_C_TEARDOWN(HashTableTestsSlab)
+{
+    hashtable_destroy(table);
+};
+
+TEST_C(HashTableTestsSlab, HashTableSlabRecyclesEntries)
+{
+    int i;
+    for (i = 0; i < 100; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    /* entries are carved out of a handful of chunks */
+    int allocs = slab_allocs;
+    CHECK_C(allocs > 0 && allocs < 10);
+
+    /* removed entries are reused by later adds */
+    int round;
+    for (round = 0; round < 10; round++) {
+        for (i = 0; i < 100; i++)
+            hashtable_remove(table, oa_keys[i], NULL);
+        for (i = 0; i < 100; i++)
+            hashtable_add(table, oa_keys[i], &oa_keys[i]);
+    }
+    CHECK_EQUAL_C_INT(allocs, slab_allocs);
+
+    void *out;
+    for (i = 0; i < 100; i++) {
+        CHECK_EQUAL_C_INT(CC_OK, hashtable_get(table, oa_keys[i], &out));
+        CHECK_EQUAL_C_POINTER(&oa_keys[i], out);
+    }
+};
+
+TEST_C(HashTableTestsSlab, HashTableSlabRemoveAll)
+{
+    int i;
+    for (i = 0; i < 500; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    hashtable_remove_all(table);
+    CHECK_EQUAL_C_INT(0, hashtable_size(table));
+    CHECK_C(!hashtable_contains_key(table, "key1"));
+
+    hashtable_add(table, NULL, "null");
+    for (i = 0; i < 500; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    CHECK_EQUAL_C_INT(501, hashtable_size(table));
+
+    void *out;
+    hashtable_get(table, "key499", &out);
+    CHECK_EQUAL_C_POINTER(&oa_keys[499], out);
+};
+
+static void check_get_batch(int n)
+{
+    void        *keys[OA_KEYS + 1];
+    void        *values[OA_KEYS + 1];
+    enum cc_stat status[OA_KEYS + 1];
+    int i;
+
+    for (i = 0; i < n; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    /* look up every present key followed by a missing one */
+    for (i = 0; i < n; i++)
+        keys[i] = oa_keys[i];
+    keys[n] = "missing";
+
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_get_batch(table, keys, n, values, status));
+    CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND,
+                      hashtable_get_batch(table, keys, n + 1, values, status));
+
+    for (i = 0; i < n; i++) {
+        CHECK_EQUAL_C_INT(CC_OK, status[i]);
+        CHECK_EQUAL_C_POINTER(&oa_keys[i], values[i]);
+    }
+    CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND, status[n]);
+
+    /* NULL keys and optional outputs */
+    hashtable_add(table, NULL, "null");
+    keys[0] = NULL;
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_get_batch(table, keys, 3, values, NULL));
+    CHECK_EQUAL_C_STRING("null", values[0]);
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_get_batch(table, keys, 3, NULL, NULL));
+}
+
+TEST_C(HashTableTestsIncremental, HashTableIncrementalGetBatch)
+{
+    check_get_batch(OA_KEYS);
+};
+
+TEST_C(HashTableTestsOpenAddressing, HashTableOpenAddressingGetBatch)
+{
+    check_get_batch(OA_KEYS);
+};
+
+TEST_C(HashTableTestsSlab, HashTableGetBatch)
+{
+    check_get_batch(37);
+};
+
+TEST_GROUP_C_SETUP(HashTableTestsWyHash)
+{
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        sprintf(oa_keys[i], "key%d", i);
+
+    hashtable_conf_init(&conf);
+    conf.hash = WY_STRING_HASH;
+    stat = hashtable_new_conf(&conf, &table);
+};
+
+TEST_GROUP_C_TEARDOWN(HashTableTestsWyHash)
+{
+    hashtable_destroy(table);
+};
+
+TEST_C(HashTableTestsWyHash, HashTableWyHashAddGet)
+{
+    CHECK_EQUAL_C_INT(CC_OK, stat);
+
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    CHECK_EQUAL_C_INT(OA_KEYS, hashtable_size(table));
+
+    void *out;
+    for (i = 0; i < OA_KEYS; i++) {
+        CHECK_EQUAL_C_INT(CC_OK, hashtable_get(table, oa_keys[i], &out));
+        CHECK_EQUAL_C_POINTER(&oa_keys[i], out);
+    }
+};
+
+TEST_C(HashTableTestsWyHash, HashTableWyHashLengths)
+{
+    char buf[200];
+    int i;
+    for (i = 0; i < 200; i++)
+        buf[i] = 'a' + i % 26;
+
+    /* the string variant agrees with the fixed length variant */
+    buf[57] = '\0';
+    CHECK_C(WY_STRING_HASH(buf, KEY_LENGTH_VARIABLE, 7) == WY_HASH(buf, 57, 7));
+    CHECK_C(WY_HASH(buf, 57, 7) != WY_HASH(buf, 57, 8));
+    buf[57] = 'a' + 57 % 26;
+
+    /* every prefix of the buffer hashes differently, which exercises all
+     * short, medium and long key paths */
+    size_t hashes[200];
+    int j;
+    for (i = 0; i < 200; i++) {
+        hashes[i] = WY_HASH(buf, i, 0);
+        for (j = 0; j < i; j++)
+            CHECK_C(hashes[i] != hashes[j]);
+    }
+};
+
+TEST_C(HashTableTestsWyHash, HashTableWyHashPointer)
+{
+    size_t hashes[64];
+    int i, j;
+    for (i = 0; i < 64; i++) {
+        hashes[i] = WY_POINTER_HASH(&oa_keys[i], KEY_LENGTH_POINTER, 0);
+        for (j = 0; j < i; j++)
+            CHECK_C(hashes[i] != hashes[j]);
+    }
+    CHECK_C(WY_POINTER_HASH(oa_keys, KEY_LENGTH_POINTER, 0) ==
+            WY_POINTER_HASH(oa_keys, KEY_LENGTH_POINTER, 0));
+};
+
+static uint32_t last_seed;
+static int      key_compares;
+
+/* collides every key under seed 42, and behaves like STRING_HASH otherwise */
+static size_t flooded_hash(const void *k, int l, uint32_t s)
+{
+    last_seed = s;
+    return s == 42 ? 1 : STRING_HASH(k, l, s);
+}
+
+static int counting_cmp(const void *k1, const void *k2)
+{
+    key_compares++;
+    return strcmp(k1, k2);
+}
+
+TEST_GROUP_C_SETUP(HashTableTestsFlooding)
+{
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        sprintf(oa_keys[i], "key%d", i);
+
+    hashtable_conf_init(&conf);
+    conf.hash             = flooded_hash;
+    conf.key_compare      = counting_cmp;
+    conf.hash_seed        = 42;
+    conf.max_chain_length = 8;
+    stat = hashtable_new_conf(&conf, &table);
+};
+
+TEST_GROUP_C_TEARDOWN(HashTableTestsFlooding)
+{
+    hashtable_destroy(table);
+};
+
+TEST_C(HashTableTestsFlooding, HashTableFloodingReseeds)
+{
+    int i;
+    for (i = 0; i < 500; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    hashtable_add(table, NULL, "null");
+    CHECK_EQUAL_C_INT(501, hashtable_size(table));
+
+    void *out;
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_get(table, oa_keys[0], &out));
+    CHECK_C(last_seed != 42);
+
+    /* lookups no longer walk a single chain of every key */
+    key_compares = 0;
+    for (i = 0; i < 500; i++) {
+        CHECK_EQUAL_C_INT(CC_OK, hashtable_get(table, oa_keys[i], &out));
+        CHECK_EQUAL_C_POINTER(&oa_keys[i], out);
+    }
+    CHECK_C(key_compares < 500 * 8);
+
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_get(table, NULL, &out));
+    CHECK_EQUAL_C_STRING("null", out);
+};
+
+TEST_C(HashTableTestsFlooding, HashTableFloodingSeedIndependent)
+{
+    HashTable *t;
+
+    conf.hash = collision_hash;
+    hashtable_new_conf(&conf, &t);
+
+    int i;
+    for (i = 0; i < 300; i++)
+        hashtable_add(t, oa_keys[i], &oa_keys[i]);
+
+    CHECK_EQUAL_C_INT(300, hashtable_size(t));
+
+    void *out;
+    for (i = 0; i < 300; i++) {
+        CHECK_EQUAL_C_INT(CC_OK, hashtable_get(t, oa_keys[i], &out));
+        CHECK_EQUAL_C_POINTER(&oa_keys[i], out);
+    }
+    hashtable_destroy(t);
+};
+
+TEST_C(HashTableTestsFlooding, HashTableRandomSeed)
+{
+    HashTable *t1;
+    HashTable *t2;
+
+    conf.random_seed = true;
+
+    hashtable_new_conf(&conf, &t1);
+    hashtable_add(t1, "a", NULL);
+    uint32_t s1 = last_seed;
+
+    hashtable_new_conf(&conf, &t2);
+    hashtable_add(t2, "a", NULL);
+    uint32_t s2 = last_seed;
+
+    CHECK_C(s1 != s2);
+
+    hashtable_destroy(t1);
+    hashtable_destroy(t2);
+};
+
+TEST_C(HashTableTestsFlooding, HashTableSipHash)
+{
+    const char *k = "https://example.com/catalog/item/0123456789/view";
+    int         l = strlen(k);
+
+    CHECK_C(SIP_STRING_HASH(k, KEY_LENGTH_VARIABLE, 1) == SIP_HASH(k, l, 1));
+    CHECK_C(SIP_HASH(k, l, 1) != SIP_HASH(k, l, 2));
+    CHECK_C(SIP_HASH(k, l, 1) != SIP_HASH(k, l - 1, 1));
+
+    HashTable *t;
+    conf.hash        = SIP_STRING_HASH;
+    conf.random_seed = true;
+    hashtable_new_conf(&conf, &t);
+
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        hashtable_add(t, oa_keys[i], &oa_keys[i]);
+
+    void *out;
+    for (i = 0; i < OA_KEYS; i++) {
+        CHECK_EQUAL_C_INT(CC_OK, hashtable_get(t, oa_keys[i], &out));
+        CHECK_EQUAL_C_POINTER(&oa_keys[i], out);
+    }
+    hashtable_destroy(t);
+};
+
+static void *count_fn(void *value, bool exists, void *ctx)
+{
+    *(int*) ctx += exists;
+    return (void*) ((intptr_t) value + 1);
+}
+
+/* counts words with both APIs and checks the counts */
+static void check_get_or_add(void)
+{
+    int i;
+    for (i = 0; i < 3000; i++) {
+        void **slot;
+        bool   inserted;
+
+        CHECK_EQUAL_C_INT(CC_OK, hashtable_get_or_add(table, oa_keys[i % 700], (void*) 0,
+                                                      &slot, &inserted));
+        CHECK_C(inserted == (i < 700));
+        *slot = (void*) ((intptr_t) *slot + 1);
+    }
+    CHECK_EQUAL_C_INT(700, hashtable_size(table));
+
+    int updated = 0;
+    for (i = 0; i < 800; i++)
+        CHECK_EQUAL_C_INT(CC_OK, hashtable_upsert(table, oa_keys[i], count_fn, &updated));
+
+    CHECK_EQUAL_C_INT(700, updated);
+    CHECK_EQUAL_C_INT(800, hashtable_size(table));
+
+    void *out;
+    for (i = 0; i < 800; i++) {
+        intptr_t expected = i < 700 ? 3000 / 700 + (i < 3000 % 700) + 1 : 1;
+        hashtable_get(table, oa_keys[i], &out);
+        CHECK_EQUAL_C_INT(expected, (intptr_t) out);
+    }
+
+    /* NULL key and optional outputs */
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_get_or_add(table, NULL, "null", NULL, NULL));
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_get_or_add(table, NULL, "other", NULL, NULL));
+    hashtable_get(table, NULL, &out);
+    CHECK_EQUAL_C_STRING("null", out);
+}
+
+TEST_C(HashTableTestsSlab, HashTableGetOrAdd)
+{
+    check_get_or_add();
+};
+
+TEST_C(HashTableTestsIncremental, HashTableIncrementalGetOrAdd)
+{
+    check_get_or_add();
+};
+
+TEST_C(HashTableTestsOpenAddressing, HashTableOpenAddressingGetOrAdd)
+{
+    check_get_or_add();
+};
+
+/* distinct hashes that all map to the first bucket of small tables */
+static size_t same_bucket_hash(const void *k, int l, uint32_t s)
+{
+    return STRING_HASH(k, l, s) << 20;
+}
+
+TEST_GROUP_C_SETUP(HashTableTestsKeyCompare)
+{
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        sprintf(oa_keys[i], "key%d", i);
+
+    key_compares = 0;
+    hashtable_conf_init(&conf);
+    conf.key_compare = counting_cmp;
+};
+
+TEST_GROUP_C_TEARDOWN(HashTableTestsKeyCompare)
+{
+    hashtable_destroy(table);
+};
+
+TEST_C(HashTableTestsKeyCompare, HashTableStoredHashSkipsCompare)
+{
+    conf.hash = same_bucket_hash;
+    hashtable_new_conf(&conf, &table);
+
+    int i;
+    for (i = 0; i < 100; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    /* only the matching entry of the single long chain is compared */
+    key_compares = 0;
+    void *out;
+    for (i = 0; i < 100; i++) {
+        CHECK_EQUAL_C_INT(CC_OK, hashtable_get(table, oa_keys[i], &out));
+        CHECK_EQUAL_C_POINTER(&oa_keys[i], out);
+    }
+    CHECK_EQUAL_C_INT(100, key_compares);
+
+    key_compares = 0;
+    CHECK_C(!hashtable_contains_key(table, "missing"));
+    CHECK_EQUAL_C_INT(0, key_compares);
+
+    for (i = 0; i < 100; i++)
+        CHECK_EQUAL_C_INT(CC_OK, hashtable_remove(table, oa_keys[i], NULL));
+    CHECK_EQUAL_C_INT(100, key_compares);
+};
+
+TEST_C(HashTableTestsKeyCompare, HashTableCachedKeyLength)
+{
+    conf.hash             = collision_hash;
+    conf.cache_key_length = true;
+    hashtable_new_conf(&conf, &table);
+
+    /* key0..key9 have length 4, key10..key99 length 5 */
+    int i;
+    for (i = 0; i < 100; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    key_compares = 0;
+    void *out;
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_get(table, "key7", &out));
+    CHECK_EQUAL_C_POINTER(&oa_keys[7], out);
+    CHECK_C(key_compares <= 10);
+
+    key_compares = 0;
+    CHECK_C(!hashtable_contains_key(table, "a much longer key"));
+    CHECK_EQUAL_C_INT(0, key_compares);
+
+    hashtable_add(table, NULL, "null");
+    CHECK_C(hashtable_contains_key(table, NULL));
+
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_remove(table, "key42", &out));
+    CHECK_EQUAL_C_POINTER(&oa_keys[42], out);
+    CHECK_EQUAL_C_INT(100, hashtable_size(table));
+};
+
+TEST_C(HashTableTestsSlab, HashTableIterInsertionOrder)
+{
+    int i;
+    for (i = 0; i < 500; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    /* replacing a value keeps the position of the key */
+    hashtable_add(table, oa_keys[3], &oa_keys[3]);
+
+    HashTableIter iter;
+    TableEntry   *entry;
+    hashtable_iter_init(&iter, table);
+
+    i = 0;
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END) {
+        CHECK_EQUAL_C_POINTER(oa_keys[i], entry->key);
+        i++;
+    }
+    CHECK_EQUAL_C_INT(500, i);
+};
+
+TEST_C(HashTableTestsSlab, HashTableIterAfterBulkRemove)
+{
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    /* keep every 100th key */
+    for (i = 0; i < OA_KEYS; i++) {
+        if (i % 100)
+            hashtable_remove(table, oa_keys[i], NULL);
+    }
+    hashtable_add(table, "new", NULL);
+
+    HashTableIter iter;
+    TableEntry   *entry;
+    hashtable_iter_init(&iter, table);
+
+    i = 0;
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END) {
+        if (i < OA_KEYS / 100)
+            CHECK_EQUAL_C_POINTER(oa_keys[i * 100], entry->key);
+        else
+            CHECK_EQUAL_C_STRING("new", entry->key);
+        i++;
+    }
+    CHECK_EQUAL_C_INT(OA_KEYS / 100 + 1, i);
+
+    /* removing through the iterator leaves the remaining order intact */
+    hashtable_iter_init(&iter, table);
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END) {
+        if (entry->key == oa_keys[200])
+            hashtable_iter_remove(&iter, NULL);
+    }
+
+    Array *keys;
+    hashtable_get_keys(table, &keys);
+    CHECK_EQUAL_C_INT(OA_KEYS / 100, array_size(keys));
+
+    void *k;
+    array_get_at(keys, 2, &k);
+    CHECK_EQUAL_C_POINTER(oa_keys[300], k);
+    array_destroy(keys);
+};
+
+static bool keep_odd(const void *key, void *value, void *ctx)
+{
+    (*(int*) ctx)++;
+    return ((char (*)[16]) value - oa_keys) % 2;
+}
+
+static void check_retain(void)
+{
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    int calls = 0;
+    CHECK_EQUAL_C_INT(OA_KEYS / 2, hashtable_retain(table, keep_odd, &calls));
+    CHECK_EQUAL_C_INT(OA_KEYS, calls);
+    CHECK_EQUAL_C_INT(OA_KEYS / 2, hashtable_size(table));
+
+    void *out;
+    for (i = 0; i < OA_KEYS; i++)
+        CHECK_EQUAL_C_INT(i % 2 ? CC_OK : CC_ERR_KEY_NOT_FOUND,
+                          hashtable_get(table, oa_keys[i], &out));
+
+    HashTableIter iter;
+    TableEntry   *entry;
+    hashtable_iter_init(&iter, table);
+
+    int n = 0;
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END)
+        n++;
+    CHECK_EQUAL_C_INT(OA_KEYS / 2, n);
+
+    /* the table is still usable */
+    hashtable_add(table, oa_keys[0], &oa_keys[0]);
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_get(table, oa_keys[0], &out));
+}
+
+TEST_C(HashTableTestsSlab, HashTableRetain)
+{
+    check_retain();
+};
+
+TEST_C(HashTableTestsIncremental, HashTableIncrementalRetain)
+{
+    check_retain();
+};
+
+TEST_C(HashTableTestsOpenAddressing, HashTableOpenAddressingRetain)
+{
+    check_retain();
+};
+
+TEST_C(HashTableTestsKeyCompare, HashTableIterRemoveSkipsCompare)
+{
+    conf.hash = same_bucket_hash;
+    hashtable_new_conf(&conf, &table);
+
+    int i;
+    for (i = 0; i < 100; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    HashTableIter iter;
+    TableEntry   *entry;
+    hashtable_iter_init(&iter, table);
+
+    key_compares = 0;
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END) {
+        void *value = entry->value;
+
+        if (((char (*)[16]) value - oa_keys) % 3 == 0) {
+            void *out;
+            CHECK_EQUAL_C_INT(CC_OK, hashtable_iter_remove(&iter, &out));
+            CHECK_EQUAL_C_POINTER(value, out);
+            CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND, hashtable_iter_remove(&iter, NULL));
+        }
+    }
+    CHECK_EQUAL_C_INT(0, key_compares);
+    CHECK_EQUAL_C_INT(66, hashtable_size(table));
+
+    for (i = 0; i < 100; i++)
+        CHECK_C(hashtable_contains_key(table, oa_keys[i]) == (i % 3 != 0));
+};
+
+static void check_add_all_from_arrays(void)
+{
+    void *keys[OA_KEYS + 2];
+    void *vals[OA_KEYS + 2];
+    int i;
+
+    for (i = 0; i < OA_KEYS; i++) {
+        keys[i] = oa_keys[i];
+        vals[i] = &oa_keys[i];
+    }
+    /* the last of two equal keys wins, as with hashtable_add */
+    keys[OA_KEYS]     = oa_keys[1];
+    vals[OA_KEYS]     = "dup";
+    keys[OA_KEYS + 1] = NULL;
+    vals[OA_KEYS + 1] = "null";
+
+    hashtable_add(table, oa_keys[0], "old");
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_add_all_from_arrays(table, keys, vals, OA_KEYS + 2));
+    CHECK_EQUAL_C_INT(OA_KEYS + 1, hashtable_size(table));
+
+    void *out;
+    hashtable_get(table, oa_keys[0], &out);
+    CHECK_EQUAL_C_POINTER(&oa_keys[0], out);
+    hashtable_get(table, oa_keys[1], &out);
+    CHECK_EQUAL_C_STRING("dup", out);
+    hashtable_get(table, NULL, &out);
+    CHECK_EQUAL_C_STRING("null", out);
+
+    for (i = 2; i < OA_KEYS; i++) {
+        CHECK_EQUAL_C_INT(CC_OK, hashtable_get(table, oa_keys[i], &out));
+        CHECK_EQUAL_C_POINTER(&oa_keys[i], out);
+    }
+}
+
+static void check_reserve_shrink(void)
+{
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_reserve(table, OA_KEYS));
+    size_t capacity = hashtable_capacity(table);
+    CHECK_C(capacity * 0.75 >= OA_KEYS);
+
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+    CHECK_EQUAL_C_INT(capacity, hashtable_capacity(table));
+
+    /* reserving less than the size never shrinks */
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_reserve(table, 10));
+    CHECK_EQUAL_C_INT(capacity, hashtable_capacity(table));
+
+    for (i = 0; i < OA_KEYS; i++) {
+        if (i % 100)
+            hashtable_remove(table, oa_keys[i], NULL);
+    }
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_shrink_to_fit(table));
+    CHECK_C(hashtable_capacity(table) <= 16);
+    CHECK_EQUAL_C_INT(OA_KEYS / 100, hashtable_size(table));
+
+    void *out;
+    for (i = 0; i < OA_KEYS; i++) {
+        CHECK_EQUAL_C_INT(i % 100 ? CC_ERR_KEY_NOT_FOUND : CC_OK,
+                          hashtable_get(table, oa_keys[i], &out));
+    }
+
+    /* the table grows again from its new size */
+    for (i = 0; i < OA_KEYS; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+    CHECK_EQUAL_C_INT(OA_KEYS, hashtable_size(table));
+    hashtable_get(table, oa_keys[OA_KEYS - 1], &out);
+    CHECK_EQUAL_C_POINTER(&oa_keys[OA_KEYS - 1], out);
+
+    hashtable_remove_all(table);
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_shrink_to_fit(table));
+    CHECK_EQUAL_C_INT(0, hashtable_size(table));
+    CHECK_C(!hashtable_contains_key(table, oa_keys[0]));
+}
+
+TEST_C(HashTableTestsSlab, HashTableAddAllFromArrays)
+{
+    check_add_all_from_arrays();
+};
+
+TEST_C(HashTableTestsIncremental, HashTableIncrementalAddAllFromArrays)
+{
+    check_add_all_from_arrays();
+};
+
+TEST_C(HashTableTestsOpenAddressing, HashTableOpenAddressingAddAllFromArrays)
+{
+    check_add_all_from_arrays();
+};
+
+TEST_C(HashTableTestsSlab, HashTableReserveShrink)
+{
+    check_reserve_shrink();
+};
+
+TEST_C(HashTableTestsIncremental, HashTableIncrementalReserveShrink)
+{
+    check_reserve_shrink();
+};
+
+TEST_C(HashTableTestsOpenAddressing, HashTableOpenAddressingReserveShrink)
+{
+    check_reserve_shrink();
+};
+
+TEST_C(HashTableTestsSlab, HashTableReserveAllocatesOnce)
+{
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_reserve(table, OA_KEYS));
+    int allocs = slab_allocs;
+
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+    CHECK_EQUAL_C_INT(allocs, slab_allocs);
+
+    /* shrinking keeps the insertion order */
+    for (i = 0; i < OA_KEYS; i++) {
+        if (i % 100)
+            hashtable_remove(table, oa_keys[i], NULL);
+    }
+    hashtable_shrink_to_fit(table);
+
+    HashTableIter iter;
+    TableEntry   *entry;
+    hashtable_iter_init(&iter, table);
+
+    i = 0;
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END) {
+        CHECK_EQUAL_C_POINTER(oa_keys[i * 100], entry->key);
+        CHECK_EQUAL_C_POINTER(&oa_keys[i * 100], entry->value);
+        i++;
+    }
+    CHECK_EQUAL_C_INT(OA_KEYS / 100, i);
+};
+
+static void check_shrink_on_remove(void)
+{
+    hashtable_destroy(table);
+    conf.min_load_factor = 0.1f;
+    hashtable_new_conf(&conf, &table);
+
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    size_t peak = hashtable_capacity(table);
+
+    for (i = 0; i < OA_KEYS - 100; i++)
+        CHECK_EQUAL_C_INT(CC_OK, hashtable_remove(table, oa_keys[i], NULL));
+
+    size_t capacity = hashtable_capacity(table);
+    CHECK_C(capacity <= peak / 4);
+    CHECK_C(hashtable_size(table) >= capacity / 10);
+
+    void *out;
+    for (i = 0; i < OA_KEYS; i++) {
+        CHECK_EQUAL_C_INT(i < OA_KEYS - 100 ? CC_ERR_KEY_NOT_FOUND : CC_OK,
+                          hashtable_get(table, oa_keys[i], &out));
+    }
+
+    /* adding and removing around the threshold doesn't resize back and forth */
+    for (i = 0; i < 100; i++) {
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+        hashtable_remove(table, oa_keys[i], NULL);
+        hashtable_remove(table, oa_keys[OA_KEYS - 1 - i % 2], NULL);
+        hashtable_add(table, oa_keys[OA_KEYS - 1 - i % 2], &oa_keys[OA_KEYS - 1 - i % 2]);
+    }
+    CHECK_EQUAL_C_INT(capacity, hashtable_capacity(table));
+
+    /* iteration still visits every entry */
+    HashTableIter iter;
+    TableEntry   *entry;
+    hashtable_iter_init(&iter, table);
+
+    int n = 0;
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END) {
+        CHECK_EQUAL_C_POINTER(entry->key, *(char (*)[16]) entry->value);
+        n++;
+    }
+    CHECK_EQUAL_C_INT(100, n);
+
+    /* the table never shrinks below its initial capacity */
+    hashtable_remove_all(table);
+    CHECK_C(hashtable_capacity(table) <= 16);
+    CHECK_C(hashtable_capacity(table) >= conf.initial_capacity);
+
+    for (i = 0; i < OA_KEYS; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+    CHECK_EQUAL_C_INT(OA_KEYS, hashtable_size(table));
+}
+
+TEST_C(HashTableTestsSlab, HashTableShrinkOnRemove)
+{
+    check_shrink_on_remove();
+};
+
+TEST_C(HashTableTestsIncremental, HashTableIncrementalShrinkOnRemove)
+{
+    check_shrink_on_remove();
+};
+
+TEST_C(HashTableTestsIncremental, HashTableIncrementalKeepsOrder)
+{
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    /* The removals compact the dense array, and the keys that are added
+     * back while that is in progress go after the remaining ones. */
+    for (i = 0; i < OA_KEYS; i++) {
+        if (i % 4)
+            hashtable_remove(table, oa_keys[i], NULL);
+        if (i % 4 == 3)
+            hashtable_add(table, oa_keys[i - 2], &oa_keys[i - 2]);
+    }
+    CHECK_EQUAL_C_INT(OA_KEYS / 2, hashtable_size(table));
+
+    HashTableIter iter;
+    TableEntry   *entry;
+    hashtable_iter_init(&iter, table);
+
+    i = 0;
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END) {
+        int expect = i < OA_KEYS / 4 ? i * 4 : (i - OA_KEYS / 4) * 4 + 1;
+        CHECK_EQUAL_C_POINTER(&oa_keys[expect], entry->value);
+        i++;
+    }
+    CHECK_EQUAL_C_INT(OA_KEYS / 2, i);
+};
+
+TEST_C(HashTableTestsOpenAddressing, HashTableOpenAddressingShrinkOnRemove)
+{
+    check_shrink_on_remove();
+};
+
+TEST_C(HashTableTestsSlab, HashTableShrinkKeepsOrder)
+{
+    hashtable_destroy(table);
+    conf.min_load_factor = 0.1f;
+    hashtable_new_conf(&conf, &table);
+
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        hashtable_add(table, oa_keys[i], &oa_keys[i]);
+
+    /* keep every 100th key */
+    for (i = 0; i < OA_KEYS; i++) {
+        if (i % 100)
+            hashtable_remove(table, oa_keys[i], NULL);
+    }
+    CHECK_EQUAL_C_INT(32, hashtable_capacity(table));
+
+    HashTableIter iter;
+    TableEntry   *entry;
+    hashtable_iter_init(&iter, table);
+
+    i = 0;
+    while (hashtable_iter_next(&iter, &entry) != CC_ITER_END) {
+        CHECK_EQUAL_C_POINTER(oa_keys[i * 100], entry->key);
+        i++;
+    }
+    CHECK_EQUAL_C_INT(OA_KEYS / 100, i);
+};
+
+static char snapshot_path[] = "/tmp/hashtable_snapshot_XXXXXX";
+
+static const void *string_ser(const void *s, size_t *size)
+{
+    *size = strlen(s);
+    return s;
+}
+
+static const void *int_ser(const void *i, size_t *size)
+{
+    *size = sizeof(int);
+    return i;
+}
+
+TEST_GROUP_C_SETUP(HashTableTestsSnapshot)
+{
+    int i;
+    for (i = 0; i < OA_KEYS; i++)
+        sprintf(oa_keys[i], "key%d", i);
+
+    hashtable_conf_init(&conf);
+    conf.hash        = STRING_HASH;
+    conf.key_length  = KEY_LENGTH_VARIABLE;
+    conf.key_compare = cc_common_cmp_str;
+    hashtable_new_conf(&conf, &table);
+
+    strcpy(snapshot_path, "/tmp/hashtable_snapshot_XXXXXX");
+};
+
+TEST_GROUP_C_TEARDOWN(HashTableTestsSnapshot)
+{
+    hashtable_destroy(table);
+    unlink(snapshot_path);
+};
+
+static HashTableSnapshot *save_and_open(void)
+{
+    HashTableSnapshot *snap;
+
+    int fd = mkstemp(snapshot_path);
+    CHECK_C(fd >= 0);
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_save(table, fd, string_ser, int_ser));
+    close(fd);
+
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_open_mmap(snapshot_path, &snap));
+    return snap;
+}
+
+TEST_C(HashTableTestsSnapshot, HashTableSnapshotGet)
+{
+    int values[OA_KEYS];
+    int i;
+
+    for (i = 0; i < OA_KEYS; i++) {
+        values[i] = i * 3;
+        hashtable_add(table, oa_keys[i], &values[i]);
+    }
+    HashTableSnapshot *snap = save_and_open();
+
+    CHECK_EQUAL_C_INT(OA_KEYS, hashtable_snapshot_size(snap));
+
+    for (i = 0; i < OA_KEYS; i++) {
+        const void *value;
+        size_t      size;
+
+        CHECK_EQUAL_C_INT(CC_OK, hashtable_snapshot_get(snap, oa_keys[i], strlen(oa_keys[i]),
+                                                        &value, &size));
+        CHECK_EQUAL_C_INT(sizeof(int), size);
+        CHECK_EQUAL_C_INT(i * 3, *(const int*) value);
+        CHECK_EQUAL_C_INT(0, (uintptr_t) value % 8);
+    }
+    CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND,
+                      hashtable_snapshot_get(snap, "key", 3, NULL, NULL));
+    CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND,
+                      hashtable_snapshot_get(snap, "key1000", 7, NULL, NULL));
+
+    hashtable_snapshot_close(snap);
+};
+
+TEST_C(HashTableTestsSnapshot, HashTableSnapshotEmpty)
+{
+    HashTableSnapshot *snap = save_and_open();
+
+    CHECK_EQUAL_C_INT(0, hashtable_snapshot_size(snap));
+    CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND,
+                      hashtable_snapshot_get(snap, "a", 1, NULL, NULL));
+
+    hashtable_snapshot_close(snap);
+};
+
+TEST_C(HashTableTestsSnapshot, HashTableSnapshotInvalid)
+{
+    HashTableSnapshot *snap;
+
+    int fd = mkstemp(snapshot_path);
+    CHECK_C(fd >= 0);
+    char junk[128];
+    memset(junk, 'x', sizeof(junk));
+    CHECK_EQUAL_C_INT(sizeof(junk), write(fd, junk, sizeof(junk)));
+    close(fd);
+
+    CHECK_EQUAL_C_INT(CC_ERR_INVALID_FORMAT, hashtable_open_mmap(snapshot_path, &snap));
+    CHECK_EQUAL_C_INT(CC_ERR_IO, hashtable_open_mmap("/nonexistent/snapshot", &snap));
+};
+
+static const void *int_to_text(const void *i, size_t *size)
+{
+    static char buf[16];
+
+    *size = sprintf(buf, "%d", *(const int*) i);
+    return buf;
+}
+
+static int ser_calls;
+
+static int int_cmp(const void *a, const void *b)
+{
+    return *(const int*) a - *(const int*) b;
+}
+
+static const void *growing_ser(const void *i, size_t *size)
+{
+    static char buf[16];
+
+    /* The second pass over the table sees longer values */
+    *size = sprintf(buf, "%d%s", *(const int*) i, ser_calls++ < 1 ? "" : "0");
+    return buf;
+}
+
+TEST_C(HashTableTestsSnapshot, HashTableSnapshotSharedBuffer)
+{
+    HashTableSnapshot *snap;
+    int                keys[100];
+    int                values[100];
+    int                i;
+
+    hashtable_destroy(table);
+    conf.hash        = GENERAL_HASH;
+    conf.key_length  = sizeof(int);
+    conf.key_compare = int_cmp;
+    hashtable_new_conf(&conf, &table);
+
+    for (i = 0; i < 100; i++) {
+        keys[i]   = i;
+        values[i] = 1000 + i;
+        hashtable_add(table, &keys[i], &values[i]);
+    }
+
+    int fd = mkstemp(snapshot_path);
+    CHECK_C(fd >= 0);
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_save(table, fd, int_to_text, int_to_text));
+    close(fd);
+
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_open_mmap(snapshot_path, &snap));
+    for (i = 0; i < 100; i++) {
+        char        key[16];
+        char        expect[16];
+        const void *value;
+        size_t      size;
+
+        sprintf(key, "%d", i);
+        sprintf(expect, "%d", values[i]);
+        CHECK_EQUAL_C_INT(CC_OK, hashtable_snapshot_get(snap, key, strlen(key), &value, &size));
+        CHECK_EQUAL_C_INT(4, size);
+        CHECK_C(!memcmp(value, expect, 4));
+    }
+    hashtable_snapshot_close(snap);
+
+    /* A serializer that isn't stable makes the save fail */
+    hashtable_remove_all(table);
+    hashtable_add(table, &keys[0], &values[0]);
+    ser_calls = 0;
+
+    fd = open(snapshot_path, O_WRONLY | O_TRUNC);
+    CHECK_C(fd >= 0);
+    CHECK_EQUAL_C_INT(CC_ERR_INVALID_FORMAT, hashtable_save(table, fd, int_to_text, growing_ser));
+    close(fd);
+};
+
+/* Header fields and the start of the first record, as laid out by
+ * hashtable_save() */
+#define SNAP_CAPACITY    24
+#define SNAP_DATA_OFFSET 48
+#define SNAP_DATA_SIZE   56
+#define SNAP_INDEX       64
+
+static void snapshot_rewrite(const uint8_t *image, size_t size)
+{
+    FILE *f = fopen(snapshot_path, "wb");
+    CHECK_C(f != NULL);
+    CHECK_EQUAL_C_INT(size, fwrite(image, 1, size, f));
+    fclose(f);
+}
+
+TEST_C(HashTableTestsSnapshot, HashTableSnapshotCorrupt)
+{
+    HashTableSnapshot *snap;
+    int                value = 1;
+    uint8_t            image[4096];
+    uint8_t            damaged[4096];
+    uint64_t           capacity;
+    uint64_t           data_offset;
+    uint64_t           field;
+    size_t             size;
+    size_t             i;
+
+    hashtable_add(table, oa_keys[0], &value);
+    snap = save_and_open();
+    hashtable_snapshot_close(snap);
+
+    FILE *f = fopen(snapshot_path, "rb");
+    CHECK_C(f != NULL);
+    size = fread(image, 1, sizeof(image), f);
+    fclose(f);
+
+    memcpy(&capacity, image + SNAP_CAPACITY, sizeof(capacity));
+    memcpy(&data_offset, image + SNAP_DATA_OFFSET, sizeof(data_offset));
+
+    /* A record whose padded key runs past the end of the data */
+    memcpy(damaged, image, size);
+    field = 21;
+    memcpy(damaged + SNAP_DATA_SIZE, &field, sizeof(field));
+    field = 5;
+    memcpy(damaged + data_offset, &field, sizeof(field));
+    field = 1000000;
+    memcpy(damaged + data_offset + 8, &field, sizeof(field));
+    snapshot_rewrite(damaged, size);
+
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_open_mmap(snapshot_path, &snap));
+    CHECK_EQUAL_C_INT(CC_ERR_INVALID_FORMAT,
+                      hashtable_snapshot_get(snap, oa_keys[0], strlen(oa_keys[0]), NULL, NULL));
+    hashtable_snapshot_close(snap);
+
+    /* An index without empty slots */
+    memcpy(damaged, image, size);
+    memset(damaged + SNAP_INDEX, 0, capacity * 16);
+    snapshot_rewrite(damaged, size);
+
+    CHECK_EQUAL_C_INT(CC_OK, hashtable_open_mmap(snapshot_path, &snap));
+    for (i = 1; i < 8; i++)
+        CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND,
+                          hashtable_snapshot_get(snap, oa_keys[i], strlen(oa_keys[i]), NULL, NULL));
+    hashtable_snapshot_close(snap);
+
+    /* A data area too small to hold a record */
+    memcpy(damaged, image, size);
+    field = 8;
+    memcpy(damaged + SNAP_DATA_SIZE, &field, sizeof(field));
+    snapshot_rewrite(damaged, size);
+
+    CHECK_EQUAL_C_INT(CC_ERR_INVALID_FORMAT, hashtable_open_mmap(snapshot_path, &snap));
+};
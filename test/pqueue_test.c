@@ -145,3 +145,28 @@ TEST_C(PQueueTestsWithDefaults, PqueuePopLastTwos)
     pqueue_pop(p1, (void *)&ptr);
     CHECK_EQUAL_C_POINTER(&d, ptr);
 };
+
+TEST_C(PQueueTestsWithDefaults, PqueuePushRealloc)
+{
+    PQueueConf cfg;
+    PQueue    *pq;
+    int        vals[100];
+    int        i;
+
+    pqueue_conf_init(&cfg, comp2);
+    cfg.capacity    = 1;
+    cfg.mem_realloc = realloc;
+    pqueue_new_conf(&cfg, &pq);
+
+    for (i = 0; i < 100; i++) {
+        vals[i] = (i * 37) % 100;
+        CHECK_EQUAL_C_INT(CC_OK, pqueue_push(pq, &vals[i]));
+    }
+
+    for (i = 99; i >= 0; i--) {
+        int *ptr;
+        pqueue_pop(pq, (void*) &ptr);
+        CHECK_EQUAL_C_INT(i, *ptr);
+    }
+    pqueue_destroy(pq);
+};
@@ -0,0 +1,18 @@
+#include "CppUTest/TestHarness_c.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+TEST_GROUP_C_WRAPPER(ShardedHashTableTests)
+{
+  TEST_GROUP_C_SETUP_WRAPPER(ShardedHashTableTests);
+  TEST_GROUP_C_TEARDOWN_WRAPPER(ShardedHashTableTests);
+};
+
+TEST_C_WRAPPER(ShardedHashTableTests, ShardedHashTableNew);
+TEST_C_WRAPPER(ShardedHashTableTests, ShardedHashTableAddGetRemove);
+TEST_C_WRAPPER(ShardedHashTableTests, ShardedHashTableParallelAdd);
+TEST_C_WRAPPER(ShardedHashTableTests, ShardedHashTableForeach);
+TEST_C_WRAPPER(ShardedHashTableTests, ShardedHashTableSingleShard);
+
+int main(int argc, char **argv) {
+  return RUN_ALL_TESTS(argc, argv);
+}
@@ -0,0 +1,141 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include "sharded_hashtable.h"
+#include "CppUTest/TestHarness_c.h"
+
+#define THREADS     8
+#define PER_THREAD  5000
+
+static ShardedHashTableConf conf;
+static ShardedHashTable *table;
+static int stat;
+
+static int cmp_ptr(const void *k1, const void *k2)
+{
+    return k1 == k2 ? 0 : 1;
+}
+
+#define KEY(i) ((void*) (uintptr_t) ((i) + 1))
+
+TEST_GROUP_C_SETUP(ShardedHashTableTests)
+{
+    sharded_hashtable_conf_init(&conf);
+    conf.shards                 = 8;
+    conf.table_conf.hash        = WY_POINTER_HASH;
+    conf.table_conf.key_compare = cmp_ptr;
+    conf.table_conf.key_length  = KEY_LENGTH_POINTER;
+
+    stat = sharded_hashtable_new_conf(&conf, &table);
+};
+
+TEST_GROUP_C_TEARDOWN(ShardedHashTableTests)
+{
+    sharded_hashtable_destroy(table);
+};
+
+TEST_C(ShardedHashTableTests, ShardedHashTableNew)
+{
+    ShardedHashTable *t;
+
+    CHECK_EQUAL_C_INT(CC_OK, stat);
+    CHECK_EQUAL_C_INT(8, sharded_hashtable_shards(table));
+    CHECK_EQUAL_C_INT(0, sharded_hashtable_size(table));
+
+    CHECK_EQUAL_C_INT(CC_OK, sharded_hashtable_new(&t));
+    CHECK_EQUAL_C_INT(CC_OK, sharded_hashtable_add(t, "key", "value"));
+    CHECK_C(sharded_hashtable_contains_key(t, "key"));
+    sharded_hashtable_destroy(t);
+};
+
+TEST_C(ShardedHashTableTests, ShardedHashTableAddGetRemove)
+{
+    size_t i;
+    void  *v;
+
+    for (i = 0; i < 10000; i++)
+        CHECK_EQUAL_C_INT(CC_OK, sharded_hashtable_add(table, KEY(i), KEY(i * 2)));
+
+    sharded_hashtable_add(table, KEY(3), "three");
+    CHECK_EQUAL_C_INT(10000, sharded_hashtable_size(table));
+
+    for (i = 0; i < 10000; i += 2) {
+        CHECK_EQUAL_C_INT(CC_OK, sharded_hashtable_remove(table, KEY(i), &v));
+        CHECK_EQUAL_C_POINTER(KEY(i * 2), v);
+    }
+    CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND, sharded_hashtable_remove(table, KEY(0), NULL));
+    CHECK_EQUAL_C_INT(5000, sharded_hashtable_size(table));
+
+    CHECK_EQUAL_C_INT(CC_OK, sharded_hashtable_get(table, KEY(3), &v));
+    CHECK_EQUAL_C_STRING("three", (char*) v);
+    CHECK_EQUAL_C_INT(CC_OK, sharded_hashtable_get(table, KEY(9999), &v));
+    CHECK_EQUAL_C_POINTER(KEY(9999 * 2), v);
+    CHECK_EQUAL_C_INT(CC_ERR_KEY_NOT_FOUND, sharded_hashtable_get(table, KEY(4), &v));
+};
+
+static void *insert_range(void *arg)
+{
+    size_t id = (uintptr_t) arg;
+    size_t i;
+
+    for (i = id * PER_THREAD; i < (id + 1) * PER_THREAD; i++)
+        sharded_hashtable_add(table, KEY(i), KEY(i));
+
+    return NULL;
+}
+
+TEST_C(ShardedHashTableTests, ShardedHashTableParallelAdd)
+{
+    pthread_t threads[THREADS];
+    size_t    i;
+    void     *v;
+
+    for (i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, insert_range, (void*) (uintptr_t) i);
+    for (i = 0; i < THREADS; i++)
+        pthread_join(threads[i], NULL);
+
+    CHECK_EQUAL_C_INT(THREADS * PER_THREAD, sharded_hashtable_size(table));
+
+    for (i = 0; i < THREADS * PER_THREAD; i++) {
+        CHECK_EQUAL_C_INT(CC_OK, sharded_hashtable_get(table, KEY(i), &v));
+        CHECK_EQUAL_C_POINTER(KEY(i), v);
+    }
+};
+
+static void sum_keys(const void *key, void *value, void *ctx)
+{
+    atomic_fetch_add((atomic_size_t*) ctx, (uintptr_t) key);
+}
+
+TEST_C(ShardedHashTableTests, ShardedHashTableForeach)
+{
+    atomic_size_t sum;
+    size_t        i;
+    size_t        threads;
+
+    for (i = 0; i < 1000; i++)
+        sharded_hashtable_add(table, KEY(i), NULL);
+
+    /* more threads than shards is fine too */
+    for (threads = 0; threads <= 16; threads += 4) {
+        atomic_init(&sum, 0);
+        sharded_hashtable_foreach(table, threads, sum_keys, &sum);
+        CHECK_EQUAL_C_INT(500500, atomic_load(&sum));
+    }
+};
+
+TEST_C(ShardedHashTableTests, ShardedHashTableSingleShard)
+{
+    ShardedHashTable *t;
+    size_t            i;
+
+    conf.shards = 1;
+    CHECK_EQUAL_C_INT(CC_OK, sharded_hashtable_new_conf(&conf, &t));
+    CHECK_EQUAL_C_INT(1, sharded_hashtable_shards(t));
+
+    for (i = 0; i < 100; i++)
+        sharded_hashtable_add(t, KEY(i), NULL);
+
+    CHECK_EQUAL_C_INT(100, sharded_hashtable_size(t));
+    sharded_hashtable_destroy(t);
+};